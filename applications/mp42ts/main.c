@@ -116,8 +116,10 @@ static GFINLINE void usage()
 	        "                          in this mode, PAT, PMT and PCR will be inserted before the first TS packet of the RAP PES\n"
 	        "-flush-rap             same as -rap but flushes all other streams (sends remaining PES packets) before inserting PAT/PMT\n"
 	        "-nb-pack N             specifies to pack up to N TS packets together before sending on network or writing to file\n"
+	        "                        * in real-time mode with UDP output only, datagrams are paced at the mux rate and default to 7 packets\n"
 	        "-pcr-ms N              sets max interval in ms between 2 PCR. Default is 100 ms or at each PES header\n"
 	        "-force-pcr-only        allows sending PCR-only packets to enforce the requested PCR rate - STILL EXPERIMENTAL.\n"
+	        "-statmux MS            enables statistical multiplexing across programs, sending data up to MS ms ahead instead of padding. Requires -rate\n"
 	        "-ttl N                 specifies Time-To-Live for multicast. Default is 1.\n"
 	        "-ifce IPIFCE           specifies default IP interface to use. Default is IF_ANY.\n"
 	        "-temi [URL]            Inserts TEMI time codes in adaptation field. URL is optional, and can be a number for external timeline IDs\n"
@@ -1870,7 +1872,7 @@ static GFINLINE GF_Err parse_args(int argc, char **argv, u32 *mux_rate, u32 *car
                                   Bool *real_time, u32 *run_time, char **video_buffer, u32 *video_buffer_size,
                                   u32 *audio_input_type, char **audio_input_ip, u16 *audio_input_port,
                                   u32 *output_type, char **ts_out, char **udp_out, char **rtp_out, u16 *output_port,
-                                  char** segment_dir, u32 *segment_duration, char **segment_manifest, u32 *segment_number, char **segment_http_prefix, u32 *split_rap, u32 *nb_pck_pack, u32 *pcr_ms, u32 *ttl, const char **ip_ifce, const char **temi_url, u32 *sdt_refresh_rate, Bool *enable_forced_pcr)
+                                  char** segment_dir, u32 *segment_duration, char **segment_manifest, u32 *segment_number, char **segment_http_prefix, u32 *split_rap, u32 *nb_pck_pack, u32 *pcr_ms, u32 *ttl, const char **ip_ifce, const char **temi_url, u32 *sdt_refresh_rate, Bool *enable_forced_pcr, u32 *statmux_ms)
 {
 	Bool rate_found=0, mpeg4_carousel_found=0, time_found=0, src_found=0, dst_found=0, audio_input_found=0, video_input_found=0,
 	     seg_dur_found=0, seg_dir_found=0, seg_manifest_found=0, seg_number_found=0, seg_http_found=0, real_time_found=0, insert_ntp=0;
@@ -2019,6 +2021,8 @@ static GFINLINE GF_Err parse_args(int argc, char **argv, u32 *mux_rate, u32 *car
 			*split_rap = 2;
 		} else if (!stricmp(arg, "-force-pcr-only")) {
 			*enable_forced_pcr = GF_TRUE;
+		} else if (CHECK_PARAM("-statmux")) {
+			*statmux_ms = atoi(next_arg);
 		} else if (CHECK_PARAM("-nb-pack")) {
 			*nb_pck_pack = atoi(next_arg);
 		} else if (CHECK_PARAM("-nb-pck")) {
@@ -2310,6 +2314,7 @@ int main(int argc, char **argv)
 	char *ts_out = NULL, *udp_out = NULL, *rtp_out = NULL, *audio_input_ip = NULL;
 	FILE *ts_output_file = NULL;
 	GF_Socket *ts_output_udp_sk = NULL, *audio_input_udp_sk = NULL;
+	GF_M2TS_Sender *ts_sender = NULL;
 #ifndef GPAC_DISABLE_STREAMING
 	GF_RTPChannel *ts_output_rtp = NULL;
 	GF_RTSPTransport tr;
@@ -2333,6 +2338,7 @@ int main(int argc, char **argv)
 	GF_M2TS_Time prev_seg_time;
 	GF_M2TS_Mux *muxer;
 	Bool enable_forced_pcr = GF_FALSE;
+	u32 statmux_ms = 0;
 	/*****************/
 	/*   gpac init   */
 	/*****************/
@@ -2391,7 +2397,7 @@ int main(int argc, char **argv)
 	                        &real_time, &run_time, &video_buffer, &video_buffer_size,
 	                        &audio_input_type, &audio_input_ip, &audio_input_port,
 	                        &output_type, &ts_out, &udp_out, &rtp_out, &output_port,
-	                        &segment_dir, &segment_duration, &segment_manifest, &segment_number, &segment_http_prefix, &split_rap, &nb_pck_pack, &pcr_ms, &ttl, &ip_ifce, &insert_temi, &sdt_refresh_rate, &enable_forced_pcr)) {
+	                        &segment_dir, &segment_duration, &segment_manifest, &segment_number, &segment_http_prefix, &split_rap, &nb_pck_pack, &pcr_ms, &ttl, &ip_ifce, &insert_temi, &sdt_refresh_rate, &enable_forced_pcr, &statmux_ms)) {
 		goto exit;
 	}
 
@@ -2412,6 +2418,9 @@ int main(int argc, char **argv)
 	if (pcr_init_val>=0) gf_m2ts_mux_set_initial_pcr(muxer, (u64) pcr_init_val);
 	gf_m2ts_mux_set_pcr_max_interval(muxer, pcr_ms);
 	gf_m2ts_mux_enable_pcr_only_packets(muxer, enable_forced_pcr);
+	if (statmux_ms && (gf_m2ts_mux_enable_statmux(muxer, statmux_ms) != GF_OK)) {
+		fprintf(stderr, "Statistical multiplexing requires a target rate (-rate) - ignoring\n");
+	}
 
 
 	if (ts_out != NULL) {
@@ -2445,7 +2454,15 @@ int main(int argc, char **argv)
 			goto exit;
 		}
 	}
-	if (udp_out != NULL) {
+	/*UDP only output in real-time: the sender paces the datagrams*/
+	if ((udp_out != NULL) && real_time && !ts_out && !rtp_out) {
+		ts_sender = gf_m2ts_sender_new(muxer, udp_out, output_port, ttl, ip_ifce, (nb_pck_pack>1) ? nb_pck_pack : 7);
+		if (!ts_sender) {
+			fprintf(stderr, "Error initializing UDP sender\n");
+			goto exit;
+		}
+	}
+	else if (udp_out != NULL) {
 		ts_output_udp_sk = gf_sk_new(GF_SOCK_TYPE_UDP);
 		if (gf_sk_is_multicast_address((char *)udp_out)) {
 			e = gf_sk_setup_multicast(ts_output_udp_sk, (char *)udp_out, output_port, ttl, 0, (char *) ip_ifce);
@@ -2592,6 +2609,10 @@ int main(int argc, char **argv)
 			if (sources[i].streams[j].stream_type==GF_STREAM_SCENE) force_pes_mode = bifs_use_pes ? 1 : 0;
 
 			stream = gf_m2ts_program_stream_add(program, &sources[i].streams[j], cur_pid+j+1, (sources[i].pcr_idx==j) ? 1 : 0, force_pes_mode);
+			if (!stream) {
+				fprintf(stderr, "Cannot add stream %d of program %d\n", j+1, sources[i].ID);
+				goto exit;
+			}
 			if (split_rap && (sources[i].streams[j].stream_type==GF_STREAM_VISUAL)) stream->start_pes_at_rap = 1;
 		}
 
@@ -2608,9 +2629,8 @@ int main(int argc, char **argv)
 	}
 	gf_m2ts_mux_update_config(muxer, 1);
 
-	if (nb_pck_pack>1) {
-		ts_pack_buffer = gf_malloc(sizeof(char) * 188 * nb_pck_pack);
-	}
+	if (!nb_pck_pack) nb_pck_pack = 1;
+	ts_pack_buffer = gf_malloc(sizeof(char) * 188 * nb_pck_pack);
 
 	/*****************/
 	/*   main loop   */
@@ -2653,23 +2673,17 @@ int main(int argc, char **argv)
 			}
 		}
 
-		/*flush all packets*/
-		nb_pck_in_pack=0;
-		while ((ts_pck = gf_m2ts_mux_process(muxer, &status, &usec_till_next)) != NULL) {
-
-			if (ts_pack_buffer ) {
-				memcpy(ts_pack_buffer + 188 * nb_pck_in_pack, ts_pck, 188);
-				nb_pck_in_pack++;
-
-				if (nb_pck_in_pack < nb_pck_pack)
-					continue;
-
-				ts_pck = (const char *) ts_pack_buffer;
-			} else {
-				nb_pck_in_pack = 1;
+		if (ts_sender) {
+			/*sends the next datagram when due, returning at least every ms to check inputs*/
+			e = gf_m2ts_sender_process(ts_sender, 1000, &status);
+			if (e) {
+				fprintf(stderr, "Error %s sending UDP packet\n", gf_error_to_string(e));
 			}
+		}
+		/*flush all packets, nb_pck_pack at a time*/
+		else while ((nb_pck_in_pack = gf_m2ts_mux_process_batch(muxer, ts_pack_buffer, nb_pck_pack, &status, &usec_till_next)) != 0) {
+			ts_pck = (const char *) ts_pack_buffer;
 
-call_flush:
 			if (ts_output_file != NULL) {
 				gf_fwrite(ts_pck, 1, 188 * nb_pck_in_pack, ts_output_file);
 				if (segment_duration && (muxer->time.sec > prev_seg_time.sec + segment_duration)) {
@@ -2732,16 +2746,10 @@ call_flush:
 			}
 #endif
 
-			nb_pck_in_pack = 0;
-
-			if (status>=GF_M2TS_STATE_PADDING) {
+			if ((nb_pck_in_pack < nb_pck_pack) || (status>=GF_M2TS_STATE_PADDING)) {
 				break;
 			}
 		}
-		if (nb_pck_in_pack) {
-			ts_pck = (const char *) ts_pack_buffer;
-			goto call_flush;
-		}
 
 		/*push video*/
 		{
@@ -2759,14 +2767,21 @@ call_flush:
 			u32 now=gf_sys_clock();
 			if (now > last_print_time + MP42TS_PRINT_TIME_MS) {
 				last_print_time = now;
-				fprintf(stderr, "M2TS: time % 6d - TS time % 6d - bitrate % 8d\r", gf_m2ts_get_sys_clock(muxer), gf_m2ts_get_ts_clock(muxer), muxer->average_birate_kbps);
+				if (ts_sender) {
+					GF_M2TS_SenderStats stats;
+					gf_m2ts_sender_get_stats(ts_sender, &stats);
+					fprintf(stderr, "M2TS: time % 6d - TS time % 6d - bitrate % 8d - sent % 8d kbps - PCR jitter %d/%d us\r", gf_m2ts_get_sys_clock(muxer), gf_m2ts_get_ts_clock(muxer), muxer->average_birate_kbps, stats.bit_rate/1000, stats.pcr_jitter_min, stats.pcr_jitter_max);
+				} else {
+					fprintf(stderr, "M2TS: time % 6d - TS time % 6d - bitrate % 8d\r", gf_m2ts_get_sys_clock(muxer), gf_m2ts_get_ts_clock(muxer), muxer->average_birate_kbps);
+				}
 
 				if (gf_prompt_has_input()) {
 					char c = gf_prompt_get_char();
 					if (c=='q') break;
 				}
 			}
-			if (status == GF_M2TS_STATE_IDLE) {
+			/*the sender already waited for the next packet*/
+			if ((status == GF_M2TS_STATE_IDLE) && !ts_sender) {
 #if 0
 				/*wait till next packet is ready to be sent*/
 				if (usec_till_next>1000) {
@@ -2799,6 +2814,19 @@ call_flush:
 		if (!dur_ms) dur_ms = 1;
 		fprintf(stderr, "Done muxing - %.02f sec - %sbitrate %d kbps "LLD" packets written\n", ((Double) dur_ms)/1000.0,mux_rate ? "" : "average ", (u32) (bits/dur_ms), muxer->tot_pck_sent);
 		fprintf(stderr, " Padding: "LLD" packets (%g kbps) - "LLD" PES padded bytes (%g kbps)\n", muxer->tot_pad_sent, (Double) (muxer->tot_pad_sent*188*8.0/dur_ms) , muxer->tot_pes_pad_bytes, (Double) (muxer->tot_pes_pad_bytes*8.0/dur_ms) );
+		if (mux_rate) {
+			GF_M2TS_Mux_Program *program = muxer->programs;
+			while (program) {
+				fprintf(stderr, " Program %d: "LLU" packets ("LLU" sent ahead) - %d late AUs - last second occupancy %d %% (%d kbps) - backlog %d bytes (%d kbps demand)\n", program->number, program->nb_pck_sent, program->nb_early_pck, program->nb_late_au, program->occupancy, program->rate_kbps, program->backlog_bytes, program->demand_kbps);
+				program = program->next;
+			}
+		}
+	}
+	if (ts_sender) {
+		GF_M2TS_SenderStats stats;
+		gf_m2ts_sender_get_stats(ts_sender, &stats);
+		fprintf(stderr, " Sent "LLU" datagrams ("LLU" errors) at %d kbps - send delay avg %d us max %d us\n", stats.nb_datagrams, stats.nb_send_errors, stats.bit_rate/1000, stats.send_delay_avg, stats.send_delay_max);
+		fprintf(stderr, " PCR jitter over "LLU" PCRs: min %d us max %d us avg %d us\n", stats.nb_pcrs, stats.pcr_jitter_min, stats.pcr_jitter_max, stats.pcr_jitter_avg);
 	}
 
 exit:
@@ -2809,6 +2837,7 @@ exit:
 	}
 	if (ts_output_file && !is_stdout) gf_fclose(ts_output_file);
 	if (ts_output_udp_sk) gf_sk_del(ts_output_udp_sk);
+	if (ts_sender) gf_m2ts_sender_del(ts_sender);
 #ifndef GPAC_DISABLE_STREAMING
 	if (ts_output_rtp) gf_rtp_del(ts_output_rtp);
 #endif
@@ -2991,7 +2991,7 @@ static void on_m2ts_dump_event(GF_M2TS_Demuxer *ts, u32 evt_type, void *par)
 	}
 }
 
-void dump_mpeg2_ts(char *mpeg2ts_file, char *out_name, Bool prog_num)
+void dump_mpeg2_ts(char *mpeg2ts_file, char *out_name, Bool prog_num, u32 nb_threads)
 {
 	char data[188];
 	GF_M2TS_Dump dumper;
@@ -3059,6 +3059,9 @@ void dump_mpeg2_ts(char *mpeg2ts_file, char *out_name, Bool prog_num)
 	gf_fseek(src, 0, SEEK_SET);
 	fdone = 0;
 
+	/*the program timestamps dump needs PES and PCR events in packet order*/
+	if (nb_threads && !prog_num) gf_m2ts_demux_set_threads(ts, nb_threads);
+
 	while (!feof(src)) {
 		size = (u32) fread(data, 1, 188, src);
 		if (size<188) break;
@@ -3068,6 +3071,7 @@ void dump_mpeg2_ts(char *mpeg2ts_file, char *out_name, Bool prog_num)
 		fdone += size;
 		gf_set_progress("MPEG-2 TS Parsing", fdone, fsize);
 	}
+	gf_m2ts_demux_sync_workers(ts);
 
 	gf_fclose(src);
 	gf_m2ts_demux_del(ts);
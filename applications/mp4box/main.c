@@ -126,7 +126,7 @@ void DumpMovieInfo(GF_ISOFile *file);
 void PrintLanguages();
 
 #ifndef GPAC_DISABLE_MPEG2TS
-void dump_mpeg2_ts(char *mpeg2ts_file, char *pes_out_name, Bool prog_num);
+void dump_mpeg2_ts(char *mpeg2ts_file, char *pes_out_name, Bool prog_num, u32 nb_threads);
 #endif
 
 
@@ -364,6 +364,8 @@ void PrintDASHUsage()
 	        " -mpd-info-url string sets MPD info url.\n"
 	        " -cprt string         adds copyright string to MPD\n"
 	        " -dash-ctx FILE       stores/restore DASH timing from FILE.\n"
+	        " -ctx-checkpoint MS   keeps the DASH context in memory and saves it to the -dash-ctx FILE as a binary snapshot at most every MS milliseconds\n"
+	        "                       and when exiting. If MS is 0, the context is only saved when exiting\n"
 	        " -dynamic             uses dynamic MPD type instead of static.\n"
 	        " -last-dynamic        same as dynamic but closes the period (insert lmsg brand if needed and update duration).\n"
 	        " -mpd-duration DUR    sets the duration in second of a live session (0 by default). If 0, you must use -mpd-refresh.\n"
@@ -375,6 +377,8 @@ void PrintDASHUsage()
 	        " -ast-offset TIME     specifies MPD AvailabilityStartTime offset in ms if positive, or availabilityTimeOffset of each representation if negative. Default is 0 sec delay\n"
 	        " -dash-scale SCALE    specifies that timing for -dash and -frag are expressed in SCALE units per seconds\n"
 	        " -mem-frags           fragments will be produced in memory rather than on disk before flushing to disk\n"
+	        " -read-ahead          prefetches ISOBMFF input data in a background thread while dashing\n"
+	        " -dash-threads N      segments representations on N threads. Ignored for scalable representations\n"
 	        " -pssh-moof           stores PSSH boxes in first moof of each segments. By default PSSH are stored in movie box.\n"
 	        " -sample-groups-traf  stores sample group descriptions in traf (duplicated for each traf). If not used, sample group descriptions are stored in the movie box.\n"
 
@@ -394,7 +398,9 @@ void PrintDASHUsage()
 	        " -no-frags-default    disables default flags in fragments\n"
 	        " -single-traf         uses a single track fragment per moof (smooth streaming and derived specs may require this)\n"
 	        " -dash-ts-prog N      program_number to be considered in case of an MPTS input file.\n"
-	        " -frag-rt             when using fragments in live mode, flush fragments according to their timing (only supported with a single input).\n"
+	        " -frag-rt             when using fragments in live mode, flush fragments according to their timing (all inputs are flushed in sync).\n"
+	        " -chunked             low-latency chunked output: each fragment is written as soon as completed and segments are\n"
+	        "                       announced before completion (availabilityTimeOffset). Disables SIDX. Use with -frag\n"
 	        " -cp-location=MODE    sets ContentProtection element location. Possible values for mode are:\n"
 	        "                        as: sets ContentProtection in AdaptationSet element\n"
 	        "                        rep: sets ContentProtection in Representation element\n"
@@ -730,6 +736,7 @@ void PrintDumpUsage()
 	        " -diso                scene IsoMedia file boxes in XML output\n"
 	        " -drtp                rtp hint samples structure to XML output\n"
 	        " -dts                 prints sample timing to text output\n"
+	        " -ts-threads N        uses N threads for PES processing when dumping MPEG-2 TS PES data\n"
 	        " -dnal trackID        prints NAL sample info of given track\n"
 	        " -sdp                 dumps SDP description of hinted file\n"
 	        " -dcr                 ISMACryp samples structure to XML output\n"
@@ -1778,7 +1785,7 @@ s32 subsegs_per_sidx;
 u32 *brand_add = NULL;
 u32 *brand_rem = NULL;
 GF_DashSwitchingMode bitstream_switching_mode = GF_DASH_BSMODE_DEFAULT;
-u32 i, stat_level, hint_flags, info_track_id, import_flags, nb_add, nb_cat, crypt, agg_samples, nb_sdp_ex, max_ptime, raw_sample_num, split_size, nb_meta_act, nb_track_act, rtp_rate, major_brand, nb_alt_brand_add, nb_alt_brand_rem, old_interleave, car_dur, minor_version, conv_type, nb_tsel_acts, program_number, dump_nal, time_shift_depth, initial_moof_sn, dump_std, import_subtitle;
+u32 i, stat_level, hint_flags, info_track_id, import_flags, nb_add, nb_cat, crypt, agg_samples, nb_sdp_ex, max_ptime, raw_sample_num, split_size, nb_meta_act, nb_track_act, rtp_rate, major_brand, nb_alt_brand_add, nb_alt_brand_rem, old_interleave, car_dur, minor_version, conv_type, nb_tsel_acts, program_number, ts_threads, dump_nal, time_shift_depth, initial_moof_sn, dump_std, import_subtitle;
 GF_DashDynamicMode dash_mode=GF_DASH_STATIC;
 #ifndef GPAC_DISABLE_SCENE_DUMP
 GF_SceneDumpFormat dump_mode;
@@ -1814,6 +1821,7 @@ Bool do_bin_nhml = GF_FALSE;
 #endif
 GF_ISOFile *file;
 Bool frag_real_time = GF_FALSE;
+Bool chunked_output = GF_FALSE;
 GF_DASH_ContentLocationMode cp_location_mode = GF_DASH_CPMODE_ADAPTATION_SET;
 Double mpd_update_time = GF_FALSE;
 Bool stream_rtp = GF_FALSE;
@@ -1837,6 +1845,9 @@ Bool seg_at_rap = GF_FALSE;
 Bool frag_at_rap = GF_FALSE;
 Bool adjust_split_end = GF_FALSE;
 Bool memory_frags = GF_TRUE;
+Bool read_ahead = GF_FALSE;
+u32 dash_threads = 0;
+s32 dash_ctx_checkpoint = -1;
 Bool keep_utc = GF_FALSE;
 u32 timescale = 0;
 const char *do_wget = NULL;
@@ -2997,6 +3008,11 @@ Bool mp4box_parse_args(int argc, char **argv)
 				i++;
 			}
 		}
+		else if (!stricmp(arg, "-ts-threads")) {
+			CHECK_NEXT_ARG
+			ts_threads = atoi(argv[i + 1]);
+			i++;
+		}
 
 #ifndef GPAC_DISABLE_SWF_IMPORT
 		/*SWF importer options*/
@@ -3169,6 +3185,9 @@ Bool mp4box_parse_args(int argc, char **argv)
 		else if (!stricmp(arg, "-frag-rt")) {
 			frag_real_time = GF_TRUE;
 		}
+		else if (!stricmp(arg, "-chunked")) {
+			chunked_output = GF_TRUE;
+		}
 		else if (!strnicmp(arg, "-cp-location=", 13)) {
 			if (strcmp(arg+13, "both")) cp_location_mode = GF_DASH_CPMODE_BOTH;
 			else if (strcmp(arg+13, "as")) cp_location_mode = GF_DASH_CPMODE_ADAPTATION_SET;
@@ -3302,6 +3321,20 @@ Bool mp4box_parse_args(int argc, char **argv)
 		else if (!stricmp(arg, "-mem-frags")) {
 			memory_frags = 1;
 		}
+		else if (!stricmp(arg, "-read-ahead")) {
+			read_ahead = 1;
+		}
+		else if (!stricmp(arg, "-ctx-checkpoint")) {
+			CHECK_NEXT_ARG
+			dash_ctx_checkpoint = atoi(argv[i + 1]);
+			if (dash_ctx_checkpoint<0) dash_ctx_checkpoint = 0;
+			i++;
+		}
+		else if (!stricmp(arg, "-dash-threads")) {
+			CHECK_NEXT_ARG
+			dash_threads = atoi(argv[i + 1]);
+			i++;
+		}
 		else if (!stricmp(arg, "-segment-marker")) {
 			char *m;
 			CHECK_NEXT_ARG
@@ -3360,6 +3393,7 @@ int mp4boxMain(int argc, char **argv)
 
 	trackID = stat_level = hint_flags = 0;
 	program_number = 0;
+	ts_threads = 0;
 	info_track_id = 0;
 	do_flat = 0;
 	inName = outName = mediaSource = input_ctx = output_ctx = drm_file = avi2raw = cprt = chap_file = pack_file = raw_cat = NULL;
@@ -3846,7 +3880,11 @@ int mp4boxMain(int argc, char **argv)
 			if (force_new)
 				gf_delete_file(dash_ctx_file);
 
-			dash_ctx = gf_cfg_force_new(NULL, dash_ctx_file);
+			/*context restored from and saved to FILE by the segmenter*/
+			if (dash_ctx_checkpoint>=0)
+				dash_ctx = gf_cfg_new(NULL, NULL);
+			else
+				dash_ctx = gf_cfg_force_new(NULL, dash_ctx_file);
 		}
 
 		if (dash_profile==GF_DASH_PROFILE_UNKNOWN)
@@ -3906,12 +3944,21 @@ int mp4boxMain(int argc, char **argv)
 		if (!e) e = gf_dasher_set_min_buffer(dasher, min_buffer);
 		if (!e) e = gf_dasher_set_ast_offset(dasher, ast_offset_ms);
 		if (!e) e = gf_dasher_enable_memory_fragmenting(dasher, memory_frags);
+		if (!e) e = gf_dasher_enable_read_ahead(dasher, read_ahead);
+		if (!e) e = gf_dasher_set_thread_count(dasher, dash_threads);
 		if (!e) e = gf_dasher_set_initial_isobmf(dasher, initial_moof_sn, initial_tfdt);
 		if (!e) e = gf_dasher_configure_isobmf_default(dasher, no_fragments_defaults, pssh_in_moof, samplegroups_in_traf, single_traf_per_moof);
 		if (!e) e = gf_dasher_enable_utc_ref(dasher, insert_utc);
 		if (!e) e = gf_dasher_enable_real_time(dasher, frag_real_time);
+		if (!e) e = gf_dasher_enable_chunked_output(dasher, chunked_output, NULL, NULL);
 		if (!e) e = gf_dasher_set_content_protection_location_mode(dasher, cp_location_mode);
 		if (!e) e = gf_dasher_set_profile_extension(dasher, dash_profile_extension);
+		if (!e && dash_ctx_file && (dash_ctx_checkpoint>=0)) {
+			e = gf_dasher_restore_context(dasher, dash_ctx_file);
+			/*no snapshot yet*/
+			if (e==GF_URL_ERROR) e = GF_OK;
+			if (!e) e = gf_dasher_set_context_checkpoint(dasher, dash_ctx_file, (u32) dash_ctx_checkpoint);
+		}
 
 		for (i=0; i < nb_dash_inputs; i++) {
 			if (!e) e = gf_dasher_add_input(dasher, &dash_inputs[i]);
@@ -4014,7 +4061,8 @@ int mp4boxMain(int argc, char **argv)
 		}
 		switch (get_file_type_by_ext(inName)) {
 		case 1:
-			file = gf_isom_open(inName, (u8) (open_edit ? GF_ISOM_OPEN_EDIT : ( ((dump_isom>0) || print_info) ? GF_ISOM_OPEN_READ_DUMP : GF_ISOM_OPEN_READ) ), tmpdir);
+			/*in read mode, only load sample tables of the tracks we use*/
+			file = gf_isom_open(inName, open_edit ? GF_ISOM_OPEN_EDIT : ( (((dump_isom>0) || print_info) ? GF_ISOM_OPEN_READ_DUMP : GF_ISOM_OPEN_READ) | GF_ISOM_OPEN_LAZY), tmpdir);
 			if (!file && (gf_isom_last_error(NULL) == GF_ISOM_INCOMPLETE_FILE) && !open_edit) {
 				u64 missing_bytes;
 				e = gf_isom_open_progressive(inName, 0, 0, &file, &missing_bytes);
@@ -4080,11 +4128,11 @@ int mp4boxMain(int argc, char **argv)
 
 				if (dump_m2ts) {
 #ifndef GPAC_DISABLE_MPEG2TS
-					dump_mpeg2_ts(inName, pes_dump, program_number);
+					dump_mpeg2_ts(inName, pes_dump, program_number, ts_threads);
 #endif
 				} else if (dump_timestamps) {
 #ifndef GPAC_DISABLE_MPEG2TS
-					dump_mpeg2_ts(inName, pes_dump, program_number);
+					dump_mpeg2_ts(inName, pes_dump, program_number, ts_threads);
 #endif
 #ifndef GPAC_DISABLE_CORE_TOOLS
 				} else if (do_bin_nhml) {
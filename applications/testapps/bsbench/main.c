@@ -0,0 +1,373 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / bitstream reader benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/tools.h>
+#include <gpac/bitstream.h>
+
+/*reference reader: the bit by bit memory reader used before the word-based fast paths, kept here to compare results and speed*/
+typedef struct
+{
+	const u8 *data;
+	u64 size, position;
+	u32 current, nbBits;
+} RefBS;
+
+static u8 ref_read_byte(RefBS *bs)
+{
+	if (bs->position >= bs->size) return 0;
+	return bs->data[bs->position++];
+}
+
+static u8 ref_read_bit(RefBS *bs)
+{
+	if (bs->nbBits == 8) {
+		bs->current = ref_read_byte(bs);
+		bs->nbBits = 0;
+	}
+	bs->current <<= 1;
+	bs->nbBits++;
+	return (u8) ((bs->current & 0x100) >> 8);
+}
+
+static u32 ref_read_int(RefBS *bs, u32 nBits)
+{
+	u32 ret = 0;
+	while (nBits-- > 0) {
+		ret <<= 1;
+		ret |= ref_read_bit(bs);
+	}
+	return ret;
+}
+
+static u64 ref_read_long_int(RefBS *bs, u32 nBits)
+{
+	u64 ret = 0;
+	while (nBits-- > 0) {
+		ret <<= 1;
+		ret |= ref_read_bit(bs);
+	}
+	return ret;
+}
+
+static u32 ref_read_bytes(RefBS *bs, u32 nb_bytes)
+{
+	u32 ret = 0;
+	while (nb_bytes--) {
+		ret <<= 8;
+		ret |= ref_read_byte(bs);
+	}
+	return ret;
+}
+
+static void ref_read_data(RefBS *bs, u8 *data, u32 nb_bytes)
+{
+	if (bs->position + nb_bytes > bs->size) return;
+	if (bs->nbBits == 8) {
+		memcpy(data, bs->data + bs->position, nb_bytes);
+		bs->position += nb_bytes;
+		return;
+	}
+	while (nb_bytes--) *data++ = ref_read_int(bs, 8);
+}
+
+static void ref_align(RefBS *bs)
+{
+	if (bs->nbBits != 8) ref_read_int(bs, 8 - bs->nbBits);
+}
+
+enum
+{
+	OP_BITS = 0,
+	OP_LONG_BITS,
+	OP_U8,
+	OP_U16,
+	OP_U24,
+	OP_U32,
+	OP_U64,
+	OP_DATA,
+	OP_COUNT
+};
+
+typedef struct
+{
+	u8 type;
+	u8 arg;
+} BenchOp;
+
+static u32 rand_seed = 1;
+static u32 bench_rand()
+{
+	rand_seed = rand_seed * 1103515245 + 12345;
+	return (rand_seed >> 16) & 0x7FFF;
+}
+
+/*builds an operation list reading about data_size bytes. With bits_ratio at 0, only byte-aligned readers are used
+(box parsing), with bits_ratio at 100 only bit fields are read (NAL header / slice parsing)*/
+static u32 build_ops(BenchOp *ops, u32 max_ops, u32 data_size, u32 bits_ratio)
+{
+	u32 nb_ops = 0;
+	u64 nb_bits = 0;
+	while ((nb_ops < max_ops) && (nb_bits + 600 < (u64) data_size*8)) {
+		BenchOp *op = &ops[nb_ops++];
+		if ((bench_rand() % 100) < bits_ratio) {
+			if (bench_rand() % 8) {
+				op->type = OP_BITS;
+				op->arg = 1 + bench_rand() % 32;
+			} else {
+				op->type = OP_LONG_BITS;
+				op->arg = 33 + bench_rand() % 32;
+			}
+		} else {
+			op->type = OP_U8 + (bench_rand() % (OP_COUNT - OP_U8));
+			op->arg = (op->type == OP_DATA) ? 1 + bench_rand() % 64 : 0;
+		}
+		switch (op->type) {
+		case OP_BITS:
+		case OP_LONG_BITS:
+			nb_bits += op->arg;
+			break;
+		case OP_DATA:
+			nb_bits += 8*op->arg + 8;
+			break;
+		default:
+			nb_bits += 64 + 8;
+			break;
+		}
+	}
+	return nb_ops;
+}
+
+static u64 run_ref(const u8 *data, u32 size, BenchOp *ops, u32 nb_ops)
+{
+	u8 buf[64];
+	u32 i;
+	u64 crc = 0;
+	RefBS bs;
+	memset(&bs, 0, sizeof(RefBS));
+	bs.data = data;
+	bs.size = size;
+	bs.nbBits = 8;
+
+	for (i=0; i<nb_ops; i++) {
+		u64 v;
+		switch (ops[i].type) {
+		case OP_BITS:
+			v = ref_read_int(&bs, ops[i].arg);
+			break;
+		case OP_LONG_BITS:
+			v = ref_read_long_int(&bs, ops[i].arg);
+			break;
+		case OP_DATA:
+			ref_read_data(&bs, buf, ops[i].arg);
+			v = buf[0] ^ buf[ops[i].arg-1];
+			break;
+		default:
+			ref_align(&bs);
+			if (ops[i].type == OP_U64) {
+				v = ref_read_bytes(&bs, 4);
+				v = (v<<32) | ref_read_bytes(&bs, 4);
+			} else {
+				v = ref_read_bytes(&bs, ops[i].type - OP_U8 + 1);
+			}
+			break;
+		}
+		crc = crc * 31 + v;
+	}
+	return crc;
+}
+
+static u64 run_gpac(const u8 *data, u32 size, BenchOp *ops, u32 nb_ops)
+{
+	u8 buf[64];
+	u32 i;
+	u64 crc = 0;
+	GF_BitStream *bs = gf_bs_new((const char *) data, size, GF_BITSTREAM_READ);
+
+	for (i=0; i<nb_ops; i++) {
+		u64 v;
+		switch (ops[i].type) {
+		case OP_BITS:
+			v = gf_bs_read_int(bs, ops[i].arg);
+			break;
+		case OP_LONG_BITS:
+			v = gf_bs_read_long_int(bs, ops[i].arg);
+			break;
+		case OP_DATA:
+			gf_bs_read_data(bs, (char *) buf, ops[i].arg);
+			v = buf[0] ^ buf[ops[i].arg-1];
+			break;
+		case OP_U8:
+			gf_bs_align(bs);
+			v = gf_bs_read_u8(bs);
+			break;
+		case OP_U16:
+			gf_bs_align(bs);
+			v = gf_bs_read_u16(bs);
+			break;
+		case OP_U24:
+			gf_bs_align(bs);
+			v = gf_bs_read_u24(bs);
+			break;
+		case OP_U32:
+			gf_bs_align(bs);
+			v = gf_bs_read_u32(bs);
+			break;
+		default:
+			gf_bs_align(bs);
+			v = gf_bs_read_u64(bs);
+			break;
+		}
+		crc = crc * 31 + v;
+	}
+	gf_bs_del(bs);
+	return crc;
+}
+
+/*writes the data as sample-sized pieces in a dynamic or chunked write bitstream and checksums the output*/
+static u64 run_write(const u8 *data, u32 size, Bool chunked)
+{
+	u64 crc = 0;
+	u32 i, pos = 0, out_size;
+	char *out;
+	GF_BitStream *bs = chunked ? gf_bs_new_chunked(0) : gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+
+	rand_seed = 1;
+	while (pos < size) {
+		u32 len = 1 + bench_rand() % 8192;
+		if (pos + len > size) len = size - pos;
+		gf_bs_write_u32(bs, len);
+		gf_bs_write_data(bs, (const char *) data + pos, len);
+		pos += len;
+	}
+	if (chunked) {
+		u32 j, count = gf_bs_get_chunk_count(bs);
+		for (j=0; j<count; j++) {
+			const char *chunk = gf_bs_get_chunk(bs, j, &out_size);
+			for (i=0; i<out_size; i++) crc = crc * 31 + (u8) chunk[i];
+		}
+	} else {
+		out = NULL;
+		gf_bs_get_content(bs, &out, &out_size);
+		for (i=0; i<out_size; i++) crc = crc * 31 + (u8) out[i];
+		gf_free(out);
+	}
+	gf_bs_del(bs);
+	return crc;
+}
+
+/*seeks past the end of a chunked bitstream, across several blocks, and checks the gap is zero-filled*/
+static Bool check_chunked_seek()
+{
+	Bool ok = GF_TRUE;
+	u32 i, size;
+	char *out = NULL;
+	GF_BitStream *bs = gf_bs_new_chunked(16);
+
+	/*dirty the blocks then drop the data, so that stale bytes are left in the blocks*/
+	for (i=0; i<100; i++) gf_bs_write_u8(bs, 0xFF);
+	gf_bs_seek(bs, 5);
+	gf_bs_truncate(bs);
+
+	if (gf_bs_seek(bs, 70) != GF_OK) ok = GF_FALSE;
+	gf_bs_write_u8(bs, 0xAB);
+	gf_bs_get_content(bs, &out, &size);
+	if (!out || (size != 71) || ((u8) out[70] != 0xAB)) ok = GF_FALSE;
+	for (i=5; ok && (i<70); i++) {
+		if (out[i]) ok = GF_FALSE;
+	}
+	if (out) gf_free(out);
+	gf_bs_del(bs);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	u32 i, t, data_size = 4*1024*1024, nb_iter = 10, max_ops = 4*1024*1024;
+	u8 *data;
+	BenchOp *ops;
+	Bool ok = GF_TRUE;
+	u32 ratios[] = {0, 50, 100};
+	const char *names[] = {"byte-aligned", "mixed", "bit fields"};
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "-h")) {
+			fprintf(stderr, "usage: bsbench [nb_iter]\n");
+			return 1;
+		}
+		nb_iter = atoi(argv[1]);
+	}
+	gf_sys_init(GF_MemTrackerNone);
+
+	data = (u8 *) gf_malloc(data_size);
+	ops = (BenchOp *) gf_malloc(sizeof(BenchOp) * max_ops);
+	for (i=0; i<data_size; i++) data[i] = (u8) bench_rand();
+
+	for (t=0; t<3; t++) {
+		u64 start, ref_time, gpac_time, ref_crc=0, gpac_crc=0;
+		u32 nb_ops = build_ops(ops, max_ops, data_size, ratios[t]);
+
+		start = gf_sys_clock_high_res();
+		for (i=0; i<nb_iter; i++) ref_crc = run_ref(data, data_size, ops, nb_ops);
+		ref_time = gf_sys_clock_high_res() - start;
+
+		start = gf_sys_clock_high_res();
+		for (i=0; i<nb_iter; i++) gpac_crc = run_gpac(data, data_size, ops, nb_ops);
+		gpac_time = gf_sys_clock_high_res() - start;
+
+		fprintf(stdout, "%s: %d reads x %d - bit reader "LLU" ms - gpac reader "LLU" ms - speedup %.2f%s\n", names[t], nb_ops, nb_iter,
+		        ref_time/1000, gpac_time/1000, gpac_time ? (Double) ref_time / gpac_time : 0, (ref_crc==gpac_crc) ? "" : " - MISMATCH");
+		if (ref_crc != gpac_crc) ok = GF_FALSE;
+	}
+
+	/*writer: realloc-based dynamic buffer vs fixed-size blocks*/
+	{
+		u64 start, dyn_time, chunk_time, dyn_crc=0, chunk_crc=0;
+		data_size = 4*data_size;
+		data = (u8 *) gf_realloc(data, data_size);
+		for (i=0; i<data_size; i++) data[i] = (u8) i;
+
+		start = gf_sys_clock_high_res();
+		for (i=0; i<nb_iter; i++) dyn_crc = run_write(data, data_size, GF_FALSE);
+		dyn_time = gf_sys_clock_high_res() - start;
+
+		start = gf_sys_clock_high_res();
+		for (i=0; i<nb_iter; i++) chunk_crc = run_write(data, data_size, GF_TRUE);
+		chunk_time = gf_sys_clock_high_res() - start;
+
+		fprintf(stdout, "writer: %d bytes x %d - dynamic buffer "LLU" ms - chunked "LLU" ms - speedup %.2f%s\n", data_size, nb_iter,
+		        dyn_time/1000, chunk_time/1000, chunk_time ? (Double) dyn_time / chunk_time : 0, (dyn_crc==chunk_crc) ? "" : " - MISMATCH");
+		if (dyn_crc != chunk_crc) ok = GF_FALSE;
+	}
+
+	if (!check_chunked_seek()) {
+		fprintf(stdout, "chunked seek past end: gap not zero-filled - MISMATCH\n");
+		ok = GF_FALSE;
+	}
+
+	gf_free(data);
+	gf_free(ops);
+	gf_sys_close();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / ISO fragment parsing benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/tools.h>
+#include <gpac/isomedia.h>
+#include <gpac/constants.h>
+
+/*creates a single track fragmented file with nb_frags fragments of nb_samples small samples each*/
+static GF_Err make_fragmented_file(const char *name, u32 nb_frags, u32 nb_samples)
+{
+	u32 i, j, track, di;
+	char data[16];
+	GF_ESD *esd;
+	GF_ISOSample *samp;
+	GF_Err e;
+	GF_ISOFile *file = gf_isom_open(name, GF_ISOM_OPEN_WRITE, NULL);
+	if (!file) return gf_isom_last_error(NULL);
+
+	track = gf_isom_new_track(file, 1, GF_ISOM_MEDIA_VISUAL, 1000);
+	gf_isom_set_track_enabled(file, track, 1);
+	esd = gf_odf_desc_esd_new(2);
+	esd->decoderConfig->streamType = GF_STREAM_VISUAL;
+	esd->decoderConfig->objectTypeIndication = GPAC_OTI_VIDEO_MPEG4_PART2;
+	e = gf_isom_new_mpeg4_description(file, track, esd, NULL, NULL, &di);
+	gf_odf_desc_del((GF_Descriptor *)esd);
+	if (!e) e = gf_isom_setup_track_fragment(file, 1, di, 40, 0, 0, 0, 0);
+	if (!e) e = gf_isom_finalize_for_fragment(file, 0);
+	if (e) {
+		gf_isom_delete(file);
+		return e;
+	}
+
+	memset(data, 0, sizeof(data));
+	samp = gf_isom_sample_new();
+	samp->data = data;
+	for (i=0; i<nb_frags; i++) {
+		gf_isom_start_fragment(file, GF_TRUE);
+		for (j=0; j<nb_samples; j++) {
+			samp->IsRAP = j ? RAP_NO : RAP;
+			/*varying sizes and CTS offsets so that trun entries are not collapsed in defaults*/
+			samp->dataLength = 1 + (j % 15);
+			samp->CTS_Offset = (j % 3) * 40;
+			gf_isom_fragment_add_sample(file, 1, samp, di, 40, 0, 0, 0);
+			samp->DTS += 40;
+		}
+	}
+	samp->data = NULL;
+	gf_isom_sample_del(&samp);
+	return gf_isom_close(file);
+}
+
+int main(int argc, char **argv)
+{
+	u32 i, nb_iter = 20, nb_frags = 2000, nb_samples = 50;
+	u64 start, now, nb_parsed = 0;
+	const char *name = "fragbench.mp4";
+	Bool generated = GF_FALSE;
+
+	if ((argc > 1) && !strcmp(argv[1], "-h")) {
+		fprintf(stderr, "usage: fragbench [file.mp4 [nb_iter]]\nwithout file, a fragmented file with %d fragments of %d samples is generated\n", nb_frags, nb_samples);
+		return 1;
+	}
+	gf_sys_init(GF_MemTrackerNone);
+
+	if (argc > 1) {
+		name = argv[1];
+		if (argc > 2) nb_iter = atoi(argv[2]);
+	} else {
+		GF_Err e = make_fragmented_file(name, nb_frags, nb_samples);
+		if (e) {
+			fprintf(stderr, "Cannot create test file: %s\n", gf_error_to_string(e));
+			gf_sys_close();
+			return 1;
+		}
+		generated = GF_TRUE;
+	}
+
+	start = gf_sys_clock_high_res();
+	for (i=0; i<nb_iter; i++) {
+		u32 j;
+		GF_ISOFile *file = gf_isom_open(name, GF_ISOM_OPEN_READ, NULL);
+		if (!file) {
+			fprintf(stderr, "Cannot open %s: %s\n", name, gf_error_to_string(gf_isom_last_error(NULL)) );
+			break;
+		}
+		for (j=0; j<gf_isom_get_track_count(file); j++) {
+			nb_parsed += gf_isom_get_sample_count(file, j+1);
+		}
+		gf_isom_close(file);
+	}
+	now = gf_sys_clock_high_res() - start;
+
+	fprintf(stdout, "%s: %d iterations in "LLU" ms - "LLU" samples - %g samples/s\n", name, i, now/1000, nb_parsed, now ? ((Double) nb_parsed * 1000000 / now) : 0);
+
+	if (generated) gf_delete_file(name);
+	gf_sys_close();
+	return 0;
+}
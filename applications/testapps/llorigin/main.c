@@ -0,0 +1,451 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / low-latency DASH origin test application
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/media_tools.h>
+#include <gpac/network.h>
+#include <gpac/thread.h>
+
+/*number of segments kept in memory, older ones are served from disk*/
+#define LL_MAX_SEGMENTS	32
+
+typedef struct
+{
+	char *name;
+	char *data;
+	u32 size, alloc;
+	Bool done;
+} LLSegment;
+
+typedef struct
+{
+	GF_DASHSegmenter *dasher;
+	Double seg_dur;
+	char out_dir[GF_MAX_PATH];
+	GF_List *segments;
+	GF_Mutex *mx;
+	Bool run;
+} LLOrigin;
+
+typedef struct
+{
+	LLOrigin *origin;
+	GF_Socket *sk;
+	GF_Thread *th;
+	Bool done;
+} LLConnection;
+
+static void usage()
+{
+	fprintf(stderr, "usage: llorigin [options] src1.mp4 [src2.mp4 ...]\n"
+	        "live DASHes the sources with low-latency chunked segments and serves them over HTTP,\n"
+	        "using chunked transfer encoding for segments still being produced. Press 'q' to quit\n"
+	        "-port N        HTTP port. Default is 8080\n"
+	        "-dir DIR       output directory, must exist. Default is the current directory\n"
+	        "-seg MS        segment duration in milliseconds. Default is 2000\n"
+	        "-frag MS       fragment (chunk) duration in milliseconds. Default is 200\n");
+}
+
+static LLSegment *llo_get_segment(LLOrigin *origin, const char *name)
+{
+	u32 i, count = gf_list_count(origin->segments);
+	for (i=0; i<count; i++) {
+		LLSegment *seg = (LLSegment *)gf_list_get(origin->segments, i);
+		if (!strcmp(seg->name, name)) return seg;
+	}
+	return NULL;
+}
+
+static void llo_del_segment(LLSegment *seg)
+{
+	gf_free(seg->name);
+	if (seg->data) gf_free(seg->data);
+	gf_free(seg);
+}
+
+static GF_Err llo_on_chunk(void *udta, const char *segment_name, const char *data, u32 size, Bool segment_end)
+{
+	LLSegment *seg;
+	LLOrigin *origin = (LLOrigin *)udta;
+	const char *name = gf_url_get_resource_name(segment_name);
+	GF_Err e = GF_OK;
+
+	gf_mx_p(origin->mx);
+	seg = llo_get_segment(origin, name);
+	if (!seg) {
+		GF_SAFEALLOC(seg, LLSegment);
+		if (!seg) {
+			gf_mx_v(origin->mx);
+			return GF_OUT_OF_MEM;
+		}
+		seg->name = gf_strdup(name);
+		gf_list_add(origin->segments, seg);
+
+		/*completed segments are on disk, drop the oldest ones*/
+		while (gf_list_count(origin->segments) > LL_MAX_SEGMENTS) {
+			LLSegment *old = (LLSegment *)gf_list_get(origin->segments, 0);
+			if (!old->done) break;
+			gf_list_rem(origin->segments, 0);
+			llo_del_segment(old);
+		}
+	}
+	if (size) {
+		if (seg->size + size > seg->alloc) {
+			seg->alloc = 2 * (seg->size + size);
+			seg->data = (char *)gf_realloc(seg->data, sizeof(char) * seg->alloc);
+		}
+		if (seg->data) {
+			memcpy(seg->data + seg->size, data, size);
+			seg->size += size;
+		} else {
+			e = GF_OUT_OF_MEM;
+		}
+	}
+	if (segment_end) seg->done = GF_TRUE;
+	gf_mx_v(origin->mx);
+	return e;
+}
+
+static GF_Err llo_send_header(GF_Socket *sk, const char *status, const char *mime, u64 content_length, Bool chunked)
+{
+	char szHdr[1024];
+	sprintf(szHdr, "HTTP/1.1 %s\r\nServer: GPAC llorigin\r\nAccess-Control-Allow-Origin: *\r\nCache-Control: no-cache\r\nConnection: close\r\n", status);
+	if (mime) sprintf(szHdr + strlen(szHdr), "Content-Type: %s\r\n", mime);
+	if (chunked) strcat(szHdr, "Transfer-Encoding: chunked\r\n");
+	else sprintf(szHdr + strlen(szHdr), "Content-Length: "LLU"\r\n", content_length);
+	strcat(szHdr, "\r\n");
+	return gf_sk_send(sk, szHdr, (u32) strlen(szHdr));
+}
+
+/*sends the segment as chunks are produced. Returns GF_NOT_FOUND if the segment is not (or no longer) in memory*/
+static GF_Err llo_send_live_segment(LLOrigin *origin, GF_Socket *sk, const char *name)
+{
+	char szChunk[20];
+	char *buf = NULL;
+	u32 buf_alloc = 0;
+	u32 sent = 0;
+	Bool header_sent = GF_FALSE;
+	GF_Err e = GF_OK;
+
+	while (1) {
+		u32 size = 0;
+		Bool done;
+		LLSegment *seg;
+
+		gf_mx_p(origin->mx);
+		seg = llo_get_segment(origin, name);
+		if (!seg) {
+			gf_mx_v(origin->mx);
+			if (!header_sent) e = GF_NOT_FOUND;
+			break;
+		}
+		if (seg->size > sent) {
+			size = seg->size - sent;
+			if (size > buf_alloc) {
+				buf_alloc = size;
+				buf = (char *)gf_realloc(buf, sizeof(char) * buf_alloc);
+			}
+			if (buf) memcpy(buf, seg->data + sent, size);
+		}
+		done = seg->done;
+		gf_mx_v(origin->mx);
+
+		if (!buf && size) {
+			e = GF_OUT_OF_MEM;
+			break;
+		}
+		if (!header_sent) {
+			e = llo_send_header(sk, "200 OK", "video/mp4", 0, GF_TRUE);
+			if (e) break;
+			header_sent = GF_TRUE;
+		}
+		if (size) {
+			sprintf(szChunk, "%X\r\n", size);
+			e = gf_sk_send(sk, szChunk, (u32) strlen(szChunk));
+			if (!e) e = gf_sk_send(sk, buf, size);
+			if (!e) e = gf_sk_send(sk, "\r\n", 2);
+			if (e) break;
+			sent += size;
+			/*more data may have been produced meanwhile*/
+			continue;
+		}
+		if (done) {
+			e = gf_sk_send(sk, "0\r\n\r\n", 5);
+			break;
+		}
+		/*the segment will never be completed*/
+		if (!origin->run) break;
+		gf_sleep(2);
+	}
+	if (buf) gf_free(buf);
+	return e;
+}
+
+static GF_Err llo_send_file(GF_Socket *sk, const char *path, const char *mime)
+{
+	char block[8192];
+	u64 size;
+	GF_Err e;
+	FILE *f = gf_fopen(path, "rb");
+	if (!f) return GF_NOT_FOUND;
+
+	gf_fseek(f, 0, SEEK_END);
+	size = gf_ftell(f);
+	gf_fseek(f, 0, SEEK_SET);
+	e = llo_send_header(sk, "200 OK", mime, size, GF_FALSE);
+	while (!e && size) {
+		u32 read = (u32) fread(block, 1, (size > sizeof(block)) ? sizeof(block) : (u32) size, f);
+		if (!read) break;
+		e = gf_sk_send(sk, block, read);
+		size -= read;
+	}
+	gf_fclose(f);
+	return e;
+}
+
+static u32 llo_connection_run(void *par)
+{
+	char szReq[4096], szPath[GF_MAX_PATH], szFile[2*GF_MAX_PATH];
+	char *sep;
+	const char *mime;
+	u32 size = 0, wait = 0;
+	LLConnection *conn = (LLConnection *)par;
+	LLOrigin *origin = conn->origin;
+	GF_Err e;
+
+	/*read the request header*/
+	while (size < sizeof(szReq) - 1) {
+		u32 read = 0;
+		e = gf_sk_receive(conn->sk, szReq, sizeof(szReq) - 1, size, &read);
+		if (e == GF_IP_NETWORK_EMPTY) {
+			if (++wait > 5000) break;
+			gf_sleep(1);
+			continue;
+		}
+		if (e || !read) break;
+		size += read;
+		szReq[size] = 0;
+		if (strstr(szReq, "\r\n\r\n")) break;
+	}
+	szReq[size] = 0;
+
+	if (strncmp(szReq, "GET ", 4) || (sscanf(szReq + 4, "%1023s", szPath) != 1)) {
+		llo_send_header(conn->sk, "400 Bad Request", NULL, 0, GF_FALSE);
+		goto exit;
+	}
+	sep = strchr(szPath, '?');
+	if (sep) sep[0] = 0;
+	/*no directory browsing*/
+	if (strstr(szPath, "..")) {
+		llo_send_header(conn->sk, "403 Forbidden", NULL, 0, GF_FALSE);
+		goto exit;
+	}
+	sep = szPath;
+	while (sep[0] == '/') sep++;
+
+	if (strstr(sep, ".mpd")) mime = "application/dash+xml";
+	else mime = "video/mp4";
+
+	/*segments being produced are sent as they grow*/
+	e = llo_send_live_segment(origin, conn->sk, sep);
+	if (e == GF_NOT_FOUND) {
+		sprintf(szFile, "%s%s", origin->out_dir, sep);
+		e = llo_send_file(conn->sk, szFile, mime);
+		if (e == GF_NOT_FOUND) llo_send_header(conn->sk, "404 Not Found", NULL, 0, GF_FALSE);
+	}
+	if (e && (e != GF_NOT_FOUND)) {
+		fprintf(stderr, "Error sending %s: %s\n", sep, gf_error_to_string(e));
+	}
+
+exit:
+	gf_sk_del(conn->sk);
+	conn->sk = NULL;
+	conn->done = GF_TRUE;
+	return 0;
+}
+
+static u32 llo_dasher_run(void *par)
+{
+	LLOrigin *origin = (LLOrigin *)par;
+
+	while (origin->run) {
+		u32 sleep_for;
+		GF_Err e = gf_dasher_process(origin->dasher, origin->seg_dur);
+		if (e) {
+			fprintf(stderr, "Error DASHing sources: %s\n", gf_error_to_string(e));
+			break;
+		}
+		sleep_for = gf_dasher_next_update_time(origin->dasher);
+		while (origin->run && sleep_for) {
+			gf_sleep(1);
+			sleep_for = gf_dasher_next_update_time(origin->dasher);
+		}
+	}
+	origin->run = GF_FALSE;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	u32 i, nb_inputs = 0;
+	u16 port = 8080;
+	Double seg_dur = 2.0, frag_dur = 0.2;
+	char szMPD[GF_MAX_PATH];
+	GF_Config *dash_ctx = NULL;
+	GF_Socket *listener = NULL;
+	GF_Thread *dash_th = NULL;
+	GF_List *connections;
+	LLOrigin origin;
+	GF_Err e = GF_OK;
+
+	memset(&origin, 0, sizeof(LLOrigin));
+	for (i=1; i<(u32) argc; i++) {
+		if (argv[i][0] != '-') break;
+		if (!strcmp(argv[i], "-port") && (i+1 < (u32) argc)) port = (u16) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-dir") && (i+1 < (u32) argc)) strcpy(origin.out_dir, argv[++i]);
+		else if (!strcmp(argv[i], "-seg") && (i+1 < (u32) argc)) seg_dur = atof(argv[++i]) / 1000;
+		else if (!strcmp(argv[i], "-frag") && (i+1 < (u32) argc)) frag_dur = atof(argv[++i]) / 1000;
+		else {
+			fprintf(stderr, "Invalid option %s\n", argv[i]);
+			usage();
+			return 1;
+		}
+	}
+	if ((i == (u32) argc) || (seg_dur <= 0) || (frag_dur <= 0)) {
+		usage();
+		return 1;
+	}
+	if (origin.out_dir[0] && (origin.out_dir[strlen(origin.out_dir)-1] != '/'))
+		strcat(origin.out_dir, "/");
+	origin.seg_dur = seg_dur;
+
+	gf_sys_init(GF_MemTrackerNone);
+	origin.segments = gf_list_new();
+	origin.mx = gf_mx_new("LLOrigin");
+	connections = gf_list_new();
+
+	sprintf(szMPD, "%slive.mpd", origin.out_dir);
+	dash_ctx = gf_cfg_new(NULL, NULL);
+	origin.dasher = gf_dasher_new(szMPD, GF_DASH_PROFILE_LIVE, NULL, 1000, dash_ctx);
+	if (!origin.dasher) {
+		e = GF_OUT_OF_MEM;
+		goto exit;
+	}
+	e = gf_dasher_enable_url_template(origin.dasher, GF_TRUE, "$RepresentationID$_$Number$", NULL);
+	if (!e) e = gf_dasher_set_durations(origin.dasher, seg_dur, GF_FALSE, frag_dur);
+	if (!e) e = gf_dasher_enable_rap_splitting(origin.dasher, GF_TRUE, GF_FALSE);
+	if (!e) e = gf_dasher_set_dynamic_mode(origin.dasher, GF_DASH_DYNAMIC, seg_dur, 30, 0);
+	if (!e) e = gf_dasher_enable_real_time(origin.dasher, GF_TRUE);
+	if (!e) e = gf_dasher_enable_chunked_output(origin.dasher, GF_TRUE, llo_on_chunk, &origin);
+	for (; (i < (u32) argc) && !e; i++) {
+		char szRep[20];
+		GF_DashSegmenterInput di;
+		memset(&di, 0, sizeof(GF_DashSegmenterInput));
+		di.file_name = argv[i];
+		sprintf(szRep, "%d", ++nb_inputs);
+		di.representationID = szRep;
+		e = gf_dasher_add_input(origin.dasher, &di);
+	}
+	if (e) {
+		fprintf(stderr, "DASH setup error: %s\n", gf_error_to_string(e));
+		goto exit;
+	}
+
+	listener = gf_sk_new(GF_SOCK_TYPE_TCP);
+	e = gf_sk_bind(listener, NULL, port, NULL, 0, GF_SOCK_REUSE_PORT);
+	if (!e) e = gf_sk_listen(listener, 16);
+	if (e) {
+		fprintf(stderr, "Cannot listen on port %d: %s\n", port, gf_error_to_string(e));
+		goto exit;
+	}
+	gf_sk_server_mode(listener, GF_TRUE);
+
+	origin.run = GF_TRUE;
+	dash_th = gf_th_new("LLOriginDASH");
+	gf_th_run(dash_th, llo_dasher_run, &origin);
+	fprintf(stderr, "Serving http://localhost:%d/live.mpd - press 'q' to quit\n", port);
+
+	while (origin.run) {
+		GF_Socket *sk = NULL;
+		if (gf_prompt_has_input() && (gf_prompt_get_char() == 'q')) break;
+
+		/*purge finished connections*/
+		for (i=0; i<gf_list_count(connections); i++) {
+			LLConnection *conn = (LLConnection *)gf_list_get(connections, i);
+			if (!conn->done) continue;
+			gf_th_del(conn->th);
+			gf_free(conn);
+			gf_list_rem(connections, i);
+			i--;
+		}
+
+		e = gf_sk_accept(listener, &sk);
+		if (e == GF_IP_NETWORK_EMPTY) {
+			gf_sleep(1);
+			continue;
+		}
+		if (e) {
+			fprintf(stderr, "Cannot accept connection: %s\n", gf_error_to_string(e));
+			continue;
+		}
+		{
+			LLConnection *conn;
+			GF_SAFEALLOC(conn, LLConnection);
+			if (!conn) {
+				gf_sk_del(sk);
+				continue;
+			}
+			conn->origin = &origin;
+			conn->sk = sk;
+			conn->th = gf_th_new("LLOriginHTTP");
+			gf_list_add(connections, conn);
+			gf_th_run(conn->th, llo_connection_run, conn);
+		}
+	}
+	e = GF_OK;
+
+exit:
+	origin.run = GF_FALSE;
+	if (dash_th) {
+		gf_th_stop(dash_th);
+		gf_th_del(dash_th);
+	}
+	while (gf_list_count(connections)) {
+		LLConnection *conn = (LLConnection *)gf_list_pop_back(connections);
+		gf_th_stop(conn->th);
+		gf_th_del(conn->th);
+		gf_free(conn);
+	}
+	gf_list_del(connections);
+	if (listener) gf_sk_del(listener);
+	if (origin.dasher) gf_dasher_del(origin.dasher);
+	if (dash_ctx) gf_cfg_del(dash_ctx);
+	while (gf_list_count(origin.segments)) {
+		llo_del_segment((LLSegment *)gf_list_pop_back(origin.segments));
+	}
+	gf_list_del(origin.segments);
+	gf_mx_del(origin.mx);
+	gf_sys_close();
+	return e ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / ISO sample index segment test
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/tools.h>
+#include <gpac/isomedia.h>
+
+/*reads the segments twice in parallel, once from the sample tables and once with the sample index enabled for the whole session,
+the index being kept across segment releases. Returns 1 if the sample properties differ*/
+
+/*compares samples from first_sample to the end of the segment, returns the number of mismatches*/
+static u32 compare_samples(GF_ISOFile *ref, GF_ISOFile *test, u32 track, u32 *first_sample, const char *seg_name)
+{
+	u32 nb_errors = 0;
+	u32 count = gf_isom_get_sample_count(ref, track);
+
+	if (count != gf_isom_get_sample_count(test, track)) {
+		fprintf(stderr, "%s track %d: sample count mismatch %d vs %d\n", seg_name, track, count, gf_isom_get_sample_count(test, track));
+		return 1;
+	}
+	for (; *first_sample <= count; (*first_sample)++) {
+		u32 di_ref, di_test;
+		u64 offset_ref, offset_test;
+		GF_ISOSample *s_ref = gf_isom_get_sample_info(ref, track, *first_sample, &di_ref, &offset_ref);
+		GF_ISOSample *s_test = gf_isom_get_sample_info(test, track, *first_sample, &di_test, &offset_test);
+
+		if (!s_ref || !s_test) {
+			if (s_ref || s_test) {
+				fprintf(stderr, "%s track %d sample %d: fetched only with %s\n", seg_name, track, *first_sample, s_ref ? "sample tables" : "sample index");
+				nb_errors++;
+			}
+		} else if ((s_ref->DTS != s_test->DTS) || (s_ref->CTS_Offset != s_test->CTS_Offset) || (s_ref->dataLength != s_test->dataLength)
+		           || (s_ref->IsRAP != s_test->IsRAP) || (di_ref != di_test) || (offset_ref != offset_test)) {
+			fprintf(stderr, "%s track %d sample %d: DTS "LLU"/"LLU" size %d/%d offset "LLU"/"LLU"\n", seg_name, track, *first_sample,
+			        s_ref->DTS, s_test->DTS, s_ref->dataLength, s_test->dataLength, offset_ref, offset_test);
+			nb_errors++;
+		}
+		if (s_ref) gf_isom_sample_del(&s_ref);
+		if (s_test) gf_isom_sample_del(&s_test);
+	}
+	return nb_errors;
+}
+
+int main(int argc, char **argv)
+{
+	GF_ISOFile *ref, *test;
+	GF_Err e;
+	u64 missing_bytes;
+	u32 i, j, nb_tracks, nb_errors = 0;
+	u32 *next_sample;
+
+	if (argc < 3) {
+		fprintf(stderr, "usage: sampleindex init.mp4 seg1.m4s [seg2.m4s ...]\n");
+		return 1;
+	}
+
+	gf_sys_init(GF_MemTrackerNone);
+	e = gf_isom_open_progressive(argv[1], 0, 0, &ref, &missing_bytes);
+	if (!e) e = gf_isom_open_progressive(argv[1], 0, 0, &test, &missing_bytes);
+	if (e) {
+		fprintf(stderr, "Cannot open %s: %s\n", argv[1], gf_error_to_string(e));
+		gf_sys_close();
+		return 1;
+	}
+	nb_tracks = gf_isom_get_track_count(ref);
+	next_sample = (u32 *) gf_malloc(sizeof(u32) * nb_tracks);
+	for (j=0; j<nb_tracks; j++) {
+		next_sample[j] = 1;
+		gf_isom_enable_sample_index(test, j+1, GF_TRUE);
+	}
+
+	for (i=2; i<(u32) argc; i++) {
+		e = gf_isom_open_segment(ref, argv[i], 0, 0, GF_FALSE);
+		if (!e) e = gf_isom_open_segment(test, argv[i], 0, 0, GF_FALSE);
+		if (e) {
+			fprintf(stderr, "Cannot open segment %s: %s\n", argv[i], gf_error_to_string(e));
+			nb_errors++;
+			break;
+		}
+		for (j=0; j<nb_tracks; j++) {
+			nb_errors += compare_samples(ref, test, j+1, &next_sample[j], argv[i]);
+		}
+		gf_isom_release_segment(ref, GF_TRUE);
+		gf_isom_release_segment(test, GF_TRUE);
+	}
+
+	fprintf(stdout, "%d segments checked - %d errors\n", argc-2, nb_errors);
+	gf_free(next_sample);
+	gf_isom_close(ref);
+	gf_isom_close(test);
+	gf_sys_close();
+	return nb_errors ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / ISO sample iterator test
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/tools.h>
+#include <gpac/isomedia.h>
+#include <gpac/thread.h>
+
+/*reads all samples of a file with the sample iterator, once with gf_isom_sample_iterator_next and once with
+gf_isom_sample_iterator_process on worker threads, and compares each of them with gf_isom_get_sample on a second
+instance of the file. Returns 1 if a sample differs or is missing*/
+
+typedef struct
+{
+	GF_ISOFile *ref;
+	/*gf_isom_get_sample is not thread-safe*/
+	GF_Mutex *mx;
+	/*number of times each sample was returned, per track*/
+	u32 **seen;
+	u32 nb_errors;
+	const char *pass;
+} SampleIterTest;
+
+static GF_Err check_sample(void *udta, u32 track, u32 sample_num, u32 di, GF_ISOSample *samp)
+{
+	u32 di_ref;
+	GF_ISOSample *ref;
+	SampleIterTest *st = (SampleIterTest *)udta;
+
+	gf_mx_p(st->mx);
+	ref = gf_isom_get_sample(st->ref, track, sample_num, &di_ref);
+	if (!ref) {
+		fprintf(stderr, "%s track %d sample %d: not found with gf_isom_get_sample\n", st->pass, track, sample_num);
+		st->nb_errors++;
+	} else {
+		if ((ref->DTS != samp->DTS) || (ref->CTS_Offset != samp->CTS_Offset) || (ref->IsRAP != samp->IsRAP) || (di_ref != di)
+		        || (ref->dataLength != samp->dataLength) || memcmp(ref->data, samp->data, samp->dataLength)) {
+			fprintf(stderr, "%s track %d sample %d: DTS "LLU"/"LLU" size %d/%d\n", st->pass, track, sample_num, ref->DTS, samp->DTS, ref->dataLength, samp->dataLength);
+			st->nb_errors++;
+		}
+		gf_isom_sample_del(&ref);
+	}
+	st->seen[track-1][sample_num-1]++;
+	gf_mx_v(st->mx);
+	return GF_OK;
+}
+
+static void check_all_seen(SampleIterTest *st)
+{
+	u32 i, j;
+	for (i=0; i<gf_isom_get_track_count(st->ref); i++) {
+		for (j=0; j<gf_isom_get_sample_count(st->ref, i+1); j++) {
+			if (st->seen[i][j] != 1) {
+				fprintf(stderr, "%s track %d sample %d: returned %d times\n", st->pass, i+1, j+1, st->seen[i][j]);
+				st->nb_errors++;
+			}
+			st->seen[i][j] = 0;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	GF_ISOFile *file;
+	GF_ISOSampleIterator *it;
+	GF_ISOSample *samp;
+	GF_Err e;
+	SampleIterTest st;
+	u32 i, nb_tracks, track, sample_num, di, nb_threads = 4;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: sampleiter file.mp4 [nb_threads]\n");
+		return 1;
+	}
+	if (argc > 2) nb_threads = atoi(argv[2]);
+
+	gf_sys_init(GF_MemTrackerNone);
+	memset(&st, 0, sizeof(SampleIterTest));
+	file = gf_isom_open(argv[1], GF_ISOM_OPEN_READ, NULL);
+	st.ref = gf_isom_open(argv[1], GF_ISOM_OPEN_READ, NULL);
+	if (!file || !st.ref) {
+		fprintf(stderr, "Cannot open %s: %s\n", argv[1], gf_error_to_string(gf_isom_last_error(NULL)));
+		if (file) gf_isom_close(file);
+		if (st.ref) gf_isom_close(st.ref);
+		gf_sys_close();
+		return 1;
+	}
+	st.mx = gf_mx_new("SampleIterTest");
+	nb_tracks = gf_isom_get_track_count(st.ref);
+	st.seen = (u32 **) gf_malloc(sizeof(u32 *) * nb_tracks);
+	for (i=0; i<nb_tracks; i++) {
+		u32 count = gf_isom_get_sample_count(st.ref, i+1);
+		st.seen[i] = (u32 *) gf_malloc(sizeof(u32) * (count+1));
+		memset(st.seen[i], 0, sizeof(u32) * (count+1));
+	}
+
+	st.pass = "next";
+	it = gf_isom_sample_iterator_new(file, NULL, 0, 0);
+	if (!it) {
+		fprintf(stderr, "Cannot create sample iterator\n");
+		st.nb_errors++;
+	} else {
+		while ((e = gf_isom_sample_iterator_next(it, &track, &sample_num, &di, &samp)) == GF_OK) {
+			check_sample(&st, track, sample_num, di, samp);
+			gf_isom_sample_del(&samp);
+		}
+		if (e != GF_EOS) {
+			fprintf(stderr, "%s: iteration failed: %s\n", st.pass, gf_error_to_string(e));
+			st.nb_errors++;
+		}
+		gf_isom_sample_iterator_del(it);
+		check_all_seen(&st);
+	}
+
+	st.pass = "process";
+	it = gf_isom_sample_iterator_new(file, NULL, 0, 0);
+	if (!it) {
+		fprintf(stderr, "Cannot create sample iterator\n");
+		st.nb_errors++;
+	} else {
+		e = gf_isom_sample_iterator_process(it, nb_threads, check_sample, &st);
+		if (e) {
+			fprintf(stderr, "%s: processing failed: %s\n", st.pass, gf_error_to_string(e));
+			st.nb_errors++;
+		}
+		gf_isom_sample_iterator_del(it);
+		check_all_seen(&st);
+	}
+
+	fprintf(stdout, "%s: %d tracks checked - %d errors\n", argv[1], nb_tracks, st.nb_errors);
+	for (i=0; i<nb_tracks; i++) gf_free(st.seen[i]);
+	gf_free(st.seen);
+	gf_mx_del(st.mx);
+	gf_isom_close(file);
+	gf_isom_close(st.ref);
+	gf_sys_close();
+	return st.nb_errors ? 1 : 0;
+}
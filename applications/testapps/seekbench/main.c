@@ -0,0 +1,95 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / ISO random sample access benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/tools.h>
+#include <gpac/isomedia.h>
+
+/*performs nb_seeks random sample info fetches on the given track, returns a checksum of the sample properties*/
+static u64 random_seeks(GF_ISOFile *file, u32 track, u32 nb_seeks, u64 *time_us)
+{
+	u32 i, count, di;
+	u64 data_offset, crc = 0;
+	u64 start = gf_sys_clock_high_res();
+
+	count = gf_isom_get_sample_count(file, track);
+	gf_rand_init(GF_TRUE);
+	for (i=0; i<nb_seeks; i++) {
+		u32 num = 1 + gf_rand() % count;
+		GF_ISOSample *samp = gf_isom_get_sample_info(file, track, num, &di, &data_offset);
+		if (!samp) {
+			fprintf(stderr, "Failed to fetch sample %d of track %d\n", num, track);
+			continue;
+		}
+		crc += samp->DTS + samp->CTS_Offset + samp->dataLength + samp->IsRAP + di + data_offset;
+		gf_isom_sample_del(&samp);
+	}
+	*time_us = gf_sys_clock_high_res() - start;
+	return crc;
+}
+
+int main(int argc, char **argv)
+{
+	u32 i, nb_seeks = 100000;
+	GF_ISOFile *file;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: seekbench file.mp4 [nb_seeks]\n");
+		return 1;
+	}
+	if (argc > 2) nb_seeks = atoi(argv[2]);
+
+	gf_sys_init(GF_MemTrackerNone);
+	file = gf_isom_open(argv[1], GF_ISOM_OPEN_READ, NULL);
+	if (!file) {
+		fprintf(stderr, "Cannot open %s: %s\n", argv[1], gf_error_to_string(gf_isom_last_error(NULL)) );
+		gf_sys_close();
+		return 1;
+	}
+
+	for (i=0; i<gf_isom_get_track_count(file); i++) {
+		u64 t_tables, t_index, build_start, t_build;
+		u64 crc_tables, crc_index;
+		u32 count = gf_isom_get_sample_count(file, i+1);
+		if (!count) continue;
+
+		crc_tables = random_seeks(file, i+1, nb_seeks, &t_tables);
+
+		gf_isom_enable_sample_index(file, i+1, GF_TRUE);
+		//first access builds the index
+		build_start = gf_sys_clock_high_res();
+		gf_isom_get_sample_dts(file, i+1, 1);
+		t_build = gf_sys_clock_high_res() - build_start;
+		crc_index = random_seeks(file, i+1, nb_seeks, &t_index);
+		gf_isom_enable_sample_index(file, i+1, GF_FALSE);
+
+		fprintf(stdout, "Track %d - %d samples - %d random seeks\n", i+1, count, nb_seeks);
+		fprintf(stdout, "\tsample tables: %.2f seeks/s\n", ((Double) nb_seeks) * 1000000 / (t_tables ? t_tables : 1));
+		fprintf(stdout, "\tsample index: %.2f seeks/s (index built in "LLU" us)\n", ((Double) nb_seeks) * 1000000 / (t_index ? t_index : 1), t_build);
+		if (crc_tables != crc_index) fprintf(stdout, "\tERROR: sample index and sample tables mismatch\n");
+	}
+	gf_isom_close(file);
+	gf_sys_close();
+	return 0;
+}
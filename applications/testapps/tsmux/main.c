@@ -0,0 +1,415 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / MPEG-2 TS muxer test
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/tools.h>
+#include <gpac/mpegts.h>
+#include <gpac/constants.h>
+#include <time.h>
+
+/*muxes synthetic streams with the MPEG-2 TS muxer and checks the output. Returns 1 if a check fails*/
+
+#define TS_VIDEO_PID	101
+#define TS_MAX_PES	4096
+
+typedef struct
+{
+	GF_ESInterface ifce;
+	u32 nb_au, au_idx, au_size, au_dur;
+	/*simulated input stall (live capture) before fetching AU stall_au, in ms*/
+	u32 stall_au, stall_ms;
+	char *data;
+} SynthStream;
+
+typedef struct
+{
+	char *data;
+	u32 nb_pck, alloc_pck;
+	/*PTS (90 kHz) and reception time (us) of each PES start of the video PID*/
+	u64 pes_pts[TS_MAX_PES], pes_time[TS_MAX_PES];
+	u32 nb_pes;
+} TSOutput;
+
+static GF_Err synth_input_ctrl(GF_ESInterface *ifce, u32 act_type, void *param)
+{
+	GF_ESIPacket pck;
+	SynthStream *st = (SynthStream *)ifce->input_udta;
+
+	if (act_type != GF_ESI_INPUT_DATA_FLUSH) return GF_OK;
+	if (st->au_idx == st->nb_au) {
+		ifce->caps |= GF_ESI_STREAM_IS_OVER;
+		return GF_OK;
+	}
+	if (st->stall_ms && (st->au_idx == st->stall_au)) gf_sleep(st->stall_ms);
+
+	memset(&pck, 0, sizeof(GF_ESIPacket));
+	pck.flags = GF_ESI_DATA_AU_START | GF_ESI_DATA_AU_END | GF_ESI_DATA_HAS_CTS;
+	if (!(st->au_idx % 25)) pck.flags |= GF_ESI_DATA_AU_RAP;
+	pck.cts = pck.dts = (u64) st->au_idx * st->au_dur;
+	pck.duration = st->au_dur;
+	pck.data = st->data;
+	pck.data_len = st->au_size;
+	memset(st->data, (u8) st->au_idx, st->au_size);
+	ifce->output_ctrl(ifce, GF_ESI_OUTPUT_DATA_DISPATCH, &pck);
+	st->au_idx++;
+	return GF_OK;
+}
+
+static void synth_init(SynthStream *st, u32 nb_au, u32 au_size)
+{
+	memset(st, 0, sizeof(SynthStream));
+	st->nb_au = nb_au;
+	st->au_size = au_size;
+	st->au_dur = 3600;
+	st->data = (char *)gf_malloc(au_size);
+
+	st->ifce.stream_id = 1;
+	st->ifce.stream_type = GF_STREAM_VISUAL;
+	st->ifce.object_type_indication = GPAC_OTI_VIDEO_MPEG2_MAIN;
+	st->ifce.timescale = 90000;
+	st->ifce.bit_rate = au_size * 8 * 25;
+	st->ifce.duration = nb_au / 25.0;
+	st->ifce.input_ctrl = synth_input_ctrl;
+	st->ifce.input_udta = st;
+}
+
+static GF_M2TS_Mux *synth_mux_new(SynthStream *st, u32 mux_rate, Bool real_time)
+{
+	GF_M2TS_Mux_Program *program;
+	GF_M2TS_Mux *muxer = gf_m2ts_mux_new(mux_rate, GF_M2TS_PSI_DEFAULT_REFRESH_RATE, real_time);
+	if (!muxer) return NULL;
+	gf_m2ts_mux_set_pcr_max_interval(muxer, 40);
+	/*the initial PCR is random by default*/
+	gf_m2ts_mux_set_initial_pcr(muxer, 0);
+	program = gf_m2ts_mux_program_add(muxer, 1, 100, GF_M2TS_PSI_DEFAULT_REFRESH_RATE, 9000, GF_FALSE);
+	if (!program || !gf_m2ts_program_stream_add(program, &st->ifce, TS_VIDEO_PID, GF_TRUE, GF_FALSE)) {
+		gf_m2ts_mux_del(muxer);
+		return NULL;
+	}
+	gf_m2ts_mux_update_config(muxer, GF_TRUE);
+	return muxer;
+}
+
+/*appends packets to the output, recording the PTS of each video PES start with the current time*/
+static void ts_output_add(TSOutput *out, const char *data, u32 nb_pck, u64 now)
+{
+	u32 i;
+	if (out->nb_pck + nb_pck > out->alloc_pck) {
+		out->alloc_pck = 2 * (out->nb_pck + nb_pck);
+		out->data = (char *)gf_realloc(out->data, 188 * out->alloc_pck);
+	}
+	memcpy(out->data + 188 * out->nb_pck, data, 188 * nb_pck);
+	out->nb_pck += nb_pck;
+
+	for (i=0; i<nb_pck; i++) {
+		const u8 *pck = (const u8 *) data + 188*i;
+		u32 pid = ((pck[1] & 0x1F) << 8) | pck[2];
+		u32 offset = 4;
+		if ((pid != TS_VIDEO_PID) || !(pck[1] & 0x40)) continue;
+		if (pck[3] & 0x20) offset += 1 + pck[4];
+		if ((offset + 14 > 188) || pck[offset] || pck[offset+1] || (pck[offset+2] != 1) || !(pck[offset+7] & 0x80)) continue;
+		if (out->nb_pes == TS_MAX_PES) continue;
+		out->pes_pts[out->nb_pes] = ((u64) (pck[offset+9] & 0x0E) << 29) | ((u64) pck[offset+10] << 22) | ((u64) (pck[offset+11] & 0xFE) << 14)
+		                            | ((u64) pck[offset+12] << 7) | ((u64) pck[offset+13] >> 1);
+		out->pes_time[out->nb_pes] = now;
+		out->nb_pes++;
+	}
+}
+
+/*runs the muxer until end of stream, one packet or batch_size packets at a time*/
+static void synth_mux_run(GF_M2TS_Mux *muxer, u32 batch_size, TSOutput *out)
+{
+	u32 status, usec_till_next;
+	char *buffer = (char *)gf_malloc(188 * batch_size);
+
+	while (1) {
+		u32 nb_pck = 0;
+		usec_till_next = 0;
+		if (batch_size > 1) {
+			nb_pck = gf_m2ts_mux_process_batch(muxer, buffer, batch_size, &status, &usec_till_next);
+			if (nb_pck) ts_output_add(out, buffer, nb_pck, gf_sys_clock_high_res());
+		} else {
+			const char *pck = gf_m2ts_mux_process(muxer, &status, &usec_till_next);
+			if (pck) {
+				ts_output_add(out, pck, 1, gf_sys_clock_high_res());
+				nb_pck = 1;
+			}
+		}
+		if (status == GF_M2TS_STATE_EOS) break;
+		if (!nb_pck) gf_sleep(1);
+	}
+	gf_free(buffer);
+}
+
+static Bool check_batch_output(u32 mux_rate)
+{
+	Bool ok;
+	u32 i;
+	TSOutput out[2];
+	for (i=0; i<2; i++) {
+		SynthStream st;
+		GF_M2TS_Mux *muxer;
+		memset(&out[i], 0, sizeof(TSOutput));
+		synth_init(&st, 100, 3000);
+		muxer = synth_mux_new(&st, mux_rate, GF_FALSE);
+		if (muxer) {
+			synth_mux_run(muxer, i ? 7 : 1, &out[i]);
+			gf_m2ts_mux_del(muxer);
+		}
+		gf_free(st.data);
+	}
+	ok = (out[0].nb_pck && (out[0].nb_pck <= out[1].nb_pck) && !memcmp(out[0].data, out[1].data, 188 * out[0].nb_pck)) ? GF_TRUE : GF_FALSE;
+	/*a fixed rate muxer pads the last batch after the end of stream*/
+	for (i=out[0].nb_pck; ok && (i<out[1].nb_pck); i++) {
+		const u8 *pck = (const u8 *) out[1].data + 188*i;
+		if ((((pck[1] & 0x1F) << 8) | pck[2]) != 0x1FFF) ok = GF_FALSE;
+	}
+	fprintf(stderr, "batch %s: %d packets per packet - %d packets per batch%s\n", mux_rate ? "fixed rate" : "VBR", out[0].nb_pck, out[1].nb_pck, ok ? "" : " - MISMATCH");
+	for (i=0; i<2; i++) {
+		if (out[i].data) gf_free(out[i].data);
+	}
+	return ok;
+}
+
+/*real-time VBR muxing with an input stall: batches must neither send a PES ahead of its time nor stay late once the
+input resumes*/
+static Bool check_batch_realtime()
+{
+	u32 i;
+	s64 lag, max_lag=0, min_lag=0, max_lag_after=0;
+	Bool ok;
+	TSOutput out;
+	SynthStream st;
+	GF_M2TS_Mux *muxer;
+
+	memset(&out, 0, sizeof(TSOutput));
+	synth_init(&st, 50, 2000);
+	st.stall_au = 10;
+	st.stall_ms = 200;
+	muxer = synth_mux_new(&st, 0, GF_TRUE);
+	if (muxer) {
+		synth_mux_run(muxer, 64, &out);
+		gf_m2ts_mux_del(muxer);
+	}
+	gf_free(st.data);
+
+	/*lag of each PES output time with regard to its PTS, relative to the first PES*/
+	for (i=0; i<out.nb_pes; i++) {
+		lag = (s64) (out.pes_time[i] - out.pes_time[0]) - (s64) (out.pes_pts[i] - out.pes_pts[0]) * 100 / 9;
+		if (lag < min_lag) min_lag = lag;
+		if (lag > max_lag) max_lag = lag;
+		if ((i >= st.stall_au + 10) && (lag > max_lag_after)) max_lag_after = lag;
+	}
+	ok = ((out.nb_pes == 50) && (min_lag > -5000) && (max_lag_after < 20000)) ? GF_TRUE : GF_FALSE;
+	fprintf(stderr, "batch real-time: %d PES - lag min %d us max %d us - max lag after input stall recovery %d us%s\n", out.nb_pes,
+	        (s32) min_lag, (s32) max_lag, (s32) max_lag_after, ok ? "" : " - FAILED");
+	if (out.data) gf_free(out.data);
+	return ok;
+}
+
+/*paced UDP output of a real-time fixed rate muxer: the output rate must match the mux rate, the PCR jitter must stay within the duration
+of a datagram (packets are sent when the last one of the datagram is due), and waiting for the next datagram must not busy-loop*/
+static Bool check_sender()
+{
+	u32 status, mux_rate = 1000000;
+	s32 max_jitter;
+	u64 start;
+	clock_t cpu_start;
+	Double cpu_load = 0;
+	Bool ok;
+	SynthStream st;
+	GF_M2TS_SenderStats stats;
+	GF_M2TS_Sender *sender = NULL;
+	GF_M2TS_Mux *muxer;
+
+	memset(&stats, 0, sizeof(GF_M2TS_SenderStats));
+	synth_init(&st, 25, 3000);
+	muxer = synth_mux_new(&st, mux_rate, GF_TRUE);
+	if (muxer) sender = gf_m2ts_sender_new(muxer, "127.0.0.1", 12345, 0, NULL, 7);
+	if (sender) {
+		start = gf_sys_clock_high_res();
+		cpu_start = clock();
+		status = GF_M2TS_STATE_IDLE;
+		/*nothing listens on the port, send errors are expected*/
+		while (status != GF_M2TS_STATE_EOS) {
+			gf_m2ts_sender_process(sender, 1000, &status);
+		}
+		cpu_load = (Double) (clock() - cpu_start) / CLOCKS_PER_SEC * 1000000 / (Double) (gf_sys_clock_high_res() - start);
+		gf_m2ts_sender_get_stats(sender, &stats);
+		gf_m2ts_sender_del(sender);
+	}
+	if (muxer) gf_m2ts_mux_del(muxer);
+	gf_free(st.data);
+
+	max_jitter = (s32) (7 * 1504 * (u64) 1000000 / mux_rate) + 5000;
+	ok = (stats.nb_pcrs && (stats.bit_rate > mux_rate * 0.95) && (stats.bit_rate < mux_rate * 1.05)
+	      && (stats.pcr_jitter_min > -max_jitter) && (stats.pcr_jitter_max < max_jitter) && (cpu_load < 0.35)) ? GF_TRUE : GF_FALSE;
+	fprintf(stderr, "sender: "LLU" packets at %d bps (mux rate %d bps) - "LLU" PCRs jitter min %d us max %d us avg %d us - CPU load %.1f %%%s\n", stats.nb_packets, stats.bit_rate, mux_rate,
+	        stats.nb_pcrs, stats.pcr_jitter_min, stats.pcr_jitter_max, stats.pcr_jitter_avg, 100 * cpu_load, ok ? "" : " - FAILED");
+	return ok;
+}
+
+/*statistical multiplexing of two programs in a fixed rate mux: data sent ahead in place of padding must not push the output above the mux rate,
+ie the packets before each PCR must fit in the time elapsed since the first PCR, and no AU may be late*/
+static Bool check_statmux()
+{
+	u32 i, first_pck=0, max_pck_ahead=0, mux_rate = 1000000;
+	u64 pcr, first_pcr=0;
+	Bool has_pcr = GF_FALSE, ok;
+	TSOutput out;
+	SynthStream st[2];
+	GF_M2TS_Mux_Program *program[2];
+	GF_M2TS_Mux *muxer;
+
+	memset(&out, 0, sizeof(TSOutput));
+	synth_init(&st[0], 100, 3000);
+	synth_init(&st[1], 100, 1500);
+	muxer = gf_m2ts_mux_new(mux_rate, GF_M2TS_PSI_DEFAULT_REFRESH_RATE, GF_FALSE);
+	gf_m2ts_mux_set_pcr_max_interval(muxer, 40);
+	gf_m2ts_mux_set_initial_pcr(muxer, 0);
+	for (i=0; i<2; i++) {
+		program[i] = gf_m2ts_mux_program_add(muxer, i+1, 100 + 10*i, GF_M2TS_PSI_DEFAULT_REFRESH_RATE, 9000, GF_FALSE);
+		gf_m2ts_program_stream_add(program[i], &st[i].ifce, TS_VIDEO_PID + 10*i, GF_TRUE, GF_FALSE);
+	}
+	ok = (gf_m2ts_mux_enable_statmux(muxer, 200) == GF_OK) ? GF_TRUE : GF_FALSE;
+	gf_m2ts_mux_update_config(muxer, GF_TRUE);
+	synth_mux_run(muxer, 1, &out);
+
+	for (i=0; i<out.nb_pck; i++) {
+		const u8 *pck = (const u8 *) out.data + 188*i;
+		if (!(pck[3] & 0x20) || !pck[4] || !(pck[5] & 0x10)) continue;
+		pcr = (((u64) pck[6] << 25) | ((u64) pck[7] << 17) | ((u64) pck[8] << 9) | ((u64) pck[9] << 1) | (pck[10] >> 7)) * 300 + (((pck[10] & 1) << 8) | pck[11]);
+		if (!has_pcr) {
+			has_pcr = GF_TRUE;
+			first_pcr = pcr;
+			first_pck = i;
+		} else {
+			/*packets the mux rate allows between the two PCRs*/
+			u64 nb_allowed = (pcr - first_pcr) * mux_rate / 1504 / 27000000;
+			if (i - first_pck > nb_allowed + max_pck_ahead) max_pck_ahead = (u32) (i - first_pck - nb_allowed);
+		}
+	}
+	if (!has_pcr || (max_pck_ahead > 1) || program[0]->nb_late_au || program[1]->nb_late_au || !(program[0]->nb_early_pck + program[1]->nb_early_pck)) ok = GF_FALSE;
+	fprintf(stderr, "statmux: %d packets at %d bps - %d packets ahead of the mux rate - late AUs %d/%d - packets sent early "LLU"/"LLU"%s\n", out.nb_pck, mux_rate, max_pck_ahead,
+	        program[0]->nb_late_au, program[1]->nb_late_au, program[0]->nb_early_pck, program[1]->nb_early_pck, ok ? "" : " - FAILED");
+
+	gf_m2ts_mux_del(muxer);
+	for (i=0; i<2; i++) gf_free(st[i].data);
+	if (out.data) gf_free(out.data);
+	return ok;
+}
+
+#ifdef __GLIBC__
+/*allocation failure injection: while armed, allocations larger than fail_alloc_above fail*/
+extern void *__libc_malloc(size_t size);
+static size_t fail_alloc_above = 0;
+static u32 nb_failed_alloc = 0;
+
+GF_EXPORT
+void *malloc(size_t size)
+{
+	if (fail_alloc_above && (size > fail_alloc_above)) {
+		nb_failed_alloc++;
+		return NULL;
+	}
+	return __libc_malloc(size);
+}
+#endif
+
+/*stream creation must fail cleanly when the packet queue of the stream cannot be allocated, leaving the program untouched*/
+static Bool check_queue_alloc()
+{
+#ifdef __GLIBC__
+	Bool ok, add_failed;
+	TSOutput out;
+	SynthStream st;
+	GF_M2TS_Mux_Stream *stream;
+	GF_M2TS_Mux_Program *program;
+	GF_M2TS_Mux *muxer;
+
+	memset(&out, 0, sizeof(TSOutput));
+	synth_init(&st, 25, 3000);
+	muxer = gf_m2ts_mux_new(2000000, GF_M2TS_PSI_DEFAULT_REFRESH_RATE, GF_FALSE);
+	gf_m2ts_mux_set_initial_pcr(muxer, 0);
+	program = gf_m2ts_mux_program_add(muxer, 1, 100, GF_M2TS_PSI_DEFAULT_REFRESH_RATE, 9000, GF_FALSE);
+
+	/*the packet queue is the only allocation of stream creation larger than the stream itself*/
+	fail_alloc_above = sizeof(GF_M2TS_Mux_Stream);
+	stream = gf_m2ts_program_stream_add(program, &st.ifce, TS_VIDEO_PID, GF_TRUE, GF_FALSE);
+	fail_alloc_above = 0;
+	add_failed = stream ? GF_FALSE : GF_TRUE;
+	ok = (add_failed && nb_failed_alloc && !program->streams) ? GF_TRUE : GF_FALSE;
+
+	/*the program is still usable*/
+	if (ok) {
+		stream = gf_m2ts_program_stream_add(program, &st.ifce, TS_VIDEO_PID, GF_TRUE, GF_FALSE);
+		if (stream) {
+			gf_m2ts_mux_update_config(muxer, GF_TRUE);
+			synth_mux_run(muxer, 1, &out);
+		}
+		if (!stream || !out.nb_pes) ok = GF_FALSE;
+	}
+	fprintf(stderr, "queue allocation: %d allocations failed - stream creation %s - %d PES muxed after retry%s\n", nb_failed_alloc,
+	        add_failed ? "failed" : "succeeded", out.nb_pes, ok ? "" : " - FAILED");
+
+	gf_m2ts_mux_del(muxer);
+	gf_free(st.data);
+	if (out.data) gf_free(out.data);
+	return ok;
+#else
+	fprintf(stderr, "queue allocation: allocation failure injection not supported on this platform - skipped\n");
+	return GF_TRUE;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	Bool ok = GF_TRUE;
+	const char *mode = (argc > 1) ? argv[1] : "";
+
+	if (strcmp(mode, "batch") && strcmp(mode, "sender") && strcmp(mode, "statmux") && strcmp(mode, "queue")) {
+		fprintf(stderr, "usage: tsmux batch|sender|statmux|queue\n");
+		return 1;
+	}
+	gf_sys_init(GF_MemTrackerNone);
+	gf_log_set_tool_level(GF_LOG_ALL, GF_LOG_WARNING);
+
+	if (!strcmp(mode, "batch")) {
+		if (!check_batch_output(0)) ok = GF_FALSE;
+		if (!check_batch_output(2000000)) ok = GF_FALSE;
+		if (!check_batch_realtime()) ok = GF_FALSE;
+	}
+	else if (!strcmp(mode, "sender")) {
+		if (!check_sender()) ok = GF_FALSE;
+	}
+	else if (!strcmp(mode, "statmux")) {
+		if (!check_statmux()) ok = GF_FALSE;
+	}
+	else if (!strcmp(mode, "queue")) {
+		if (!check_queue_alloc()) ok = GF_FALSE;
+	}
+
+	gf_sys_close();
+	return ok ? 0 : 1;
+}
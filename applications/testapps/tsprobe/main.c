@@ -0,0 +1,296 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / MPEG-2 TS PID probe
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/mpegts.h>
+
+static void on_m2ts_event(GF_M2TS_Demuxer *ts, u32 evt_type, void *par)
+{
+}
+
+static const char *get_pid_program(GF_M2TS_Demuxer *ts, u32 pid, u32 *prog_num)
+{
+	u32 i, j;
+	for (i=0; i<gf_list_count(ts->programs); i++) {
+		GF_M2TS_Program *prog = (GF_M2TS_Program *)gf_list_get(ts->programs, i);
+		*prog_num = prog->number;
+		if (prog->pmt_pid == pid) return "PMT";
+		for (j=0; j<gf_list_count(prog->streams); j++) {
+			GF_M2TS_ES *es = (GF_M2TS_ES *)gf_list_get(prog->streams, j);
+			if (es->pid == pid) return gf_m2ts_get_stream_name(es->stream_type);
+		}
+		if (prog->pcr_pid == pid) return "PCR";
+	}
+	*prog_num = 0;
+	switch (pid) {
+	case GF_M2TS_PID_PAT:
+		return "PAT";
+	case GF_M2TS_PID_CAT:
+		return "CAT";
+	case GF_M2TS_PID_NIT_ST:
+		return "NIT";
+	case GF_M2TS_PID_SDT_BAT_ST:
+		return "SDT/BAT";
+	case GF_M2TS_PID_EIT_ST_CIT:
+		return "EIT";
+	case GF_M2TS_PID_TDT_TOT_ST:
+		return "TDT/TOT";
+	case 0x1FFF:
+		return "NULL";
+	}
+	return "unknown";
+}
+
+/*builds the random access index of the file and stores it next to it*/
+static GF_Err build_index(const char *name)
+{
+	u32 i;
+	u64 start, now;
+	char szIdx[GF_MAX_PATH];
+	GF_M2TS_Index *index;
+	GF_Err e;
+
+	start = gf_sys_clock_high_res();
+	e = gf_m2ts_index_build(name, 500, &index);
+	now = gf_sys_clock_high_res() - start;
+	if (e) return e;
+
+	sprintf(szIdx, "%s.tsidx", name);
+	e = gf_m2ts_index_save(index, szIdx);
+	if (!e) {
+		fprintf(stdout, "%s: index built in "LLU" ms and saved to %s\n", name, now/1000, szIdx);
+		for (i=0; i<gf_list_count(index->programs); i++) {
+			GF_M2TS_IndexProgram *prog = (GF_M2TS_IndexProgram *)gf_list_get(index->programs, i);
+			fprintf(stdout, "Program %d: PCR PID %d - %d PCRs - duration %.3f s\n", prog->number, prog->pcr_pid, prog->nb_pcrs, gf_m2ts_index_get_duration(index, prog->number));
+		}
+		for (i=0; i<gf_list_count(index->streams); i++) {
+			GF_M2TS_IndexStream *st = (GF_M2TS_IndexStream *)gf_list_get(index->streams, i);
+			fprintf(stdout, "PID %d (%s): %d RAPs indexed\n", st->pid, gf_m2ts_get_stream_name(st->stream_type), st->nb_raps);
+		}
+	}
+	gf_m2ts_index_del(index);
+	return e;
+}
+
+/*checks the index sidecar of the file if any, an index built before the file was modified must not be used*/
+static void check_index(const char *name)
+{
+	u64 size;
+	char szIdx[GF_MAX_PATH];
+	GF_M2TS_Index *index;
+	FILE *f;
+
+	sprintf(szIdx, "%s.tsidx", name);
+	if (gf_m2ts_index_load(szIdx, &index) != GF_OK) return;
+	f = gf_fopen(name, "rb");
+	size = 0;
+	if (f) {
+		gf_fseek(f, 0, SEEK_END);
+		size = gf_ftell(f);
+		gf_fclose(f);
+	}
+	if (gf_m2ts_index_matches(index, size)) {
+		fprintf(stdout, "Index %s up to date\n", szIdx);
+	} else {
+		fprintf(stdout, "Index %s is stale (built for "LLU" bytes, file has "LLU" bytes) - ignored\n", szIdx, index->file_size, size);
+	}
+	gf_m2ts_index_del(index);
+}
+
+/*per-PID PES and PCR counts of a demux pass*/
+typedef struct
+{
+	u32 nb_pes[GF_M2TS_MAX_STREAMS], pes_crc[GF_M2TS_MAX_STREAMS], nb_pcr[GF_M2TS_MAX_STREAMS];
+	u32 nb_pmt;
+} DemuxStats;
+
+static void on_filter_event(GF_M2TS_Demuxer *ts, u32 evt_type, void *par)
+{
+	u32 i;
+	GF_M2TS_PES_PCK *pck;
+	GF_M2TS_Program *prog;
+	DemuxStats *stats = (DemuxStats *)ts->user;
+
+	switch (evt_type) {
+	case GF_M2TS_EVT_PMT_FOUND:
+		prog = (GF_M2TS_Program *)par;
+		stats->nb_pmt++;
+		for (i=0; i<gf_list_count(prog->streams); i++) {
+			GF_M2TS_ES *es = (GF_M2TS_ES *)gf_list_get(prog->streams, i);
+			if (!(es->flags & GF_M2TS_ES_IS_SECTION)) gf_m2ts_set_pes_framing((GF_M2TS_PES *)es, GF_M2TS_PES_FRAMING_DEFAULT);
+		}
+		break;
+	case GF_M2TS_EVT_PES_PCK:
+		pck = (GF_M2TS_PES_PCK *)par;
+		stats->nb_pes[pck->stream->pid]++;
+		stats->pes_crc[pck->stream->pid] = 31 * stats->pes_crc[pck->stream->pid] + gf_crc_32(pck->data, pck->data_len);
+		break;
+	case GF_M2TS_EVT_PES_PCR:
+		pck = (GF_M2TS_PES_PCK *)par;
+		stats->nb_pcr[pck->stream->pid]++;
+		break;
+	}
+}
+
+/*demuxes the whole file with the filter set up on the demuxer*/
+static GF_Err demux_file(GF_M2TS_Demuxer *ts, const char *name, DemuxStats *stats)
+{
+	char data[188*64];
+	u32 size;
+	FILE *src = gf_fopen(name, "rb");
+	if (!src) return GF_URL_ERROR;
+
+	memset(stats, 0, sizeof(DemuxStats));
+	ts->user = stats;
+	ts->on_event = on_filter_event;
+	while ((size = (u32) fread(data, 1, sizeof(data), src)) > 0) {
+		gf_m2ts_process_data(ts, data, size);
+	}
+	gf_fclose(src);
+	return GF_OK;
+}
+
+/*checks the PID filter and the PCR-only mode against a full demux of the file: kept PIDs must give the same PES data and PCRs,
+dropped PIDs nothing, and programs must still be found. Returns 1 if a check fails*/
+static int check_filter(const char *name)
+{
+	u32 i, pcr_pid, pes_pid, pids[2];
+	Bool ok = GF_TRUE;
+	DemuxStats *ref, *res;
+	GF_M2TS_Demuxer *ts;
+
+	GF_SAFEALLOC(ref, DemuxStats);
+	GF_SAFEALLOC(res, DemuxStats);
+	ts = gf_m2ts_demux_new();
+	demux_file(ts, name, ref);
+	gf_m2ts_demux_del(ts);
+
+	/*PCR PID and another PES PID of the file*/
+	pcr_pid = pes_pid = 0;
+	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+		if (ref->nb_pcr[i] && !pcr_pid) pcr_pid = i;
+		else if (ref->nb_pes[i] && !pes_pid) pes_pid = i;
+	}
+	if (!pcr_pid || !ref->nb_pes[pcr_pid] || !pes_pid) {
+		fprintf(stderr, "%s: no PCR PID with PES data and other PES PID found\n", name);
+		ok = GF_FALSE;
+	}
+
+	/*whitelist: only the PCR PID is demuxed*/
+	if (ok) {
+		ts = gf_m2ts_demux_new();
+		pids[0] = pcr_pid;
+		if (gf_m2ts_demux_set_pid_filter(ts, pids, 1, GF_TRUE) != GF_OK) ok = GF_FALSE;
+		/*an invalid PID list is refused and keeps the current filter*/
+		pids[0] = pes_pid;
+		pids[1] = GF_M2TS_MAX_STREAMS;
+		if (gf_m2ts_demux_set_pid_filter(ts, pids, 2, GF_TRUE) != GF_BAD_PARAM) ok = GF_FALSE;
+		demux_file(ts, name, res);
+		gf_m2ts_demux_del(ts);
+		if ((res->nb_pmt != ref->nb_pmt) || (res->nb_pes[pcr_pid] != ref->nb_pes[pcr_pid]) || (res->pes_crc[pcr_pid] != ref->pes_crc[pcr_pid])
+		        || (res->nb_pcr[pcr_pid] != ref->nb_pcr[pcr_pid]) || res->nb_pes[pes_pid]) ok = GF_FALSE;
+		fprintf(stderr, "PID filter: whitelist PID %d - %d/%d PES - PID %d %d PES%s\n", pcr_pid, res->nb_pes[pcr_pid], ref->nb_pes[pcr_pid], pes_pid, res->nb_pes[pes_pid], ok ? "" : " - FAILED");
+	}
+	/*blacklist: the PCR PID is dropped, other PIDs are untouched*/
+	if (ok) {
+		ts = gf_m2ts_demux_new();
+		pids[0] = pcr_pid;
+		gf_m2ts_demux_set_pid_filter(ts, pids, 1, GF_FALSE);
+		demux_file(ts, name, res);
+		gf_m2ts_demux_del(ts);
+		if ((res->nb_pmt != ref->nb_pmt) || res->nb_pes[pcr_pid] || res->nb_pcr[pcr_pid]
+		        || (res->nb_pes[pes_pid] != ref->nb_pes[pes_pid]) || (res->pes_crc[pes_pid] != ref->pes_crc[pes_pid])) ok = GF_FALSE;
+		fprintf(stderr, "PID filter: blacklist PID %d - %d PES - PID %d %d/%d PES%s\n", pcr_pid, res->nb_pes[pcr_pid], pes_pid, res->nb_pes[pes_pid], ref->nb_pes[pes_pid], ok ? "" : " - FAILED");
+	}
+	/*PCR-only: all PCRs and no PES*/
+	if (ok) {
+		ts = gf_m2ts_demux_new();
+		gf_m2ts_demux_set_pcr_only(ts, GF_TRUE);
+		demux_file(ts, name, res);
+		gf_m2ts_demux_del(ts);
+		for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+			if (res->nb_pes[i] || (res->nb_pcr[i] != ref->nb_pcr[i])) ok = GF_FALSE;
+		}
+		if (res->nb_pmt != ref->nb_pmt) ok = GF_FALSE;
+		fprintf(stderr, "PCR only: PID %d %d/%d PCRs%s\n", pcr_pid, res->nb_pcr[pcr_pid], ref->nb_pcr[pcr_pid], ok ? "" : " - FAILED");
+	}
+
+	gf_free(ref);
+	gf_free(res);
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	u32 i, prog_num;
+	u64 start, now;
+	GF_Err e;
+	GF_M2TS_PIDStats *stats;
+	GF_M2TS_Demuxer *ts;
+
+	if ((argc < 2) || !strcmp(argv[1], "-h")) {
+		fprintf(stderr, "usage: tsprobe [-idx|-filter] file.ts\nprints programs and per-PID packet statistics of the file, and checks its index if any\n-idx: builds the random access index of the file in file.ts.tsidx\n-filter: checks the demuxer PID filter and PCR-only mode on the file\n");
+		return 1;
+	}
+	gf_sys_init(GF_MemTrackerNone);
+
+	if (!strcmp(argv[1], "-idx")) {
+		e = (argc > 2) ? build_index(argv[2]) : GF_BAD_PARAM;
+		if (e) fprintf(stderr, "Cannot index %s: %s\n", (argc > 2) ? argv[2] : "", gf_error_to_string(e));
+		gf_sys_close();
+		return e ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "-filter")) {
+		int ret = (argc > 2) ? check_filter(argv[2]) : 1;
+		gf_sys_close();
+		return ret;
+	}
+
+	GF_SAFEALLOC(stats, GF_M2TS_PIDStats);
+	ts = gf_m2ts_demux_new();
+	ts->on_event = on_m2ts_event;
+
+	start = gf_sys_clock_high_res();
+	e = gf_m2ts_probe_pids(ts, argv[1], stats);
+	now = gf_sys_clock_high_res() - start;
+
+	if (e) {
+		fprintf(stderr, "Cannot probe %s: %s\n", argv[1], gf_error_to_string(e));
+	} else {
+		fprintf(stdout, "%s: "LLU" packets of %d bytes - "LLU" bytes skipped - %d programs - probed in "LLU" ms\n", argv[1], stats->nb_packets, stats->packet_size, stats->nb_skipped_bytes, gf_list_count(ts->programs), now/1000);
+		for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+			const char *name;
+			if (!stats->pid_packets[i]) continue;
+			name = get_pid_program(ts, i, &prog_num);
+			fprintf(stdout, "PID %4d (0x%04X) program %5d %-16s "LLU" packets (%.2f %%) - %d CC errors\n", i, i, prog_num, name, stats->pid_packets[i], 100.0 * (Double) stats->pid_packets[i] / (Double) stats->nb_packets, stats->pid_cc_errors[i]);
+		}
+		check_index(argv[1]);
+	}
+
+	gf_m2ts_demux_del(ts);
+	gf_free(stats);
+	gf_sys_close();
+	return e ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Authors: Jean Le Feuvre
+ *			Copyright (c) Telecom ParisTech 2016-
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / MPEG-2 TS packet-level remultiplexer
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <gpac/mpegts.h>
+
+static void usage()
+{
+	fprintf(stderr, "usage: tsremux [options] src.ts dst.ts\n"
+	        "remultiplexes src.ts at packet level, without PES reassembly\n"
+	        "-prog N        keeps program N only, can be used several times. All programs are kept by default\n"
+	        "-map IN:OUT    outputs input PID IN as PID OUT, can be used several times\n"
+	        "-shift T       shifts PCR, PTS and DTS by T in 90 kHz (may be negative)\n");
+}
+
+int main(int argc, char **argv)
+{
+	u32 i;
+	u64 start, now, nb_in, nb_out;
+	GF_Err e = GF_OK;
+	GF_M2TS_Remux *remux;
+
+	if (argc < 3) {
+		usage();
+		return 1;
+	}
+	gf_sys_init(GF_MemTrackerNone);
+	remux = gf_m2ts_remux_new();
+
+	for (i=1; i<(u32) argc-2; i++) {
+		if (!strcmp(argv[i], "-prog") && (i+1 < (u32) argc-2)) {
+			e = gf_m2ts_remux_keep_program(remux, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-map") && (i+1 < (u32) argc-2)) {
+			u32 in_pid, out_pid;
+			if (sscanf(argv[++i], "%u:%u", &in_pid, &out_pid) != 2) e = GF_BAD_PARAM;
+			else e = gf_m2ts_remux_map_pid(remux, in_pid, out_pid);
+		} else if (!strcmp(argv[i], "-shift") && (i+1 < (u32) argc-2)) {
+			gf_m2ts_remux_set_ts_shift(remux, (s64) atof(argv[++i]));
+		} else {
+			e = GF_BAD_PARAM;
+		}
+		if (e) {
+			fprintf(stderr, "Invalid option %s\n", argv[i]);
+			usage();
+			goto exit;
+		}
+	}
+
+	start = gf_sys_clock_high_res();
+	e = gf_m2ts_remux_file(remux, argv[argc-2], argv[argc-1]);
+	now = gf_sys_clock_high_res() - start;
+	if (e) {
+		fprintf(stderr, "Cannot remux %s: %s\n", argv[argc-2], gf_error_to_string(e));
+	} else {
+		gf_m2ts_remux_get_stats(remux, &nb_in, &nb_out);
+		fprintf(stdout, "%s: "LLU" packets read - "LLU" packets written to %s in "LLU" ms\n", argv[argc-2], nb_in, nb_out, argv[argc-1], now/1000);
+	}
+
+exit:
+	gf_m2ts_remux_del(remux);
+	gf_sys_close();
+	return e ? 1 : 0;
+}
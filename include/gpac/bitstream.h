@@ -68,6 +68,16 @@ typedef struct __tag_bitstream GF_BitStream;
  *	does not write more than possible.
  */
 GF_BitStream *gf_bs_new(const char *buffer, u64 size, u32 mode);
+/*!
+ *	\brief chunked bitstream constructor
+ *
+ *	Constructs a write bitstream storing data in a list of fixed-size memory blocks. Unlike dynamic write bitstreams created with \ref gf_bs_new, written data is never reallocated nor moved when the bitstream grows.
+ *	\param block_size size in bytes of each memory block. If 0, a default size of 64 kBytes is used.
+ *	\return new bitstream object
+ *	\note The written data can be fetched block by block using \ref gf_bs_get_chunk, gathered in a single buffer using \ref gf_bs_get_content, or written to another bitstream using \ref gf_bs_transfer.
+ *	\note Seeking past the end of the written data extends it with zero bytes.
+ */
+GF_BitStream *gf_bs_new_chunked(u32 block_size);
 /*!
  *	\brief bitstream constructor from file handle
  *
@@ -392,6 +402,25 @@ u32 gf_bs_write_byte(GF_BitStream *bs, u8 byte, u32 count);
  */
 void gf_bs_set_eos_callback(GF_BitStream *bs, void (*EndOfStream)(void *par), void *par);
 
+/*!
+ *	\brief bitstream cookie
+ *
+ *	Attaches user flags to the bitstream, typically used to pass parsing options to readers of the bitstream
+ *	\param bs the target bitstream
+ *	\param cookie the cookie value to set
+ *	\return the previous cookie value
+ */
+u64 gf_bs_set_cookie(GF_BitStream *bs, u64 cookie);
+
+/*!
+ *	\brief bitstream cookie query
+ *
+ *	Gets the user flags attached to the bitstream
+ *	\param bs the target bitstream
+ *	\return the cookie value, 0 by default
+ */
+u64 gf_bs_get_cookie(GF_BitStream *bs);
+
 /*!
  *	\brief bitstream alignment
  *
@@ -420,6 +449,25 @@ u64 gf_bs_available(GF_BitStream *bs);
 	* Once this function has been called, the internal bitstream buffer is reseted.
  */
 void gf_bs_get_content(GF_BitStream *bs, char **output, u32 *outSize);
+/*!
+ *	\brief chunk count
+ *
+ *	Gets the number of memory blocks holding the data of a chunked bitstream.
+ *	\param bs the target bitstream
+ *	\return the number of blocks, 0 if the bitstream is empty or was not created with \ref gf_bs_new_chunked
+ */
+u32 gf_bs_get_chunk_count(GF_BitStream *bs);
+/*!
+ *	\brief chunk fetching
+ *
+ *	Gets a memory block of a chunked bitstream, typically to build a scatter/gather (writev) output list without copying the data.
+ *	\param bs the target bitstream
+ *	\param idx 0-based index of the block
+ *	\param size set to the number of bytes written in this block
+ *	\return the block data, or NULL if not found. The block remains owned by the bitstream and is only valid until the bitstream is modified or destroyed.
+ *	\note Pending bits of an unaligned bitstream are not part of the returned data.
+ */
+const char *gf_bs_get_chunk(GF_BitStream *bs, u32 idx, u32 *size);
 /*!
  *	\brief byte skipping
  *
@@ -31,6 +31,7 @@ extern "C" {
 #endif
 
 #include <gpac/isomedia.h>
+#include <gpac/thread.h>
 
 #ifndef GPAC_DISABLE_ISOM
 
@@ -99,6 +100,13 @@ GF_Err gf_isom_read_box_list_ex(GF_Box *parent, GF_BitStream *bs, GF_Err (*add_b
 GF_Err gf_isom_box_add_default(GF_Box *a, GF_Box *subbox);
 GF_Err gf_isom_parse_box_ex(GF_Box **outBox, GF_BitStream *bs, u32 parent_type, Bool is_root_box);
 
+/*bitstream cookie flags used while parsing boxes*/
+enum
+{
+	/*sample table arrays are not parsed, only their position is recorded - see stbl_LoadLazyTables*/
+	GF_ISOM_BS_COOKIE_LAZY_TABLES = 1,
+};
+
 #define gf_isom_full_box_init(__pre)
 
 //void gf_isom_full_box_init(GF_Box *ptr);
@@ -1210,6 +1218,7 @@ typedef struct
 	GF_ISOM_FULL_BOX
 	u32 SampleCount;
 	u8 *padbits;
+	u32 alloc_size;
 } GF_PaddingBitsBox;
 
 typedef struct
@@ -1218,6 +1227,7 @@ typedef struct
 	u32 sampleCount;
 	/*each dep type is packed on 1 byte*/
 	u8 *sample_info;
+	u32 alloc_size;
 } GF_SampleDependencyTypeBox;
 
 
@@ -1286,6 +1296,28 @@ typedef struct
 } GF_SampleAuxiliaryInfoOffsetBox;
 
 
+/*flattened view of the sample table, built on demand for random sample access (cf gf_isom_enable_sample_index)*/
+typedef struct
+{
+	/*number of samples described / allocated*/
+	u32 nb_samples, nb_alloc;
+	u64 *offsets;
+	u64 *dts;
+	u32 *sizes;
+	s32 *cts_offsets;
+	u32 *desc_indexes;
+	/*SAP type as signaled by the sync sample table*/
+	u8 *raps;
+} GF_SampleIndex;
+
+/*position of a sample table box whose parsing is deferred*/
+typedef struct
+{
+	u32 type;
+	u64 offset;
+	u64 size;
+} GF_LazyBoxInfo;
+
 typedef struct
 {
 	GF_ISOM_BOX
@@ -1323,6 +1355,14 @@ typedef struct
 	u32 currentEntryIndex;
 
 	Bool no_sync_found;
+
+	/*sample index, only used in read mode*/
+	Bool use_sample_index;
+	GF_SampleIndex *sample_index;
+
+	/*sample table boxes not yet parsed, only used in read mode*/
+	GF_LazyBoxInfo *lazy_boxes;
+	u32 nb_lazy_boxes;
 } GF_SampleTableBox;
 
 typedef struct __tag_media_info_box
@@ -1742,6 +1782,8 @@ typedef struct
 	u64 fragment_offset;
 	u32 mdat_size;
 	char *mdat;
+	/*mdat data of a fragment stored in memory mode, in chunked bitstream blocks*/
+	GF_BitStream *mdat_bs;
 
 	//temp storage of prft box
 	u32 reference_track_ID;
@@ -1828,12 +1870,14 @@ typedef struct
 	u32 first_sample_flags;
 	/*can be empty*/
 	GF_List *entries;
+	/*in read mode, all entries are allocated in this single block, freed with the box*/
+	struct __trun_entry *entries_block;
 
 	/*in write mode with data caching*/
 	GF_BitStream *cache;
 } GF_TrackFragmentRunBox;
 
-typedef struct
+typedef struct __trun_entry
 {
 	u32 Duration;
 	u32 size;
@@ -2597,6 +2641,8 @@ typedef struct {
 #define GF_ISOM_DATA_FILE_MAPPING		0x02
 /*External file object. Needs implementation*/
 #define GF_ISOM_DATA_FILE_EXTERN		0x03
+/*File object with background read-ahead, read-only mode*/
+#define GF_ISOM_DATA_FILE_READ_AHEAD		0x04
 
 /*Data Map modes*/
 enum
@@ -2613,6 +2659,12 @@ enum
 	GF_ISOM_DATA_MAP_READ_ONLY = 4,
 	/*write-only access at the end of the movie - only used for movie fragments concatenation*/
 	GF_ISOM_DATA_MAP_CAT = 5,
+	/*read-only access to the movie file using a file mapping object if supported by the platform, regular IO otherwise
+	mode is set to GF_ISOM_DATA_MAP_READ afterwards*/
+	GF_ISOM_DATA_MAP_READ_MMAP = 6,
+	/*read-only access to the movie file with background prefetching of the data following the last read
+	mode is set to GF_ISOM_DATA_MAP_READ afterwards*/
+	GF_ISOM_DATA_MAP_READ_AHEAD = 7,
 };
 
 /*this is the DataHandler structure each data handler has its own bitstream*/
@@ -2649,11 +2701,45 @@ typedef struct
 	u64 byte_pos;
 } GF_FileMappingDataMap;
 
+/*default read-ahead window size and number of windows*/
+#define GF_ISOM_READ_AHEAD_WINDOW_SIZE	1048576
+#define GF_ISOM_READ_AHEAD_WINDOWS	4
+
+/*default max size of a single read in the sample iterator*/
+#define GF_ISOM_SAMPLE_ITERATOR_READ_SIZE	1048576
+
+typedef struct
+{
+	u64 start;
+	u32 size;
+	u32 state;
+	char *data;
+} GF_ReadAheadWindow;
+
+/*read-ahead handler: a background thread loads the file windows following the last read offset
+in a fixed set of buffers*/
+typedef struct
+{
+	GF_ISOM_BASE_DATA_HANDLER
+	/*file used by the parser and by blocking reads*/
+	FILE *stream;
+	/*file used by the prefetch thread*/
+	FILE *ra_stream;
+	GF_Thread *th;
+	GF_Mutex *mx;
+	GF_Semaphore *sema;
+	volatile Bool run;
+	GF_ReadAheadWindow *windows;
+	u32 nb_windows, window_size;
+} GF_ReadAheadDataMap;
+
 GF_Err gf_isom_datamap_new(const char *location, const char *parentPath, u8 mode, GF_DataMap **outDataMap);
 void gf_isom_datamap_del(GF_DataMap *ptr);
 GF_Err gf_isom_datamap_open(GF_MediaBox *minf, u32 dataRefIndex, u8 Edit);
 void gf_isom_datamap_close(GF_MediaInformationBox *minf);
 u32 gf_isom_datamap_get_data(GF_DataMap *map, char *buffer, u32 bufferLength, u64 Offset);
+/*returns a pointer to the mapped data at the given offset, or NULL if the data map is not a file mapping or the range is not available*/
+const char *gf_isom_datamap_get_data_ref(GF_DataMap *map, u32 size, u64 offset);
 
 /*File-based data map*/
 GF_DataMap *gf_isom_fdm_new(const char *sPath, u8 mode);
@@ -2669,6 +2755,11 @@ GF_DataMap *gf_isom_fmo_new(const char *sPath, u8 mode);
 void gf_isom_fmo_del(GF_FileMappingDataMap *ptr);
 u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset);
 
+/*Read-ahead data map - window_size and nb_windows may be 0 to use default values*/
+GF_DataMap *gf_isom_rdm_new(const char *sPath, u8 mode, u32 window_size, u32 nb_windows);
+void gf_isom_rdm_del(GF_ReadAheadDataMap *ptr);
+u32 gf_isom_rdm_get_data(GF_ReadAheadDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset);
+
 #ifndef GPAC_DISABLE_ISOM_WRITE
 u64 gf_isom_datamap_get_offset(GF_DataMap *map);
 GF_Err gf_isom_datamap_add_data(GF_DataMap *ptr, char *data, u32 dataSize);
@@ -2776,6 +2867,14 @@ struct __tag_isom {
 #endif
 	GF_ProducerReferenceTimeBox *last_producer_ref_time;
 
+	/*in WRITE mode, if set, all data written to editFileMap is forwarded to this callback and the edit map is reset after each
+	flush (init segment, fragment, segment or final close), so that at most one fragment is kept on disk*/
+	gf_isom_on_block_out on_block_out;
+	void *on_block_out_usr_data;
+	/*if set, data written to the segment by gf_isom_flush_fragments and the segment marker are forwarded to this callback, see gf_isom_set_segment_chunk_callback*/
+	gf_isom_on_block_out on_segment_chunk;
+	void *on_segment_chunk_usr_data;
+
 	/*this contains ALL the root boxes excepts fragments*/
 	GF_List *TopBoxes;
 
@@ -2792,6 +2891,10 @@ GF_Err gf_isom_parse_movie_boxes(GF_ISOFile *mov, u64 *bytesMissing, Bool progre
 GF_ISOFile *gf_isom_new_movie();
 /*Movie and Track access functions*/
 GF_TrackBox *gf_isom_get_track_from_file(GF_ISOFile *the_file, u32 trackNumber);
+/*same as above but does not load the deferred sample tables of the track - only use for header and sample description queries*/
+GF_TrackBox *gf_isom_get_track_info_from_file(GF_ISOFile *the_file, u32 trackNumber);
+/*loads the deferred sample tables of the track if any*/
+GF_Err gf_isom_load_track_tables(GF_TrackBox *trak);
 GF_TrackBox *gf_isom_get_track(GF_MovieBox *moov, u32 trackNumber);
 GF_TrackBox *gf_isom_get_track_from_id(GF_MovieBox *moov, u32 trackID);
 GF_TrackBox *gf_isom_get_track_from_original_id(GF_MovieBox *moov, u32 originalID, u32 originalFile);
@@ -2817,6 +2920,7 @@ GF_Err Track_FindRef(GF_TrackBox *trak, u32 ReferenceType, GF_TrackReferenceType
 /*Time and sample*/
 GF_Err GetMediaTime(GF_TrackBox *trak, Bool force_non_empty, u64 movieTime, u64 *MediaTime, s64 *SegmentStartTime, s64 *MediaOffset, u8 *useEdit, u64 *next_edit_start_plus_one);
 GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp, u32 *sampleDescriptionIndex, Bool no_data, u64 *out_offset);
+GF_Err Media_RewriteSample(GF_MediaBox *mdia, GF_ISOSample *samp, u32 sampleNumber, u32 sampleDescIndex);
 GF_Err Media_CheckDataEntry(GF_MediaBox *mdia, u32 dataEntryIndex);
 GF_Err Media_FindSyncSample(GF_SampleTableBox *stbl, u32 searchFromTime, u32 *sampleNumber, u8 mode);
 GF_Err Media_RewriteODFrame(GF_MediaBox *mdia, GF_ISOSample *sample);
@@ -2843,6 +2947,11 @@ GF_Err stbl_GetSampleRAP(GF_SyncSampleBox *stss, u32 SampleNumber, SAPType *IsRA
 /*same as above but only look for open-gop RAPs and GDR (roll)*/
 GF_Err stbl_SearchSAPs(GF_SampleTableBox *stbl, u32 SampleNumber, SAPType *IsRAP, u32 *prevRAP, u32 *nextRAP);
 GF_Err stbl_GetSampleInfos(GF_SampleTableBox *stbl, u32 sampleNumber, u64 *offset, u32 *chunkNumber, u32 *descIndex, u8 *isEdited);
+/*returns the sample index of the table, building or extending it if needed - returns NULL if index is disabled or cannot be built*/
+GF_SampleIndex *stbl_GetSampleIndex(GF_SampleTableBox *stbl);
+void stbl_ResetSampleIndex(GF_SampleTableBox *stbl);
+/*parses the sample table boxes deferred at load time from the given bitstream*/
+GF_Err stbl_LoadLazyTables(GF_SampleTableBox *stbl, GF_BitStream *bs);
 GF_Err stbl_GetSampleShadow(GF_ShadowSyncBox *stsh, u32 *sampleNumber, u32 *syncNum);
 GF_Err stbl_GetPaddingBits(GF_PaddingBitsBox *padb, u32 SampleNumber, u8 *PadBits);
 u32 stbl_GetSampleFragmentCount(GF_SampleFragmentBox *stsf, u32 sampleNumber);
@@ -2871,6 +2980,8 @@ GF_ISOFile *gf_isom_create_movie(const char *fileName, u32 OpenMode, const char
 void gf_isom_insert_moov(GF_ISOFile *file);
 
 GF_Err WriteToFile(GF_ISOFile *movie);
+/*sends the content of the edit map to the block callback, if any, and empties the edit map*/
+GF_Err gf_isom_flush_block_out(GF_ISOFile *movie);
 GF_Err Track_SetStreamDescriptor(GF_TrackBox *trak, u32 StreamDescriptionIndex, u32 DataReferenceIndex, GF_ESD *esd, u32 *outStreamIndex);
 u8 RequestTrack(GF_MovieBox *moov, u32 TrackID);
 /*Track-Media setup*/
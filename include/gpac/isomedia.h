@@ -81,6 +81,19 @@ enum
 	GF_ISOM_WRITE_EDIT,
 	/*Opens an existing file for fragment concatenation*/
 	GF_ISOM_OPEN_CAT_FRAGMENTS,
+
+	/*flag to combine with GF_ISOM_OPEN_READ or GF_ISOM_OPEN_READ_DUMP: the file is mapped in memory if the platform
+	supports it (regular file IO is used otherwise). This avoids system calls when fetching samples and allows accessing
+	sample data without copy through gf_isom_get_sample_ref. The file shall not be modified while opened*/
+	GF_ISOM_OPEN_MMAP = 1<<8,
+	/*flag to combine with GF_ISOM_OPEN_READ or GF_ISOM_OPEN_READ_DUMP: a background thread prefetches the file data
+	following the last sample read, so that sequential sample reads are served from memory. Ignored if GF_ISOM_OPEN_MMAP is set*/
+	GF_ISOM_OPEN_READ_AHEAD = 1<<9,
+	/*flag to combine with GF_ISOM_OPEN_READ: the sample tables (sizes, offsets, timing, sync) of a track are only
+	loaded from the file when the track is first accessed. This reduces open time and memory usage for files with many
+	tracks when only some of them are used. Header queries (track ID, type, timescale, duration, sample count, sample descriptions)
+	do not load the tables*/
+	GF_ISOM_OPEN_LAZY = 1<<10,
 };
 
 /*Movie Options for file writing*/
@@ -404,6 +417,16 @@ only relies on the underlying OS fwrite/fgetc
 If movie is NULL, assigns the default write cache size for any new movie*/
 GF_Err gf_isom_set_output_buffering(GF_ISOFile *movie, u32 size);
 
+/*callback used to output the file as it is produced - block is only valid during the callback*/
+typedef GF_Err (*gf_isom_on_block_out)(void *usr_data, char *block, u32 block_size);
+
+/*sets a callback receiving the file data instead of writing it to disk. Only valid for files created in GF_ISOM_OPEN_WRITE mode,
+before gf_isom_finalize_for_fragment is called; the file may be created with a NULL fileName, in which case a temporary file is used.
+When fragmenting, the init segment, each fragment (or segment) are sent to the callback as soon as they are stored and removed from
+the temporary file, so that memory and disk usage stay bounded by the size of a fragment whatever the duration of the session.
+Fragments then use moof-relative data offsets. Pre-allocated SIDX (gf_isom_allocate_sidx) is not supported in this mode*/
+GF_Err gf_isom_set_write_callback(GF_ISOFile *movie, gf_isom_on_block_out on_block_out, void *usr_data);
+
 /********************************************************************
 				STREAMING API FUNCTIONS
 ********************************************************************/
@@ -422,6 +445,9 @@ If the movie is successfully loaded (the_file non-NULL), BytesMissing is zero
 */
 GF_Err gf_isom_open_progressive(const char *fileName, u64 start_range, u64 end_range, GF_ISOFile **the_file, u64 *BytesMissing);
 
+/*same as gf_isom_open_progressive with additional open flags - only GF_ISOM_OPEN_READ_AHEAD is currently supported, other flags are ignored*/
+GF_Err gf_isom_open_progressive_ex(const char *fileName, u64 start_range, u64 end_range, u32 open_flags, GF_ISOFile **the_file, u64 *BytesMissing);
+
 /*If requesting a sample fails with error GF_ISOM_INCOMPLETE_FILE, use this function
 to get the number of bytes missing to retrieve the sample*/
 u64 gf_isom_get_missing_bytes(GF_ISOFile *the_file, u32 trackNumber);
@@ -563,6 +589,12 @@ reads more data than available. This sets the amount of extra bytes to allocate
 NOTE: the dataLength of the sample does NOT include padding*/
 GF_Err gf_isom_set_sample_padding(GF_ISOFile *the_file, u32 trackNumber, u32 padding_bytes);
 
+/*enables or disables the sample index of the track. When enabled, all sample properties (offset, size, DTS, CTS offset, RAP)
+are flattened in memory on first access, and further random access to samples or search by time no longer browse the
+sample tables. This speeds up random access on tracks with many samples at the cost of about 30 bytes per sample.
+The index is only available for files opened in GF_ISOM_OPEN_READ mode*/
+GF_Err gf_isom_enable_sample_index(GF_ISOFile *the_file, u32 trackNumber, Bool enable);
+
 /*return a sample given its number, and set the StreamDescIndex of this sample
 this index allows to retrieve the stream description if needed (2 media in 1 track)
 return NULL if error*/
@@ -577,6 +609,38 @@ retrieved (faster)
 */
 GF_ISOSample *gf_isom_get_sample_info(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *StreamDescriptionIndex, u64 *data_offset);
 
+/*same as gf_isom_get_sample_info but also retrieves the sample payload without copy
+@StreamDescriptionIndex (optional): set to stream description index
+@sample_data: set to the sample payload in the file mapping. The payload is the sample data as stored in the file: no
+padding, NALU rewriting or other sample transformation is applied. The data shall not be modified or freed and is only
+valid until the file is closed.
+returns NULL if error - the last error is set to GF_NOT_SUPPORTED if the file was not opened with GF_ISOM_OPEN_MMAP, mapping
+failed or if the data is located in an external file*/
+GF_ISOSample *gf_isom_get_sample_ref(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *StreamDescriptionIndex, const char **sample_data);
+
+/*sample iterator reading samples of several tracks in file offset order*/
+typedef struct __isom_sample_iterator GF_ISOSampleIterator;
+
+/*creates a sample iterator over the given tracks (all tracks of the file if tracks is NULL). Samples of each track are returned
+in decoding order, samples of different tracks are interleaved following their position in the file. Samples stored contiguously
+in the file, whatever their track, are loaded in a single read of at most max_read_size bytes (0 means default size).
+returns NULL if error*/
+GF_ISOSampleIterator *gf_isom_sample_iterator_new(GF_ISOFile *the_file, const u32 *tracks, u32 nb_tracks, u32 max_read_size);
+/*destroys the iterator and any sample not yet returned*/
+void gf_isom_sample_iterator_del(GF_ISOSampleIterator *it);
+
+/*gets the next sample, as returned by gf_isom_get_sample - the sample shall be destroyed by the caller.
+returns GF_EOS once all samples have been returned*/
+GF_Err gf_isom_sample_iterator_next(GF_ISOSampleIterator *it, u32 *trackNumber, u32 *sampleNumber, u32 *StreamDescriptionIndex, GF_ISOSample **sample);
+
+/*callback for sample processing - the sample is destroyed when the callback returns. Returning an error aborts the processing*/
+typedef GF_Err (*gf_isom_on_sample)(void *usr_data, u32 trackNumber, u32 sampleNumber, u32 StreamDescriptionIndex, GF_ISOSample *sample);
+
+/*reads all remaining samples of the iterator and calls on_sample for each of them. If nb_threads is greater than 1, the calls are
+dispatched to nb_threads worker threads while the calling thread keeps reading the file: callbacks may then run concurrently and
+complete in any order, and must be thread-safe. Returns the first error encountered, GF_OK otherwise*/
+GF_Err gf_isom_sample_iterator_process(GF_ISOSampleIterator *it, u32 nb_threads, gf_isom_on_sample on_sample, void *usr_data);
+
 /*retrieves given sample DTS*/
 u64 gf_isom_get_sample_dts(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber);
 
@@ -1359,6 +1423,11 @@ GF_Err gf_isom_close_segment(GF_ISOFile *movie, s32 subsegs_per_sidx, u32 refere
 /*writes any pending fragment to file for low-latency output. shall only be used if no SIDX is used (subsegs_per_sidx<0 or flushing all fragments before calling gf_isom_close_segment)*/
 GF_Err gf_isom_flush_fragments(GF_ISOFile *movie, Bool last_segment);
 
+/*sets a callback receiving, besides the file, the data written to the segment by each gf_isom_flush_fragments (styp if any and moof+mdat of the
+flushed fragments, in a single call) and the segment marker appended by gf_isom_close_segment once all fragments are flushed. The data is sent once written
+to disk. NULL removes the callback*/
+GF_Err gf_isom_set_segment_chunk_callback(GF_ISOFile *movie, gf_isom_on_block_out on_chunk, void *usr_data);
+
 /*sets fragment prft box info, written just before the moof*/
 GF_Err gf_isom_set_fragment_reference_time(GF_ISOFile *movie, u32 reference_track_ID, u64 ntp, u64 timestamp);
 
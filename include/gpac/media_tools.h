@@ -612,12 +612,14 @@ typedef struct __gf_dash_segmenter GF_DASHSegmenter;
  *	\param profile target DASH profile, cannot be changed
  *	\param tmp_dir temp dir for file generation, OS NULL for default
  *	\param timescale timescale used to specif most of the dash timings. If 0, 1000 is used
- *	\param dasher_context_file config file used to store the context of the DASH segmenter. This allows destroying the segmenter and restarting it later on with the right DASH segquence numbers, MPD and and timing info
+ *	\param dasher_context_file config file used to store the context of the DASH segmenter. This allows destroying the segmenter and restarting it later on with the right DASH segquence numbers, MPD and and timing info.
+ The segment timelines are kept in the segmenter and only written back to this config by \ref gf_dasher_del: a context saved while the segmenter is alive has no segment timelines and
+ cannot be used to restart. Save the config after \ref gf_dasher_del, or use \ref gf_dasher_save_context or \ref gf_dasher_set_context_checkpoint to persist the context between calls to \ref gf_dasher_process
  *	\return the DASH segmenter object
 */
 GF_DASHSegmenter *gf_dasher_new(const char *mpdName, GF_DashProfile profile, const char *tmp_dir, u32 timescale, GF_Config *dasher_context_file);
 /*!
- Deletes a DASH segmenter
+ Deletes a DASH segmenter. The segment timelines are written back to the DASH context config, if any, which shall only be saved afterwards
  \param dasher the DASH segmenter object
 */
 void gf_dasher_del(GF_DASHSegmenter *dasher);
@@ -771,6 +773,24 @@ GF_Err gf_dasher_set_ast_offset(GF_DASHSegmenter *dasher, s32 ast_offset);
 */
 GF_Err gf_dasher_enable_memory_fragmenting(GF_DASHSegmenter *dasher, Bool enable);
 
+/*!
+ Enables background read-ahead of ISOBMFF input files: sample data following the current read position is prefetched by a dedicated thread
+ *	\param dasher the DASH segmenter object
+ *	\param enable Enables or disables. Default is disabled.
+ *	\return error code if any
+*/
+GF_Err gf_dasher_enable_read_ahead(GF_DASHSegmenter *dasher, Bool enable);
+
+/*!
+ Sets the number of threads used to segment representations. All representations of a period are then segmented concurrently,
+ and their MPD parts are merged in input order so that the output is the same as with a single thread. When a DASH context is used, each
+ representation works on a private copy of the context which is merged back once the period is done. Scalable representations are always segmented sequentially.
+ *	\param dasher the DASH segmenter object
+ *	\param nb_threads number of threads. 0 or 1 segments representations one after the other. Default is 0.
+ *	\return error code if any
+*/
+GF_Err gf_dasher_set_thread_count(GF_DASHSegmenter *dasher, u32 nb_threads);
+
 /*!
  Sets initial values for ISOBMFF sequence number and TFDT in movie fragments.
  *	\param dasher the DASH segmenter object
@@ -803,11 +823,60 @@ GF_Err gf_dasher_enable_utc_ref(GF_DASHSegmenter *dasher, Bool insert_utc);
 /*!
  Enables real-time generation of media segments.
  *	\param dasher the DASH segmenter object
- *	\param real_time if set, segemnts are generated in real time. Only supported for single representation (potentially multiplexed) DASH session. Default is disabled.
+ *	\param real_time if set, segemnts are generated in real time. When several representations are used, they are all segmented concurrently against the same generation clock, so that segments of all representations are available at the same time. Not supported for scalable representations. Default is disabled.
  *	\return error code if any
 */
 GF_Err gf_dasher_enable_real_time(GF_DASHSegmenter *dasher, Bool real_time);
 
+/*!
+ Callback function used in chunked output mode. It is first called without data when a segment is started, then for each chunk
+ *	\param udta user data passed to gf_dasher_enable_chunked_output
+ *	\param segment_name name of the segment file the chunk belongs to
+ *	\param data chunk data, only valid during the callback. NULL when signaling the start or the end of the segment
+ *	\param size size of the chunk data
+ *	\param segment_end set for the last call of a segment, once the segment file is complete
+ *	\return error code if any, aborting the segmentation
+*/
+typedef GF_Err (*gf_dasher_on_chunk)(void *udta, const char *segment_name, const char *data, u32 size, Bool segment_end);
+
+/*!
+ Enables low-latency chunked output of ISOBMFF segments. Each fragment (moof+mdat chunk) is written to its segment file as soon as it is
+ complete, and the MPD signals availabilityTimeOffset so that clients may request segments before they are complete. SIDX is disabled in this mode.
+ Not supported in single file (onDemand) mode.
+ *	\param dasher the DASH segmenter object
+ *	\param enable Enables or disables. Default is disabled.
+ *	\param on_chunk optional callback receiving each chunk as soon as it is written. When representations are segmented concurrently, it may be called from several threads.
+ *	\param udta user data for the callback
+ *	\return error code if any
+*/
+GF_Err gf_dasher_enable_chunked_output(GF_DASHSegmenter *dasher, Bool enable, gf_dasher_on_chunk on_chunk, void *udta);
+
+/*!
+ Saves a binary snapshot of the DASH context (segmenter state and segment timelines) of the segmenter. The snapshot is written to a temporary file then renamed, so that an interrupted save never corrupts a previous snapshot.
+ *	\param dasher the DASH segmenter object, created with a DASH context
+ *	\param file_name name of the snapshot file
+ *	\return error code if any
+*/
+GF_Err gf_dasher_save_context(GF_DASHSegmenter *dasher, const char *file_name);
+
+/*!
+ Restores a snapshot saved with \ref gf_dasher_save_context in the DASH context of the segmenter. Shall be called before the first call to \ref gf_dasher_process.
+ *	\param dasher the DASH segmenter object, created with a DASH context
+ *	\param file_name name of the snapshot file
+ *	\return error code if any, GF_NON_COMPLIANT_BITSTREAM if the file is not a DASH context snapshot or is truncated or corrupted, in which case no segment timeline is restored
+*/
+GF_Err gf_dasher_restore_context(GF_DASHSegmenter *dasher, const char *file_name);
+
+/*!
+ Enables periodic checkpoints of the DASH context. The DASH context is kept in memory between calls to \ref gf_dasher_process, and a snapshot is saved at the end
+ of \ref gf_dasher_process only if the checkpoint period has elapsed since the last one, and when the segmenter is destroyed.
+ *	\param dasher the DASH segmenter object, created with a DASH context
+ *	\param file_name name of the snapshot file, or NULL to disable checkpoints
+ *	\param checkpoint_ms minimum time in milliseconds between two checkpoints. If 0, the context is only saved when the segmenter is destroyed.
+ *	\return error code if any
+*/
+GF_Err gf_dasher_set_context_checkpoint(GF_DASHSegmenter *dasher, const char *file_name, u32 checkpoint_ms);
+
 /*!
  Sets where the  ContentProtection element is inserted in an adaptation set.
 *	\param dasher the DASH segmenter object
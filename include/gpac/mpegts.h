@@ -281,6 +281,9 @@ typedef struct __gf_dvb_tuner GF_Tuner;
 /*Maximum number of streams in a TS*/
 #define GF_M2TS_MAX_STREAMS	8192
 
+/*Maximum number of bytes kept between two input calls of the demuxer (one partial 192-byte packet)*/
+#define GF_M2TS_MAX_CARRY_SIZE	191
+
 /*Maximum number of service in a TS*/
 #define GF_M2TS_MAX_SERVICES	65535
 
@@ -301,11 +304,55 @@ const char *gf_m2ts_get_stream_name(u32 streamType);
 /*returns 1 if file is an MPEG-2 TS */
 Bool gf_m2ts_probe_file(const char *fileName);
 
+/*validates size bytes of TS packets of pck_size bytes (188 or 192), data pointing to the sync byte of the first packet, and stores
+the PID of each packet in pids, which must hold at least size/pck_size entries. Returns the number of packets found, stopping
+at the first packet without sync byte*/
+u32 gf_m2ts_get_packet_pids(const char *data, u32 size, u32 pck_size, u16 *pids);
+
+/*PID statistics of a TS file*/
+typedef struct
+{
+	/*number of packets per PID*/
+	u64 pid_packets[GF_M2TS_MAX_STREAMS];
+	/*number of continuity counter errors per PID, jumps signaled by the discontinuity_indicator not being counted*/
+	u32 pid_cc_errors[GF_M2TS_MAX_STREAMS];
+	/*total number of packets*/
+	u64 nb_packets;
+	/*number of bytes skipped while looking for packet sync*/
+	u64 nb_skipped_bytes;
+	/*packet size found, 188 or 192*/
+	u32 packet_size;
+} GF_M2TS_PIDStats;
+
+/*scans the whole file and gathers PID statistics without parsing packet payloads. If ts is not NULL, the packets of PSI/SI PIDs
+and of PMTs are processed by the demuxer, which signals programs and streams through its usual events while no PES is parsed*/
+GF_Err gf_m2ts_probe_pids(GF_M2TS_Demuxer *ts, const char *fileName, GF_M2TS_PIDStats *stats);
+
 /*shifts all timing by the given value
 @is_pes: array of GF_M2TS_MAX_STREAMS u8 set to 1 for PES PIDs to be restamped
 */
 GF_Err gf_m2ts_restamp(char *buffer, u32 size, s64 ts_shift, u8 *is_pes);
 
+/*packet-level TS remultiplexer: TS packets are copied as is, except for PID remapping and PCR/PTS/DTS shifting
+(see gf_m2ts_restamp). PAT and PMTs are regenerated for the kept programs with remapped PIDs, keeping their descriptors.
+PES are never reassembled*/
+typedef struct __tag_m2ts_remux GF_M2TS_Remux;
+
+GF_M2TS_Remux *gf_m2ts_remux_new();
+void gf_m2ts_remux_del(GF_M2TS_Remux *remux);
+/*sets the output PID of the given input PID (PMT, PCR or elementary stream PID). Input PIDs are kept as is by default. Fails with
+GF_BAD_PARAM if out_pid is an SI PID or is already the output PID of another mapped input PID. An output PID also used by an unmapped
+input PID of the file can only be detected once the file PIDs are known: gf_m2ts_remux_file then fails with GF_BAD_PARAM*/
+GF_Err gf_m2ts_remux_map_pid(GF_M2TS_Remux *remux, u32 in_pid, u32 out_pid);
+/*only keeps the given program, may be called for several programs. All programs are kept by default*/
+GF_Err gf_m2ts_remux_keep_program(GF_M2TS_Remux *remux, u32 program_number);
+/*shifts all PCR, PTS and DTS by ts_shift, in 90 kHz*/
+void gf_m2ts_remux_set_ts_shift(GF_M2TS_Remux *remux, s64 ts_shift);
+/*remultiplexes the src file into dst, always written with 188-byte packets*/
+GF_Err gf_m2ts_remux_file(GF_M2TS_Remux *remux, const char *src, const char *dst);
+/*gets the number of packets read and written by the last gf_m2ts_remux_file*/
+void gf_m2ts_remux_get_stats(GF_M2TS_Remux *remux, u64 *nb_packets_in, u64 *nb_packets_out);
+
 /*PES data framing modes*/
 enum
 {
@@ -939,9 +986,9 @@ struct tag_m2ts_demux
 	/*private user data*/
 	void *user;
 
-	/*private resync buffer*/
-	char *buffer;
-	u32 buffer_size, alloc_size;
+	/*private resync buffer, holding the partial packet left by the previous input call*/
+	char buffer[2*GF_M2TS_MAX_CARRY_SIZE+2];
+	u32 buffer_size;
 	/*default transport PID filters*/
 	GF_M2TS_SectionFilter *pat, *cat, *nit, *sdt, *eit, *tdt_tot;
 
@@ -986,6 +1033,17 @@ struct tag_m2ts_demux
 	u64 nb_pck_at_pcr;
 
 	Bool paused;
+
+	/*PES worker threads, see gf_m2ts_demux_set_threads*/
+	struct __m2ts_pes_workers *pes_workers;
+
+	/*bitmap of GF_M2TS_MAX_STREAMS bits, a bit set means packets of the PID are dropped - see gf_m2ts_demux_set_pid_filter*/
+	u32 *pid_filter;
+	/*only sections and PCRs are processed, see gf_m2ts_demux_set_pcr_only*/
+	Bool pcr_only;
+
+	/*random access index of the file, not owned by the demuxer - see gf_m2ts_demux_set_index*/
+	struct __tag_m2ts_index *index;
 };
 
 GF_M2TS_Demuxer *gf_m2ts_demux_new();
@@ -997,6 +1055,16 @@ GF_Err gf_m2ts_set_pes_framing(GF_M2TS_PES *pes, u32 mode);
 u32 gf_m2ts_pes_get_framing_mode(GF_M2TS_PES *pes);
 void gf_m2ts_es_del(GF_M2TS_ES *es, GF_M2TS_Demuxer *ts);
 GF_Err gf_m2ts_process_data(GF_M2TS_Demuxer *ts, char *data, u32 data_size);
+
+/*input buffer for gf_m2ts_process_data_list*/
+typedef struct
+{
+	char *data;
+	u32 size;
+} GF_M2TS_InputBuffer;
+/*processes a list of input buffers as if they were concatenated (eg datagrams received in one batch). As with gf_m2ts_process_data,
+complete packets are processed in place and only the last partial packet is copied*/
+GF_Err gf_m2ts_process_data_list(GF_M2TS_Demuxer *ts, GF_M2TS_InputBuffer *buffers, u32 nb_buffers);
 u32 gf_dvb_get_freq_from_url(const char *channels_config_path, const char *url);
 void gf_m2ts_demux_dmscc_init(GF_M2TS_Demuxer *ts);
 
@@ -1009,6 +1077,25 @@ Bool gf_m2ts_crc32_check(char *data, u32 len);
 /*aborts parsing of the current data (typically needed when parsing done by a different thread). If force_reset_pes is set, all pending pes data is discarded*/
 void gf_m2ts_abort_parsing(GF_M2TS_Demuxer *ts, Bool force_reset_pes);
 
+/*enables threaded PES processing with nb_threads workers, 0 or 1 disables it. PID routing, PCR and section parsing stay on the thread calling
+gf_m2ts_process_data, while PES reassembly and reframing are done by the workers, each PID being always handled by the same worker.
+PES events are then sent from the worker threads, and the event callback must be thread-safe. From a worker thread, gf_m2ts_set_pes_framing and
+gf_m2ts_flush_pes only apply to the PIDs processed by this worker (the PID of the event), gf_m2ts_abort_parsing resets PES data once all workers
+are synced, and gf_m2ts_es_del, gf_m2ts_reset_parsers_for_program and gf_m2ts_demux_set_pcr_only are refused*/
+GF_Err gf_m2ts_demux_set_threads(GF_M2TS_Demuxer *ts, u32 nb_threads);
+/*waits until all PES packets queued to the workers are processed. This is done automatically when streams are added, removed or reset.
+Does nothing if called from a worker thread (eg in an event callback), since workers may still be processing packets*/
+void gf_m2ts_demux_sync_workers(GF_M2TS_Demuxer *ts);
+
+/*sets the PIDs processed by the demuxer. If is_whitelist is set, only packets of the given PIDs are processed, otherwise packets
+of the given PIDs are dropped. Dropped packets are discarded right after reading their PID, before any adaptation field or payload
+parsing. PAT, CAT and PMT packets are never dropped. Calling with no PIDs and is_whitelist not set removes the filter.
+Returns GF_BAD_PARAM if a PID is not below GF_M2TS_MAX_STREAMS, in which case the current filter is kept*/
+GF_Err gf_m2ts_demux_set_pid_filter(GF_M2TS_Demuxer *ts, const u32 *pids, u32 nb_pids, Bool is_whitelist);
+/*enables PCR-only mode: PES packets are neither buffered nor reframed, only sections (PSI/SI, SCTE-35, ...) and PCRs
+(GF_M2TS_EVT_PES_PCR events) are processed. PES packets without PCR are dropped before adaptation field parsing*/
+void gf_m2ts_demux_set_pcr_only(GF_M2TS_Demuxer *ts, Bool pcr_only);
+
 
 typedef struct
 {
@@ -1063,6 +1150,69 @@ void gf_m2ts_print_info(GF_M2TS_Demuxer *ts);
 */
 GF_Err gf_m2ts_demux_file(GF_M2TS_Demuxer *ts, const char *fileName, u64 start_byterange, u64 end_byterange, u32 refresh_type, Bool signal_end_of_stream);
 
+
+/*TS random access index entry, for a RAP of a stream*/
+typedef struct
+{
+	/*byte offset of the TS packet starting the PES carrying the RAP*/
+	u64 offset;
+	/*PTS and DTS of the RAP in 90 kHz, unwrapped from 33 bits*/
+	u64 pts, dts;
+} GF_M2TS_IndexRAP;
+
+/*TS random access index entry, for a PCR of a program*/
+typedef struct
+{
+	/*byte offset of the TS packet carrying the PCR*/
+	u64 offset;
+	/*PCR in 27 MHz, unwrapped*/
+	u64 pcr;
+} GF_M2TS_IndexPCR;
+
+typedef struct
+{
+	u32 pid, stream_type, program_number;
+	u32 nb_raps, alloc_raps;
+	GF_M2TS_IndexRAP *raps;
+} GF_M2TS_IndexStream;
+
+typedef struct
+{
+	u32 number, pcr_pid;
+	u32 nb_pcrs, alloc_pcrs;
+	GF_M2TS_IndexPCR *pcrs;
+} GF_M2TS_IndexProgram;
+
+typedef struct __tag_m2ts_index
+{
+	/*TS packet size, 188 or 192*/
+	u32 packet_size;
+	/*size of the indexed file*/
+	u64 file_size;
+	/*list of GF_M2TS_IndexProgram*/
+	GF_List *programs;
+	/*list of GF_M2TS_IndexStream*/
+	GF_List *streams;
+} GF_M2TS_Index;
+
+/*builds the random access index of a TS file in a single pass: RAPs with their PTS/DTS of each PES stream and PCRs of each program,
+with their byte offsets. RAPs less than rap_interval_ms apart from the previously indexed RAP of the same stream are skipped (0 keeps all)*/
+GF_Err gf_m2ts_index_build(const char *fileName, u32 rap_interval_ms, GF_M2TS_Index **out_index);
+/*writes/reads the index to/from a sidecar file*/
+GF_Err gf_m2ts_index_save(GF_M2TS_Index *index, const char *fileName);
+GF_Err gf_m2ts_index_load(const char *fileName, GF_M2TS_Index **out_index);
+void gf_m2ts_index_del(GF_M2TS_Index *index);
+/*checks that a loaded index was built for a file of file_size bytes and that all its offsets are within the file. A sidecar index
+is not updated when its TS file is rewritten, and must not be used if this check fails*/
+Bool gf_m2ts_index_matches(GF_M2TS_Index *index, u64 file_size);
+/*gets the duration in seconds of the program (first program if program_number is 0) from its first and last PCR*/
+Double gf_m2ts_index_get_duration(GF_M2TS_Index *index, u32 program_number);
+/*gets the byte offset of the last RAP at or before time_ms from the start of the program (first program if program_number is 0).
+RAPs are looked up on the PCR PID of the program if indexed, otherwise on the first indexed stream of the program*/
+GF_Err gf_m2ts_index_seek(GF_M2TS_Index *index, u32 program_number, u32 time_ms, u64 *offset, u64 *rap_pts);
+/*sets the index used by the demuxer when seeking in a file (gf_m2ts_demuxer_setup/play), and the duration of the file from the index*/
+void gf_m2ts_demux_set_index(GF_M2TS_Demuxer *ts, GF_M2TS_Index *index);
+
 #endif /*GPAC_DISABLE_MPEG2TS*/
 
 
@@ -1111,6 +1261,8 @@ typedef struct __m2ts_mux_pck
 	struct __m2ts_mux_pck *next;
 	char *data;
 	u32 data_len;
+	/*allocated size of data*/
+	u32 data_alloc;
 	u32 flags;
 	u64 cts, dts;
 	u32 duration;
@@ -1179,11 +1331,14 @@ typedef struct __m2ts_mux_stream {
 	struct __elementary_stream_ifce *ifce;
 	Double ts_scale;
 
-	/*packet fifo*/
-	GF_M2TS_Packet *pck_first, *pck_last;
+	/*packet fifo between the ES output and the muxer - single producer / single consumer, lock-free*/
+	struct __m2ts_pck_queue *pck_queue;
 	/*packet reassembler (PES packets are most of the time full frames)*/
 	GF_M2TS_Packet *pck_reassembler;
-	GF_Mutex *mx;
+	Bool has_reassembled_data;
+	/*payload of curr_pck if it comes from the packet fifo, recycled once sent*/
+	char *queue_data;
+	u32 queue_data_alloc;
 	/*avg bitrate compute*/
 	u64 last_br_time;
 	u32 bytes_since_last_time, pes_since_last_time;
@@ -1243,6 +1398,22 @@ struct __m2ts_mux_program {
 	Bool mpeg4_signaling_for_scene_only;
 
 	char *name, *provider;
+
+	/*occupancy metrics, updated every second of multiplex in fixed rate mode*/
+	u64 nb_pck_sent;
+	u32 pck_sent_over_window;
+	/*share of the multiplex packets used by the program over the last second, in percent*/
+	u32 occupancy;
+	/*rate sent over the last second, in kbps*/
+	u32 rate_kbps;
+	/*bytes waiting in the ES queues and current PES of the program*/
+	u32 backlog_bytes;
+	/*rate needed to send the backlog within the program PCR offset (1 second if none), in kbps*/
+	u32 demand_kbps;
+	/*access units completely sent after their deadline (scheduling time + PCR offset)*/
+	u32 nb_late_au;
+	/*packets sent ahead of their scheduling time in place of padding, with statmux enabled*/
+	u64 nb_early_pck;
 };
 
 enum
@@ -1319,6 +1490,11 @@ struct __m2ts_mux {
 	Bool flush_pes_at_rap;
 	/*cf enum above*/
 	u32 force_pat_pmt_state;
+
+	/*statistical multiplexing lookahead, 0 if disabled - see gf_m2ts_mux_enable_statmux*/
+	u32 statmux_lookahead_ms;
+	/*packets sent since the last update of the program occupancy metrics*/
+	u32 pck_sent_over_stats_window;
 };
 
 
@@ -1347,12 +1523,23 @@ void gf_m2ts_mux_update_config(GF_M2TS_Mux *mux, Bool reset_time);
 GF_M2TS_Mux_Program *gf_m2ts_mux_program_find(GF_M2TS_Mux *muxer, u32 program_number);
 
 const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status, u32 *usec_till_next);
+/*!
+ * produces up to max_packets TS packets in a row in buffer, which must be at least 188*max_packets bytes.
+ * The system clock is only queried once per call, except for real-time muxers without fixed rate where it is queried for each packet. Stops at the first call of gf_m2ts_mux_process which would return NULL.
+ * status and usec_till_next are set as by gf_m2ts_mux_process for the last packet processed.
+ * returns the number of packets written
+ */
+u32 gf_m2ts_mux_process_batch(GF_M2TS_Mux *muxer, char *buffer, u32 max_packets, u32 *status, u32 *usec_till_next);
 u32 gf_m2ts_get_sys_clock(GF_M2TS_Mux *muxer);
 u32 gf_m2ts_get_ts_clock(GF_M2TS_Mux *muxer);
 
 GF_Err gf_m2ts_mux_use_single_au_pes_mode(GF_M2TS_Mux *muxer, GF_M2TS_PackMode au_pes_mode);
 GF_Err gf_m2ts_mux_set_initial_pcr(GF_M2TS_Mux *muxer, u64 init_pcr_value);
 GF_Err gf_m2ts_mux_enable_pcr_only_packets(GF_M2TS_Mux *muxer, Bool enable_forced_pcr);
+/*enables statistical multiplexing for fixed rate muxers: the packet slots are given to the most urgent stream of all programs
+(least time left before the deadline of its current access unit, once the remaining packets are sent), and slots which would be padding
+are used to send data scheduled within the next lookahead_ms. 0 disables statmux*/
+GF_Err gf_m2ts_mux_enable_statmux(GF_M2TS_Mux *muxer, u32 lookahead_ms);
 
 /*user inteface functions*/
 GF_Err gf_m2ts_program_stream_update_ts_scale(GF_ESInterface *_self, u32 time_scale);
@@ -1360,6 +1547,32 @@ GF_Err gf_m2ts_program_stream_update_ts_scale(GF_ESInterface *_self, u32 time_sc
 void gf_m2ts_mux_program_set_name(GF_M2TS_Mux_Program *program, const char *program_name, const char *mux_provider_name);
 void gf_m2ts_mux_enable_sdt(GF_M2TS_Mux *mux, u32 refresh_rate_ms);
 
+/*UDP sender for a real-time muxer: packs TS packets in datagrams and sends each datagram when its last packet is due,
+waiting with a sleep then busy-wait loop rather than millisecond sleeps*/
+typedef struct __m2ts_sender GF_M2TS_Sender;
+
+typedef struct
+{
+	u64 nb_packets, nb_datagrams, nb_send_errors;
+	/*average output rate since the first datagram, in bits per second*/
+	u32 bit_rate;
+	/*delay between the time a datagram is due and the time it is sent, in microseconds - fixed rate muxers only*/
+	u32 send_delay_avg, send_delay_max;
+	/*PCR jitter in microseconds: variation of the difference between send time and PCR value, per PCR PID, PCR wraps being accounted for*/
+	u64 nb_pcrs;
+	s32 pcr_jitter_min, pcr_jitter_max;
+	u32 pcr_jitter_avg;
+} GF_M2TS_SenderStats;
+
+/*creates a sender for the muxer, which shall be in real-time mode. The socket is bound or joins the multicast group ip:port.
+nb_pck_per_datagram is the number of TS packets per datagram (7 if 0)*/
+GF_M2TS_Sender *gf_m2ts_sender_new(GF_M2TS_Mux *muxer, const char *ip, u16 port, u32 ttl, const char *ifce_ip, u32 nb_pck_per_datagram);
+void gf_m2ts_sender_del(GF_M2TS_Sender *sender);
+/*sends at most one datagram, waiting until it is due. If the next packet is due in more than max_wait_us, sleeps max_wait_us
+(with millisecond precision) and returns without sending, pending packets being kept for the next call. status is set as by gf_m2ts_mux_process*/
+GF_Err gf_m2ts_sender_process(GF_M2TS_Sender *sender, u32 max_wait_us, u32 *status);
+void gf_m2ts_sender_get_stats(GF_M2TS_Sender *sender, GF_M2TS_SenderStats *stats);
+
 
 #endif /*GPAC_DISABLE_MPEG2TS_MUX*/
 
@@ -394,6 +394,7 @@ GF_Err ISOR_ConnectService(GF_InputService *plug, GF_ClientService *serv, const
 
 	if (isor_is_local(szURL)) {
 		GF_Err e;
+		const char *opt;
 		u64 start_range, end_range;
 		start_range = end_range = 0;
 		if (plug->query_proxy) {
@@ -404,7 +405,12 @@ GF_Err ISOR_ConnectService(GF_InputService *plug, GF_ClientService *serv, const
 				end_range = param.url_query.end_range;
 			}
 		}
-		e = gf_isom_open_progressive(szURL, start_range, end_range, &read->mov, &read->missing_bytes);
+		opt = gf_modules_get_option((GF_BaseInterface *)plug, "ISOReader", "ReadAhead");
+		if (!opt) {
+			gf_modules_set_option((GF_BaseInterface *)plug, "ISOReader", "ReadAhead", "no");
+			opt = "no";
+		}
+		e = gf_isom_open_progressive_ex(szURL, start_range, end_range, !strcmp(opt, "yes") ? GF_ISOM_OPEN_READ_AHEAD : 0, &read->mov, &read->missing_bytes);
 		if (e != GF_OK) {
 			GF_LOG(GF_LOG_ERROR, GF_LOG_NETWORK, ("[IsoMedia] : error while opening %s, error=%s\n", szURL, gf_error_to_string(e)));
 			if (read->input->query_proxy && read->input->proxy_udta && read->input->proxy_type) {
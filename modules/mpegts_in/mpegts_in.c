@@ -94,6 +94,9 @@ typedef struct
 	Double media_start_range;
 
 	const char *force_temi_url;
+
+	/*random access index of a local file, loaded from file.ts.tsidx if present*/
+	GF_M2TS_Index *index;
 } M2TSIn;
 
 
@@ -1131,6 +1134,9 @@ static GF_Err M2TS_ConnectService(GF_InputService *plug, GF_ClientService *serv,
 	m2ts->force_temi_url = gf_modules_get_option((GF_BaseInterface *)m2ts->owner, "M2TS", "ForceTEMILocation");
 	if (m2ts->force_temi_url && !strlen(m2ts->force_temi_url)) m2ts->force_temi_url = NULL;
 
+	opt = gf_modules_get_option((GF_BaseInterface *)m2ts->owner, "M2TS", "PESThreads");
+	if (opt) gf_m2ts_demux_set_threads(m2ts->ts, atoi(opt));
+
 	opt = gf_modules_get_option((GF_BaseInterface *)m2ts->owner, "DSMCC", "Activated");
 	if (opt && !strcmp(opt, "yes")) {
 		gf_m2ts_demux_dmscc_init(m2ts->ts);
@@ -1163,6 +1169,23 @@ static GF_Err M2TS_ConnectService(GF_InputService *plug, GF_ClientService *serv,
 			m2ts->ts->run_state = 1;
 		} else {
 			e = gf_m2ts_demuxer_setup(m2ts->ts,url,0);
+			/*seek in local files through their index when available*/
+			if (!e && m2ts->ts->file) {
+				char szIdx[GF_MAX_PATH];
+				snprintf(szIdx, GF_MAX_PATH, "%s.tsidx", m2ts->ts->filename);
+				if (m2ts->index) gf_m2ts_index_del(m2ts->index);
+				m2ts->index = NULL;
+				if (gf_m2ts_index_load(szIdx, &m2ts->index) == GF_OK) {
+					if (gf_m2ts_index_matches(m2ts->index, m2ts->ts->file_size)) {
+						GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[M2TSIn] Using random access index %s\n", szIdx));
+					} else {
+						GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[M2TSIn] Random access index %s does not match the file (built for "LLU" bytes, file has "LLU" bytes) - ignoring it\n", szIdx, m2ts->index->file_size, m2ts->ts->file_size));
+						gf_m2ts_index_del(m2ts->index);
+						m2ts->index = NULL;
+					}
+				}
+				gf_m2ts_demux_set_index(m2ts->ts, m2ts->index);
+			}
 		}
 	}
 
@@ -1694,6 +1717,7 @@ void DeleteM2TSReader(void *ifce)
 
 	m2ts->network_buffer = NULL;
 	gf_m2ts_demux_del(m2ts->ts);
+	if (m2ts->index) gf_m2ts_index_del(m2ts->index);
 	gf_mx_del(m2ts->mx);
 	gf_free(m2ts);
 
@@ -179,6 +179,7 @@
 
 /* Bitstream */
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_new_chunked) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_from_file) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_del) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_read_bit) )
@@ -204,9 +205,13 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_write_double) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_write_data) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_set_eos_callback) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_set_cookie) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_cookie) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_align) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_available) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_content) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_chunk_count) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_chunk) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_skip_bytes) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_seek) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_peek_bits) )
@@ -687,6 +692,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_box_size) )
 #endif
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_open_progressive) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_open_progressive_ex) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_missing_bytes) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_is_fragmented) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_fragmented_duration) )
@@ -726,8 +732,14 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_data_reference) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_count) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_sample_padding) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_enable_sample_index) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_info) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_ref) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_iterator_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_iterator_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_iterator_next) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_iterator_process) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_flags) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_for_media_time) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_for_movie_time) )
@@ -1018,6 +1030,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_sample_cenc_group) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_composition_offset_mode) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_output_buffering) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_write_callback) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_add_sample_group_info) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_add_sample_info) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_copy_sample_info) )
@@ -1051,6 +1064,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_finalize_for_fragment) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_start_fragment) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_flush_fragments) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_segment_chunk_callback) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_fragment_reference_time) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_fragment_option) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_single_moof_mode) )
@@ -1902,6 +1916,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_new) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_del) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_process_data) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_process_data_list) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_reset_parsers) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_reset_parsers_for_program) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_es_del) )
@@ -1909,10 +1924,31 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_stream_name) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_crc32_check) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_restamp) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_map_pid) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_keep_program) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_set_ts_shift) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_file) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_remux_get_stats) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_packet_pids) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_probe_pids) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_build) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_save) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_load) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_matches) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_get_duration) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_seek) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_set_index) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_file) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_pes_get_framing_mode) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_sdt_info) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_abort_parsing) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_set_threads) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_sync_workers) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_set_pid_filter) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_set_pcr_only) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_pause_demux) )
 
 
@@ -1935,6 +1971,11 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_program_stream_update_ts_scale) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_update_config) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_process) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_process_batch) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_sender_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_sender_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_sender_process) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_sender_get_stats) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_sys_clock) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_ts_clock) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_use_single_au_pes_mode) )
@@ -1943,6 +1984,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_enable_sdt) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_program_find) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_enable_pcr_only_packets) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_enable_statmux) )
 
 #endif /*GPAC_DISABLE_MPEG2TS_MUX*/
 /* M3U8 & MPD related functions */
@@ -2024,10 +2066,16 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_set_ast_offset) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_enable_memory_fragmenting) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_set_initial_isobmf) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dasher_enable_read_ahead) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dasher_set_thread_count) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_enable_memory_fragmenting) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_configure_isobmf_default) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_enable_utc_ref) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_enable_real_time) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dasher_enable_chunked_output) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dasher_save_context) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dasher_restore_context) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dasher_set_context_checkpoint) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_set_content_protection_location_mode) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_set_profile_extension) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_dasher_add_input) )
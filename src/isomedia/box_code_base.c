@@ -3339,6 +3339,7 @@ void moof_del(GF_Box *s)
 	if (ptr->mfhd) gf_isom_box_del((GF_Box *) ptr->mfhd);
 	gf_isom_box_array_del(ptr->TrackList);
 	if (ptr->mdat) gf_free(ptr->mdat);
+	if (ptr->mdat_bs) gf_bs_del(ptr->mdat_bs);
 	gf_free(ptr);
 }
 
@@ -4631,6 +4632,8 @@ void stbl_del(GF_Box *s)
 	if (ptr->sai_sizes) gf_isom_box_array_del(ptr->sai_sizes);
 	if (ptr->sai_offsets) gf_isom_box_array_del(ptr->sai_offsets);
 
+	stbl_ResetSampleIndex(ptr);
+	if (ptr->lazy_boxes) gf_free(ptr->lazy_boxes);
 	gf_free(ptr);
 }
 
@@ -4742,14 +4745,82 @@ GF_Err stbl_AddBox(GF_SampleTableBox *ptr, GF_Box *a)
 
 
 
-GF_Err stbl_Read(GF_Box *s, GF_BitStream *bs)
+//checks if the next child box is a sample table array, and if so records its position and skips it
+static Bool stbl_DeferChild(GF_SampleTableBox *ptr, GF_BitStream *bs)
+{
+	u32 type, hdr_size;
+	u64 size, start = gf_bs_get_position(bs);
+
+	if (gf_bs_available(bs) < 8) return GF_FALSE;
+	size = gf_bs_read_u32(bs);
+	type = gf_bs_read_u32(bs);
+	hdr_size = 8;
+	if (size == 1) {
+		size = gf_bs_read_u64(bs);
+		hdr_size += 8;
+	}
+	switch (type) {
+	case GF_ISOM_BOX_TYPE_STTS:
+	case GF_ISOM_BOX_TYPE_CTTS:
+	case GF_ISOM_BOX_TYPE_STSS:
+	case GF_ISOM_BOX_TYPE_STSC:
+	case GF_ISOM_BOX_TYPE_STCO:
+	case GF_ISOM_BOX_TYPE_CO64:
+	case GF_ISOM_BOX_TYPE_STDP:
+	case GF_ISOM_BOX_TYPE_SDTP:
+		break;
+	//sample count is stored in a placeholder box
+	case GF_ISOM_BOX_TYPE_STSZ:
+	case GF_ISOM_BOX_TYPE_STZ2:
+		if (ptr->SampleSize) type = 0;
+		break;
+	default:
+		type = 0;
+		break;
+	}
+	if (!type || (size < hdr_size + 12) || (size > ptr->size) || (size > gf_bs_available(bs) + hdr_size)) {
+		gf_bs_seek(bs, start);
+		return GF_FALSE;
+	}
+
+	if ((type == GF_ISOM_BOX_TYPE_STSZ) || (type == GF_ISOM_BOX_TYPE_STZ2)) {
+		GF_SampleSizeBox *stsz = (GF_SampleSizeBox *) gf_isom_box_new(type);
+		if (!stsz) {
+			gf_bs_seek(bs, start);
+			return GF_FALSE;
+		}
+		//version and flags
+		gf_bs_read_u32(bs);
+		if (type == GF_ISOM_BOX_TYPE_STSZ) {
+			stsz->sampleSize = gf_bs_read_u32(bs);
+		} else {
+			gf_bs_read_int(bs, 24);
+			stsz->sampleSize = 0;
+		}
+		stsz->sampleCount = gf_bs_read_u32(bs);
+		stsz->size = size;
+		ptr->SampleSize = stsz;
+	}
+
+	ptr->lazy_boxes = (GF_LazyBoxInfo *)gf_realloc(ptr->lazy_boxes, sizeof(GF_LazyBoxInfo) * (ptr->nb_lazy_boxes+1));
+	ptr->lazy_boxes[ptr->nb_lazy_boxes].type = type;
+	ptr->lazy_boxes[ptr->nb_lazy_boxes].offset = start;
+	ptr->lazy_boxes[ptr->nb_lazy_boxes].size = size;
+	ptr->nb_lazy_boxes++;
+
+	gf_bs_seek(bs, start + size);
+	ptr->size -= size;
+	return GF_TRUE;
+}
+
+static GF_Err stbl_ReadChildren(GF_SampleTableBox *ptr, GF_BitStream *bs, Bool defer_tables)
 {
 	GF_Err e;
 	GF_Box *a;
-	//we need to parse DegPrior in a special way
-	GF_SampleTableBox *ptr = (GF_SampleTableBox *)s;
 
 	while (ptr->size) {
+		if (defer_tables && stbl_DeferChild(ptr, bs)) continue;
+
 		e = gf_isom_parse_box(&a, bs);
 		if (e) return e;
 		//we need to read the DegPriority in a different way...
@@ -4788,7 +4859,18 @@ GF_Err stbl_Read(GF_Box *s, GF_BitStream *bs)
 		e = stbl_AddBox(ptr, a);
 		if (e) return e;
 	}
-	if (!ptr->SyncSample)
+	return GF_OK;
+}
+
+GF_Err stbl_Read(GF_Box *s, GF_BitStream *bs)
+{
+	GF_Err e;
+	GF_SampleTableBox *ptr = (GF_SampleTableBox *)s;
+
+	e = stbl_ReadChildren(ptr, bs, (gf_bs_get_cookie(bs) & GF_ISOM_BS_COOKIE_LAZY_TABLES) ? GF_TRUE : GF_FALSE);
+	if (e) return e;
+
+	if (!ptr->SyncSample && !ptr->nb_lazy_boxes)
 		ptr->no_sync_found = 1;
 
 	ptr->nb_sgpd_in_stbl = gf_list_count(ptr->sampleGroupsDescription);
@@ -4797,6 +4879,42 @@ GF_Err stbl_Read(GF_Box *s, GF_BitStream *bs)
 	return GF_OK;
 }
 
+GF_Err stbl_LoadLazyTables(GF_SampleTableBox *ptr, GF_BitStream *bs)
+{
+	u32 i;
+	u64 pos, size;
+	GF_Err e = GF_OK;
+	if (!ptr->nb_lazy_boxes) return GF_OK;
+
+	pos = gf_bs_get_position(bs);
+	size = ptr->size;
+	for (i=0; i<ptr->nb_lazy_boxes; i++) {
+		//remove sample count placeholder
+		if ((ptr->lazy_boxes[i].type == GF_ISOM_BOX_TYPE_STSZ) || (ptr->lazy_boxes[i].type == GF_ISOM_BOX_TYPE_STZ2)) {
+			if (ptr->SampleSize) gf_isom_box_del((GF_Box *)ptr->SampleSize);
+			ptr->SampleSize = NULL;
+		}
+		e = gf_bs_seek(bs, ptr->lazy_boxes[i].offset);
+		if (e) break;
+		ptr->size = ptr->lazy_boxes[i].size;
+		e = stbl_ReadChildren(ptr, bs, GF_FALSE);
+		if (e) break;
+	}
+	ptr->size = size;
+	gf_bs_seek(bs, pos);
+
+	gf_free(ptr->lazy_boxes);
+	ptr->lazy_boxes = NULL;
+	ptr->nb_lazy_boxes = 0;
+	if (!ptr->SyncSample)
+		ptr->no_sync_found = 1;
+
+	if (e) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[iso file] Failed to load sample tables: %s\n", gf_error_to_string(e) ));
+	}
+	return e;
+}
+
 GF_Box *stbl_New()
 {
 	ISOM_DECL_BOX_ALLOC(GF_SampleTableBox, GF_ISOM_BOX_TYPE_STBL);
@@ -7076,10 +7194,15 @@ void trun_del(GF_Box *s)
 	GF_TrackFragmentRunBox *ptr = (GF_TrackFragmentRunBox *)s;
 	if (ptr == NULL) return;
 
-	while (gf_list_count(ptr->entries)) {
-		p = (GF_TrunEntry*)gf_list_get(ptr->entries, 0);
-		gf_list_rem(ptr->entries, 0);
-		gf_free(p);
+	/*entries of a parsed box are in a single block*/
+	if (ptr->entries_block) {
+		gf_free(ptr->entries_block);
+	} else {
+		while (gf_list_count(ptr->entries)) {
+			p = (GF_TrunEntry*)gf_list_last(ptr->entries);
+			gf_list_rem_last(ptr->entries);
+			gf_free(p);
+		}
 	}
 	gf_list_del(ptr->entries);
 	if (ptr->cache) gf_bs_del(ptr->cache);
@@ -7089,7 +7212,7 @@ void trun_del(GF_Box *s)
 GF_Err trun_Read(GF_Box *s, GF_BitStream *bs)
 {
 	GF_Err e;
-	u32 i;
+	u32 i, entry_size;
 	GF_TrunEntry *p;
 	GF_TrackFragmentRunBox *ptr = (GF_TrackFragmentRunBox *)s;
 
@@ -7112,12 +7235,22 @@ GF_Err trun_Read(GF_Box *s, GF_BitStream *bs)
 		ptr->size -= 4;
 	}
 
+	//allocate all entries at once rather than one by one, fragmented files may have thousands of them
+	entry_size = 0;
+	if (ptr->flags & GF_ISOM_TRUN_DURATION) entry_size += 4;
+	if (ptr->flags & GF_ISOM_TRUN_SIZE) entry_size += 4;
+	if (ptr->flags & GF_ISOM_TRUN_FLAGS) entry_size += 4;
+	if ((u64) ptr->sample_count * entry_size > ptr->size) return GF_ISOM_INVALID_FILE;
+	if (ptr->sample_count) {
+		ptr->entries_block = (GF_TrunEntry *) gf_malloc(sizeof(GF_TrunEntry) * ptr->sample_count);
+		if (!ptr->entries_block) return GF_OUT_OF_MEM;
+		memset(ptr->entries_block, 0, sizeof(GF_TrunEntry) * ptr->sample_count);
+	}
+
 	//read each entry (even though nothing may be written)
 	for (i=0; i<ptr->sample_count; i++) {
 		u32 trun_size = 0;
-		p = (GF_TrunEntry *) gf_malloc(sizeof(GF_TrunEntry));
-		if (!p) return GF_OUT_OF_MEM;
-		memset(p, 0, sizeof(GF_TrunEntry));
+		p = &ptr->entries_block[i];
 
 		if (ptr->flags & GF_ISOM_TRUN_DURATION) {
 			p->Duration = gf_bs_read_u32(bs);
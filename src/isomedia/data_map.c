@@ -45,6 +45,59 @@ GF_Err gf_isom_set_output_buffering(GF_ISOFile *movie, u32 size)
 #endif
 }
 
+GF_EXPORT
+GF_Err gf_isom_set_write_callback(GF_ISOFile *movie, gf_isom_on_block_out on_block_out, void *usr_data)
+{
+#ifndef GPAC_DISABLE_ISOM_WRITE
+	if (!movie || !movie->editFileMap) return GF_BAD_PARAM;
+	if (movie->openMode != GF_ISOM_OPEN_WRITE) return GF_ISOM_INVALID_MODE;
+	/*concatenation to an existing file cannot be streamed*/
+	if (movie->movieFileMap) return GF_NOT_SUPPORTED;
+#ifndef GPAC_DISABLE_ISOM_FRAGMENTS
+	if (movie->FragmentsFlags & GF_ISOM_FRAG_WRITE_READY) return GF_BAD_PARAM;
+#endif
+	movie->on_block_out = on_block_out;
+	movie->on_block_out_usr_data = usr_data;
+	return GF_OK;
+#else
+	return GF_NOT_SUPPORTED;
+#endif
+}
+
+#ifndef GPAC_DISABLE_ISOM_WRITE
+
+#define GF_ISOM_BLOCK_OUT_SIZE	4096
+
+GF_Err gf_isom_flush_block_out(GF_ISOFile *movie)
+{
+	char block[GF_ISOM_BLOCK_OUT_SIZE];
+	u64 size;
+	GF_BitStream *bs;
+	GF_Err e = GF_OK;
+
+	if (!movie->on_block_out || !movie->editFileMap) return GF_OK;
+	bs = movie->editFileMap->bs;
+	size = gf_bs_get_size(bs);
+	gf_bs_seek(bs, 0);
+	while (size) {
+		u32 to_read = (size > GF_ISOM_BLOCK_OUT_SIZE) ? GF_ISOM_BLOCK_OUT_SIZE : (u32) size;
+		u32 read = gf_bs_read_data(bs, block, to_read);
+		if (!read) {
+			e = GF_IO_ERR;
+			break;
+		}
+		e = movie->on_block_out(movie->on_block_out_usr_data, block, read);
+		if (e) break;
+		size -= read;
+	}
+	/*everything has been sent (or the sink failed), restart from an empty edit map*/
+	gf_bs_seek(bs, 0);
+	gf_bs_truncate(bs);
+	return e;
+}
+
+#endif /*GPAC_DISABLE_ISOM_WRITE*/
+
 void gf_isom_datamap_del(GF_DataMap *ptr)
 {
 	if (!ptr) return;
@@ -60,6 +113,9 @@ void gf_isom_datamap_del(GF_DataMap *ptr)
 	case GF_ISOM_DATA_FILE_MAPPING:
 		gf_isom_fmo_del((GF_FileMappingDataMap *)ptr);
 		break;
+	case GF_ISOM_DATA_FILE_READ_AHEAD:
+		gf_isom_rdm_del((GF_ReadAheadDataMap *)ptr);
+		break;
 	//not implemented
 	default:
 		break;
@@ -163,7 +219,20 @@ GF_Err gf_isom_datamap_new(const char *location, const char *parentPath, u8 mode
 		return GF_URL_ERROR;
 	}
 
-	if (mode == GF_ISOM_DATA_MAP_READ_ONLY) {
+	if (mode == GF_ISOM_DATA_MAP_READ_AHEAD) {
+		*outDataMap = gf_isom_rdm_new(sPath, GF_ISOM_DATA_MAP_READ, 0, 0);
+		if (! (*outDataMap)) {
+			GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[iso file] Cannot setup read-ahead on file %s, using regular file IO\n", sPath));
+			*outDataMap = gf_isom_fdm_new(sPath, GF_ISOM_DATA_MAP_READ);
+		}
+	} else if (mode == GF_ISOM_DATA_MAP_READ_MMAP) {
+		//use file mapping if possible, otherwise regular IO
+		*outDataMap = gf_isom_fmo_new(sPath, GF_ISOM_DATA_MAP_READ);
+		if (! (*outDataMap)) {
+			GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[iso file] Cannot map file %s in memory, using regular file IO\n", sPath));
+			*outDataMap = gf_isom_fdm_new(sPath, GF_ISOM_DATA_MAP_READ);
+		}
+	} else if (mode == GF_ISOM_DATA_MAP_READ_ONLY) {
 		mode = GF_ISOM_DATA_MAP_READ;
 		/*It seems win32 file mapping is reported in prog mem usage -> large increases of occupancy. Should not be a pb
 		but unless you want mapping, only regular IO will be used...*/
@@ -276,11 +345,24 @@ u32 gf_isom_datamap_get_data(GF_DataMap *map, char *buffer, u32 bufferLength, u6
 	case GF_ISOM_DATA_FILE_MAPPING:
 		return gf_isom_fmo_get_data((GF_FileMappingDataMap *)map, buffer, bufferLength, Offset);
 
+	case GF_ISOM_DATA_FILE_READ_AHEAD:
+		return gf_isom_rdm_get_data((GF_ReadAheadDataMap *)map, buffer, bufferLength, Offset);
+
 	default:
 		return 0;
 	}
 }
 
+const char *gf_isom_datamap_get_data_ref(GF_DataMap *map, u32 size, u64 offset)
+{
+	GF_FileMappingDataMap *fmo;
+	if (!map || (map->type != GF_ISOM_DATA_FILE_MAPPING)) return NULL;
+
+	fmo = (GF_FileMappingDataMap *)map;
+	if (offset + size > fmo->file_size) return NULL;
+	return fmo->byte_map + offset;
+}
+
 void gf_isom_datamap_flush(GF_DataMap *map)
 {
 	if (!map) return;
@@ -462,7 +544,8 @@ void gf_isom_fdm_del(GF_FileDataMap *ptr)
 
 
 
-u32 gf_isom_fdm_get_data(GF_FileDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
+//blocking read from the data map file bitstream
+static u32 datamap_read_bs(GF_DataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
 {
 	u32 bytesRead;
 
@@ -492,12 +575,229 @@ u32 gf_isom_fdm_get_data(GF_FileDataMap *ptr, char *buffer, u32 bufferLength, u6
 			bytesRead = 0;
 		}
 	}
+	return bytesRead;
+}
+
+u32 gf_isom_fdm_get_data(GF_FileDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
+{
+	u32 bytesRead = datamap_read_bs((GF_DataMap *)ptr, buffer, bufferLength, fileOffset);
 	ptr->last_acces_was_read = 1;
 	return bytesRead;
 }
 
 
 
+/*read-ahead window states*/
+enum
+{
+	RA_WINDOW_EMPTY = 0,
+	RA_WINDOW_PENDING,
+	RA_WINDOW_LOADING,
+	RA_WINDOW_READY,
+};
+
+static u32 rdm_thread_run(void *par)
+{
+	GF_ReadAheadDataMap *ptr = (GF_ReadAheadDataMap *)par;
+
+	while (ptr->run) {
+		u32 i;
+		u64 start;
+		size_t read;
+		GF_ReadAheadWindow *win = NULL;
+
+		gf_mx_p(ptr->mx);
+		//load closest pending window first
+		for (i=0; i<ptr->nb_windows; i++) {
+			if (ptr->windows[i].state != RA_WINDOW_PENDING) continue;
+			if (!win || (ptr->windows[i].start < win->start)) win = &ptr->windows[i];
+		}
+		if (win) win->state = RA_WINDOW_LOADING;
+		gf_mx_v(ptr->mx);
+
+		//nothing to load, wait for the next request (or for the data map destruction)
+		if (!win) {
+			gf_sema_wait(ptr->sema);
+			continue;
+		}
+
+		start = win->start;
+		read = 0;
+		if (gf_fseek(ptr->ra_stream, start, SEEK_SET) == 0) {
+			read = fread(win->data, 1, ptr->window_size, ptr->ra_stream);
+			//clear EOF for growing files
+			if (read < ptr->window_size) clearerr(ptr->ra_stream);
+		}
+
+		gf_mx_p(ptr->mx);
+		win->size = (u32) read;
+		win->state = read ? RA_WINDOW_READY : RA_WINDOW_EMPTY;
+		gf_mx_v(ptr->mx);
+	}
+	return 0;
+}
+
+//request windows following the given position, recycling windows located before it - must be called with the mutex locked
+static void rdm_schedule(GF_ReadAheadDataMap *ptr, u64 position)
+{
+	u32 i, j;
+	Bool notify = GF_FALSE;
+	u64 first = position - (position % ptr->window_size);
+
+	for (i=0; i<ptr->nb_windows; i++) {
+		GF_ReadAheadWindow *win = NULL;
+		u64 start = first + i * ptr->window_size;
+		for (j=0; j<ptr->nb_windows; j++) {
+			if ((ptr->windows[j].state != RA_WINDOW_EMPTY) && (ptr->windows[j].start == start)) break;
+		}
+		//already loaded or requested
+		if (j<ptr->nb_windows) continue;
+
+		for (j=0; j<ptr->nb_windows; j++) {
+			if (ptr->windows[j].state == RA_WINDOW_LOADING) continue;
+			if (ptr->windows[j].state == RA_WINDOW_EMPTY) {
+				win = &ptr->windows[j];
+				break;
+			}
+			//window no longer in our range, recycle it
+			if ((ptr->windows[j].start < first) || (ptr->windows[j].start >= first + ptr->nb_windows * ptr->window_size)) {
+				if (!win || (ptr->windows[j].start < win->start)) win = &ptr->windows[j];
+			}
+		}
+		if (!win) break;
+		win->start = start;
+		win->size = 0;
+		win->state = RA_WINDOW_PENDING;
+		notify = GF_TRUE;
+	}
+	if (notify) gf_sema_notify(ptr->sema, 1);
+}
+
+GF_DataMap *gf_isom_rdm_new(const char *sPath, u8 mode, u32 window_size, u32 nb_windows)
+{
+	u32 i;
+	GF_ReadAheadDataMap *tmp;
+
+	//only in read only
+	if (mode != GF_ISOM_DATA_MAP_READ) return NULL;
+
+	GF_SAFEALLOC(tmp, GF_ReadAheadDataMap);
+	if (!tmp) return NULL;
+
+	tmp->type = GF_ISOM_DATA_FILE_READ_AHEAD;
+	tmp->mode = mode;
+	tmp->window_size = window_size ? window_size : GF_ISOM_READ_AHEAD_WINDOW_SIZE;
+	tmp->nb_windows = nb_windows ? nb_windows : GF_ISOM_READ_AHEAD_WINDOWS;
+
+	tmp->stream = gf_fopen(sPath, "rb");
+	tmp->ra_stream = gf_fopen(sPath, "rb");
+	if (!tmp->stream || !tmp->ra_stream) goto err_exit;
+
+	tmp->bs = gf_bs_from_file(tmp->stream, GF_BITSTREAM_READ);
+	if (!tmp->bs) goto err_exit;
+
+	tmp->windows = (GF_ReadAheadWindow*)gf_malloc(sizeof(GF_ReadAheadWindow) * tmp->nb_windows);
+	if (!tmp->windows) goto err_exit;
+	memset(tmp->windows, 0, sizeof(GF_ReadAheadWindow) * tmp->nb_windows);
+	for (i=0; i<tmp->nb_windows; i++) {
+		tmp->windows[i].data = (char*)gf_malloc(sizeof(char) * tmp->window_size);
+		if (!tmp->windows[i].data) goto err_exit;
+	}
+
+	tmp->mx = gf_mx_new("ISOReadAhead");
+	tmp->sema = gf_sema_new(1, 0);
+	tmp->th = gf_th_new("ISOReadAhead");
+	if (!tmp->mx || !tmp->sema || !tmp->th) goto err_exit;
+
+	tmp->run = GF_TRUE;
+	if (gf_th_run(tmp->th, rdm_thread_run, tmp) != GF_OK) {
+		tmp->run = GF_FALSE;
+		goto err_exit;
+	}
+	return (GF_DataMap *)tmp;
+
+err_exit:
+	gf_isom_rdm_del(tmp);
+	return NULL;
+}
+
+void gf_isom_rdm_del(GF_ReadAheadDataMap *ptr)
+{
+	u32 i;
+	if (!ptr || (ptr->type != GF_ISOM_DATA_FILE_READ_AHEAD)) return;
+
+	if (ptr->th) {
+		ptr->run = GF_FALSE;
+		if (ptr->sema) gf_sema_notify(ptr->sema, 1);
+		//waits for the thread to exit
+		gf_th_del(ptr->th);
+	}
+	if (ptr->sema) gf_sema_del(ptr->sema);
+	if (ptr->mx) gf_mx_del(ptr->mx);
+	if (ptr->windows) {
+		for (i=0; i<ptr->nb_windows; i++) {
+			if (ptr->windows[i].data) gf_free(ptr->windows[i].data);
+		}
+		gf_free(ptr->windows);
+	}
+	if (ptr->bs) gf_bs_del(ptr->bs);
+	if (ptr->stream) gf_fclose(ptr->stream);
+	if (ptr->ra_stream) gf_fclose(ptr->ra_stream);
+	gf_free(ptr);
+}
+
+u32 gf_isom_rdm_get_data(GF_ReadAheadDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
+{
+	u32 i, done = 0;
+
+	//data not yet known in the file (growing file or truncated range), regular read
+	if (fileOffset + bufferLength > gf_bs_get_size(ptr->bs))
+		return datamap_read_bs((GF_DataMap *)ptr, buffer, bufferLength, fileOffset);
+
+	gf_mx_p(ptr->mx);
+	while (done < bufferLength) {
+		u64 pos = fileOffset + done;
+		GF_ReadAheadWindow *win = NULL;
+		for (i=0; i<ptr->nb_windows; i++) {
+			if (ptr->windows[i].state != RA_WINDOW_READY) continue;
+			if ((ptr->windows[i].start <= pos) && (pos < ptr->windows[i].start + ptr->windows[i].size)) {
+				win = &ptr->windows[i];
+				break;
+			}
+		}
+		if (!win) {
+			//short window (end of file at load time), reload it in case the file has grown
+			for (i=0; i<ptr->nb_windows; i++) {
+				if ((ptr->windows[i].state == RA_WINDOW_READY) && (ptr->windows[i].size < ptr->window_size)
+				        && (ptr->windows[i].start <= pos) && (pos < ptr->windows[i].start + ptr->window_size)) {
+					ptr->windows[i].state = RA_WINDOW_EMPTY;
+				}
+			}
+			break;
+		}
+		i = (u32) (win->start + win->size - pos);
+		if (i > bufferLength - done) i = bufferLength - done;
+		memcpy(buffer + done, win->data + (pos - win->start), i);
+		done += i;
+	}
+	//prefetch what follows
+	rdm_schedule(ptr, fileOffset + bufferLength);
+	gf_mx_v(ptr->mx);
+
+	if (done < bufferLength) {
+		//not yet prefetched, regular read of the missing part
+		i = datamap_read_bs((GF_DataMap *)ptr, buffer + done, bufferLength - done, fileOffset + done);
+		if (i != bufferLength - done) {
+			ptr->curPos = fileOffset;
+			return 0;
+		}
+	}
+	ptr->curPos = fileOffset + bufferLength;
+	return bufferLength;
+}
+
+
+
 #ifndef GPAC_DISABLE_ISOM_WRITE
 
 
@@ -547,6 +847,8 @@ GF_Err FDM_AddData(GF_FileDataMap *ptr, char *data, u32 dataSize)
 #include <windows.h>
 #include <winerror.h>
 
+#define GPAC_ISOM_HAS_FMO
+
 GF_DataMap *gf_isom_fmo_new(const char *sPath, u8 mode)
 {
 	GF_FileMappingDataMap *tmp;
@@ -632,15 +934,65 @@ void gf_isom_fmo_del(GF_FileMappingDataMap *ptr)
 	gf_free(ptr);
 }
 
+#elif defined(GPAC_CONFIG_LINUX) || defined(GPAC_CONFIG_DARWIN) || defined(GPAC_CONFIG_FREEBSD)
 
-u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define GPAC_ISOM_HAS_FMO
+
+GF_DataMap *gf_isom_fmo_new(const char *sPath, u8 mode)
 {
-	//can we seek till that point ???
-	if (fileOffset > ptr->file_size) return 0;
+	GF_FileMappingDataMap *tmp;
+	struct stat st;
+	void *map;
+	int fd;
 
-	//we do only read operations, so trivial
-	memcpy(buffer, ptr->byte_map + fileOffset, bufferLength);
-	return bufferLength;
+	//only in read only
+	if (mode != GF_ISOM_DATA_MAP_READ) return NULL;
+
+	fd = open(sPath, O_RDONLY);
+	if (fd < 0) return NULL;
+	//empty files cannot be mapped, and files larger than the address space cannot be mapped at once
+	if (fstat(fd, &st) || !st.st_size || ((u64) st.st_size != (u64) (size_t) st.st_size)) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	//the mapping holds its own reference on the file
+	close(fd);
+	if (map == MAP_FAILED) return NULL;
+
+	GF_SAFEALLOC(tmp, GF_FileMappingDataMap);
+	if (!tmp) {
+		munmap(map, (size_t) st.st_size);
+		return NULL;
+	}
+	tmp->type = GF_ISOM_DATA_FILE_MAPPING;
+	tmp->mode = mode;
+	tmp->name = gf_strdup(sPath);
+	tmp->file_size = (u64) st.st_size;
+	tmp->byte_map = (char *) map;
+
+	//finaly open our bitstream (from buffer)
+	tmp->bs = gf_bs_new(tmp->byte_map, tmp->file_size, GF_BITSTREAM_READ);
+	if (!tmp->bs) {
+		gf_isom_fmo_del(tmp);
+		return NULL;
+	}
+	return (GF_DataMap *)tmp;
+}
+
+void gf_isom_fmo_del(GF_FileMappingDataMap *ptr)
+{
+	if (!ptr || (ptr->type != GF_ISOM_DATA_FILE_MAPPING)) return;
+
+	if (ptr->bs) gf_bs_del(ptr->bs);
+	if (ptr->byte_map) munmap(ptr->byte_map, (size_t) ptr->file_size);
+	gf_free(ptr->name);
+	gf_free(ptr);
 }
 
 #else
@@ -658,6 +1010,20 @@ u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLen
 
 #endif
 
+#ifdef GPAC_ISOM_HAS_FMO
+u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
+{
+	//can we seek till that point ???
+	if (fileOffset >= ptr->file_size) return 0;
+	if (fileOffset + bufferLength > ptr->file_size) bufferLength = (u32) (ptr->file_size - fileOffset);
+
+	//we do only read operations, so trivial
+	memcpy(buffer, ptr->byte_map + fileOffset, bufferLength);
+	ptr->curPos = fileOffset + bufferLength;
+	return bufferLength;
+}
+#endif
+
 #endif /*GPAC_DISABLE_ISOM*/
 
 
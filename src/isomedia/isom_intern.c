@@ -502,9 +502,18 @@ GF_ISOFile *gf_isom_open_file(const char *fileName, u32 OpenMode, const char *tm
 {
 	GF_Err e;
 	u64 bytes;
+	u8 read_mode;
+	u32 OpenModeFlags;
+	Bool lazy_tables = GF_FALSE;
 	GF_ISOFile *mov = gf_isom_new_movie();
 	if (! mov) return NULL;
 
+	read_mode = GF_ISOM_DATA_MAP_READ_ONLY;
+	if (OpenMode & GF_ISOM_OPEN_MMAP) read_mode = GF_ISOM_DATA_MAP_READ_MMAP;
+	else if (OpenMode & GF_ISOM_OPEN_READ_AHEAD) read_mode = GF_ISOM_DATA_MAP_READ_AHEAD;
+	OpenModeFlags = OpenMode;
+	OpenMode &= 0xFF;
+
 	mov->fileName = gf_strdup(fileName);
 	mov->openMode = OpenMode;
 
@@ -519,7 +528,7 @@ GF_ISOFile *gf_isom_open_file(const char *fileName, u32 OpenMode, const char *tm
 		//the bitstream IS PART OF the GF_DataMap
 		//as this is read-only, use a FileMapping. this is the only place where
 		//we use file mapping
-		e = gf_isom_datamap_new(fileName, NULL, GF_ISOM_DATA_MAP_READ_ONLY, &mov->movieFileMap);
+		e = gf_isom_datamap_new(fileName, NULL, read_mode, &mov->movieFileMap);
 		if (e) {
 			gf_isom_set_last_error(NULL, e);
 			gf_isom_delete_movie(mov);
@@ -529,6 +538,7 @@ GF_ISOFile *gf_isom_open_file(const char *fileName, u32 OpenMode, const char *tm
 #ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
 		if (OpenMode == GF_ISOM_OPEN_READ_DUMP) mov->FragmentsFlags |= GF_ISOM_FRAG_READ_DEBUG;
 #endif
+		lazy_tables = (OpenModeFlags & GF_ISOM_OPEN_LAZY) ? GF_TRUE : GF_FALSE;
 
 	} else {
 
@@ -572,7 +582,21 @@ GF_ISOFile *gf_isom_open_file(const char *fileName, u32 OpenMode, const char *tm
 	}
 
 	//OK, let's parse the movie...
+	if (lazy_tables) gf_bs_set_cookie(mov->movieFileMap->bs, GF_ISOM_BS_COOKIE_LAZY_TABLES);
 	mov->LastError = gf_isom_parse_movie_boxes(mov, &bytes, 0);
+	if (lazy_tables) {
+		gf_bs_set_cookie(mov->movieFileMap->bs, 0);
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+		//fragmented files update the tables when merging fragments, load them now (they are usually empty)
+		if (!mov->LastError && mov->moov && mov->moov->mvex) {
+			u32 i;
+			for (i=0; i<gf_list_count(mov->moov->trackList); i++) {
+				mov->LastError = gf_isom_load_track_tables((GF_TrackBox*)gf_list_get(mov->moov->trackList, i));
+				if (mov->LastError) break;
+			}
+		}
+#endif
+	}
 
 	if (!mov->LastError && (OpenMode == GF_ISOM_OPEN_CAT_FRAGMENTS)) {
 		gf_isom_datamap_del(mov->movieFileMap);
@@ -629,7 +653,10 @@ GF_TrackBox *gf_isom_get_track_from_id(GF_MovieBox *moov, u32 trackID)
 	count = gf_list_count(moov->trackList);
 	for (i = 0; i<count; i++) {
 		trak = (GF_TrackBox*)gf_list_get(moov->trackList, i);
-		if (trak->Header->trackID == trackID) return trak;
+		if (trak->Header->trackID == trackID) {
+			gf_isom_load_track_tables(trak);
+			return trak;
+		}
 	}
 	return NULL;
 }
@@ -643,17 +670,43 @@ GF_TrackBox *gf_isom_get_track_from_original_id(GF_MovieBox *moov, u32 originalI
 	count = gf_list_count(moov->trackList);
 	for (i = 0; i<count; i++) {
 		trak = (GF_TrackBox*)gf_list_get(moov->trackList, i);
-		if ((trak->originalFile == originalFile) && (trak->originalID == originalID)) return trak;
+		if ((trak->originalFile == originalFile) && (trak->originalID == originalID)) {
+			gf_isom_load_track_tables(trak);
+			return trak;
+		}
 	}
 	return NULL;
 }
 
-GF_TrackBox *gf_isom_get_track_from_file(GF_ISOFile *movie, u32 trackNumber)
+GF_Err gf_isom_load_track_tables(GF_TrackBox *trak)
+{
+	GF_SampleTableBox *stbl;
+	if (!trak || !trak->Media || !trak->Media->information || !trak->Media->information->sampleTable) return GF_OK;
+	stbl = trak->Media->information->sampleTable;
+	if (!stbl->nb_lazy_boxes) return GF_OK;
+	if (!trak->moov || !trak->moov->mov || !trak->moov->mov->movieFileMap) return GF_BAD_PARAM;
+	return stbl_LoadLazyTables(stbl, trak->moov->mov->movieFileMap->bs);
+}
+
+GF_TrackBox *gf_isom_get_track_info_from_file(GF_ISOFile *movie, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	if (!movie) return NULL;
-	trak = gf_isom_get_track(movie->moov, trackNumber);
-	if (!trak) movie->LastError = GF_BAD_PARAM;
+	if (!movie || !movie->moov || !trackNumber || (trackNumber > gf_list_count(movie->moov->trackList))) {
+		if (movie) movie->LastError = GF_BAD_PARAM;
+		return NULL;
+	}
+	//does not load lazy sample tables
+	trak = (GF_TrackBox*)gf_list_get(movie->moov->trackList, trackNumber - 1);
+	return trak;
+}
+
+GF_TrackBox *gf_isom_get_track_from_file(GF_ISOFile *movie, u32 trackNumber)
+{
+	GF_TrackBox *trak = gf_isom_get_track_info_from_file(movie, trackNumber);
+	if (trak) {
+		GF_Err e = gf_isom_load_track_tables(trak);
+		if (e) movie->LastError = e;
+	}
 	return trak;
 }
 
@@ -921,9 +974,18 @@ GF_ISOFile *gf_isom_create_movie(const char *fileName, u32 OpenMode, const char
 	if (OpenMode == GF_ISOM_OPEN_WRITE) {
 		//THIS IS NOT A TEMP FILE, WRITE mode is used for "live capture"
 		//this file will be the final file...
-		mov->fileName = gf_strdup(fileName);
-		e = gf_isom_datamap_new(fileName, NULL, GF_ISOM_DATA_MAP_WRITE, & mov->editFileMap);
-		if (e) goto err_exit;
+		//no file name: the file is delivered through gf_isom_set_write_callback, use a temp file
+		if (!fileName) {
+			mov->editFileMap = gf_isom_fdm_new_temp(tmp_dir);
+			if (!mov->editFileMap) {
+				e = GF_IO_ERR;
+				goto err_exit;
+			}
+		} else {
+			mov->fileName = gf_strdup(fileName);
+			e = gf_isom_datamap_new(fileName, NULL, GF_ISOM_DATA_MAP_WRITE, & mov->editFileMap);
+			if (e) goto err_exit;
+		}
 
 		/*brand is set to ISOM by default - it may be touched until sample data is added to track*/
 		gf_isom_set_brand_info( (GF_ISOFile *) mov, GF_ISOM_BRAND_ISOM, 1);
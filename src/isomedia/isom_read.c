@@ -149,6 +149,12 @@ u32 gf_isom_probe_file(const char *fileName)
 **************************************************************/
 GF_EXPORT
 GF_Err gf_isom_open_progressive(const char *fileName, u64 start_range, u64 end_range, GF_ISOFile **the_file, u64 *BytesMissing)
+{
+	return gf_isom_open_progressive_ex(fileName, start_range, end_range, 0, the_file, BytesMissing);
+}
+
+GF_EXPORT
+GF_Err gf_isom_open_progressive_ex(const char *fileName, u64 start_range, u64 end_range, u32 open_flags, GF_ISOFile **the_file, u64 *BytesMissing)
 {
 	GF_Err e;
 	GF_ISOFile *movie;
@@ -164,7 +170,7 @@ GF_Err gf_isom_open_progressive(const char *fileName, u64 start_range, u64 end_r
 	movie->fileName = gf_strdup(fileName);
 	movie->openMode = GF_ISOM_OPEN_READ;
 	//do NOT use FileMapping on incomplete files
-	e = gf_isom_datamap_new(fileName, NULL, GF_ISOM_DATA_MAP_READ, &movie->movieFileMap);
+	e = gf_isom_datamap_new(fileName, NULL, (open_flags & GF_ISOM_OPEN_READ_AHEAD) ? GF_ISOM_DATA_MAP_READ_AHEAD : GF_ISOM_DATA_MAP_READ, &movie->movieFileMap);
 	if (e) {
 		gf_isom_delete_movie(movie);
 		return e;
@@ -256,6 +262,8 @@ GF_Err gf_isom_close(GF_ISOFile *movie)
 		} else
 #endif
 			e = WriteToFile(movie);
+		/*streaming mode: send whatever is left*/
+		if (!e) e = gf_isom_flush_block_out(movie);
 	}
 #endif /*GPAC_DISABLE_ISOM_WRITE*/
 
@@ -408,7 +416,7 @@ u32 gf_isom_get_track_id(GF_ISOFile *movie, u32 trackNumber)
 {
 	GF_TrackBox *trak;
 	if (!movie) return 0;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return 0;
 	return trak->Header->trackID;
 }
@@ -437,7 +445,7 @@ u32 gf_isom_get_track_original_id(GF_ISOFile *movie, u32 trackNumber)
 {
 	GF_TrackBox *trak;
 	if (!movie) return 0;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return 0;
 	return trak->originalID;
 }
@@ -621,7 +629,7 @@ GF_EXPORT
 u8 gf_isom_is_track_enabled(GF_ISOFile *the_file, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 
 	if (!trak) return 2;
 	return (trak->Header->flags & 1) ? 1 : 0;
@@ -656,7 +664,7 @@ GF_Err gf_isom_get_media_language(GF_ISOFile *the_file, u32 trackNumber, char **
 		return GF_BAD_PARAM;
 	}
 	*lang = NULL;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak) return GF_BAD_PARAM;
 	count = gf_list_count(trak->Media->other_boxes);
 	if (count>0) {
@@ -681,7 +689,7 @@ u32 gf_isom_get_track_kind_count(GF_ISOFile *the_file, u32 trackNumber)
 	GF_UserDataBox *udta;
 	GF_UserDataMap *map;
 	if (trackNumber) {
-		GF_TrackBox *trak = gf_isom_get_track_from_file(the_file, trackNumber);
+		GF_TrackBox *trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 		if (!trak) return 0;
 		if (!trak->udta) {
 			return 0;
@@ -710,7 +718,7 @@ GF_Err gf_isom_get_track_kind(GF_ISOFile *the_file, u32 trackNumber, u32 index,
 	*value = NULL;
 
 	if (trackNumber) {
-		GF_TrackBox *trak = gf_isom_get_track_from_file(the_file, trackNumber);
+		GF_TrackBox *trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 		if (!trak) return GF_BAD_PARAM;
 		if (!trak->udta) {
 			e = trak_AddBox((GF_Box*)trak, gf_isom_box_new(GF_ISOM_BOX_TYPE_UDTA));
@@ -741,7 +749,7 @@ s32 gf_isom_get_reference_count(GF_ISOFile *movie, u32 trackNumber, u32 referenc
 {
 	GF_TrackBox *trak;
 	GF_TrackReferenceTypeBox *dpnd;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return -1;
 	if (!trak->References) return 0;
 	if (movie->openMode == GF_ISOM_OPEN_WRITE) {
@@ -765,7 +773,7 @@ GF_Err gf_isom_get_reference(GF_ISOFile *movie, u32 trackNumber, u32 referenceTy
 	GF_TrackBox *trak;
 	GF_TrackReferenceTypeBox *dpnd;
 	u32 refTrackNum;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 
 	*refTrack = 0;
 	if (!trak || !trak->References) return GF_BAD_PARAM;
@@ -797,7 +805,7 @@ GF_Err gf_isom_get_reference_ID(GF_ISOFile *movie, u32 trackNumber, u32 referenc
 	GF_Err e;
 	GF_TrackBox *trak;
 	GF_TrackReferenceTypeBox *dpnd;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 
 	*refTrackID = 0;
 	if (!trak || !trak->References) return GF_BAD_PARAM;
@@ -822,7 +830,7 @@ u32 gf_isom_has_track_reference(GF_ISOFile *movie, u32 trackNumber, u32 referenc
 	u32 i;
 	GF_TrackBox *trak;
 	GF_TrackReferenceTypeBox *dpnd;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return 0;
 	if (!trak->References) return 0;
 
@@ -873,7 +881,7 @@ GF_EXPORT
 u32 gf_isom_get_sample_description_count(GF_ISOFile *the_file, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak) return 0;
 
 	return gf_list_count(trak->Media->information->sampleTable->SampleDescription->other_boxes);
@@ -944,7 +952,7 @@ GF_EXPORT
 u64 gf_isom_get_media_original_duration(GF_ISOFile *movie, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return 0;
 
 	return trak->Media->mediaHeader->original_duration;
@@ -955,7 +963,7 @@ GF_EXPORT
 u32 gf_isom_get_media_timescale(GF_ISOFile *the_file, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak) return 0;
 	return trak->Media->mediaHeader->timeScale;
 }
@@ -1076,7 +1084,7 @@ GF_EXPORT
 u32 gf_isom_get_media_type(GF_ISOFile *movie, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return GF_BAD_PARAM;
 	return (trak->Media && trak->Media->handler) ? trak->Media->handler->handlerType : 0;
 }
@@ -1113,7 +1121,7 @@ u8 gf_isom_is_track_encrypted(GF_ISOFile *the_file, u32 trackNumber)
 {
 	GF_TrackBox *trak;
 	GF_Box *entry;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak) return 2;
 	entry = (GF_Box*)gf_list_get(trak->Media->information->sampleTable->SampleDescription->other_boxes, 0);
 	if (!entry) return 2;
@@ -1125,7 +1133,7 @@ u32 gf_isom_get_media_subtype(GF_ISOFile *the_file, u32 trackNumber, u32 Descrip
 {
 	GF_TrackBox *trak;
 	GF_Box *entry;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak || !DescriptionIndex || !trak->Media || !trak->Media->information || !trak->Media->information->sampleTable) return 0;
 	entry = (GF_Box*)gf_list_get(trak->Media->information->sampleTable->SampleDescription->other_boxes, DescriptionIndex-1);
 	if (!entry) return 0;
@@ -1152,7 +1160,7 @@ u32 gf_isom_get_mpeg4_subtype(GF_ISOFile *the_file, u32 trackNumber, u32 Descrip
 {
 	GF_TrackBox *trak;
 	GF_Box *entry;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak || !DescriptionIndex) return 0;
 	entry = (GF_Box*)gf_list_get(trak->Media->information->sampleTable->SampleDescription->other_boxes, DescriptionIndex-1);
 	if (!entry) return 0;
@@ -1167,7 +1175,7 @@ GF_EXPORT
 GF_Err gf_isom_get_handler_name(GF_ISOFile *the_file, u32 trackNumber, const char **outName)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak || !outName) return GF_BAD_PARAM;
 	*outName = trak->Media->handler->nameUTF8;
 	return GF_OK;
@@ -1235,7 +1243,7 @@ GF_EXPORT
 u32 gf_isom_get_sample_count(GF_ISOFile *the_file, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak || !trak->Media->information->sampleTable->SampleSize) return 0;
 	return trak->Media->information->sampleTable->SampleSize->sampleCount
 #ifndef GPAC_DISABLE_ISOM_FRAGMENTS
@@ -1247,7 +1255,7 @@ u32 gf_isom_get_sample_count(GF_ISOFile *the_file, u32 trackNumber)
 u32 gf_isom_get_constant_sample_size(GF_ISOFile *the_file, u32 trackNumber)
 {
 	GF_TrackBox *trak;
-	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak) return 0;
 	return trak->Media->information->sampleTable->SampleSize->sampleSize;
 }
@@ -1417,12 +1425,437 @@ GF_ISOSample *gf_isom_get_sample_info(GF_ISOFile *the_file, u32 trackNumber, u32
 	return samp;
 }
 
+GF_EXPORT
+GF_ISOSample *gf_isom_get_sample_ref(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *sampleDescriptionIndex, const char **sample_data)
+{
+	u32 descIndex;
+	u64 data_offset;
+	GF_TrackBox *trak;
+	GF_ISOSample *samp;
+
+	if (!sample_data) return NULL;
+	*sample_data = NULL;
+	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	if (!trak) return NULL;
+
+	//this opens the data map of the sample
+	samp = gf_isom_get_sample_info(the_file, trackNumber, sampleNumber, &descIndex, &data_offset);
+	if (!samp) return NULL;
+
+	*sample_data = gf_isom_datamap_get_data_ref(trak->Media->information->dataHandler, samp->dataLength, data_offset);
+	if (! *sample_data) {
+		gf_isom_set_last_error(the_file, GF_NOT_SUPPORTED);
+		gf_isom_sample_del(&samp);
+		return NULL;
+	}
+	if (sampleDescriptionIndex) *sampleDescriptionIndex = descIndex;
+	return samp;
+}
+
+typedef struct
+{
+	u32 trackNumber;
+	GF_TrackBox *trak;
+	/*next sample to fetch in media numbering, and its properties loaded without data (NULL once done)*/
+	u32 sample_num;
+	GF_ISOSample *next;
+	u32 next_desc_index;
+	u64 next_offset;
+	GF_DataMap *next_map;
+} GF_SampleIterTrack;
+
+typedef struct
+{
+	GF_ISOSample *samp;
+	u32 trackNumber, sampleNumber, descIndex;
+} GF_SampleIterEntry;
+
+struct __isom_sample_iterator
+{
+	GF_ISOFile *movie;
+	GF_SampleIterTrack *tracks;
+	u32 nb_tracks;
+	u32 max_read_size;
+
+	/*samples loaded by the last read and not yet returned*/
+	GF_SampleIterEntry *pending;
+	u32 nb_pending, pending_pos, pending_alloc;
+
+	char *read_buf;
+	u32 read_buf_alloc;
+};
+
+static GF_Err sample_iter_fetch_info(GF_SampleIterTrack *tk)
+{
+	GF_Err e;
+	GF_MediaBox *mdia = tk->trak->Media;
+
+	if (tk->sample_num > mdia->information->sampleTable->SampleSize->sampleCount) {
+		if (tk->next) gf_isom_sample_del(&tk->next);
+		return GF_OK;
+	}
+	if (!tk->next) {
+		tk->next = gf_isom_sample_new();
+		if (!tk->next) return GF_OUT_OF_MEM;
+	}
+	//this opens the data map of the sample
+	e = Media_GetSample(mdia, tk->sample_num, &tk->next, &tk->next_desc_index, GF_TRUE, &tk->next_offset);
+	if (e) {
+		gf_isom_sample_del(&tk->next);
+		return e;
+	}
+	tk->next_map = mdia->information->dataHandler;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_ISOSampleIterator *gf_isom_sample_iterator_new(GF_ISOFile *movie, const u32 *tracks, u32 nb_tracks, u32 max_read_size)
+{
+	u32 i;
+	GF_ISOSampleIterator *it;
+	if (!movie || !movie->moov) return NULL;
+	if (!tracks) nb_tracks = gf_list_count(movie->moov->trackList);
+	if (!nb_tracks) return NULL;
+
+	GF_SAFEALLOC(it, GF_ISOSampleIterator);
+	if (!it) return NULL;
+	it->movie = movie;
+	it->max_read_size = max_read_size ? max_read_size : GF_ISOM_SAMPLE_ITERATOR_READ_SIZE;
+	it->tracks = (GF_SampleIterTrack*)gf_malloc(sizeof(GF_SampleIterTrack) * nb_tracks);
+	if (!it->tracks) {
+		gf_free(it);
+		return NULL;
+	}
+	memset(it->tracks, 0, sizeof(GF_SampleIterTrack) * nb_tracks);
+	it->nb_tracks = nb_tracks;
+
+	for (i=0; i<nb_tracks; i++) {
+		GF_Err e;
+		GF_SampleIterTrack *tk = &it->tracks[i];
+		tk->trackNumber = tracks ? tracks[i] : i+1;
+		tk->trak = gf_isom_get_track_from_file(movie, tk->trackNumber);
+		if (!tk->trak || !tk->trak->Media->information->sampleTable->SampleSize) {
+			gf_isom_set_last_error(movie, GF_BAD_PARAM);
+			gf_isom_sample_iterator_del(it);
+			return NULL;
+		}
+		tk->sample_num = 1;
+		e = sample_iter_fetch_info(tk);
+		if (e) {
+			gf_isom_set_last_error(movie, e);
+			gf_isom_sample_iterator_del(it);
+			return NULL;
+		}
+	}
+	return it;
+}
+
+GF_EXPORT
+void gf_isom_sample_iterator_del(GF_ISOSampleIterator *it)
+{
+	u32 i;
+	if (!it) return;
+	for (i=0; i<it->nb_tracks; i++) {
+		if (it->tracks[i].next) gf_isom_sample_del(&it->tracks[i].next);
+	}
+	for (i=it->pending_pos; i<it->nb_pending; i++) {
+		gf_isom_sample_del(&it->pending[i].samp);
+	}
+	if (it->pending) gf_free(it->pending);
+	if (it->read_buf) gf_free(it->read_buf);
+	gf_free(it->tracks);
+	gf_free(it);
+}
+
+/*moves the next sample of the track to the pending list*/
+static GF_Err sample_iter_push(GF_ISOSampleIterator *it, GF_SampleIterTrack *tk)
+{
+	GF_SampleIterEntry *ent;
+	if (it->nb_pending == it->pending_alloc) {
+		it->pending_alloc = it->pending_alloc ? 2*it->pending_alloc : 32;
+		it->pending = (GF_SampleIterEntry*)gf_realloc(it->pending, sizeof(GF_SampleIterEntry) * it->pending_alloc);
+		if (!it->pending) return GF_OUT_OF_MEM;
+	}
+	ent = &it->pending[it->nb_pending];
+	ent->samp = tk->next;
+	ent->trackNumber = tk->trackNumber;
+	ent->sampleNumber = tk->sample_num;
+	ent->descIndex = tk->next_desc_index;
+	it->nb_pending++;
+
+	tk->next = NULL;
+	tk->sample_num++;
+	return sample_iter_fetch_info(tk);
+}
+
+/*loads the next run of contiguous samples, starting from the sample with the lowest offset, in a single read*/
+static GF_Err sample_iter_load(GF_ISOSampleIterator *it)
+{
+	GF_Err e;
+	u32 i, bytes;
+	u64 run_start, run_end;
+	GF_DataMap *map;
+	GF_SampleIterTrack *tk = NULL;
+
+	it->nb_pending = it->pending_pos = 0;
+
+	for (i=0; i<it->nb_tracks; i++) {
+		GF_SampleIterTrack *a_tk = &it->tracks[i];
+		if (!a_tk->next) continue;
+		if (!tk || (a_tk->next_offset < tk->next_offset)) tk = a_tk;
+	}
+	if (!tk) return GF_EOS;
+
+	map = tk->next_map;
+	run_start = tk->next_offset;
+	run_end = run_start + tk->next->dataLength;
+	e = sample_iter_push(it, tk);
+	if (e) return e;
+
+	/*grow the run with any sample starting where it ends, trying the current track first*/
+	while (1) {
+		GF_SampleIterTrack *next_tk = NULL;
+		if (tk->next && (tk->next_map==map) && (tk->next_offset==run_end)) {
+			next_tk = tk;
+		} else {
+			for (i=0; i<it->nb_tracks; i++) {
+				GF_SampleIterTrack *a_tk = &it->tracks[i];
+				if (a_tk->next && (a_tk->next_map==map) && (a_tk->next_offset==run_end)) {
+					next_tk = a_tk;
+					break;
+				}
+			}
+		}
+		if (!next_tk) break;
+		if (run_end + next_tk->next->dataLength - run_start > it->max_read_size) break;
+
+		tk = next_tk;
+		run_end += tk->next->dataLength;
+		e = sample_iter_push(it, tk);
+		if (e) return e;
+	}
+
+	bytes = (u32) (run_end - run_start);
+	if (bytes > it->read_buf_alloc) {
+		it->read_buf = (char*)gf_realloc(it->read_buf, bytes);
+		if (!it->read_buf) return GF_OUT_OF_MEM;
+		it->read_buf_alloc = bytes;
+	}
+	if (bytes && (gf_isom_datamap_get_data(map, it->read_buf, bytes, run_start) < bytes))
+		return GF_IO_ERR;
+
+	/*dispatch the run to the samples*/
+	run_end = 0;
+	for (i=0; i<it->nb_pending; i++) {
+		GF_SampleIterEntry *ent = &it->pending[i];
+		GF_TrackBox *trak = gf_isom_get_track_from_file(it->movie, ent->trackNumber);
+
+		ent->samp->data = (char*)gf_malloc(sizeof(char) * (ent->samp->dataLength + trak->padding_bytes));
+		if (!ent->samp->data) return GF_OUT_OF_MEM;
+		memcpy(ent->samp->data, it->read_buf + run_end, ent->samp->dataLength);
+		if (trak->padding_bytes)
+			memset(ent->samp->data + ent->samp->dataLength, 0, sizeof(char) * trak->padding_bytes);
+		run_end += ent->samp->dataLength;
+
+		e = Media_RewriteSample(trak->Media, ent->samp, ent->sampleNumber, ent->descIndex);
+		if (e) return e;
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+		ent->samp->DTS += trak->dts_at_seg_start;
+		ent->sampleNumber += trak->sample_count_at_seg_start;
+#endif
+	}
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_isom_sample_iterator_next(GF_ISOSampleIterator *it, u32 *trackNumber, u32 *sampleNumber, u32 *sampleDescriptionIndex, GF_ISOSample **sample)
+{
+	GF_SampleIterEntry *ent;
+	if (!it || !sample) return GF_BAD_PARAM;
+	*sample = NULL;
+
+	if (it->pending_pos == it->nb_pending) {
+		GF_Err e = sample_iter_load(it);
+		if (e) {
+			/*drop whatever was loaded*/
+			while (it->pending_pos < it->nb_pending) {
+				gf_isom_sample_del(&it->pending[it->pending_pos].samp);
+				it->pending_pos++;
+			}
+			if (e != GF_EOS) gf_isom_set_last_error(it->movie, e);
+			return e;
+		}
+	}
+	ent = &it->pending[it->pending_pos];
+	it->pending_pos++;
+
+	*sample = ent->samp;
+	ent->samp = NULL;
+	if (trackNumber) *trackNumber = ent->trackNumber;
+	if (sampleNumber) *sampleNumber = ent->sampleNumber;
+	if (sampleDescriptionIndex) *sampleDescriptionIndex = ent->descIndex;
+	return GF_OK;
+}
+
+typedef struct
+{
+	GF_ISOSampleIterator *it;
+	gf_isom_on_sample on_sample;
+	void *usr_data;
+
+	GF_Mutex *mx;
+	GF_Semaphore *free_slots, *filled_slots;
+	/*circular queue of samples waiting for a worker, a NULL sample stops the worker*/
+	GF_SampleIterEntry *queue;
+	u32 queue_size, read_pos, write_pos;
+	GF_Err error;
+} GF_SampleIterPool;
+
+static u32 sample_iter_worker(void *par)
+{
+	GF_SampleIterPool *pool = (GF_SampleIterPool *)par;
+	while (1) {
+		GF_Err e;
+		Bool skip;
+		GF_SampleIterEntry ent;
+
+		gf_sema_wait(pool->filled_slots);
+		gf_mx_p(pool->mx);
+		ent = pool->queue[pool->read_pos];
+		pool->read_pos = (pool->read_pos + 1) % pool->queue_size;
+		skip = pool->error ? GF_TRUE : GF_FALSE;
+		gf_mx_v(pool->mx);
+		gf_sema_notify(pool->free_slots, 1);
+
+		if (!ent.samp) break;
+		if (!skip) {
+			e = pool->on_sample(pool->usr_data, ent.trackNumber, ent.sampleNumber, ent.descIndex, ent.samp);
+			if (e) {
+				gf_mx_p(pool->mx);
+				if (!pool->error) pool->error = e;
+				gf_mx_v(pool->mx);
+			}
+		}
+		gf_isom_sample_del(&ent.samp);
+	}
+	return 0;
+}
+
+static void sample_iter_queue(GF_SampleIterPool *pool, GF_SampleIterEntry *ent)
+{
+	gf_sema_wait(pool->free_slots);
+	gf_mx_p(pool->mx);
+	pool->queue[pool->write_pos] = *ent;
+	pool->write_pos = (pool->write_pos + 1) % pool->queue_size;
+	gf_mx_v(pool->mx);
+	gf_sema_notify(pool->filled_slots, 1);
+}
+
+static GF_Err sample_iter_process_sync(GF_ISOSampleIterator *it, gf_isom_on_sample on_sample, void *usr_data)
+{
+	GF_Err e;
+	GF_SampleIterEntry ent;
+	while (1) {
+		e = gf_isom_sample_iterator_next(it, &ent.trackNumber, &ent.sampleNumber, &ent.descIndex, &ent.samp);
+		if (e) return (e==GF_EOS) ? GF_OK : e;
+		e = on_sample(usr_data, ent.trackNumber, ent.sampleNumber, ent.descIndex, ent.samp);
+		gf_isom_sample_del(&ent.samp);
+		if (e) return e;
+	}
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_isom_sample_iterator_process(GF_ISOSampleIterator *it, u32 nb_threads, gf_isom_on_sample on_sample, void *usr_data)
+{
+	u32 i, nb_started;
+	GF_Err e;
+	GF_SampleIterEntry ent;
+	GF_SampleIterPool pool;
+	GF_Thread **threads;
+
+	if (!it || !on_sample) return GF_BAD_PARAM;
+
+	if (nb_threads <= 1) return sample_iter_process_sync(it, on_sample, usr_data);
+
+	memset(&pool, 0, sizeof(GF_SampleIterPool));
+	pool.it = it;
+	pool.on_sample = on_sample;
+	pool.usr_data = usr_data;
+	pool.queue_size = 2*nb_threads;
+	pool.queue = (GF_SampleIterEntry*)gf_malloc(sizeof(GF_SampleIterEntry) * pool.queue_size);
+	threads = (GF_Thread **)gf_malloc(sizeof(GF_Thread *) * nb_threads);
+	if (!pool.queue || !threads) {
+		if (pool.queue) gf_free(pool.queue);
+		if (threads) gf_free(threads);
+		return GF_OUT_OF_MEM;
+	}
+	pool.mx = gf_mx_new("ISOSampleWorkers");
+	pool.free_slots = gf_sema_new(pool.queue_size, pool.queue_size);
+	pool.filled_slots = gf_sema_new(pool.queue_size, 0);
+
+	nb_started = 0;
+	if (pool.mx && pool.free_slots && pool.filled_slots) {
+		for (i=0; i<nb_threads; i++) {
+			threads[i] = gf_th_new("ISOSampleWorker");
+			if (!threads[i]) break;
+			if (gf_th_run(threads[i], sample_iter_worker, &pool) != GF_OK) {
+				gf_th_del(threads[i]);
+				break;
+			}
+			nb_started++;
+		}
+	}
+	//no worker could be started, process in the calling thread
+	if (!nb_started) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[iso file] Failed to start sample workers, processing samples in the calling thread\n"));
+		e = sample_iter_process_sync(it, on_sample, usr_data);
+		goto exit;
+	}
+
+	e = GF_OK;
+	while (1) {
+		Bool abort;
+		e = gf_isom_sample_iterator_next(it, &ent.trackNumber, &ent.sampleNumber, &ent.descIndex, &ent.samp);
+		if (e) break;
+
+		gf_mx_p(pool.mx);
+		abort = pool.error ? GF_TRUE : GF_FALSE;
+		gf_mx_v(pool.mx);
+		if (abort) {
+			gf_isom_sample_del(&ent.samp);
+			break;
+		}
+		sample_iter_queue(&pool, &ent);
+	}
+	if (e==GF_EOS) e = GF_OK;
+
+	/*one stop marker per worker*/
+	memset(&ent, 0, sizeof(GF_SampleIterEntry));
+	for (i=0; i<nb_started; i++) {
+		sample_iter_queue(&pool, &ent);
+	}
+	for (i=0; i<nb_started; i++) {
+		gf_th_del(threads[i]);
+	}
+	if (!e) e = pool.error;
+
+exit:
+	gf_free(threads);
+	gf_free(pool.queue);
+	if (pool.mx) gf_mx_del(pool.mx);
+	if (pool.free_slots) gf_sema_del(pool.free_slots);
+	if (pool.filled_slots) gf_sema_del(pool.filled_slots);
+	return e;
+}
+
 //same as gf_isom_get_sample but doesn't fetch media data
 GF_EXPORT
 u64 gf_isom_get_sample_dts(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber)
 {
 	u64 dts;
 	GF_TrackBox *trak;
+	GF_SampleIndex *idx;
 	trak = gf_isom_get_track_from_file(the_file, trackNumber);
 	if (!trak) return 0;
 
@@ -1431,6 +1864,11 @@ u64 gf_isom_get_sample_dts(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumb
 	if (sampleNumber<=trak->sample_count_at_seg_start) return 0;
 	sampleNumber -= trak->sample_count_at_seg_start;
 #endif
+	idx = stbl_GetSampleIndex(trak->Media->information->sampleTable);
+	if (idx) {
+		if (sampleNumber > idx->nb_samples) return 0;
+		return idx->dts[sampleNumber-1];
+	}
 	if (stbl_GetSampleDTS(trak->Media->information->sampleTable->TimeToSample, sampleNumber, &dts) != GF_OK) return 0;
 	return dts;
 }
@@ -1765,6 +2203,22 @@ GF_Err gf_isom_set_sample_padding(GF_ISOFile *the_file, u32 trackNumber, u32 pad
 
 }
 
+GF_EXPORT
+GF_Err gf_isom_enable_sample_index(GF_ISOFile *the_file, u32 trackNumber, Bool enable)
+{
+	GF_SampleTableBox *stbl;
+	GF_TrackBox *trak;
+	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	if (!trak) return GF_BAD_PARAM;
+	//sample tables may be modified in other modes
+	if (enable && (the_file->openMode != GF_ISOM_OPEN_READ)) return GF_NOT_SUPPORTED;
+
+	stbl = trak->Media->information->sampleTable;
+	stbl->use_sample_index = enable;
+	if (!enable) stbl_ResetSampleIndex(stbl);
+	return GF_OK;
+}
+
 //get the number of edited segment
 GF_EXPORT
 Bool gf_isom_get_edit_list_type(GF_ISOFile *the_file, u32 trackNumber, s64 *mediaOffset)
@@ -2393,6 +2847,7 @@ GF_Err gf_isom_reset_tables(GF_ISOFile *movie, Bool reset_sample_count)
 			}
 		}
 
+		stbl_ResetSampleIndex(stbl);
 		RECREATE_BOX(stbl->ChunkOffset, (GF_Box *));
 		RECREATE_BOX(stbl->CompositionOffset, (GF_CompositionOffsetBox *));
 		RECREATE_BOX(stbl->DegradationPriority, (GF_DegradationPriorityBox *));
@@ -2499,6 +2954,7 @@ GF_Err gf_isom_release_segment(GF_ISOFile *movie, Bool reset_tables)
 				}
 			}
 
+			stbl_ResetSampleIndex(stbl);
 			RECREATE_BOX(stbl->ChunkOffset, (GF_Box *));
 			RECREATE_BOX(stbl->CompositionOffset, (GF_CompositionOffsetBox *));
 			RECREATE_BOX(stbl->DegradationPriority, (GF_DegradationPriorityBox *));
@@ -2784,7 +3240,7 @@ GF_Err gf_isom_get_visual_info(GF_ISOFile *movie, u32 trackNumber, u32 StreamDes
 	GF_SampleEntryBox *entry;
 	GF_SampleDescriptionBox *stsd;
 
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return GF_BAD_PARAM;
 
 	stsd = trak->Media->information->sampleTable->SampleDescription;
@@ -2833,7 +3289,7 @@ GF_Err gf_isom_get_audio_info(GF_ISOFile *movie, u32 trackNumber, u32 StreamDesc
 	GF_SampleEntryBox *entry;
 	GF_SampleDescriptionBox *stsd;
 
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return GF_BAD_PARAM;
 
 	stsd = trak->Media->information->sampleTable->SampleDescription;
@@ -2870,7 +3326,7 @@ GF_Err gf_isom_get_pixel_aspect_ratio(GF_ISOFile *movie, u32 trackNumber, u32 St
 	GF_VisualSampleEntryBox *entry;
 	GF_SampleDescriptionBox *stsd;
 
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak || !hSpacing || !vSpacing) return GF_BAD_PARAM;
 	*hSpacing = 1;
 	*vSpacing = 1;
@@ -2953,7 +3409,7 @@ u8 gf_isom_get_pl_indication(GF_ISOFile *movie, u8 PL_Code)
 GF_EXPORT
 GF_Err gf_isom_get_track_matrix(GF_ISOFile *the_file, u32 trackNumber, u32 matrix[9])
 {
-	GF_TrackBox *trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	GF_TrackBox *trak = gf_isom_get_track_info_from_file(the_file, trackNumber);
 	if (!trak || !trak->Header) return GF_BAD_PARAM;
 	memcpy(matrix, trak->Header->matrix, sizeof(trak->Header->matrix));
 	return GF_OK;
@@ -2962,7 +3418,7 @@ GF_Err gf_isom_get_track_matrix(GF_ISOFile *the_file, u32 trackNumber, u32 matri
 GF_EXPORT
 GF_Err gf_isom_get_track_layout_info(GF_ISOFile *movie, u32 trackNumber, u32 *width, u32 *height, s32 *translation_x, s32 *translation_y, s16 *layer)
 {
-	GF_TrackBox *tk = gf_isom_get_track_from_file(movie, trackNumber);
+	GF_TrackBox *tk = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!tk) return GF_BAD_PARAM;
 	if (width) *width = tk->Header->width>>16;
 	if (height) *height = tk->Header->height>>16;
@@ -3264,7 +3720,7 @@ GF_Err gf_isom_get_track_switch_group_count(GF_ISOFile *movie, u32 trackNumber,
 	GF_UserDataMap *map;
 	GF_TrackBox *trak;
 
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!trak) return GF_BAD_PARAM;
 	*alternateGroupID = trak->Header->alternate_group;
 	*nb_groups = 0;
@@ -3283,7 +3739,7 @@ const u32 *gf_isom_get_track_switch_parameter(GF_ISOFile *movie, u32 trackNumber
 	GF_UserDataMap *map;
 	GF_TrackSelectionBox *tsel;
 
-	trak = gf_isom_get_track_from_file(movie, trackNumber);
+	trak = gf_isom_get_track_info_from_file(movie, trackNumber);
 	if (!group_index || !trak || !trak->udta) return NULL;
 
 	map = udta_getEntry(trak->udta, GF_ISOM_BOX_TYPE_TSEL, NULL);
@@ -3395,6 +3851,7 @@ void gf_isom_reset_fragment_info(GF_ISOFile *movie, Bool keep_sample_count)
 	for (i=0; i<gf_list_count(movie->moov->trackList); i++) {
 		GF_TrackBox *trak = (GF_TrackBox*)gf_list_get(movie->moov->trackList, i);
 		trak->Media->information->sampleTable->SampleSize->sampleCount = 0;
+		stbl_ResetSampleIndex(trak->Media->information->sampleTable);
 #ifdef GPAC_DISABLE_ISOM_FRAGMENTS
 	}
 #else
@@ -100,7 +100,7 @@ static GF_Err gf_isom_get_3gpp_audio_esd(GF_SampleTableBox *stbl, GF_GenericAudi
 		memset(szName, 0, 80);
 		strcpy(szName, "QCELP-13K(GPAC-emulated)");
 		gf_bs_write_data(bs, szName, 80);
-		ent = &stbl->TimeToSample->entries[0];
+		ent = (stbl->TimeToSample && stbl->TimeToSample->nb_entries) ? &stbl->TimeToSample->entries[0] : NULL;
 		sample_rate = entry->samplerate_hi;
 		block_size = ent ? ent->sampleDelta : 160;
 		gf_bs_write_u16_le(bs, 8*sample_size*sample_rate/block_size);
@@ -350,6 +350,7 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 	u64 offset, new_size;
 	u8 isEdited;
 	GF_SampleEntryBox *entry;
+	GF_SampleIndex *idx;
 
 	if (!mdia || !mdia->information->sampleTable) return GF_BAD_PARAM;
 	if (!mdia->information->sampleTable->SampleSize)
@@ -358,26 +359,34 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 	//OK, here we go....
 	if (sampleNumber > mdia->information->sampleTable->SampleSize->sampleCount) return GF_BAD_PARAM;
 
-	//get the DTS
-	e = stbl_GetSampleDTS(mdia->information->sampleTable->TimeToSample, sampleNumber, &(*samp)->DTS);
-	if (e) return e;
-	//the CTS offset
-	if (mdia->information->sampleTable->CompositionOffset) {
-		e = stbl_GetSampleCTS(mdia->information->sampleTable->CompositionOffset , sampleNumber, &(*samp)->CTS_Offset);
-		if (e) return e;
+	idx = stbl_GetSampleIndex(mdia->information->sampleTable);
+	if (idx) {
+		(*samp)->DTS = idx->dts[sampleNumber-1];
+		(*samp)->CTS_Offset = idx->cts_offsets[sampleNumber-1];
+		(*samp)->dataLength = idx->sizes[sampleNumber-1];
+		(*samp)->IsRAP = idx->raps[sampleNumber-1];
 	} else {
-		(*samp)->CTS_Offset = 0;
-	}
-	//the size
-	e = stbl_GetSampleSize(mdia->information->sampleTable->SampleSize, sampleNumber, &(*samp)->dataLength);
-	if (e) return e;
-	//the RAP
-	if (mdia->information->sampleTable->SyncSample) {
-		e = stbl_GetSampleRAP(mdia->information->sampleTable->SyncSample, sampleNumber, &(*samp)->IsRAP, NULL, NULL);
+		//get the DTS
+		e = stbl_GetSampleDTS(mdia->information->sampleTable->TimeToSample, sampleNumber, &(*samp)->DTS);
 		if (e) return e;
-	} else {
-		//if no SyncSample, all samples are sync (cf spec)
-		(*samp)->IsRAP = RAP;
+		//the CTS offset
+		if (mdia->information->sampleTable->CompositionOffset) {
+			e = stbl_GetSampleCTS(mdia->information->sampleTable->CompositionOffset , sampleNumber, &(*samp)->CTS_Offset);
+			if (e) return e;
+		} else {
+			(*samp)->CTS_Offset = 0;
+		}
+		//the size
+		e = stbl_GetSampleSize(mdia->information->sampleTable->SampleSize, sampleNumber, &(*samp)->dataLength);
+		if (e) return e;
+		//the RAP
+		if (mdia->information->sampleTable->SyncSample) {
+			e = stbl_GetSampleRAP(mdia->information->sampleTable->SyncSample, sampleNumber, &(*samp)->IsRAP, NULL, NULL);
+			if (e) return e;
+		} else {
+			//if no SyncSample, all samples are sync (cf spec)
+			(*samp)->IsRAP = RAP;
+		}
 	}
 	/*overwrite sync sample with sample dep if any*/
 	if (mdia->information->sampleTable->SampleDep) {
@@ -400,8 +409,15 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 	if (!sIDX) return GF_OK;
 
 	(*sIDX) = 0;
-	e = stbl_GetSampleInfos(mdia->information->sampleTable, sampleNumber, &offset, &chunkNumber, sIDX, &isEdited);
-	if (e) return e;
+	if (idx) {
+		//index is only used in read mode, samples are never edited
+		offset = idx->offsets[sampleNumber-1];
+		(*sIDX) = idx->desc_indexes[sampleNumber-1];
+		isEdited = 0;
+	} else {
+		e = stbl_GetSampleInfos(mdia->information->sampleTable, sampleNumber, &offset, &chunkNumber, sIDX, &isEdited);
+		if (e) return e;
+	}
 
 	//then get the DataRef
 	e = Media_GetSampleDesc(mdia, *sIDX, &entry, &dataRefIndex);
@@ -448,16 +464,28 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 		return GF_IO_ERR;
 	}
 	mdia->BytesMissing = 0;
+	return Media_RewriteSample(mdia, *samp, sampleNumber, *sIDX);
+}
+
+/*applies the sample transformations (OD frame, NALU and text rewriting) to a sample whose data has just been loaded*/
+GF_Err Media_RewriteSample(GF_MediaBox *mdia, GF_ISOSample *samp, u32 sampleNumber, u32 sampleDescIndex)
+{
+	GF_Err e;
+	GF_SampleEntryBox *entry;
+
+	e = Media_GetSampleDesc(mdia, sampleDescIndex, &entry, NULL);
+	if (e) return e;
+
 	//finally rewrite the sample if this is an OD Access Unit
 	if (mdia->handler->handlerType == GF_ISOM_MEDIA_OD) {
-		e = Media_RewriteODFrame(mdia, *samp);
+		e = Media_RewriteODFrame(mdia, samp);
 		if (e) return e;
 	}
 	/*FIXME: we do NOT rewrite sample if we have a encrypted track*/
 	else if (gf_isom_is_nalu_based_entry(mdia, entry) &&
 	         !gf_isom_is_track_encrypted(mdia->mediaTrack->moov->mov, gf_isom_get_tracknum_from_id(mdia->mediaTrack->moov, mdia->mediaTrack->Header->trackID))
 	        ) {
-		e = gf_isom_nalu_sample_rewrite(mdia, *samp, sampleNumber, (GF_MPEGVisualSampleEntryBox *)entry);
+		e = gf_isom_nalu_sample_rewrite(mdia, samp, sampleNumber, (GF_MPEGVisualSampleEntryBox *)entry);
 		if (e) return e;
 	}
 	else if (mdia->mediaTrack->moov->mov->convert_streaming_text
@@ -466,12 +494,12 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 	        ) {
 		u64 dur;
 		if (sampleNumber == mdia->information->sampleTable->SampleSize->sampleCount) {
-			dur = mdia->mediaHeader->duration - (*samp)->DTS;
+			dur = mdia->mediaHeader->duration - samp->DTS;
 		} else {
 			stbl_GetSampleDTS(mdia->information->sampleTable->TimeToSample, sampleNumber+1, &dur);
-			dur -= (*samp)->DTS;
+			dur -= samp->DTS;
 		}
-		e = gf_isom_rewrite_text_sample(*samp, *sIDX, (u32) dur);
+		e = gf_isom_rewrite_text_sample(samp, sampleDescIndex, (u32) dur);
 		if (e) return e;
 	}
 	return GF_OK;
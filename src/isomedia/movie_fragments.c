@@ -150,6 +150,9 @@ GF_Err gf_isom_finalize_for_fragment(GF_ISOFile *movie, u32 media_segment_type)
 		//write movie
 		e = WriteToFile(movie);
 		if (e) return e;
+		/*streaming mode: send the init segment right away*/
+		e = gf_isom_flush_block_out(movie);
+		if (e) return e;
 	}
 
 	//make sure we do have all we need. If not this is not an error, just consider
@@ -437,7 +440,8 @@ u32 UpdateRuns(GF_ISOFile *movie, GF_TrackFragmentBox *traf)
 	sampleCount = 0;
 
 #ifndef USE_BASE_DATA_OFFSET
-	if (movie->use_segments) {
+	/*in streaming mode the edit map is reset after each fragment, absolute offsets cannot be used*/
+	if (movie->use_segments || movie->on_block_out) {
 		traf->tfhd->flags = GF_ISOM_MOOF_BASE_OFFSET;
 	} else
 #endif
@@ -745,7 +749,7 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 {
 	GF_Err e;
 	u64 moof_start, pos;
-	u32 size, i, s_count, mdat_size;
+	u32 i, s_count, mdat_size;
 	s32 offset;
 	char *buffer;
 	GF_TrackFragmentBox *traf;
@@ -768,10 +772,8 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 		//update offset
 		trun->data_offset = (u32) (gf_bs_get_position(bs) - movie->moof->fragment_offset - 8);
 		//write cache
-		gf_bs_get_content(trun->cache, &buffer, &size);
-		gf_bs_write_data(bs, buffer, size);
+		gf_bs_transfer(bs, trun->cache);
 		gf_bs_del(trun->cache);
-		gf_free(buffer);
 		trun->cache = NULL;
 		traf->DataCache=0;
 	}
@@ -785,12 +787,10 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 			gf_bs_seek(bs, 0);
 			/*write mdat size*/
 			gf_bs_write_u32(bs, (u32) movie->moof->mdat_size);
-			/*and get internal buffer*/
+			/*and keep the bitstream blocks until the fragment is written to the segment*/
 			gf_bs_seek(bs, movie->moof->mdat_size);
-			gf_bs_get_content(bs, &movie->moof->mdat, &movie->moof->mdat_size);
-
-			gf_bs_del(bs);
-			movie->editFileMap->bs = gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+			movie->moof->mdat_bs = bs;
+			movie->editFileMap->bs = gf_bs_new_chunked(0);
 		} else {
 			u64 offset = movie->segment_start;
 			gf_bs_seek(bs, offset);
@@ -817,7 +817,7 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 	}
 
 	//2- update MOOF MDAT header
-	if (!movie->moof->mdat) {
+	if (!movie->moof->mdat && !movie->moof->mdat_bs) {
 		gf_bs_seek(bs, movie->moof->fragment_offset);
 		//we assume we never write large MDATs in fragment mode which should always be true
 		mdat_size = (u32) (moof_start - movie->moof->fragment_offset);
@@ -829,7 +829,7 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 	/*estimate moof size and shift trun offsets*/
 #ifndef USE_BASE_DATA_OFFSET
 	offset = 0;
-	if (movie->use_segments) {
+	if (movie->use_segments || movie->on_block_out) {
 		e = gf_isom_box_size((GF_Box *) movie->moof);
 		if (e) return e;
 		offset = (s32) movie->moof->size;
@@ -857,7 +857,7 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 
 	buffer = NULL;
 	/*rewind bitstream and load mdat in memory */
-	if (movie->moof_first && !movie->moof->mdat) {
+	if (movie->moof_first && !movie->moof->mdat && !movie->moof->mdat_bs) {
 		buffer = (char*)gf_malloc(sizeof(char)*mdat_size);
 		gf_bs_seek(bs, movie->moof->fragment_offset);
 		gf_bs_read_data(bs, buffer, mdat_size);
@@ -873,7 +873,7 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 	DECIDE NOT TO USE THE DATA-OFFSET FLAG*/
 	if (movie->moof_first
 #ifndef USE_BASE_DATA_OFFSET
-	        && !movie->use_segments
+	        && !movie->use_segments && !movie->on_block_out
 #endif
 	   ) {
 		i=0;
@@ -884,7 +884,7 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 		}
 	}
 #ifndef USE_BASE_DATA_OFFSET
-	else if (movie->use_segments) {
+	else if (movie->use_segments || movie->on_block_out) {
 		if (offset != (movie->moof->size+8)) {
 			offset = (s32) (movie->moof->size + 8 - offset);
 			update_trun_offsets(movie, offset);
@@ -915,7 +915,12 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 	if (e) return e;
 
 	//rewrite mdat after moof
-	if (movie->moof->mdat) {
+	if (movie->moof->mdat_bs) {
+		e = gf_bs_transfer(bs, movie->moof->mdat_bs);
+		gf_bs_del(movie->moof->mdat_bs);
+		movie->moof->mdat_bs = NULL;
+		if (e) return e;
+	} else if (movie->moof->mdat) {
 		gf_bs_write_data(bs, movie->moof->mdat, movie->moof->mdat_size);
 		gf_free(movie->moof->mdat);
 		movie->moof->mdat = NULL;
@@ -929,6 +934,9 @@ GF_Err StoreFragment(GF_ISOFile *movie, Bool load_mdat_only, s32 data_offset_dif
 	if (!movie->use_segments) {
 		gf_isom_box_del((GF_Box *) movie->moof);
 		movie->moof = NULL;
+		/*streaming mode: send the fragment and restart from an empty edit map*/
+		e = gf_isom_flush_block_out(movie);
+		if (e) return e;
 	}
 	return GF_OK;
 }
@@ -954,6 +962,8 @@ GF_Err gf_isom_allocate_sidx(GF_ISOFile *movie, s32 subsegs_per_sidx, Bool daisy
 	if (movie->openMode != GF_ISOM_OPEN_WRITE) return GF_ISOM_INVALID_MODE;
 	if (movie->root_sidx) return GF_BAD_PARAM;
 	if (movie->moof) return GF_BAD_PARAM;
+	/*the SIDX is rewritten once all segments are done, which is not possible once data has been sent*/
+	if (movie->on_block_out) return GF_NOT_SUPPORTED;
 	if (gf_list_count(movie->moof_list)) return GF_BAD_PARAM;
 
 	movie->root_sidx = (GF_SegmentIndexBox *)gf_isom_box_new(GF_ISOM_BOX_TYPE_SIDX);
@@ -1015,6 +1025,9 @@ GF_EXPORT
 GF_Err gf_isom_flush_fragments(GF_ISOFile *movie, Bool last_segment)
 {
 	GF_BitStream *temp_bs = NULL;
+	GF_BitStream *file_bs = NULL;
+	char *chunk = NULL;
+	u32 chunk_size = 0;
 	GF_Err e;
 
 	if (!movie || !(movie->FragmentsFlags & GF_ISOM_FRAG_WRITE_READY) ) return GF_BAD_PARAM;
@@ -1034,12 +1047,17 @@ GF_Err gf_isom_flush_fragments(GF_ISOFile *movie, Bool last_segment)
 	gf_bs_seek(movie->editFileMap->bs, movie->segment_start);
 	gf_bs_truncate(movie->editFileMap->bs);
 
+	/*chunk callback: the fragments are written in memory, then copied to the file and sent. Segment fragments only use moof-relative offsets*/
+	if (movie->on_segment_chunk) {
+		file_bs = movie->editFileMap->bs;
+		movie->editFileMap->bs = gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+	}
+
 	/*write styp to file if needed*/
 	e = gf_isom_write_styp(movie, last_segment);
-	if (e) return e;
 
 	/*write all pending fragments to file*/
-	while (gf_list_count(movie->moof_list)) {
+	while (!e && gf_list_count(movie->moof_list)) {
 		s32 offset_diff;
 		u32 moof_size;
 
@@ -1050,12 +1068,23 @@ GF_Err gf_isom_flush_fragments(GF_ISOFile *movie, Bool last_segment)
 		movie->moof->fragment_offset = gf_bs_get_position(movie->editFileMap->bs);
 
 		e = StoreFragment(movie, GF_FALSE, offset_diff, &moof_size);
-		if (e) return e;
+		if (e) break;
 
 		gf_isom_box_del((GF_Box *) movie->moof);
 		movie->moof = NULL;
 	}
 
+	if (file_bs) {
+		gf_bs_get_content(movie->editFileMap->bs, &chunk, &chunk_size);
+		gf_bs_del(movie->editFileMap->bs);
+		movie->editFileMap->bs = file_bs;
+		if (!e && chunk_size) gf_bs_write_data(file_bs, chunk, chunk_size);
+	}
+	if (e) {
+		if (chunk) gf_free(chunk);
+		return e;
+	}
+
 	/*append mode: store fragment at the end of the regular movie bitstream, and delete the temp bitstream*/
 	if (movie->append_segment) {
 		char bloc[1024];
@@ -1072,7 +1101,14 @@ GF_Err gf_isom_flush_fragments(GF_ISOFile *movie, Bool last_segment)
 		movie->editFileMap = gf_isom_fdm_new_temp(NULL);
 	} else {
 		gf_isom_datamap_flush(movie->editFileMap);
+		/*streaming mode: send the fragments and restart from an empty edit map*/
+		e = gf_isom_flush_block_out(movie);
 	}
+	if (chunk) {
+		if (!e && chunk_size) e = movie->on_segment_chunk(movie->on_segment_chunk_usr_data, chunk, chunk_size);
+		gf_free(chunk);
+	}
+	if (e) return e;
 	movie->segment_start = gf_bs_get_position(movie->editFileMap->bs);
 
 	if (temp_bs) {
@@ -1082,6 +1118,15 @@ GF_Err gf_isom_flush_fragments(GF_ISOFile *movie, Bool last_segment)
 	return GF_OK;
 }
 
+GF_EXPORT
+GF_Err gf_isom_set_segment_chunk_callback(GF_ISOFile *movie, gf_isom_on_block_out on_chunk, void *usr_data)
+{
+	if (!movie) return GF_BAD_PARAM;
+	movie->on_segment_chunk = on_chunk;
+	movie->on_segment_chunk_usr_data = usr_data;
+	return GF_OK;
+}
+
 typedef struct
 {
 	GF_SegmentIndexBox *sidx;
@@ -1155,6 +1200,16 @@ GF_Err gf_isom_close_segment(GF_ISOFile *movie, s32 subsegments_per_sidx, u32 re
 				gf_bs_write_u32(movie->editFileMap->bs, 8);	//write size field
 				gf_bs_write_u32(movie->editFileMap->bs, segment_marker_4cc); //write box type field
 			}
+			/*fragments were already flushed, make the segment complete on disk*/
+			gf_isom_datamap_flush(movie->append_segment ? movie->movieFileMap : movie->editFileMap);
+			if (movie->on_segment_chunk) {
+				char marker[8];
+				GF_BitStream *bs = gf_bs_new(marker, 8, GF_BITSTREAM_WRITE);
+				gf_bs_write_u32(bs, 8);
+				gf_bs_write_u32(bs, segment_marker_4cc);
+				gf_bs_del(bs);
+				return movie->on_segment_chunk(movie->on_segment_chunk_usr_data, marker, 8);
+			}
 		}
 		return GF_OK;
 	}
@@ -1546,6 +1601,10 @@ GF_Err gf_isom_close_segment(GF_ISOFile *movie, s32 subsegments_per_sidx, u32 re
 		}
 		gf_isom_datamap_del(movie->editFileMap);
 		movie->editFileMap = gf_isom_fdm_new_temp(NULL);
+	} else if (!e) {
+		/*streaming mode: send the segment and restart from an empty edit map*/
+		e = gf_isom_flush_block_out(movie);
+		movie->segment_start = 0;
 	}
 
 	return e;
@@ -1574,6 +1633,8 @@ GF_Err gf_isom_start_segment(GF_ISOFile *movie, const char *SegName, Bool memory
 
 	movie->segment_bs = NULL;
 	movie->append_segment = GF_FALSE;
+	/*in streaming mode, segments are sent to the write callback*/
+	if (SegName && movie->on_block_out) return GF_BAD_PARAM;
 	/*update segment file*/
 	if (SegName) {
 		gf_isom_datamap_del(movie->editFileMap);
@@ -1592,7 +1653,7 @@ GF_Err gf_isom_start_segment(GF_ISOFile *movie, const char *SegName, Bool memory
 	/*create a memory bitstream for all file IO until final flush*/
 	if (memory_mode) {
 		movie->segment_bs = movie->editFileMap->bs;
-		movie->editFileMap->bs = gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+		movie->editFileMap->bs = gf_bs_new_chunked(0);
 	}
 	return GF_OK;
 }
@@ -1623,8 +1684,8 @@ GF_Err gf_isom_start_fragment(GF_ISOFile *movie, Bool moof_first)
 	if (!count)
 		return GF_BAD_PARAM;
 
-	/*always force cached mode when writing movie segments*/
-	if (movie->use_segments) moof_first = GF_TRUE;
+	/*always force cached mode when writing movie segments or streaming*/
+	if (movie->use_segments || movie->on_block_out) moof_first = GF_TRUE;
 	movie->moof_first = moof_first;
 
 	//store existing fragment
@@ -1679,8 +1740,7 @@ GF_EXPORT
 GF_Err gf_isom_fragment_add_sample(GF_ISOFile *movie, u32 TrackID, const GF_ISOSample *sample, u32 DescIndex,
                                    u32 Duration, u8 PaddingBits, u16 DegradationPriority, Bool redundant_coding)
 {
-	u32 count, buffer_size;
-	char *buffer;
+	u32 count;
 	u64 pos;
 	GF_ISOSample *od_sample = NULL;
 	GF_TrunEntry *ent;
@@ -1706,11 +1766,9 @@ GF_Err gf_isom_fragment_add_sample(GF_ISOFile *movie, u32 TrackID, const GF_ISOS
 			if (count) {
 				trun = (GF_TrackFragmentRunBox *)gf_list_get(traf->TrackRuns, count-1);
 				trun->data_offset = (u32) (pos - movie->moof->fragment_offset - 8);
-				gf_bs_get_content(trun->cache, &buffer, &buffer_size);
-				gf_bs_write_data(movie->editFileMap->bs, buffer, buffer_size);
+				gf_bs_transfer(movie->editFileMap->bs, trun->cache);
 				gf_bs_del(trun->cache);
 				trun->cache = NULL;
-				gf_free(buffer);
 			}
 		}
 		traf_2 = (GF_TrackFragmentBox *) gf_isom_box_new(GF_ISOM_BOX_TYPE_TRAF);
@@ -1749,11 +1807,9 @@ GF_Err gf_isom_fragment_add_sample(GF_ISOFile *movie, u32 TrackID, const GF_ISOS
 		//if data cache is on and we're changing TRUN, store the cache and update data offset
 		if (!count && traf->DataCache) {
 			trun->data_offset = (u32) (pos - movie->moof->fragment_offset - 8);
-			gf_bs_get_content(trun->cache, &buffer, &buffer_size);
-			gf_bs_write_data(movie->editFileMap->bs, buffer, buffer_size);
+			gf_bs_transfer(movie->editFileMap->bs, trun->cache);
 			gf_bs_del(trun->cache);
 			trun->cache = NULL;
-			gf_free(buffer);
 		}
 	}
 
@@ -1766,7 +1822,7 @@ GF_Err gf_isom_fragment_add_sample(GF_ISOFile *movie, u32 TrackID, const GF_ISOS
 
 		//if we use data caching, create a bitstream
 		if (traf->DataCache)
-			trun->cache = gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+			trun->cache = gf_bs_new_chunked(0);
 	}
 
 	GF_SAFEALLOC(ent, GF_TrunEntry);
@@ -34,6 +34,7 @@ GF_Err findEntryForTime(GF_SampleTableBox *stbl, u64 DTS, u8 useCTS, u32 *sample
 	s32 CTSOffset;
 	u64 curDTS;
 	GF_SttsEntry *ent;
+	GF_SampleIndex *idx;
 	(*sampleNumber) = 0;
 	(*prevSampleNumber) = 0;
 
@@ -43,6 +44,25 @@ GF_Err findEntryForTime(GF_SampleTableBox *stbl, u64 DTS, u8 useCTS, u32 *sample
 	decoding order. */
 	useCTS = 0;
 
+	//use the sample index if any: binary search of the first sample with DTS >= target
+	idx = stbl_GetSampleIndex(stbl);
+	if (idx) {
+		u32 lo = 0, hi = idx->nb_samples;
+		while (lo < hi) {
+			u32 mid = lo + (hi - lo) / 2;
+			if (idx->dts[mid] < DTS) lo = mid + 1;
+			else hi = mid;
+		}
+		//after all DTSs
+		if (lo == idx->nb_samples) return GF_OK;
+		if (idx->dts[lo] == DTS) {
+			(*sampleNumber) = lo + 1;
+		} else {
+			(*prevSampleNumber) = lo ? lo : 1;
+		}
+		return GF_OK;
+	}
+
 	//our cache
 	if (stbl->TimeToSample->r_FirstSampleInEntry &&
 	        (DTS >= stbl->TimeToSample->r_CurrentDTS) ) {
@@ -493,6 +513,160 @@ sample_found:
 }
 
 
+static GF_Err stbl_IndexSampleInfos(GF_SampleTableBox *stbl, GF_SampleIndex *idx, u32 first_sample, u32 nb_samples)
+{
+	u32 i, k, j, sample_num, nb_co, size=0;
+	u64 offset;
+	GF_StscEntry *ent;
+	GF_SampleToChunkBox *stsc = stbl->SampleToChunk;
+
+	if (!stbl->ChunkOffset || !stsc) return GF_ISOM_INVALID_FILE;
+	if (stbl->ChunkOffset->type == GF_ISOM_BOX_TYPE_STCO) nb_co = ((GF_ChunkOffsetBox *)stbl->ChunkOffset)->nb_entries;
+	else nb_co = ((GF_ChunkLargeOffsetBox *)stbl->ChunkOffset)->nb_entries;
+
+	//same shortcut as stbl_GetSampleInfos: one entry per sample
+	if (stsc->nb_entries == stbl->SampleSize->sampleCount) {
+		for (sample_num = first_sample; sample_num <= nb_samples; sample_num++) {
+			if (sample_num > nb_co) return GF_ISOM_INVALID_FILE;
+			ent = &stsc->entries[sample_num-1];
+			idx->desc_indexes[sample_num-1] = ent->sampleDescriptionIndex;
+			if (stbl->ChunkOffset->type == GF_ISOM_BOX_TYPE_STCO) idx->offsets[sample_num-1] = ((GF_ChunkOffsetBox *)stbl->ChunkOffset)->offsets[sample_num-1];
+			else idx->offsets[sample_num-1] = ((GF_ChunkLargeOffsetBox *)stbl->ChunkOffset)->offsets[sample_num-1];
+		}
+		return GF_OK;
+	}
+
+	//walk chunks sequentially, only browsing samples of the chunks we need to index
+	sample_num = 1;
+	for (i=0; i<stsc->nb_entries; i++) {
+		ent = &stsc->entries[i];
+		//this overwrites stbl_GetSampleInfos cache, but the ghost number is recomputed when the cache is used
+		GetGhostNum(ent, i, stsc->nb_entries, stbl);
+		for (k=0; k<stsc->ghostNumber; k++) {
+			u32 chunk_num = ent->firstChunk + k;
+			if (sample_num + ent->samplesPerChunk <= first_sample) {
+				sample_num += ent->samplesPerChunk;
+				continue;
+			}
+			if (!chunk_num || (chunk_num > nb_co)) return GF_ISOM_INVALID_FILE;
+			if (stbl->ChunkOffset->type == GF_ISOM_BOX_TYPE_STCO) offset = ((GF_ChunkOffsetBox *)stbl->ChunkOffset)->offsets[chunk_num-1];
+			else offset = ((GF_ChunkLargeOffsetBox *)stbl->ChunkOffset)->offsets[chunk_num-1];
+
+			for (j=0; j<ent->samplesPerChunk; j++) {
+				if (sample_num > nb_samples) return GF_OK;
+				if (sample_num >= first_sample) {
+					idx->offsets[sample_num-1] = offset;
+					idx->desc_indexes[sample_num-1] = ent->sampleDescriptionIndex;
+					size = idx->sizes[sample_num-1];
+				} else {
+					stbl_GetSampleSize(stbl->SampleSize, sample_num, &size);
+				}
+				offset += size;
+				sample_num++;
+			}
+		}
+	}
+	if (sample_num <= nb_samples) return GF_ISOM_INVALID_FILE;
+	return GF_OK;
+}
+
+void stbl_ResetSampleIndex(GF_SampleTableBox *stbl)
+{
+	GF_SampleIndex *idx = stbl->sample_index;
+	if (!idx) return;
+	if (idx->offsets) gf_free(idx->offsets);
+	if (idx->dts) gf_free(idx->dts);
+	if (idx->sizes) gf_free(idx->sizes);
+	if (idx->cts_offsets) gf_free(idx->cts_offsets);
+	if (idx->desc_indexes) gf_free(idx->desc_indexes);
+	if (idx->raps) gf_free(idx->raps);
+	gf_free(idx);
+	stbl->sample_index = NULL;
+}
+
+GF_SampleIndex *stbl_GetSampleIndex(GF_SampleTableBox *stbl)
+{
+	GF_Err e;
+	u32 i, first, count;
+	GF_SampleIndex *idx;
+
+	if (!stbl->use_sample_index) return NULL;
+	if (!stbl->SampleSize || !stbl->TimeToSample) return NULL;
+	count = stbl->SampleSize->sampleCount;
+
+	idx = stbl->sample_index;
+	//tables have been reset, rebuild
+	if (idx && (idx->nb_samples > count)) {
+		stbl_ResetSampleIndex(stbl);
+		idx = NULL;
+	}
+	if (idx && (idx->nb_samples == count)) return idx;
+
+	if (!idx) {
+		GF_SAFEALLOC(idx, GF_SampleIndex);
+		if (!idx) return NULL;
+		stbl->sample_index = idx;
+	}
+	//new samples were added (fragment merge), extend the index
+	if (idx->nb_alloc < count) {
+		u64 *offsets, *dts;
+		u32 *sizes, *desc_indexes;
+		s32 *cts_offsets;
+		u8 *raps;
+		//a failed realloc keeps the previous buffer, which is freed with the index
+		offsets = (u64*)gf_realloc(idx->offsets, sizeof(u64) * count);
+		if (offsets) idx->offsets = offsets;
+		dts = (u64*)gf_realloc(idx->dts, sizeof(u64) * count);
+		if (dts) idx->dts = dts;
+		sizes = (u32*)gf_realloc(idx->sizes, sizeof(u32) * count);
+		if (sizes) idx->sizes = sizes;
+		cts_offsets = (s32*)gf_realloc(idx->cts_offsets, sizeof(s32) * count);
+		if (cts_offsets) idx->cts_offsets = cts_offsets;
+		desc_indexes = (u32*)gf_realloc(idx->desc_indexes, sizeof(u32) * count);
+		if (desc_indexes) idx->desc_indexes = desc_indexes;
+		raps = (u8*)gf_realloc(idx->raps, sizeof(u8) * count);
+		if (raps) idx->raps = raps;
+		if (!offsets || !dts || !sizes || !cts_offsets || !desc_indexes || !raps) {
+			e = GF_OUT_OF_MEM;
+			goto err_exit;
+		}
+		idx->nb_alloc = count;
+	}
+
+	//sequential access to the tables, all box caches are used
+	first = idx->nb_samples + 1;
+	for (i=first; i<=count; i++) {
+		SAPType is_rap;
+		e = stbl_GetSampleDTS(stbl->TimeToSample, i, &idx->dts[i-1]);
+		if (e) goto err_exit;
+		idx->cts_offsets[i-1] = 0;
+		if (stbl->CompositionOffset) {
+			e = stbl_GetSampleCTS(stbl->CompositionOffset, i, &idx->cts_offsets[i-1]);
+			if (e) goto err_exit;
+		}
+		e = stbl_GetSampleSize(stbl->SampleSize, i, &idx->sizes[i-1]);
+		if (e) goto err_exit;
+		is_rap = RAP;
+		if (stbl->SyncSample) {
+			e = stbl_GetSampleRAP(stbl->SyncSample, i, &is_rap, NULL, NULL);
+			if (e) goto err_exit;
+		}
+		idx->raps[i-1] = is_rap;
+	}
+	e = stbl_IndexSampleInfos(stbl, idx, first, count);
+	if (e) goto err_exit;
+
+	idx->nb_samples = count;
+	return idx;
+
+err_exit:
+	GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[iso file] Failed to build sample index: %s - disabling index\n", gf_error_to_string(e) ));
+	stbl_ResetSampleIndex(stbl);
+	stbl->use_sample_index = GF_FALSE;
+	return NULL;
+}
+
+
 GF_Err stbl_GetSampleShadow(GF_ShadowSyncBox *stsh, u32 *sampleNumber, u32 *syncNum)
 {
 	u32 i, count;
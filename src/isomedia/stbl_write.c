@@ -474,6 +474,7 @@ GF_Err stbl_AddRedundant(GF_SampleTableBox *stbl, u32 sampleNumber)
 	if (sdtp->sampleCount + 1 < sampleNumber) {
 		u32 missed = sampleNumber-1 - sdtp->sampleCount;
 		sdtp->sample_info = (u8*) gf_realloc(sdtp->sample_info, sizeof(u8) * (sdtp->sampleCount+missed) );
+		sdtp->alloc_size = sdtp->sampleCount+missed;
 		memset(&sdtp->sample_info[sdtp->sampleCount], 0, sizeof(u8) * missed );
 		while (missed) {
 			SAPType isRAP;
@@ -487,6 +488,7 @@ GF_Err stbl_AddRedundant(GF_SampleTableBox *stbl, u32 sampleNumber)
 
 	sdtp->sample_info = (u8*) gf_realloc(sdtp->sample_info, sizeof(u8) * (sdtp->sampleCount + 1));
 	if (!sdtp->sample_info) return GF_OUT_OF_MEM;
+	sdtp->alloc_size = sdtp->sampleCount + 1;
 	if (sdtp->sampleCount < sampleNumber) {
 		sdtp->sample_info[sdtp->sampleCount] = 0x29;
 	} else {
@@ -516,8 +518,12 @@ GF_Err stbl_AppendDependencyType(GF_SampleTableBox *stbl, u32 isLeading, u32 dep
 	flags |= redundant;
 
 
-	sdtp->sample_info = (u8*) gf_realloc(sdtp->sample_info, sizeof(u8) * (sdtp->sampleCount + 1));
-	if (!sdtp->sample_info) return GF_OUT_OF_MEM;
+	if (sdtp->sampleCount >= sdtp->alloc_size) {
+		ALLOC_INC(sdtp->alloc_size);
+		if (sdtp->sampleCount >= sdtp->alloc_size) sdtp->alloc_size = sdtp->sampleCount+1;
+		sdtp->sample_info = (u8*) gf_realloc(sdtp->sample_info, sizeof(u8) * sdtp->alloc_size);
+		if (!sdtp->sample_info) return GF_OUT_OF_MEM;
+	}
 	sdtp->sample_info[sdtp->sampleCount] = flags;
 	sdtp->sampleCount ++;
 	return GF_OK;
@@ -1088,6 +1094,7 @@ GF_Err stbl_RemoveRedundant(GF_SampleTableBox *stbl, u32 SampleNumber)
 	if (i) memmove(&stbl->SampleDep->sample_info[SampleNumber-1], & stbl->SampleDep->sample_info[SampleNumber], sizeof(u8)*i);
 	stbl->SampleDep->sample_info = (u8*)gf_realloc(stbl->SampleDep->sample_info, sizeof(u8) * (stbl->SampleDep->sampleCount-1));
 	stbl->SampleDep->sampleCount-=1;
+	stbl->SampleDep->alloc_size = stbl->SampleDep->sampleCount;
 	return GF_OK;
 }
 
@@ -1126,6 +1133,7 @@ GF_Err stbl_SetPaddingBits(GF_SampleTableBox *stbl, u32 SampleNumber, u8 bits)
 		stbl->PaddingBits->SampleCount = stbl->SampleSize->sampleCount;
 		stbl->PaddingBits->padbits = (u8*)gf_malloc(sizeof(u8)*stbl->PaddingBits->SampleCount);
 		if (!stbl->PaddingBits->padbits) return GF_OUT_OF_MEM;
+		stbl->PaddingBits->alloc_size = stbl->PaddingBits->SampleCount;
 		memset(stbl->PaddingBits->padbits, 0, sizeof(u8)*stbl->PaddingBits->SampleCount);
 	}
 	//realloc (this is needed in case n out of k samples get padding added)
@@ -1139,6 +1147,7 @@ GF_Err stbl_SetPaddingBits(GF_SampleTableBox *stbl, u32 SampleNumber, u8 bits)
 		gf_free(stbl->PaddingBits->padbits);
 		stbl->PaddingBits->padbits = p;
 		stbl->PaddingBits->SampleCount = stbl->SampleSize->sampleCount;
+		stbl->PaddingBits->alloc_size = stbl->PaddingBits->SampleCount;
 	}
 	stbl->PaddingBits->padbits[SampleNumber-1] = bits;
 	return GF_OK;
@@ -1174,6 +1183,7 @@ GF_Err stbl_RemovePaddingBits(GF_SampleTableBox *stbl, u32 SampleNumber)
 	stbl->PaddingBits->SampleCount -= 1;
 	gf_free(stbl->PaddingBits->padbits);
 	stbl->PaddingBits->padbits = p;
+	stbl->PaddingBits->alloc_size = stbl->PaddingBits->SampleCount;
 	return GF_OK;
 }
 
@@ -1414,8 +1424,7 @@ void stbl_AppendChunk(GF_SampleTableBox *stbl, u64 offset)
 {
 	GF_ChunkOffsetBox *stco;
 	GF_ChunkLargeOffsetBox *co64;
-	u32 *new_offsets, i;
-	u64 *off_64;
+	u32 i;
 
 	//we may have to convert the table...
 	if (stbl->ChunkOffset->type==GF_ISOM_BOX_TYPE_STCO) {
@@ -1434,26 +1443,26 @@ void stbl_AppendChunk(GF_SampleTableBox *stbl, u64 offset)
 			return;
 		}
 		//we're fine
-		new_offsets = (u32*)gf_malloc(sizeof(u32)*(stco->nb_entries+1));
-		if (!new_offsets) return;
-		for (i=0; i<stco->nb_entries; i++) new_offsets[i] = stco->offsets[i];
-		new_offsets[i] = (u32) offset;
-		if (stco->offsets) gf_free(stco->offsets);
-		stco->offsets = new_offsets;
+		if (stco->nb_entries >= stco->alloc_size) {
+			ALLOC_INC(stco->alloc_size);
+			if (stco->nb_entries >= stco->alloc_size) stco->alloc_size = stco->nb_entries+1;
+			stco->offsets = (u32*)gf_realloc(stco->offsets, sizeof(u32)*stco->alloc_size);
+			if (!stco->offsets) return;
+		}
+		stco->offsets[stco->nb_entries] = (u32) offset;
 		stco->nb_entries += 1;
-		stco->alloc_size = stco->nb_entries;
 	}
 	//large offsets
 	else {
 		co64 = (GF_ChunkLargeOffsetBox *)stbl->ChunkOffset;
-		off_64 = (u64*)gf_malloc(sizeof(u64)*(co64->nb_entries+1));
-		if (!off_64) return;
-		for (i=0; i<co64->nb_entries; i++) off_64[i] = co64->offsets[i];
-		off_64[i] = offset;
-		if (co64->offsets) gf_free(co64->offsets);
-		co64->offsets = off_64;
+		if (co64->nb_entries >= co64->alloc_size) {
+			ALLOC_INC(co64->alloc_size);
+			if (co64->nb_entries >= co64->alloc_size) co64->alloc_size = co64->nb_entries+1;
+			co64->offsets = (u64*)gf_realloc(co64->offsets, sizeof(u64)*co64->alloc_size);
+			if (!co64->offsets) return;
+		}
+		co64->offsets[co64->nb_entries] = offset;
 		co64->nb_entries += 1;
-		co64->alloc_size = co64->nb_entries;
 	}
 }
 
@@ -1526,18 +1535,21 @@ void stbl_AppendRAP(GF_SampleTableBox *stbl, u8 isRap)
 
 void stbl_AppendPadding(GF_SampleTableBox *stbl, u8 padding)
 {
-	u32 i;
-	u8 *pad_bits;
+	GF_PaddingBitsBox *padb;
 	if (!stbl->PaddingBits) stbl->PaddingBits = (GF_PaddingBitsBox *) gf_isom_box_new(GF_ISOM_BOX_TYPE_PADB);
-
-	pad_bits = (u8*)gf_malloc(sizeof(u8) * stbl->SampleSize->sampleCount);
-	if (!pad_bits) return;
-	memset(pad_bits, 0, sizeof(u8) * stbl->SampleSize->sampleCount);
-	for (i=0; i<stbl->PaddingBits->SampleCount; i++) pad_bits[i] = stbl->PaddingBits->padbits[i];
-	pad_bits[stbl->SampleSize->sampleCount-1] = padding;
-	if (stbl->PaddingBits->padbits) gf_free(stbl->PaddingBits->padbits);
-	stbl->PaddingBits->padbits = pad_bits;
-	stbl->PaddingBits->SampleCount = stbl->SampleSize->sampleCount;
+	padb = stbl->PaddingBits;
+
+	if (padb->alloc_size < stbl->SampleSize->sampleCount) {
+		ALLOC_INC(padb->alloc_size);
+		if (padb->alloc_size < stbl->SampleSize->sampleCount) padb->alloc_size = stbl->SampleSize->sampleCount;
+		padb->padbits = (u8*)gf_realloc(padb->padbits, sizeof(u8) * padb->alloc_size);
+		if (!padb->padbits) return;
+	}
+	//samples merged without padding since the last call have no padding
+	if (padb->SampleCount < stbl->SampleSize->sampleCount)
+		memset(&padb->padbits[padb->SampleCount], 0, sizeof(u8) * (stbl->SampleSize->sampleCount - padb->SampleCount));
+	padb->padbits[stbl->SampleSize->sampleCount-1] = padding;
+	padb->SampleCount = stbl->SampleSize->sampleCount;
 }
 
 void stbl_AppendCTSOffset(GF_SampleTableBox *stbl, u32 CTSOffset)
@@ -1575,6 +1587,7 @@ void stbl_AppendDepType(GF_SampleTableBox *stbl, u32 DepType)
 {
 	if (!stbl->SampleDep) stbl->SampleDep= (GF_SampleDependencyTypeBox *) gf_isom_box_new(GF_ISOM_BOX_TYPE_SDTP);
 	stbl->SampleDep->sample_info = (u8*)gf_realloc(stbl->SampleDep->sample_info, sizeof(u8)*stbl->SampleSize->sampleCount );
+	stbl->SampleDep->alloc_size = stbl->SampleSize->sampleCount;
 	stbl->SampleDep->sample_info[stbl->SampleDep->sampleCount] = DepType;
 	stbl->SampleDep->sampleCount = stbl->SampleSize->sampleCount;
 
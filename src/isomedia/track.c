@@ -35,7 +35,10 @@ GF_TrackBox *GetTrackbyID(GF_MovieBox *moov, u32 TrackID)
 	if (!moov) return NULL;
 	i=0;
 	while ((trak = (GF_TrackBox *)gf_list_enum(moov->trackList, &i))) {
-		if (trak->Header->trackID == TrackID) return trak;
+		if (trak->Header->trackID == TrackID) {
+			gf_isom_load_track_tables(trak);
+			return trak;
+		}
 	}
 	return NULL;
 }
@@ -45,6 +48,8 @@ GF_TrackBox *gf_isom_get_track(GF_MovieBox *moov, u32 trackNumber)
 	GF_TrackBox *trak;
 	if (!moov || !trackNumber || (trackNumber > gf_list_count(moov->trackList))) return NULL;
 	trak = (GF_TrackBox*)gf_list_get(moov->trackList, trackNumber - 1);
+	//sample tables of lazy-loaded files are used by most callers (ESD, sample lookup)
+	gf_isom_load_track_tables(trak);
 	return trak;
 
 }
@@ -59,6 +59,39 @@ struct _dash_component
 	char *lang;
 };
 
+/*segment of a representation timeline, times in DASH timescale*/
+typedef struct
+{
+	u64 start, duration;
+	char *seg_name;
+} DashTimelineEntry;
+
+/*S element of a segment timeline: run of repeat+1 consecutive segments with the same duration*/
+typedef struct
+{
+	u64 duration;
+	u32 repeat;
+} DashTimelineRun;
+
+/*segment timeline of a representation. Segments are appended in time order and removed from the head once out of the time shift buffer.
+The S elements are maintained along with the segments, so that the SegmentTimeline is written without going through the segment history*/
+typedef struct
+{
+	char representationID[100];
+	DashTimelineEntry *entries;
+	u32 nb_entries, nb_alloc;
+	DashTimelineRun *runs;
+	u32 nb_runs, nb_alloc_runs;
+} DashTimeline;
+
+/*XML of a past period. It no longer changes once the period is closed and is kept in memory, rather than read again at each MPD generation*/
+typedef struct
+{
+	char *file_name;
+	char *xml;
+	u32 size;
+} DashPeriodXML;
+
 struct __gf_dash_segmenter
 {
 	char *mpd_name;
@@ -101,6 +134,8 @@ struct __gf_dash_segmenter
 	s32 ast_offset_ms;
 	u32 dash_scale;
 	Bool fragments_in_memory;
+	Bool read_ahead;
+	u32 nb_threads;
 	u32 initial_moof_sn;
 	u64 initial_tfdt;
 	Bool no_fragments_defaults;
@@ -110,9 +145,18 @@ struct __gf_dash_segmenter
 	Double mpd_live_duration;
 	Bool insert_utc;
 	Bool real_time;
+	Bool chunked_output;
+	gf_dasher_on_chunk on_chunk;
+	void *on_chunk_udta;
 	const char *dash_profile_extension;
 
 	GF_Config *dash_ctx;
+	/*segment timelines of the representations (DashTimeline), kept in binary form next to the DASH context*/
+	GF_List *timelines;
+	char *ctx_checkpoint_file;
+	u32 ctx_checkpoint_ms, last_ctx_checkpoint;
+	/*past periods XML (DashPeriodXML)*/
+	GF_List *past_periods;
 
 
 	Double subduration;
@@ -385,13 +429,206 @@ const char *gf_dasher_strip_output_dir(const char *mpd_url, const char *path)
 	return res;
 }
 
-GF_Err gf_dasher_store_segment_info(GF_DASHSegmenter *dash_cfg, const char *representationID, const char *SegmentName, u64 segStartTime, u64 segEndTime)
+/*gets the segment timeline of a representation. Timelines of all representations are created before representations are segmented concurrently,
+so that jobs only ever look them up*/
+static DashTimeline *dasher_get_timeline(GF_DASHSegmenter *dash_cfg, const char *representationID, Bool create)
+{
+	u32 i=0;
+	DashTimeline *tl;
+	if (!dash_cfg->timelines) return NULL;
+	while ((tl = (DashTimeline *) gf_list_enum(dash_cfg->timelines, &i))) {
+		if (!strcmp(tl->representationID, representationID)) return tl;
+	}
+	if (!create) return NULL;
+	GF_SAFEALLOC(tl, DashTimeline);
+	if (!tl) return NULL;
+	snprintf(tl->representationID, sizeof(tl->representationID), "%s", representationID);
+	gf_list_add(dash_cfg->timelines, tl);
+	return tl;
+}
+
+static GF_Err dasher_timeline_add_run(DashTimeline *tl, u64 segDuration)
+{
+	if (tl->nb_runs && (tl->runs[tl->nb_runs-1].duration == segDuration)) {
+		tl->runs[tl->nb_runs-1].repeat++;
+		return GF_OK;
+	}
+	if (tl->nb_runs == tl->nb_alloc_runs) {
+		tl->nb_alloc_runs = tl->nb_alloc_runs ? 2*tl->nb_alloc_runs : 8;
+		tl->runs = (DashTimelineRun *) gf_realloc(tl->runs, sizeof(DashTimelineRun) * tl->nb_alloc_runs);
+		if (!tl->runs) {
+			tl->nb_runs = tl->nb_alloc_runs = 0;
+			return GF_OUT_OF_MEM;
+		}
+	}
+	tl->runs[tl->nb_runs].duration = segDuration;
+	tl->runs[tl->nb_runs].repeat = 0;
+	tl->nb_runs++;
+	return GF_OK;
+}
+
+static GF_Err dasher_timeline_rebuild_runs(DashTimeline *tl)
 {
+	u32 i;
+	tl->nb_runs = 0;
+	for (i=0; i<tl->nb_entries; i++) {
+		GF_Err e = dasher_timeline_add_run(tl, tl->entries[i].duration);
+		if (e) return e;
+	}
+	return GF_OK;
+}
+
+/*removes the first nb_removed segments from the runs*/
+static void dasher_timeline_trim_runs(DashTimeline *tl, u32 nb_removed)
+{
+	u32 i;
+	for (i=0; (i<tl->nb_runs) && nb_removed; i++) {
+		if (tl->runs[i].repeat >= nb_removed) {
+			tl->runs[i].repeat -= nb_removed;
+			break;
+		}
+		nb_removed -= tl->runs[i].repeat + 1;
+	}
+	if (i) {
+		tl->nb_runs -= i;
+		memmove(tl->runs, tl->runs + i, sizeof(DashTimelineRun) * tl->nb_runs);
+	}
+}
+
+static GF_Err dasher_timeline_add(DashTimeline *tl, const char *SegmentName, u64 segStartTime, u64 segDuration)
+{
+	DashTimelineEntry *ent;
+	if (tl->nb_entries == tl->nb_alloc) {
+		tl->nb_alloc = tl->nb_alloc ? 2*tl->nb_alloc : 32;
+		tl->entries = (DashTimelineEntry *) gf_realloc(tl->entries, sizeof(DashTimelineEntry) * tl->nb_alloc);
+		if (!tl->entries) {
+			tl->nb_entries = tl->nb_alloc = 0;
+			return GF_OUT_OF_MEM;
+		}
+	}
+	ent = &tl->entries[tl->nb_entries];
+	ent->start = segStartTime;
+	ent->duration = segDuration;
+	ent->seg_name = gf_strdup(SegmentName);
+	tl->nb_entries++;
+	return dasher_timeline_add_run(tl, segDuration);
+}
+
+static void dasher_reset_timelines(GF_DASHSegmenter *dash_cfg, Bool destroy)
+{
+	u32 i, j;
+	DashTimeline *tl;
+	if (!dash_cfg->timelines) return;
+	i=0;
+	while ((tl = (DashTimeline *) gf_list_enum(dash_cfg->timelines, &i))) {
+		for (j=0; j<tl->nb_entries; j++) {
+			gf_free(tl->entries[j].seg_name);
+		}
+		tl->nb_entries = 0;
+		tl->nb_runs = 0;
+		if (destroy) {
+			if (tl->entries) gf_free(tl->entries);
+			if (tl->runs) gf_free(tl->runs);
+			gf_free(tl);
+		}
+	}
+	if (destroy) {
+		gf_list_del(dash_cfg->timelines);
+		dash_cfg->timelines = NULL;
+	}
+}
+
+/*imports the segment timelines stored in an INI DASH context, and removes them from the context*/
+static void dasher_import_timelines(GF_DASHSegmenter *dash_cfg)
+{
+	u32 i, count;
+	char szRepID[100];
+
+	count = gf_cfg_get_key_count(dash_cfg->dash_ctx, "SegmentsStartTimes");
+	for (i=0; i<count; i++) {
+		u64 start, dur;
+		DashTimeline *tl;
+		const char *fileName = gf_cfg_get_key_name(dash_cfg->dash_ctx, "SegmentsStartTimes", i);
+		const char *MPDTime = fileName ? gf_cfg_get_key(dash_cfg->dash_ctx, "SegmentsStartTimes", fileName) : NULL;
+		if (!MPDTime)
+			break;
+
+		szRepID[0] = 0;
+		if (sscanf(MPDTime, ""LLU"-"LLU"@%99s", &start, &dur, szRepID) < 2) continue;
+		tl = dasher_get_timeline(dash_cfg, szRepID, GF_TRUE);
+		if (tl) dasher_timeline_add(tl, fileName, start, dur);
+	}
+	if (count) gf_cfg_del_section(dash_cfg->dash_ctx, "SegmentsStartTimes");
+}
+
+/*exports the segment timelines in the DASH context, so that INI DASH contexts saved by the caller remain usable by a new segmenter*/
+static void dasher_export_timelines(GF_DASHSegmenter *dash_cfg)
+{
+	u32 i, j;
 	char szKey[512];
+	DashTimeline *tl;
+	if (!dash_cfg->dash_ctx || !dash_cfg->timelines) return;
+
+	i=0;
+	while ((tl = (DashTimeline *) gf_list_enum(dash_cfg->timelines, &i))) {
+		for (j=0; j<tl->nb_entries; j++) {
+			sprintf(szKey, ""LLU"-"LLU"@%s", tl->entries[j].start, tl->entries[j].duration, tl->representationID);
+			gf_cfg_set_key(dash_cfg->dash_ctx, "SegmentsStartTimes", tl->entries[j].seg_name, szKey);
+		}
+	}
+}
+
+GF_Err gf_dasher_store_segment_info(GF_DASHSegmenter *dash_cfg, const char *representationID, const char *SegmentName, u64 segStartTime, u64 segEndTime)
+{
+	s32 i;
+	DashTimeline *tl;
 	if (!dash_cfg->dash_ctx) return GF_OK;
 
-	sprintf(szKey, ""LLU"-"LLU"@%s", segStartTime, segEndTime-segStartTime, representationID);
-	return gf_cfg_set_key(dash_cfg->dash_ctx, "SegmentsStartTimes", SegmentName, szKey);
+	tl = dasher_get_timeline(dash_cfg, representationID, GF_TRUE);
+	if (!tl) return GF_OUT_OF_MEM;
+
+	/*a segment produced again replaces its previous entry - only entries not older than the segment need to be checked*/
+	for (i=(s32)tl->nb_entries-1; i>=0; i--) {
+		DashTimelineEntry *ent = &tl->entries[i];
+		if (ent->start < segStartTime) break;
+		if (!strcmp(ent->seg_name, SegmentName)) {
+			ent->start = segStartTime;
+			ent->duration = segEndTime-segStartTime;
+			return dasher_timeline_rebuild_runs(tl);
+		}
+	}
+	return dasher_timeline_add(tl, SegmentName, segStartTime, segEndTime-segStartTime);
+}
+
+/*chunked output: forwards to the user the fragments flushed to the current segment*/
+typedef struct
+{
+	GF_DASHSegmenter *dash_cfg;
+	const char *seg_name;
+	/*last error of the user callback, also checked after closing the segment*/
+	GF_Err e;
+} DashChunkOutput;
+
+static GF_Err dasher_on_segment_chunk(void *udta, char *data, u32 size)
+{
+	DashChunkOutput *chunk_out = (DashChunkOutput *)udta;
+	chunk_out->e = chunk_out->dash_cfg->on_chunk(chunk_out->dash_cfg->on_chunk_udta, chunk_out->seg_name, data, size, GF_FALSE);
+	return chunk_out->e;
+}
+
+/*in chunked mode, segments are available once their first fragment is written*/
+static void dasher_write_availability_offset(GF_DASHSegmenter *dash_cfg)
+{
+	if (dash_cfg->ast_offset_ms<0) {
+		fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", - (Double) dash_cfg->ast_offset_ms / 1000.0);
+	} else if (dash_cfg->chunked_output && (dash_cfg->segment_duration > dash_cfg->fragment_duration)) {
+		fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", dash_cfg->segment_duration - dash_cfg->fragment_duration);
+	} else {
+		return;
+	}
+	/*availabilityTimeComplete only qualifies an availabilityTimeOffset*/
+	if (dash_cfg->chunked_output && dash_cfg->dash_mode)
+		fprintf(dash_cfg->mpd, " availabilityTimeComplete=\"false\"");
 }
 
 
@@ -694,28 +931,33 @@ static void gf_dash_append_segment_timeline(GF_BitStream *mpd_timeline_bs, u64 s
 	*segment_timeline_repeat_count = 0;
 }
 
+/*writes the S elements of the representation timeline. The last S element is left open, so that new segments are appended to it*/
 static void gf_dash_load_segment_timeline(GF_DASHSegmenter *dash_cfg, GF_BitStream *mpd_timeline_bs, const char *representationID, u64 *previous_segment_duration , Bool *first_segment_in_timeline,u32 *segment_timeline_repeat_count)
 {
-	u32 i, count;
-	char szRepID[100];
+	u32 i;
+	char szMPDTempLine[2048];
+	DashTimeline *tl;
 
 	*first_segment_in_timeline = GF_TRUE;
 	*segment_timeline_repeat_count = 0;
 	*previous_segment_duration = 0;
 
-	count = gf_cfg_get_key_count(dash_cfg->dash_ctx, "SegmentsStartTimes");
-	for (i=0; i<count; i++) {
-		u64 start, dur;
-		const char *fileName = gf_cfg_get_key_name(dash_cfg->dash_ctx, "SegmentsStartTimes", i);
-		const char *MPDTime = gf_cfg_get_key(dash_cfg->dash_ctx, "SegmentsStartTimes", fileName);
-		if (!fileName)
-			break;
-
-		sscanf(MPDTime, ""LLU"-"LLU"@%s", &start, &dur, szRepID);
-		if (strcmp(representationID, szRepID)) continue;
+	tl = dasher_get_timeline(dash_cfg, representationID, GF_FALSE);
+	if (!tl || !tl->nb_runs) return;
 
-		gf_dash_append_segment_timeline(mpd_timeline_bs, start, start+dur, previous_segment_duration, first_segment_in_timeline, segment_timeline_repeat_count);
+	for (i=0; i<tl->nb_runs; i++) {
+		if (!i) {
+			sprintf(szMPDTempLine, "     <S t=\""LLU"\" d=\""LLU"\"", tl->entries[0].start, tl->runs[i].duration);
+		} else if (tl->runs[i-1].repeat) {
+			sprintf(szMPDTempLine, " r=\"%d\"/>\n     <S d=\""LLU"\"", tl->runs[i-1].repeat, tl->runs[i].duration);
+		} else {
+			sprintf(szMPDTempLine, "/>\n     <S d=\""LLU"\"", tl->runs[i].duration);
+		}
+		gf_bs_write_data(mpd_timeline_bs, szMPDTempLine, (u32) strlen(szMPDTempLine));
 	}
+	*first_segment_in_timeline = GF_FALSE;
+	*previous_segment_duration = tl->runs[tl->nb_runs-1].duration;
+	*segment_timeline_repeat_count = tl->runs[tl->nb_runs-1].repeat;
 }
 
 static u64 get_presentation_time(u64 media_time, s32 ts_shift)
@@ -833,6 +1075,8 @@ static GF_Err gf_media_isom_segment_file(GF_ISOFile *input, const char *output_f
 	const char *bs_switching_segment_name = NULL;
 	u64 generation_start_utc = 0;
 	u64 ntpts = 0;
+	DashChunkOutput chunk_out;
+	memset(&chunk_out, 0, sizeof(DashChunkOutput));
 	SegmentName[0] = 0;
 	SegmentDuration = 0;
 	nb_samp = 0;
@@ -1510,6 +1754,14 @@ restart_fragmentation_pass:
 				} else {
 					e = gf_isom_start_segment(output, NULL, dash_cfg->fragments_in_memory);
 				}
+				/*announce the new segment, its fragments are then sent as they are flushed*/
+				if (!e && dash_cfg->chunked_output && dash_cfg->on_chunk) {
+					chunk_out.dash_cfg = dash_cfg;
+					chunk_out.seg_name = seg_rad_name ? SegmentName : gf_isom_get_filename(output);
+					chunk_out.e = GF_OK;
+					e = dash_cfg->on_chunk(dash_cfg->on_chunk_udta, chunk_out.seg_name, NULL, 0, GF_FALSE);
+					if (!e) e = gf_isom_set_segment_chunk_callback(output, dasher_on_segment_chunk, &chunk_out);
+				}
 				if (dash_cfg->pssh_moof)
 					store_pssh = GF_TRUE;
 
@@ -1854,8 +2106,8 @@ restart_fragmentation_pass:
 
 		SegmentDuration += maxFragDurationOverSegment;
 
-		/*if no simulation and no SIDX or realtime is used, flush fragments as we write them*/
-		if (!simulation_pass && (!dash_cfg->enable_sidx || dash_cfg->real_time) ) {
+		/*if no simulation and no SIDX, realtime or chunked output is used, flush fragments as we write them*/
+		if (!simulation_pass && (!dash_cfg->enable_sidx || dash_cfg->real_time || dash_cfg->chunked_output) ) {
 
 			if (tfref && dash_cfg->real_time) {
 				u64 utc, end_time = tfref->InitialTSOffset + tfref->next_sample_dts - tfref->DefaultDuration;
@@ -1966,6 +2218,13 @@ restart_fragmentation_pass:
 				gf_isom_close_segment(output, dash_cfg->enable_sidx ? dash_cfg->subsegs_per_sidx : 0, dash_cfg->enable_sidx ? ref_track_id : 0, ref_track_first_dts, tfref ? tfref->media_time_to_pres_time_shift : tf->media_time_to_pres_time_shift, ref_track_next_cts, dash_cfg->daisy_chain_sidx, last_segment, dash_cfg->segment_marker_4cc, &idx_start_range, &idx_end_range);
 				nbFragmentInSegment = 0;
 
+				if (dash_cfg->chunked_output && chunk_out.seg_name) {
+					gf_isom_set_segment_chunk_callback(output, NULL, NULL);
+					e = chunk_out.e;
+					if (!e) e = dash_cfg->on_chunk(dash_cfg->on_chunk_udta, chunk_out.seg_name, NULL, 0, GF_TRUE);
+					if (e) goto err_exit;
+				}
+
 				//take care of scalable reps
 				if (dash_input->moof_seqnum_increase) {
 					u32 frag_index = gf_isom_get_next_moof_number(output) + dash_input->nb_representations * dash_input->moof_seqnum_increase;
@@ -2040,6 +2299,13 @@ restart_fragmentation_pass:
 		gf_isom_close_segment(output, dash_cfg->enable_sidx ? dash_cfg->subsegs_per_sidx : 0, dash_cfg->enable_sidx ? ref_track_id : 0, ref_track_first_dts, tfref ? tfref->media_time_to_pres_time_shift : tf->media_time_to_pres_time_shift, ref_track_next_cts, dash_cfg->daisy_chain_sidx, GF_TRUE, dash_cfg->segment_marker_4cc, &idx_start_range, &idx_end_range);
 		nb_segments++;
 
+		if (dash_cfg->chunked_output && chunk_out.seg_name) {
+			gf_isom_set_segment_chunk_callback(output, NULL, NULL);
+			e = chunk_out.e;
+			if (!e) e = dash_cfg->on_chunk(dash_cfg->on_chunk_udta, chunk_out.seg_name, NULL, 0, GF_TRUE);
+			if (e) goto err_exit;
+		}
+
 		if (!seg_rad_name) {
 			file_size = gf_isom_get_file_size(output);
 			end_range = file_size - 1;
@@ -2153,9 +2419,7 @@ restart_fragmentation_pass:
 			const char *rad_name = gf_dasher_strip_output_dir(dash_cfg->mpd_name, seg_rad_name);
 			gf_media_mpd_format_segment_name(GF_DASH_TEMPLATE_TEMPLATE, is_bs_switching, SegmentName, output_file, dash_input->representationID, NULL, rad_name, !stricmp(seg_ext, "null") ? NULL : seg_ext, 0, 0, 0, dash_cfg->use_segment_timeline);
 			fprintf(dash_cfg->mpd, "   <SegmentTemplate timescale=\"%d\" media=\"%s\" startNumber=\"%d\"", mpd_timeline_bs ? dash_cfg->dash_scale : mpd_timescale, SegmentName, startNumber);
-			if (dash_cfg->ast_offset_ms<0) {
-				fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", - (Double) dash_cfg->ast_offset_ms / 1000.0);
-			}
+			dasher_write_availability_offset(dash_cfg);
 			if (!dash_cfg->use_segment_timeline) {
 				if (!max_segment_duration)
 					max_segment_duration = dash_cfg->segment_duration;
@@ -2192,9 +2456,7 @@ restart_fragmentation_pass:
 				if (presentationTimeOffset)
 					fprintf(dash_cfg->mpd, " presentationTimeOffset=\""LLD"\"", presentationTimeOffset);
 			}
-			if (dash_cfg->ast_offset_ms<0) {
-				fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", - (Double) dash_cfg->ast_offset_ms / 1000.0);
-			}
+			dasher_write_availability_offset(dash_cfg);
 
 			if (mpd_timeline_bs) {
 				char *mpd_seg_info = NULL;
@@ -2217,9 +2479,7 @@ restart_fragmentation_pass:
 		u32 size;
 
 		fprintf(dash_cfg->mpd, "   <SegmentList timescale=\"%d\"", dash_cfg->dash_scale);
-		if (dash_cfg->ast_offset_ms<0) {
-			fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", - (Double) dash_cfg->ast_offset_ms / 1000.0);
-		}
+		dasher_write_availability_offset(dash_cfg);
 		fprintf(dash_cfg->mpd, "\n");
 
 		gf_bs_get_content(mpd_timeline_bs, &mpd_seg_info, &size);
@@ -2319,9 +2579,7 @@ restart_fragmentation_pass:
 			if (presentationTimeOffset)
 				fprintf(dash_cfg->mpd, " presentationTimeOffset=\""LLD"\"", presentationTimeOffset);
 
-			if (dash_cfg->ast_offset_ms<0) {
-				fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", - (Double) dash_cfg->ast_offset_ms / 1000.0);
-			}
+			dasher_write_availability_offset(dash_cfg);
 
 			if (mpd_timeline_bs && (!first_in_set || dash_cfg->segment_alignment_disabled) ) {
 				char *mpd_seg_info = NULL;
@@ -2368,9 +2626,7 @@ restart_fragmentation_pass:
 		if (presentationTimeOffset) {
 			fprintf(dash_cfg->mpd, " presentationTimeOffset=\""LLD"\"", presentationTimeOffset);
 		}
-		if (dash_cfg->ast_offset_ms<0) {
-			fprintf(dash_cfg->mpd, " availabilityTimeOffset=\"%g\"", - (Double) dash_cfg->ast_offset_ms / 1000.0);
-		}
+		dasher_write_availability_offset(dash_cfg);
 		fprintf(dash_cfg->mpd, ">\n");
 		/*we are not in bitstreamSwitching mode*/
 		if (!is_bs_switching) {
@@ -3168,7 +3424,13 @@ static GF_Err dasher_isom_segment_file(GF_DashSegInput *dash_input, const char *
 	GF_Err e = GF_OK;
 
 	if (!dash_input->isobmf_input) {
-		GF_ISOFile *in = gf_isom_open(dash_input->file_name, dash_input->media_duration ? GF_ISOM_OPEN_EDIT : GF_ISOM_OPEN_READ, dash_cfg->tmpdir);
+		u32 open_mode = GF_ISOM_OPEN_EDIT;
+		GF_ISOFile *in;
+		if (!dash_input->media_duration) {
+			open_mode = GF_ISOM_OPEN_READ;
+			if (dash_cfg->read_ahead) open_mode |= GF_ISOM_OPEN_READ_AHEAD;
+		}
+		in = gf_isom_open(dash_input->file_name, open_mode, dash_cfg->tmpdir);
 
 		GF_LOG(GF_LOG_DEBUG, GF_LOG_DASH, ("[DASH] ISOBMFF opened\n"));
 
@@ -5265,61 +5527,62 @@ static Bool gf_dasher_cleanup(GF_DASHSegmenter *dasher)
 
 	/*cleanup old segments*/
 	if (dasher->time_shift_depth >= 0) {
-		for (i=0; i<gf_cfg_get_key_count(dasher->dash_ctx, "SegmentsStartTimes"); i++) {
-			Double seg_time;
-			u64 start, dur;
-			char szRepID[100];
-			char szSecName[200];
-			u32 j;
-			const char *fileName = gf_cfg_get_key_name(dasher->dash_ctx, "SegmentsStartTimes", i);
-			const char *opt = gf_cfg_get_key(dasher->dash_ctx, "SegmentsStartTimes", fileName);
-			if (!fileName)
-				break;
-
-			sscanf(opt, ""LLU"-"LLU"@%s", &start, &dur, szRepID);
-			seg_time = (Double) start;
-			seg_time /= dasher->dash_scale;
-			if (dasher->ast_offset_ms > 0)
-				seg_time += ((Double) dasher->ast_offset_ms) / 1000;
-
-
-			seg_time += 2 * dash_duration + dasher->time_shift_depth;
-			seg_time -= elapsed;
-			if (seg_time >= 0)
-				continue;
-
-			if (! (dasher->dash_mode == GF_DASH_DYNAMIC_DEBUG) ) {
-				GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("[DASH] Removing segment %s - %g sec too late\n", fileName, -seg_time - dash_duration));
-			}
-
-			e = gf_delete_file(fileName);
-			if (e) {
-				GF_LOG(GF_LOG_WARNING, GF_LOG_DASH, ("[DASH] Could not remove file %s: %s\n", fileName, gf_error_to_string(e) ));
-				break;
-			}
+		DashTimeline *tl;
+		i=0;
+		while ((tl = (DashTimeline *) gf_list_enum(dasher->timelines, &i))) {
+			char szSecName[200], szCount[20];
+			u32 j, k, nb_removed=0;
+
+			sprintf(szSecName, "URLs_%s", tl->representationID);
+			for (j=0; j<tl->nb_entries; j++) {
+				Double seg_time;
+				const char *fileName = tl->entries[j].seg_name;
+
+				seg_time = (Double) tl->entries[j].start;
+				seg_time /= dasher->dash_scale;
+				if (dasher->ast_offset_ms > 0)
+					seg_time += ((Double) dasher->ast_offset_ms) / 1000;
+
+				seg_time += 2 * dash_duration + dasher->time_shift_depth;
+				seg_time -= elapsed;
+				/*timeline entries are in time order*/
+				if (seg_time >= 0)
+					break;
 
-			sprintf(szSecName, "URLs_%s", szRepID);
+				if (! (dasher->dash_mode == GF_DASH_DYNAMIC_DEBUG) ) {
+					GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("[DASH] Removing segment %s - %g sec too late\n", fileName, -seg_time - dash_duration));
+				}
 
-			/*remove URLs*/
-			for (j=0; j<gf_cfg_get_key_count(dasher->dash_ctx, szSecName); j++) {
-				const char *entry = gf_cfg_get_key_name(dasher->dash_ctx, szSecName, j);
-				const char *name = gf_cfg_get_key(dasher->dash_ctx, szSecName, entry);
-				if (strstr(name, fileName)) {
-					gf_cfg_set_key(dasher->dash_ctx, szSecName, entry, NULL);
+				e = gf_delete_file(fileName);
+				if (e) {
+					GF_LOG(GF_LOG_WARNING, GF_LOG_DASH, ("[DASH] Could not remove file %s: %s\n", fileName, gf_error_to_string(e) ));
 					break;
 				}
+
+				/*remove URLs*/
+				for (k=0; k<gf_cfg_get_key_count(dasher->dash_ctx, szSecName); k++) {
+					const char *entry = gf_cfg_get_key_name(dasher->dash_ctx, szSecName, k);
+					const char *name = gf_cfg_get_key(dasher->dash_ctx, szSecName, entry);
+					if (strstr(name, fileName)) {
+						gf_cfg_set_key(dasher->dash_ctx, szSecName, entry, NULL);
+						break;
+					}
+				}
+				gf_free(tl->entries[j].seg_name);
+				nb_removed++;
 			}
+			if (!nb_removed) continue;
+
+			tl->nb_entries -= nb_removed;
+			memmove(tl->entries, tl->entries + nb_removed, sizeof(DashTimelineEntry) * tl->nb_entries);
+			dasher_timeline_trim_runs(tl, nb_removed);
 
 			/*adjust seg removed count - this is needed to adjust startNumber for SegmentTimeline case*/
-			sprintf(szSecName, "Representation_%s", szRepID);
-			j = 1;
+			sprintf(szSecName, "Representation_%s", tl->representationID);
 			opt = gf_cfg_get_key(dasher->dash_ctx, szSecName, "NbSegmentsRemoved");
-			if (opt) j += atoi(opt);
-			sprintf(szRepID, "%d", j);
-			gf_cfg_set_key(dasher->dash_ctx, szSecName, "NbSegmentsRemoved", szRepID);
-
-			gf_cfg_set_key(dasher->dash_ctx, "SegmentsStartTimes", fileName, NULL);
-			i--;
+			if (opt) nb_removed += atoi(opt);
+			sprintf(szCount, "%d", nb_removed);
+			gf_cfg_set_key(dasher->dash_ctx, szSecName, "NbSegmentsRemoved", szCount);
 		}
 	}
 	return GF_TRUE;
@@ -5336,10 +5599,21 @@ static u32 gf_dash_get_dependency_bandwidth(GF_DashSegInput *inputs, u32 nb_dash
 	return 0; //we should never be here !!!!
 }
 
-static GF_Err dash_insert_period_xml(FILE *mpd, char *szPeriodXML)
+static GF_Err dash_insert_period_xml(GF_DASHSegmenter *dasher, FILE *mpd, char *szPeriodXML, Bool is_past_period)
 {
 	FILE *period_mpd;
-	u32 xml_size;
+	u32 i, xml_size, read;
+	DashPeriodXML *pxml = NULL;
+
+	if (is_past_period) {
+		i=0;
+		while ((pxml = (DashPeriodXML *) gf_list_enum(dasher->past_periods, &i))) {
+			if (!strcmp(pxml->file_name, szPeriodXML)) {
+				fwrite(pxml->xml, 1, pxml->size, mpd);
+				return GF_OK;
+			}
+		}
+	}
 
 	period_mpd = gf_fopen(szPeriodXML, "rb");
 	if (!period_mpd) {
@@ -5350,13 +5624,36 @@ static GF_Err dash_insert_period_xml(FILE *mpd, char *szPeriodXML)
 	xml_size = (u32) gf_ftell(period_mpd);
 	gf_fseek(period_mpd, 0, SEEK_SET);
 
+	if (is_past_period) {
+		GF_SAFEALLOC(pxml, DashPeriodXML);
+		if (pxml) pxml->xml = (char *) gf_malloc(sizeof(char) * (xml_size+1));
+		if (!pxml || !pxml->xml) {
+			if (pxml) gf_free(pxml);
+			gf_fclose(period_mpd);
+			return GF_OUT_OF_MEM;
+		}
+		read = (u32) fread(pxml->xml, 1, xml_size, period_mpd);
+		gf_fclose(period_mpd);
+		if (read != xml_size) {
+			GF_LOG(GF_LOG_WARNING, GF_LOG_DASH, ("[DASH] Error reading from period MPD file: got %d but requested %d bytes\n", read, xml_size ));
+			gf_free(pxml->xml);
+			gf_free(pxml);
+			return GF_IO_ERR;
+		}
+		pxml->size = xml_size;
+		pxml->file_name = gf_strdup(szPeriodXML);
+		if (!dasher->past_periods) dasher->past_periods = gf_list_new();
+		gf_list_add(dasher->past_periods, pxml);
+		fwrite(pxml->xml, 1, pxml->size, mpd);
+		return GF_OK;
+	}
+
 	while (xml_size) {
 		char buf[4096];
-		u32 read;
 		u32 size = 4096;
 		if (xml_size<4096) size = xml_size;
-		read = (s32) fread(buf, 1, size, period_mpd);
-		if (read != (s32) size) {
+		read = (u32) fread(buf, 1, size, period_mpd);
+		if (read != size) {
 			GF_LOG(GF_LOG_WARNING, GF_LOG_DASH, ("[DASH] Error reading from period MPD file: got %d but requested %d bytes\n", read, size ));
 			gf_fclose(period_mpd);
 			return GF_IO_ERR;
@@ -5370,9 +5667,11 @@ static GF_Err dash_insert_period_xml(FILE *mpd, char *szPeriodXML)
 	return GF_OK;
 }
 
-static void purge_dash_context(GF_Config *dash_ctx)
+static void purge_dash_context(GF_DASHSegmenter *dasher)
 {
 	u32 i, count;
+	GF_Config *dash_ctx = dasher->dash_ctx;
+	dasher_reset_timelines(dasher, GF_FALSE);
 	//purge dash context
 	count = gf_cfg_get_section_count(dash_ctx);
 	for (i=0; i<count; i++) {
@@ -5396,6 +5695,275 @@ typedef struct
 	const char *id;
 } PeriodEntry;
 
+/*segmentation of one representation. The segmenter state is copied when the job is created, so that jobs of a period can run concurrently,
+each writing its part of the MPD in its own file*/
+typedef struct
+{
+	GF_DASHSegmenter dasher;
+	/*NULL for jobs only carrying an adaptation set header*/
+	GF_DashSegInput *dash_input;
+	char szOutName[GF_MAX_PATH];
+	char szSolvedSegName[GF_MAX_PATH];
+	Bool first_in_set;
+	/*the adaptation set is closed after this job*/
+	Bool close_set;
+	FILE *mpd;
+	/*private copy of the dash context, merged back once all jobs of the period are done*/
+	GF_Config *dash_ctx;
+	GF_Err e;
+} DashRepJob;
+
+typedef struct
+{
+	GF_List *jobs;
+	u32 next_job;
+	GF_Mutex *mx;
+} DashJobQueue;
+
+static void dasher_setup_rep_job(GF_DASHSegmenter *dasher, GF_DashSegInput *dash_input, Bool has_scalability, DashRepJob *job)
+{
+	char *sep, tmp[GF_MAX_PATH];
+	char *segment_name = dasher->seg_rad_name;
+	char *szOutName = job->szOutName;
+
+	job->dasher = *dasher;
+	job->dash_input = dash_input;
+
+	strcpy(szOutName, gf_url_get_resource_name(dash_input->file_name));
+	sep = strrchr(szOutName, '.');
+	if (sep) sep[0] = 0;
+
+	/*in scalable case: seg_name is variable*/
+	job->dasher.variable_seg_rad_name = has_scalability ? GF_TRUE : GF_FALSE;
+	if (segment_name) {
+		if (strstr(segment_name, "%s")) {
+			sprintf(job->szSolvedSegName, segment_name, szOutName);
+			job->dasher.variable_seg_rad_name = GF_TRUE;
+			if (dash_input->single_track_num) {
+				char szTkNum[50];
+				sprintf(szTkNum, "_track%d_", dash_input->single_track_num);
+				strcat(job->szSolvedSegName, szTkNum);
+			}
+		} else {
+			strcpy(job->szSolvedSegName, segment_name);
+		}
+
+		segment_name = job->szSolvedSegName;
+	}
+
+	/* user added a relative-path baseURL */
+	if (dash_input->nb_baseURL) {
+		if (gf_url_is_local(dash_input->baseURL[0])) {
+			const char *name;
+			char tmp_segment_name[GF_MAX_PATH];
+			if (dash_input->nb_baseURL > 1)
+				GF_LOG(GF_LOG_WARNING, GF_LOG_DASH, ("[DASH] Several relative path baseURL for input %s: selecting \"%s\"\n", dash_input->file_name, dash_input->baseURL[0]));
+			name = gf_url_get_resource_name(szOutName);
+			strcpy(tmp_segment_name, name);
+			gf_url_get_resource_path(dash_input->baseURL[0], szOutName);
+			if (szOutName[strlen(szOutName)] != GF_PATH_SEPARATOR) {
+				char ext[2];
+				ext[0] = GF_PATH_SEPARATOR;
+				ext[1] = 0;
+				strcat(szOutName, ext);
+			}
+			strcat(szOutName, tmp_segment_name);
+		} else {
+			GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("[DASH] Found baseURL for input %s but not a relative path (%s)\n", dash_input->file_name, dash_input->baseURL[0]));
+		}
+	}
+
+	if ((dash_input->trackNum || dash_input->single_track_num) && (!dasher->seg_rad_name || !strstr(dasher->seg_rad_name, "$RepresentationID$") ) ) {
+		char tmp[10];
+		sprintf(tmp, "_track%d", dash_input->trackNum ? dash_input->trackNum : dash_input->single_track_num);
+		strcat(szOutName, tmp);
+	}
+	strcat(szOutName, "_dash");
+
+	if (gf_url_get_resource_path(dasher->mpd_name, tmp)) {
+		strcat(tmp, szOutName);
+		strcpy(szOutName, tmp);
+	}
+	if (segment_name && dash_input->trackNum && !strstr(dasher->seg_rad_name, "$RepresentationID$") ) {
+		char tmp[10];
+		sprintf(tmp, "_track%d_", dash_input->trackNum);
+		strcat(segment_name, tmp);
+	}
+	job->dasher.seg_rad_name = segment_name;
+
+	/*in scalable case, we need also the bandwidth of dependent representation*/
+	if (dash_input->dependencyID) {
+		dash_input->dependency_bandwidth = gf_dash_get_dependency_bandwidth(dasher->inputs, dasher->nb_inputs, dash_input->file_name, dash_input->lower_layer_track);
+	}
+
+	if (dash_input->segment_duration)
+		job->dasher.segment_duration = dash_input->segment_duration;
+
+	if (dash_input->segment_duration && (dasher->fragment_duration * dasher->dash_scale > dash_input->segment_duration)) {
+		job->dasher.fragment_duration = job->dasher.segment_duration;
+	}
+}
+
+static GF_Err dasher_run_rep_job(DashRepJob *job)
+{
+	GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("DASHing file %s\n", job->dash_input->file_name));
+	job->e = job->dash_input->dasher_segment_file(job->dash_input, job->szOutName, &job->dasher, job->first_in_set);
+	if (job->e) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("Error while DASH-ing file: %s\n", gf_error_to_string(job->e)));
+	}
+	return job->e;
+}
+
+static u32 dasher_job_thread(void *par)
+{
+	DashJobQueue *jq = (DashJobQueue *)par;
+	while (1) {
+		DashRepJob *job;
+		gf_mx_p(jq->mx);
+		job = (DashRepJob *)gf_list_get(jq->jobs, jq->next_job);
+		if (job) jq->next_job++;
+		gf_mx_v(jq->mx);
+		if (!job) break;
+		if (job->dash_input) dasher_run_rep_job(job);
+	}
+	return 0;
+}
+
+static GF_Config *dasher_clone_context(GF_Config *ctx)
+{
+	u32 i, j, nb_sec, nb_keys;
+	GF_Config *clone = gf_cfg_new(NULL, NULL);
+	if (!clone) return NULL;
+
+	nb_sec = gf_cfg_get_section_count(ctx);
+	for (i=0; i<nb_sec; i++) {
+		const char *sec_name = gf_cfg_get_section_name(ctx, i);
+		nb_keys = gf_cfg_get_key_count(ctx, sec_name);
+		for (j=0; j<nb_keys; j++) {
+			const char *key_name = gf_cfg_get_key_name(ctx, sec_name, j);
+			gf_cfg_set_key(clone, sec_name, key_name, gf_cfg_get_key(ctx, sec_name, key_name));
+		}
+	}
+	return clone;
+}
+
+/*applies to ctx the changes made by a job on its private copy job_ctx of the context snapshot ref*/
+static void dasher_merge_context(GF_Config *ctx, GF_Config *ref, GF_Config *job_ctx)
+{
+	u32 i, j, nb_sec, nb_keys;
+
+	nb_sec = gf_cfg_get_section_count(job_ctx);
+	for (i=0; i<nb_sec; i++) {
+		const char *sec_name = gf_cfg_get_section_name(job_ctx, i);
+		nb_keys = gf_cfg_get_key_count(job_ctx, sec_name);
+		for (j=0; j<nb_keys; j++) {
+			const char *key_name = gf_cfg_get_key_name(job_ctx, sec_name, j);
+			const char *val = gf_cfg_get_key(job_ctx, sec_name, key_name);
+			const char *ref_val = gf_cfg_get_key(ref, sec_name, key_name);
+			if (ref_val && !strcmp(ref_val, val)) continue;
+
+			/*shared keys: the max segment duration is only raised, the segment template is set by the first representation*/
+			if (!strcmp(sec_name, "DASH")) {
+				const char *cur_val = gf_cfg_get_key(ctx, sec_name, key_name);
+				if (cur_val && !strcmp(key_name, "MaxSegmentDuration") && (atof(cur_val) >= atof(val))) continue;
+				if (cur_val && !strcmp(key_name, "SegmentTemplate")) continue;
+			}
+			gf_cfg_set_key(ctx, sec_name, key_name, val);
+		}
+	}
+	/*removed keys*/
+	nb_sec = gf_cfg_get_section_count(ref);
+	for (i=0; i<nb_sec; i++) {
+		const char *sec_name = gf_cfg_get_section_name(ref, i);
+		nb_keys = gf_cfg_get_key_count(ref, sec_name);
+		for (j=0; j<nb_keys; j++) {
+			const char *key_name = gf_cfg_get_key_name(ref, sec_name, j);
+			if (!gf_cfg_get_key(job_ctx, sec_name, key_name))
+				gf_cfg_set_key(ctx, sec_name, key_name, NULL);
+		}
+	}
+}
+
+/*runs all jobs of a period on dasher->nb_threads threads, then writes their MPD parts in order. In real-time mode, each job gets its own thread
+so that all representations are flushed against the same generation clock*/
+static GF_Err dasher_run_period_jobs(GF_DASHSegmenter *dasher, GF_List *jobs, FILE *period_mpd)
+{
+	u32 i, nb_threads, count;
+	GF_Thread **threads;
+	DashJobQueue jq;
+	GF_Config *ctx_ref = NULL;
+	GF_Err e = GF_OK;
+
+	count = gf_list_count(jobs);
+	if (!count) return GF_OK;
+
+	if (dasher->dash_ctx) {
+		ctx_ref = dasher_clone_context(dasher->dash_ctx);
+		if (!ctx_ref) return GF_OUT_OF_MEM;
+		for (i=0; i<count; i++) {
+			DashRepJob *job = (DashRepJob *)gf_list_get(jobs, i);
+			if (!job->dash_input) continue;
+			job->dash_ctx = dasher_clone_context(ctx_ref);
+			if (!job->dash_ctx) {
+				gf_cfg_del(ctx_ref);
+				return GF_OUT_OF_MEM;
+			}
+			job->dasher.dash_ctx = job->dash_ctx;
+		}
+	}
+
+	jq.jobs = jobs;
+	jq.next_job = 0;
+	jq.mx = gf_mx_new("DASHJobs");
+
+	nb_threads = dasher->real_time ? count : MIN(dasher->nb_threads, count);
+	threads = (GF_Thread **)gf_malloc(sizeof(GF_Thread *) * nb_threads);
+	for (i=0; i<nb_threads; i++) {
+		threads[i] = gf_th_new("DASHRepresentation");
+		gf_th_run(threads[i], dasher_job_thread, &jq);
+	}
+	for (i=0; i<nb_threads; i++) {
+		gf_th_stop(threads[i]);
+		gf_th_del(threads[i]);
+	}
+	gf_free(threads);
+	gf_mx_del(jq.mx);
+
+	for (i=0; i<count; i++) {
+		char buf[4096];
+		u32 read;
+		DashRepJob *job = (DashRepJob *)gf_list_get(jobs, i);
+		if (job->e) {
+			e = job->e;
+			break;
+		}
+		if (job->dash_ctx)
+			dasher_merge_context(dasher->dash_ctx, ctx_ref, job->dash_ctx);
+
+		gf_fseek(job->mpd, 0, SEEK_SET);
+		while ((read = (u32) fread(buf, 1, sizeof(buf), job->mpd)) > 0) {
+			gf_fwrite(buf, 1, read, period_mpd);
+		}
+		if (job->close_set)
+			fprintf(period_mpd, "  </AdaptationSet>\n");
+
+		if (job->dasher.max_segment_duration > dasher->max_segment_duration)
+			dasher->max_segment_duration = job->dasher.max_segment_duration;
+	}
+	if (ctx_ref) gf_cfg_del(ctx_ref);
+	return e;
+}
+
+static void dasher_reset_jobs(GF_List *jobs)
+{
+	while (gf_list_count(jobs)) {
+		DashRepJob *job = (DashRepJob *)gf_list_pop_back(jobs);
+		if (job->mpd) gf_fclose(job->mpd);
+		if (job->dash_ctx) gf_cfg_del(job->dash_ctx);
+		gf_free(job);
+	}
+}
+
 
 GF_EXPORT
 GF_DASHSegmenter *gf_dasher_new(const char *mpdName, GF_DashProfile dash_profile, const char *tmp_dir, u32 dash_timescale, GF_Config *dasher_context_file)
@@ -5409,6 +5977,7 @@ GF_DASHSegmenter *gf_dasher_new(const char *mpdName, GF_DashProfile dash_profile
 	if (tmp_dir) dasher->tmpdir = gf_strdup(tmp_dir);
 	dasher->profile = dash_profile;
 	dasher->dash_ctx = dasher_context_file;
+	if (dasher->dash_ctx) dasher->timelines = gf_list_new();
 
 	return dasher;
 }
@@ -5439,6 +6008,25 @@ void gf_dasher_clean_inputs(GF_DASHSegmenter *dasher)
 GF_EXPORT
 void gf_dasher_del(GF_DASHSegmenter *dasher)
 {
+	if (dasher->ctx_checkpoint_file) {
+		GF_Err e = gf_dasher_save_context(dasher, dasher->ctx_checkpoint_file);
+		if (e) {
+			GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] Failed to save DASH context to %s: %s\n", dasher->ctx_checkpoint_file, gf_error_to_string(e) ));
+		}
+		gf_free(dasher->ctx_checkpoint_file);
+	} else {
+		dasher_export_timelines(dasher);
+	}
+	dasher_reset_timelines(dasher, GF_TRUE);
+	if (dasher->past_periods) {
+		while (gf_list_count(dasher->past_periods)) {
+			DashPeriodXML *pxml = (DashPeriodXML *) gf_list_pop_back(dasher->past_periods);
+			gf_free(pxml->file_name);
+			gf_free(pxml->xml);
+			gf_free(pxml);
+		}
+		gf_list_del(dasher->past_periods);
+	}
 	if (dasher->seg_rad_name) gf_free(dasher->seg_rad_name);
 	gf_dasher_clean_inputs(dasher);
 	gf_free(dasher->base_urls);
@@ -5611,6 +6199,22 @@ GF_Err gf_dasher_enable_memory_fragmenting(GF_DASHSegmenter *dasher, Bool fragme
 	return GF_OK;
 }
 
+GF_EXPORT
+GF_Err gf_dasher_enable_read_ahead(GF_DASHSegmenter *dasher, Bool read_ahead)
+{
+	if (!dasher) return GF_BAD_PARAM;
+	dasher->read_ahead = read_ahead;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_dasher_set_thread_count(GF_DASHSegmenter *dasher, u32 nb_threads)
+{
+	if (!dasher) return GF_BAD_PARAM;
+	dasher->nb_threads = nb_threads;
+	return GF_OK;
+}
+
 GF_EXPORT
 GF_Err gf_dasher_set_initial_isobmf(GF_DASHSegmenter *dasher, u32 initial_moof_sn, u64 initial_tfdt)
 {
@@ -5647,6 +6251,229 @@ GF_Err gf_dasher_enable_real_time(GF_DASHSegmenter *dasher, Bool real_time)
 	return GF_OK;
 }
 
+GF_EXPORT
+GF_Err gf_dasher_enable_chunked_output(GF_DASHSegmenter *dasher, Bool enable, gf_dasher_on_chunk on_chunk, void *udta)
+{
+	if (!dasher) return GF_BAD_PARAM;
+	dasher->chunked_output = enable;
+	dasher->on_chunk = enable ? on_chunk : NULL;
+	dasher->on_chunk_udta = udta;
+	return GF_OK;
+}
+
+#define DASH_CTX_SNAPSHOT_VERSION	1
+
+static void dasher_ctx_write_string(GF_BitStream *bs, const char *str)
+{
+	u32 len = str ? (u32) strlen(str) : 0;
+	gf_bs_write_u32(bs, len);
+	if (len) gf_bs_write_data(bs, str, len);
+}
+
+static char *dasher_ctx_read_string(GF_BitStream *bs)
+{
+	char *str;
+	u32 len;
+	if (gf_bs_available(bs) < 4) return NULL;
+	len = gf_bs_read_u32(bs);
+	if (len > gf_bs_available(bs)) return NULL;
+	str = (char *) gf_malloc(sizeof(char) * (len+1));
+	if (!str) return NULL;
+	gf_bs_read_data(bs, str, len);
+	str[len] = 0;
+	return str;
+}
+
+/*reads a record count, the snapshot must have room for count records of at least min_size bytes*/
+static GF_Err dasher_ctx_read_count(GF_BitStream *bs, u32 min_size, u32 *count)
+{
+	if (gf_bs_available(bs) < 4) return GF_NON_COMPLIANT_BITSTREAM;
+	*count = gf_bs_read_u32(bs);
+	if (*count > gf_bs_available(bs) / min_size) return GF_NON_COMPLIANT_BITSTREAM;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_dasher_save_context(GF_DASHSegmenter *dasher, const char *file_name)
+{
+	u32 i, j, count, nb_keys, size;
+	char *data;
+	char szTempName[GF_MAX_PATH];
+	FILE *f;
+	DashTimeline *tl;
+	GF_BitStream *bs;
+	GF_Err e = GF_OK;
+
+	if (!dasher || !dasher->dash_ctx || !file_name) return GF_BAD_PARAM;
+
+	bs = gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+	if (!bs) return GF_OUT_OF_MEM;
+	gf_bs_write_u32(bs, GF_4CC('G','D','C','X'));
+	gf_bs_write_u32(bs, DASH_CTX_SNAPSHOT_VERSION);
+
+	count = gf_cfg_get_section_count(dasher->dash_ctx);
+	gf_bs_write_u32(bs, count);
+	for (i=0; i<count; i++) {
+		const char *sec_name = gf_cfg_get_section_name(dasher->dash_ctx, i);
+		nb_keys = gf_cfg_get_key_count(dasher->dash_ctx, sec_name);
+		dasher_ctx_write_string(bs, sec_name);
+		gf_bs_write_u32(bs, nb_keys);
+		for (j=0; j<nb_keys; j++) {
+			const char *key_name = gf_cfg_get_key_name(dasher->dash_ctx, sec_name, j);
+			dasher_ctx_write_string(bs, key_name);
+			dasher_ctx_write_string(bs, gf_cfg_get_key(dasher->dash_ctx, sec_name, key_name));
+		}
+	}
+
+	gf_bs_write_u32(bs, gf_list_count(dasher->timelines));
+	i=0;
+	while ((tl = (DashTimeline *) gf_list_enum(dasher->timelines, &i))) {
+		dasher_ctx_write_string(bs, tl->representationID);
+		gf_bs_write_u32(bs, tl->nb_entries);
+		for (j=0; j<tl->nb_entries; j++) {
+			gf_bs_write_u64(bs, tl->entries[j].start);
+			gf_bs_write_u64(bs, tl->entries[j].duration);
+			dasher_ctx_write_string(bs, tl->entries[j].seg_name);
+		}
+	}
+	gf_bs_get_content(bs, &data, &size);
+	gf_bs_del(bs);
+
+	/*write to a temp file and move it, so that a previous snapshot stays valid until the new one is complete*/
+	snprintf(szTempName, GF_MAX_PATH-1, "%s.tmp", file_name);
+	szTempName[GF_MAX_PATH-1] = 0;
+	f = gf_fopen(szTempName, "wb");
+	if (!f) {
+		gf_free(data);
+		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] Cannot create DASH context snapshot %s\n", szTempName));
+		return GF_IO_ERR;
+	}
+	if (gf_fwrite(data, 1, size, f) != size) e = GF_IO_ERR;
+	gf_fclose(f);
+	gf_free(data);
+
+	if (!e) {
+		gf_delete_file(file_name);
+		e = gf_move_file(szTempName, file_name);
+	}
+	if (e) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] Error writing DASH context snapshot %s: %s\n", file_name, gf_error_to_string(e) ));
+		gf_delete_file(szTempName);
+	}
+	return e;
+}
+
+GF_EXPORT
+GF_Err gf_dasher_restore_context(GF_DASHSegmenter *dasher, const char *file_name)
+{
+	u32 i, j, count, nb_keys;
+	FILE *f;
+	GF_BitStream *bs;
+	GF_Err e = GF_OK;
+
+	if (!dasher || !dasher->dash_ctx || !file_name) return GF_BAD_PARAM;
+
+	f = gf_fopen(file_name, "rb");
+	if (!f) return GF_URL_ERROR;
+	bs = gf_bs_from_file(f, GF_BITSTREAM_READ);
+	if (!bs) {
+		gf_fclose(f);
+		return GF_OUT_OF_MEM;
+	}
+	if ((gf_bs_available(bs) < 8) || (gf_bs_read_u32(bs) != GF_4CC('G','D','C','X'))) {
+		e = GF_NON_COMPLIANT_BITSTREAM;
+		goto exit;
+	}
+	if (gf_bs_read_u32(bs) != DASH_CTX_SNAPSHOT_VERSION) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] Unsupported DASH context snapshot version in %s\n", file_name));
+		e = GF_NOT_SUPPORTED;
+		goto exit;
+	}
+	dasher_reset_timelines(dasher, GF_FALSE);
+
+	/*sections: name and key count, keys: name and value*/
+	e = dasher_ctx_read_count(bs, 8, &count);
+	if (e) goto exit;
+	for (i=0; i<count; i++) {
+		char *sec_name = dasher_ctx_read_string(bs);
+		if (!sec_name) {
+			e = GF_NON_COMPLIANT_BITSTREAM;
+			goto exit;
+		}
+		e = dasher_ctx_read_count(bs, 8, &nb_keys);
+		for (j=0; !e && (j<nb_keys); j++) {
+			char *key_name = dasher_ctx_read_string(bs);
+			char *value = dasher_ctx_read_string(bs);
+			if (key_name && value) gf_cfg_set_key(dasher->dash_ctx, sec_name, key_name, value);
+			else e = GF_NON_COMPLIANT_BITSTREAM;
+			if (key_name) gf_free(key_name);
+			if (value) gf_free(value);
+			if (e) break;
+		}
+		gf_free(sec_name);
+		if (e) goto exit;
+	}
+
+	/*timelines: representation ID and entry count, entries: start, duration and segment name*/
+	e = dasher_ctx_read_count(bs, 8, &count);
+	if (e) goto exit;
+	for (i=0; i<count; i++) {
+		DashTimeline *tl;
+		char *rep_id = dasher_ctx_read_string(bs);
+		if (!rep_id) {
+			e = GF_NON_COMPLIANT_BITSTREAM;
+			goto exit;
+		}
+		tl = dasher_get_timeline(dasher, rep_id, GF_TRUE);
+		gf_free(rep_id);
+		if (!tl) {
+			e = GF_OUT_OF_MEM;
+			goto exit;
+		}
+		e = dasher_ctx_read_count(bs, 20, &nb_keys);
+		if (e) goto exit;
+		for (j=0; j<nb_keys; j++) {
+			char *seg_name;
+			u64 start, dur;
+			if (gf_bs_available(bs) < 20) {
+				e = GF_NON_COMPLIANT_BITSTREAM;
+				goto exit;
+			}
+			start = gf_bs_read_u64(bs);
+			dur = gf_bs_read_u64(bs);
+			seg_name = dasher_ctx_read_string(bs);
+			if (!seg_name) {
+				e = GF_NON_COMPLIANT_BITSTREAM;
+				goto exit;
+			}
+			e = dasher_timeline_add(tl, seg_name, start, dur);
+			gf_free(seg_name);
+			if (e) goto exit;
+		}
+	}
+
+exit:
+	gf_bs_del(bs);
+	gf_fclose(f);
+	if (e==GF_NON_COMPLIANT_BITSTREAM) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] File %s is not a valid DASH context snapshot\n", file_name));
+	}
+	/*do not keep a partially restored timeline*/
+	if (e) dasher_reset_timelines(dasher, GF_FALSE);
+	return e;
+}
+
+GF_EXPORT
+GF_Err gf_dasher_set_context_checkpoint(GF_DASHSegmenter *dasher, const char *file_name, u32 checkpoint_ms)
+{
+	if (!dasher || (file_name && !dasher->dash_ctx)) return GF_BAD_PARAM;
+	if (dasher->ctx_checkpoint_file) gf_free(dasher->ctx_checkpoint_file);
+	dasher->ctx_checkpoint_file = file_name ? gf_strdup(file_name) : NULL;
+	dasher->ctx_checkpoint_ms = checkpoint_ms;
+	dasher->last_ctx_checkpoint = gf_sys_clock();
+	return GF_OK;
+}
+
 GF_EXPORT
 
 GF_Err gf_dasher_set_content_protection_location_mode(GF_DASHSegmenter *dasher, GF_DASH_ContentLocationMode mode)
@@ -5734,7 +6561,7 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 {
 	u32 i, j, max_period, cur_period;
 	Bool has_role = GF_FALSE;
-	char *sep, szSolvedSegName[GF_MAX_PATH], szTempMPD[GF_MAX_PATH], szOpt[GF_MAX_PATH];
+	char *sep, szTempMPD[GF_MAX_PATH], szOpt[GF_MAX_PATH];
 	const char *opt;
 	GF_Err e;
 	Bool uses_xlink = GF_FALSE;
@@ -5756,6 +6583,8 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 	u32 last_period_rep_idx_plus_one = 0;
 	FILE *mpd = NULL;
 	PeriodEntry *p;
+	GF_List *period_jobs = NULL;
+	Bool has_dependencies = GF_FALSE;
 	if (!dasher) return GF_BAD_PARAM;
 
 	GF_LOG(GF_LOG_DEBUG, GF_LOG_DASH, ("[DASH] Dashing starting\n"));
@@ -5771,8 +6600,14 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 			return GF_BAD_PARAM;
 		}
 	}
-	if (dasher->real_time && (dasher->nb_inputs>1)) {
-		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] real-time simulation is only supported with a single representation.\n"));
+	for (i=0; i<dasher->nb_inputs; i++) {
+		if (dasher->inputs[i].idx_representations || dasher->inputs[i].dependencyID) {
+			has_dependencies = GF_TRUE;
+			break;
+		}
+	}
+	if (dasher->real_time && (dasher->nb_inputs>1) && has_dependencies) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] real-time simulation is not supported with scalable representations.\n"));
 		return GF_BAD_PARAM;
 	}
 
@@ -5782,6 +6617,10 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 		Bool regenerate;
 		e = gf_dasher_init_context(dasher->dash_ctx, &dasher->dash_mode, &dasher->time_shift_depth, NULL, dasher->ast_offset_ms);
 		if (e) return e;
+		dasher_import_timelines(dasher);
+		for (i=0; i<dasher->nb_inputs; i++) {
+			if (!dasher_get_timeline(dasher, dasher->inputs[i].representationID, GF_TRUE)) return GF_OUT_OF_MEM;
+		}
 		opt = gf_cfg_get_key(dasher->dash_ctx, "DASH", "MaxSegmentDuration");
 		if (opt) {
 			Double seg_dur = atof(opt);
@@ -6034,6 +6873,18 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 		dasher_format_seg_name(dasher, "%s_dash");
 	}
 
+	if (dasher->chunked_output) {
+		if (dasher->single_segment) {
+			GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("[DASH] chunked output is not supported in single file mode.\n"));
+			return GF_BAD_PARAM;
+		}
+		/*the SIDX would have to be written before the chunks already sent*/
+		if (dasher->enable_sidx) {
+			GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("[DASH] SIDX is disabled in chunked output mode.\n"));
+			dasher->enable_sidx = GF_FALSE;
+		}
+	}
+
 	if (dasher->single_segment) {
 		GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("DASH-ing file%s - single segment\nSubsegment duration %.3f - Fragment duration: %.3f secs\n", (dasher->nb_inputs>1) ? "s" : "", dasher->segment_duration, dasher->fragment_duration));
 		dasher->subsegs_per_sidx = 0;
@@ -6221,7 +7072,7 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 				sprintf(szOpt, "%g", active_period_start);
 				gf_cfg_set_key(dasher->dash_ctx, "DASH", "LastActivePeriodStart", szOpt);
 
-				purge_dash_context(dasher->dash_ctx);
+				purge_dash_context(dasher);
 			}
 
 			//and finally switch active period
@@ -6259,6 +7110,11 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 
 	period_links = gf_list_new();
 
+	/*scalable representations depend on each other, segment them sequentially. Real-time representations are always segmented concurrently*/
+	if (((dasher->nb_threads > 1) || (dasher->real_time && (dasher->nb_inputs>1))) && !has_dependencies) {
+		period_jobs = gf_list_new();
+	}
+
 	if (dasher->dash_ctx) {
 		u32 count = gf_cfg_get_key_count(dasher->dash_ctx, "PastPeriods");
 		for (i=0; i<count; i++) {
@@ -6369,6 +7225,7 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 			char szFPS[100];
 			Bool is_first_rep = GF_FALSE;
 			Bool skip_init_segment_creation = GF_FALSE;
+			DashRepJob *set_job = NULL;
 
 			dasher->segment_alignment_disabled = GF_FALSE;
 
@@ -6499,7 +7356,21 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 					sprintf(szFPS, "%d", fps_num);
 			}
 
-			e = write_adaptation_header(period_mpd, dasher->profile, dasher->use_url_template, dasher->single_file_mode, dasher->inputs, dasher->nb_inputs, cur_period+1, cur_adaptation_set+1, first_rep_in_set,
+			/*in threaded mode, the adaptation set header is written by a job preceding the representation ones*/
+			if (period_jobs) {
+				GF_SAFEALLOC(set_job, DashRepJob);
+				if (set_job) {
+					gf_list_add(period_jobs, set_job);
+					set_job->mpd = gf_temp_file_new(NULL);
+				}
+				if (!set_job || !set_job->mpd) {
+					gf_free(lang);
+					e = set_job ? GF_IO_ERR : GF_OUT_OF_MEM;
+					goto exit;
+				}
+			}
+
+			e = write_adaptation_header(set_job ? set_job->mpd : period_mpd, dasher->profile, dasher->use_url_template, dasher->single_file_mode, dasher->inputs, dasher->nb_inputs, cur_period+1, cur_adaptation_set+1, first_rep_in_set,
 			                            use_bs_switching, max_width, max_height, dar_num, dar_den, szFPS, lang, szInit, dasher->segment_alignment_disabled, dasher->mpd_name);
 			gf_free(lang);
 
@@ -6507,107 +7378,50 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 
 			is_first_rep = GF_TRUE;
 			for (i=0; i<dasher->nb_inputs && !e; i++) {
-				char szOutName[GF_MAX_PATH], *segment_name, *orig_seg_name;
+				DashRepJob *job;
 				GF_DashSegInput *dash_input = &dasher->inputs[i];
-				Double segdur, fragdur;
 				if (dash_input->adaptation_set!=cur_adaptation_set+1)
 					continue;
 
-				orig_seg_name = segment_name = dasher->seg_rad_name;
-
-				strcpy(szOutName, gf_url_get_resource_name(dash_input->file_name));
-				sep = strrchr(szOutName, '.');
-				if (sep) sep[0] = 0;
-
-				/*in scalable case: seg_name is variable*/
-				dasher->variable_seg_rad_name = has_scalability ? GF_TRUE : GF_FALSE;
-				if (segment_name) {
-					if (strstr(segment_name, "%s")) {
-						sprintf(szSolvedSegName, segment_name, szOutName);
-						dasher->variable_seg_rad_name = GF_TRUE;
-						if (dash_input->single_track_num) {
-							char szTkNum[50];
-							sprintf(szTkNum, "_track%d_", dash_input->single_track_num);
-							strcat(szSolvedSegName, szTkNum);
-						}
-					} else {
-						strcpy(szSolvedSegName, segment_name);
-					}
-
-					segment_name = szSolvedSegName;
+				GF_SAFEALLOC(job, DashRepJob);
+				if (!job) {
+					e = GF_OUT_OF_MEM;
+					goto exit;
 				}
+				dasher_setup_rep_job(dasher, dash_input, has_scalability, job);
+				job->first_in_set = is_first_rep;
+				is_first_rep = GF_FALSE;
 
-				/* user added a relative-path baseURL */
-				if (dash_input->nb_baseURL) {
-					if (gf_url_is_local(dash_input->baseURL[0])) {
-						const char *name;
-						char tmp_segment_name[GF_MAX_PATH];
-						if (dash_input->nb_baseURL > 1)
-							GF_LOG(GF_LOG_WARNING, GF_LOG_DASH, ("[DASH] Several relative path baseURL for input %s: selecting \"%s\"\n", dash_input->file_name, dash_input->baseURL[0]));
-						name = gf_url_get_resource_name(szOutName);
-						strcpy(tmp_segment_name, name);
-						gf_url_get_resource_path(dash_input->baseURL[0], szOutName);
-						if (szOutName[strlen(szOutName)] != GF_PATH_SEPARATOR) {
-							char ext[2];
-							ext[0] = GF_PATH_SEPARATOR;
-							ext[1] = 0;
-							strcat(szOutName, ext);
-						}
-						strcat(szOutName, tmp_segment_name);
-					} else {
-						GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("[DASH] Found baseURL for input %s but not a relative path (%s)\n", dash_input->file_name, dash_input->baseURL[0]));
+				if (set_job) {
+					job->mpd = gf_temp_file_new(NULL);
+					job->dasher.mpd = job->mpd;
+					gf_list_add(period_jobs, job);
+					if (!job->mpd) {
+						e = GF_IO_ERR;
+						goto exit;
 					}
+					continue;
 				}
 
-				if ((dash_input->trackNum || dash_input->single_track_num) && (!dasher->seg_rad_name || !strstr(dasher->seg_rad_name, "$RepresentationID$") ) ) {
-					char tmp[10];
-					sprintf(tmp, "_track%d", dash_input->trackNum ? dash_input->trackNum : dash_input->single_track_num);
-					strcat(szOutName, tmp);
-				}
-				strcat(szOutName, "_dash");
-
-				if (gf_url_get_resource_path(dasher->mpd_name, tmp)) {
-					strcat(tmp, szOutName);
-					strcpy(szOutName, tmp);
-				}
-				if (segment_name && dash_input->trackNum && !strstr(dasher->seg_rad_name, "$RepresentationID$") ) {
-					char tmp[10];
-					sprintf(tmp, "_track%d_", dash_input->trackNum);
-					strcat(segment_name, tmp);
-				}
-				dasher->seg_rad_name = segment_name;
-
-				/*in scalable case, we need also the bandwidth of dependent representation*/
-				if (dash_input->dependencyID) {
-					dash_input->dependency_bandwidth = gf_dash_get_dependency_bandwidth(dasher->inputs, dasher->nb_inputs, dash_input->file_name, dash_input->lower_layer_track);
-				}
-
-				segdur = dasher->segment_duration;
-				fragdur = dasher->fragment_duration;
-
-				if (dash_input->segment_duration)
-					dasher->segment_duration = dash_input->segment_duration;
-
-				if (dash_input->segment_duration && (dasher->fragment_duration * dasher->dash_scale > dash_input->segment_duration)) {
-					dasher->fragment_duration = dasher->segment_duration;
-				}
-
-
-				GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("DASHing file %s\n", dash_input->file_name));
-				e = dash_input->dasher_segment_file(dash_input, szOutName, dasher, is_first_rep);
-
-				dasher->seg_rad_name = orig_seg_name;
-				dasher->segment_duration = segdur;
-				dasher->fragment_duration = fragdur;
-
-				if (e) {
-					GF_LOG(GF_LOG_ERROR, GF_LOG_DASH, ("Error while DASH-ing file: %s\n", gf_error_to_string(e)));
-					goto exit;
-				}
-				is_first_rep = GF_FALSE;
+				e = dasher_run_rep_job(job);
+				if (job->dasher.max_segment_duration > dasher->max_segment_duration)
+					dasher->max_segment_duration = job->dasher.max_segment_duration;
+				gf_free(job);
+				if (e) goto exit;
 			}
 			/*close adaptation set*/
-			fprintf(period_mpd, "  </AdaptationSet>\n");
+			if (set_job) {
+				((DashRepJob *)gf_list_last(period_jobs))->close_set = GF_TRUE;
+			} else {
+				fprintf(period_mpd, "  </AdaptationSet>\n");
+			}
+		}
+
+		/*segment all representations of the period*/
+		if (period_jobs) {
+			e = dasher_run_period_jobs(dasher, period_jobs, period_mpd);
+			dasher_reset_jobs(period_jobs);
+			if (e) goto exit;
 		}
 
 		if (period_mpd) {
@@ -6633,7 +7447,7 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 			sprintf(szOpt, "%g", active_period_start);
 			gf_cfg_set_key(dasher->dash_ctx, "DASH", "LastActivePeriodStart", szOpt);
 
-			if (dasher->dash_ctx) purge_dash_context(dasher->dash_ctx);
+			if (dasher->dash_ctx) purge_dash_context(dasher);
 		}
 	}
 
@@ -6670,13 +7484,13 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 			if (p->is_xlink) {
 				write_period_header(dasher, mpd, p->id, 0.0, p->period_duration, p->xlink, 0, GF_FALSE);
 			} else {
-				dash_insert_period_xml(mpd, p->szPeriodXML);
+				dash_insert_period_xml(dasher, mpd, p->szPeriodXML, GF_TRUE);
 			}
 		} else {
 			if (p->is_xlink) {
 				write_period_header(dasher, mpd, p->id, 0.0, p->period_duration, p->xlink, p->period_idx, GF_FALSE);
 			} else {
-				dash_insert_period_xml(mpd, p->szPeriodXML);
+				dash_insert_period_xml(dasher, mpd, p->szPeriodXML, GF_FALSE);
 			}
 
 			if (!dasher->dash_ctx && !p->is_xlink) {
@@ -6705,6 +7519,14 @@ GF_Err gf_dasher_process(GF_DASHSegmenter *dasher, Double sub_duration)
 
 	GF_LOG(GF_LOG_DEBUG, GF_LOG_DASH, ("[DASH] Done dashing\n"));
 
+	/*the context is kept in memory between calls and only saved once the checkpoint period is over*/
+	if (dasher->ctx_checkpoint_file && dasher->ctx_checkpoint_ms && (gf_sys_clock() - dasher->last_ctx_checkpoint >= dasher->ctx_checkpoint_ms)) {
+		if (gf_dasher_save_context(dasher, dasher->ctx_checkpoint_file) == GF_OK) {
+			GF_LOG(GF_LOG_INFO, GF_LOG_DASH, ("[DASH] DASH context saved to %s\n", dasher->ctx_checkpoint_file));
+		}
+		dasher->last_ctx_checkpoint = gf_sys_clock();
+	}
+
 exit:
 	if (mpd) {
 		gf_fclose(mpd);
@@ -6724,6 +7546,10 @@ exit:
 		}
 		gf_list_del(period_links);
 	}
+	if (period_jobs) {
+		dasher_reset_jobs(period_jobs);
+		gf_list_del(period_jobs);
+	}
 
 	return e;
 }
@@ -94,6 +94,222 @@ static GFINLINE s32 gf_m2ts_time_diff_us(GF_M2TS_Time *a, GF_M2TS_Time *b)
 	return drift;
 }
 
+/************************************
+ * ES packet queue
+ ************************************/
+
+/*packets go from the ES output to the muxer through a ring of descriptors indexed by free-running counters, head being
+only written by the muxer and tail only by the ES output. Payloads are handed back to the ES output through a second ring
+for reuse. When the ring is full, packets are put in an overflow list under mutex, and keep going there until the muxer
+drains it so that packet order is preserved*/
+#define M2TS_PCK_QUEUE_SIZE	256
+#define M2TS_PAYLOAD_POOL_SIZE	16
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+/*compiler barrier only, x86 and x64 do not reorder stores with stores nor loads with loads*/
+#define M2TS_MEMORY_BARRIER()	_ReadWriteBarrier()
+#else
+#define M2TS_MEMORY_BARRIER()	__sync_synchronize()
+#endif
+
+typedef struct
+{
+	char *data;
+	u32 size;
+} GF_M2TS_Payload;
+
+struct __m2ts_pck_queue
+{
+	GF_M2TS_Packet pcks[M2TS_PCK_QUEUE_SIZE];
+	volatile u32 head, tail;
+
+	GF_M2TS_Payload pool[M2TS_PAYLOAD_POOL_SIZE];
+	volatile u32 pool_head, pool_tail;
+
+	GF_Mutex *mx;
+	GF_M2TS_Packet *overflow_first, *overflow_last;
+	volatile u32 nb_overflow;
+};
+
+static struct __m2ts_pck_queue *gf_m2ts_pck_queue_new()
+{
+	struct __m2ts_pck_queue *q;
+	GF_SAFEALLOC(q, struct __m2ts_pck_queue);
+	if (!q) return NULL;
+	q->mx = gf_mx_new("M2TS PID");
+	return q;
+}
+
+static void gf_m2ts_pck_queue_del(struct __m2ts_pck_queue *q)
+{
+	while (q->head != q->tail) {
+		GF_M2TS_Packet *pck = &q->pcks[q->head % M2TS_PCK_QUEUE_SIZE];
+		if (pck->data) gf_free(pck->data);
+		if (pck->mpeg2_af_descriptors) gf_free(pck->mpeg2_af_descriptors);
+		q->head++;
+	}
+	while (q->overflow_first) {
+		GF_M2TS_Packet *pck = q->overflow_first;
+		q->overflow_first = pck->next;
+		if (pck->data) gf_free(pck->data);
+		if (pck->mpeg2_af_descriptors) gf_free(pck->mpeg2_af_descriptors);
+		gf_free(pck);
+	}
+	while (q->pool_head != q->pool_tail) {
+		gf_free(q->pool[q->pool_head % M2TS_PAYLOAD_POOL_SIZE].data);
+		q->pool_head++;
+	}
+	gf_mx_del(q->mx);
+	gf_free(q);
+}
+
+/*ES output side*/
+static GF_Err gf_m2ts_pck_queue_push(struct __m2ts_pck_queue *q, GF_M2TS_Packet *pck)
+{
+	GF_M2TS_Packet *ovf;
+	if (!q->nb_overflow && (q->tail - q->head < M2TS_PCK_QUEUE_SIZE)) {
+		q->pcks[q->tail % M2TS_PCK_QUEUE_SIZE] = *pck;
+		/*publish the descriptor before the new tail*/
+		M2TS_MEMORY_BARRIER();
+		q->tail++;
+		return GF_OK;
+	}
+	ovf = (GF_M2TS_Packet*)gf_malloc(sizeof(GF_M2TS_Packet));
+	if (!ovf) return GF_OUT_OF_MEM;
+	*ovf = *pck;
+	ovf->next = NULL;
+	gf_mx_p(q->mx);
+	if (q->overflow_last) q->overflow_last->next = ovf;
+	else q->overflow_first = ovf;
+	q->overflow_last = ovf;
+	q->nb_overflow++;
+	gf_mx_v(q->mx);
+	return GF_OK;
+}
+
+/*ES output side: makes sure the packet payload can hold size bytes, reusing a payload released by the muxer if any*/
+static GF_Err gf_m2ts_pck_queue_alloc_payload(struct __m2ts_pck_queue *q, GF_M2TS_Packet *pck, u32 size)
+{
+	if (!pck->data && (q->pool_head != q->pool_tail)) {
+		M2TS_MEMORY_BARRIER();
+		pck->data = q->pool[q->pool_head % M2TS_PAYLOAD_POOL_SIZE].data;
+		pck->data_alloc = q->pool[q->pool_head % M2TS_PAYLOAD_POOL_SIZE].size;
+		M2TS_MEMORY_BARRIER();
+		q->pool_head++;
+	}
+	if (pck->data_alloc < size) {
+		pck->data = (char*)gf_realloc(pck->data, sizeof(char)*size);
+		if (!pck->data) {
+			pck->data_alloc = 0;
+			return GF_OUT_OF_MEM;
+		}
+		pck->data_alloc = size;
+	}
+	return GF_OK;
+}
+
+static Bool gf_m2ts_pck_queue_is_empty(struct __m2ts_pck_queue *q)
+{
+	return ((q->head == q->tail) && !q->nb_overflow) ? GF_TRUE : GF_FALSE;
+}
+
+/*muxer side: the returned packet stays valid until the next pop*/
+static GF_M2TS_Packet *gf_m2ts_pck_queue_peek(struct __m2ts_pck_queue *q, u32 idx)
+{
+	GF_M2TS_Packet *pck;
+	u32 count = q->tail - q->head;
+	if (idx < count) {
+		M2TS_MEMORY_BARRIER();
+		return &q->pcks[(q->head + idx) % M2TS_PCK_QUEUE_SIZE];
+	}
+	if (!q->nb_overflow) return NULL;
+	idx -= count;
+	gf_mx_p(q->mx);
+	pck = q->overflow_first;
+	while (pck && idx) {
+		pck = pck->next;
+		idx--;
+	}
+	gf_mx_v(q->mx);
+	return pck;
+}
+
+/*muxer side*/
+static Bool gf_m2ts_pck_queue_pop(struct __m2ts_pck_queue *q, GF_M2TS_Packet *pck)
+{
+	GF_M2TS_Packet *ovf;
+	if (q->head != q->tail) {
+		M2TS_MEMORY_BARRIER();
+		*pck = q->pcks[q->head % M2TS_PCK_QUEUE_SIZE];
+		/*the slot may be overwritten as soon as the new head is visible*/
+		M2TS_MEMORY_BARRIER();
+		q->head++;
+		return GF_TRUE;
+	}
+	if (!q->nb_overflow) return GF_FALSE;
+
+	gf_mx_p(q->mx);
+	ovf = q->overflow_first;
+	if (ovf) {
+		q->overflow_first = ovf->next;
+		if (!q->overflow_first) q->overflow_last = NULL;
+		q->nb_overflow--;
+	}
+	gf_mx_v(q->mx);
+	if (!ovf) return GF_FALSE;
+	*pck = *ovf;
+	gf_free(ovf);
+	return GF_TRUE;
+}
+
+/*muxer side: total payload size of queued packets*/
+static u32 gf_m2ts_pck_queue_get_size(struct __m2ts_pck_queue *q)
+{
+	u32 i, size = 0;
+	u32 count = q->tail - q->head;
+	M2TS_MEMORY_BARRIER();
+	for (i=0; i<count; i++) {
+		size += q->pcks[(q->head + i) % M2TS_PCK_QUEUE_SIZE].data_len;
+	}
+	if (q->nb_overflow) {
+		GF_M2TS_Packet *pck;
+		gf_mx_p(q->mx);
+		pck = q->overflow_first;
+		while (pck) {
+			size += pck->data_len;
+			pck = pck->next;
+		}
+		gf_mx_v(q->mx);
+	}
+	return size;
+}
+
+/*muxer side: hands a payload back to the ES output, or frees it if enough payloads are pending reuse*/
+static void gf_m2ts_pck_queue_recycle_payload(struct __m2ts_pck_queue *q, char *data, u32 size)
+{
+	if (q->pool_tail - q->pool_head < M2TS_PAYLOAD_POOL_SIZE) {
+		q->pool[q->pool_tail % M2TS_PAYLOAD_POOL_SIZE].data = data;
+		q->pool[q->pool_tail % M2TS_PAYLOAD_POOL_SIZE].size = size;
+		M2TS_MEMORY_BARRIER();
+		q->pool_tail++;
+	} else {
+		gf_free(data);
+	}
+}
+
+/*releases a payload of the stream - payloads coming from the packet queue are recycled*/
+static void gf_m2ts_stream_free_data(GF_M2TS_Mux_Stream *stream, char *data)
+{
+	if (!data) return;
+	if (data == stream->queue_data) {
+		gf_m2ts_pck_queue_recycle_payload(stream->pck_queue, data, stream->queue_data_alloc);
+		stream->queue_data = NULL;
+	} else {
+		gf_free(data);
+	}
+}
+
 /************************************
  * Section-related functions
  ************************************/
@@ -956,7 +1172,6 @@ static void id3_tag_create(char **input, u32 *len)
 	gf_bs_write_u8(bs, 0);
 	gf_bs_write_u8(bs, 0);
 	gf_bs_write_data(bs, *input, *len);
-	gf_free(*input);
 	gf_bs_get_content(bs, input, len);
 	gf_bs_del(bs);
 }
@@ -1026,7 +1241,7 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 	if (stream->ifce->caps & GF_ESI_AU_PULL_CAP) {
 		if (stream->curr_pck.data_len) {
 			/*discard packet data if we use SL over PES*/
-			if (stream->discard_data) gf_free(stream->curr_pck.data);
+			if (stream->discard_data) gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 			/*release data*/
 			stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_RELEASE, NULL);
 		}
@@ -1039,40 +1254,34 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 		assert( stream->ifce->input_ctrl);
 		stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_PULL, &stream->curr_pck);
 	} else {
-		GF_M2TS_Packet *curr_pck;
+		GF_M2TS_Packet curr_pck;
 
-		if (!stream->pck_first && (stream->ifce->caps & GF_ESI_STREAM_IS_OVER))
+		if (gf_m2ts_pck_queue_is_empty(stream->pck_queue) && (stream->ifce->caps & GF_ESI_STREAM_IS_OVER))
 			return ret;
 
 		/*flush input pipe*/
 		if (stream->ifce->input_ctrl) stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_FLUSH, NULL);
 
-		gf_mx_p(stream->mx);
-
 		stream->pck_offset = 0;
 		stream->curr_pck.data_len = 0;
 
 		/*fill curr_pck*/
-		curr_pck = stream->pck_first;
-		if (!curr_pck) {
-			gf_mx_v(stream->mx);
+		if (!gf_m2ts_pck_queue_pop(stream->pck_queue, &curr_pck))
 			return ret;
-		}
-		stream->curr_pck.cts = curr_pck->cts;
-		stream->curr_pck.data = curr_pck->data;
-		stream->curr_pck.data_len = curr_pck->data_len;
-		stream->curr_pck.dts = curr_pck->dts;
-		stream->curr_pck.duration = curr_pck->duration;
-		stream->curr_pck.flags = curr_pck->flags;
-		stream->curr_pck.mpeg2_af_descriptors = curr_pck->mpeg2_af_descriptors;
-		stream->curr_pck.mpeg2_af_descriptors_size = curr_pck->mpeg2_af_descriptors_size;
-
-		/*discard first packet*/
-		stream->pck_first = curr_pck->next;
-		gf_free(curr_pck);
-		stream->discard_data = GF_TRUE;
 
-		gf_mx_v(stream->mx);
+		stream->curr_pck.cts = curr_pck.cts;
+		stream->curr_pck.data = curr_pck.data;
+		stream->curr_pck.data_len = curr_pck.data_len;
+		stream->curr_pck.dts = curr_pck.dts;
+		stream->curr_pck.duration = curr_pck.duration;
+		stream->curr_pck.flags = curr_pck.flags;
+		stream->curr_pck.mpeg2_af_descriptors = curr_pck.mpeg2_af_descriptors;
+		stream->curr_pck.mpeg2_af_descriptors_size = curr_pck.mpeg2_af_descriptors_size;
+
+		/*payload goes back to the queue once sent*/
+		stream->queue_data = curr_pck.data;
+		stream->queue_data_alloc = curr_pck.data_alloc;
+		stream->discard_data = GF_TRUE;
 	}
 
 	if (!(stream->curr_pck.flags & GF_ESI_DATA_HAS_DTS))
@@ -1094,7 +1303,7 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 			GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[MPEG-2 TS Muxer] PID %d: Initializing PCR for program number %d: PCR %d - mux time %d:%09d\n", stream->pid, stream->program->number, stream->program->pcr_init_time, muxer->time.sec, muxer->time.nanosec));
 		} else {
 			/*PES has been sent, discard internal buffer*/
-			if (stream->discard_data) gf_free(stream->curr_pck.data);
+			if (stream->discard_data) gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 			stream->curr_pck.data = NULL;
 			stream->curr_pck.data_len = 0;
 			stream->pck_offset = 0;
@@ -1123,7 +1332,7 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 
 		/*packet data is now copied in sections, discard it if not pull*/
 		if (!(stream->ifce->caps & GF_ESI_AU_PULL_CAP)) {
-			gf_free(stream->curr_pck.data);
+			gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 			stream->curr_pck.data = NULL;
 			stream->curr_pck.data_len = 0;
 		}
@@ -1155,7 +1364,7 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 
 		/*discard src data*/
 		if (!(stream->ifce->caps & GF_ESI_AU_PULL_CAP)) {
-			gf_free(src_data);
+			gf_m2ts_stream_free_data(stream, src_data);
 		}
 		GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[MPEG-2 TS Muxer] PID %d: Encapsulating MPEG-4 SL Data (%p - %p) on PES - SL Header size %d\n", stream->pid, src_data, stream->curr_pck.data, stream->curr_pck.data_len - src_data_len));
 
@@ -1209,7 +1418,7 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 		stream->reframe_overhead = stream->curr_pck.data_len;
 		gf_bs_write_data(bs, stream->curr_pck.data, stream->curr_pck.data_len);
 		gf_bs_align(bs);
-		gf_free(stream->curr_pck.data);
+		gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 		gf_bs_get_content(bs, &stream->curr_pck.data, &stream->curr_pck.data_len);
 		gf_bs_del(bs);
 		stream->reframe_overhead = stream->curr_pck.data_len - stream->reframe_overhead;
@@ -1246,7 +1455,7 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 
 			gf_bs_write_data(bs, stream->curr_pck.data, stream->curr_pck.data_len);
 			gf_bs_align(bs);
-			gf_free(stream->curr_pck.data);
+			gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 			gf_bs_get_content(bs, &stream->curr_pck.data, &stream->curr_pck.data_len);
 			gf_bs_del(bs);
 			/*constant reframe overhead*/
@@ -1258,7 +1467,9 @@ static u32 gf_m2ts_stream_process_pes(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *st
 	case GF_M2TS_METADATA_PES:
 	case GF_M2TS_METADATA_ID3_HLS:
 	{
+		char *src_data = stream->curr_pck.data;
 		id3_tag_create(&stream->curr_pck.data, &stream->curr_pck.data_len);
+		gf_m2ts_stream_free_data(stream, src_data);
 		stream->discard_data = GF_TRUE;
 	}
 	break;
@@ -1355,18 +1566,26 @@ void gf_m2ts_stream_update_data_following(GF_M2TS_Mux_Stream *stream)
 		}
 	} else {
 		/*flush input*/
-		if (!stream->pck_first && stream->ifce->input_ctrl) stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_FLUSH, NULL);
-		if (stream->pck_first) {
-			stream->next_payload_size = stream->pck_first->data_len;
-			stream->next_pck_cts = stream->pck_first->cts;
-			stream->next_pck_dts = stream->pck_first->dts;
-			stream->next_pck_flags = stream->pck_first->flags;
-
-			if (!stream->pck_first->next && stream->ifce->input_ctrl) stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_FLUSH, NULL);
-			if (stream->pck_first->next) {
-				stream->next_next_payload_size = stream->pck_first->next->data_len;
+		GF_M2TS_Packet *next_pck = gf_m2ts_pck_queue_peek(stream->pck_queue, 0);
+		if (!next_pck && stream->ifce->input_ctrl) {
+			stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_FLUSH, NULL);
+			next_pck = gf_m2ts_pck_queue_peek(stream->pck_queue, 0);
+		}
+		if (next_pck) {
+			GF_M2TS_Packet *next_next_pck;
+			stream->next_payload_size = next_pck->data_len;
+			stream->next_pck_cts = next_pck->cts;
+			stream->next_pck_dts = next_pck->dts;
+			stream->next_pck_flags = next_pck->flags;
+
+			next_next_pck = gf_m2ts_pck_queue_peek(stream->pck_queue, 1);
+			if (!next_next_pck && stream->ifce->input_ctrl) {
+				stream->ifce->input_ctrl(stream->ifce, GF_ESI_INPUT_DATA_FLUSH, NULL);
+				next_next_pck = gf_m2ts_pck_queue_peek(stream->pck_queue, 1);
+			}
+			if (next_next_pck) {
+				stream->next_next_payload_size = next_next_pck->data_len;
 			}
-
 		}
 	}
 	/*consider we don't have the next AU if:
@@ -1820,6 +2039,8 @@ void gf_m2ts_mux_pes_get_next_packet(GF_M2TS_Mux_Stream *stream, char *packet)
 
 	if (stream->pck_offset == stream->curr_pck.data_len) {
 		u64 pcr = gf_m2ts_get_pcr(stream)/300;
+		/*late AU accounting, modulo 2^33 since DTS may have wrapped*/
+		if ((((pcr - stream->curr_pck.dts) & 0x1FFFFFFFFULL) - 1) < 0xFFFFFFFFULL) stream->program->nb_late_au++;
 		if (stream->program->mux->real_time && !stream->program->mux->fixed_rate && gf_m2ts_time_less(&stream->time, &stream->program->mux->time) ) {
 			GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[MPEG2-TS Muxer] Sent PES TOO LATE: PID %d - DTS "LLD" - PCR "LLD" - stream time %d:%09d - mux time %d:%09d - current mux rate %d\n",
 			                                       stream->pid, stream->curr_pck.dts, pcr,
@@ -1845,7 +2066,7 @@ void gf_m2ts_mux_pes_get_next_packet(GF_M2TS_Mux_Stream *stream, char *packet)
 		}
 
 		/*PES has been sent, discard internal buffer*/
-		if (stream->discard_data) gf_free(stream->curr_pck.data);
+		if (stream->discard_data) gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 		stream->curr_pck.data = NULL;
 		stream->curr_pck.data_len = 0;
 		stream->pck_offset = 0;
@@ -1897,7 +2118,7 @@ void gf_m2ts_mux_pes_get_next_packet(GF_M2TS_Mux_Stream *stream, char *packet)
 				if (stream->pck_offset == stream->curr_pck.data_len) {
 					assert(!remain || (remain>=stream->min_bytes_copy_from_next));
 					/*PES has been sent, discard internal buffer*/
-					if (stream->discard_data) gf_free(stream->curr_pck.data);
+					if (stream->discard_data) gf_m2ts_stream_free_data(stream, stream->curr_pck.data);
 					stream->curr_pck.data = NULL;
 					stream->curr_pck.data_len = 0;
 					stream->pck_offset = 0;
@@ -1932,6 +2153,7 @@ GF_M2TS_Mux_Stream *gf_m2ts_stream_new(u32 pid) {
 
 GF_Err gf_m2ts_output_ctrl(GF_ESInterface *_self, u32 ctrl_type, void *param)
 {
+	GF_Err e;
 	GF_ESIPacket *esi_pck;
 
 	GF_M2TS_Mux_Stream *stream = (GF_M2TS_Mux_Stream *)_self->output_udta;
@@ -1939,26 +2161,23 @@ GF_Err gf_m2ts_output_ctrl(GF_ESInterface *_self, u32 ctrl_type, void *param)
 	case GF_ESI_OUTPUT_DATA_DISPATCH:
 		esi_pck = (GF_ESIPacket *)param;
 
-		if (stream->force_new || (esi_pck->flags & GF_ESI_DATA_AU_START)) {
-			if (stream->pck_reassembler) {
-				gf_mx_p(stream->mx);
-				if (!stream->pck_first) {
-					stream->pck_first = stream->pck_last = stream->pck_reassembler;
-				} else {
-					stream->pck_last->next = stream->pck_reassembler;
-					stream->pck_last = stream->pck_reassembler;
-				}
-				gf_mx_v(stream->mx);
-				stream->pck_reassembler = NULL;
-			}
-		}
 		if (!stream->pck_reassembler) {
 			GF_SAFEALLOC(stream->pck_reassembler, GF_M2TS_Packet);
 			if (!stream->pck_reassembler) {
 				GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS Muxer] PID %d: fail to allocate packet reassembler\n", stream->pid));
 				return GF_OUT_OF_MEM;
 			}
-
+		}
+		if (stream->force_new || (esi_pck->flags & GF_ESI_DATA_AU_START)) {
+			if (stream->has_reassembled_data) {
+				e = gf_m2ts_pck_queue_push(stream->pck_queue, stream->pck_reassembler);
+				memset(stream->pck_reassembler, 0, sizeof(GF_M2TS_Packet));
+				stream->has_reassembled_data = GF_FALSE;
+				if (e) return e;
+			}
+		}
+		if (!stream->has_reassembled_data) {
+			stream->has_reassembled_data = GF_TRUE;
 			stream->pck_reassembler->cts = esi_pck->cts;
 			stream->pck_reassembler->dts = esi_pck->dts;
 			stream->pck_reassembler->duration = esi_pck->duration;
@@ -1971,21 +2190,17 @@ GF_Err gf_m2ts_output_ctrl(GF_ESInterface *_self, u32 ctrl_type, void *param)
 
 		stream->force_new = esi_pck->flags & GF_ESI_DATA_AU_END ? GF_TRUE : GF_FALSE;
 
-		stream->pck_reassembler->data = (char*)gf_realloc(stream->pck_reassembler->data , sizeof(char)*(stream->pck_reassembler->data_len+esi_pck->data_len) );
+		e = gf_m2ts_pck_queue_alloc_payload(stream->pck_queue, stream->pck_reassembler, stream->pck_reassembler->data_len + esi_pck->data_len);
+		if (e) return e;
 		memcpy(stream->pck_reassembler->data + stream->pck_reassembler->data_len, esi_pck->data, esi_pck->data_len);
 		stream->pck_reassembler->data_len += esi_pck->data_len;
 
 		stream->pck_reassembler->flags |= esi_pck->flags;
 		if (stream->force_new) {
-			gf_mx_p(stream->mx);
-			if (!stream->pck_first) {
-				stream->pck_first = stream->pck_last = stream->pck_reassembler;
-			} else {
-				stream->pck_last->next = stream->pck_reassembler;
-				stream->pck_last = stream->pck_reassembler;
-			}
-			gf_mx_v(stream->mx);
-			stream->pck_reassembler = NULL;
+			e = gf_m2ts_pck_queue_push(stream->pck_queue, stream->pck_reassembler);
+			memset(stream->pck_reassembler, 0, sizeof(GF_M2TS_Packet));
+			stream->has_reassembled_data = GF_FALSE;
+			if (e) return e;
 		}
 		break;
 	}
@@ -2114,6 +2329,13 @@ GF_M2TS_Mux_Stream *gf_m2ts_program_stream_add(GF_M2TS_Mux_Program *program, str
 	GF_M2TS_Mux_Stream *stream, *st;
 
 	stream = gf_m2ts_stream_new(pid);
+	if (!stream) return NULL;
+	stream->pck_queue = gf_m2ts_pck_queue_new();
+	if (!stream->pck_queue) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS Muxer] PID %d: fail to allocate packet queue\n", pid));
+		gf_free(stream);
+		return NULL;
+	}
 	stream->ifce = ifce;
 	stream->pid = pid;
 	stream->program = program;
@@ -2274,7 +2496,6 @@ GF_M2TS_Mux_Stream *gf_m2ts_program_stream_add(GF_M2TS_Mux_Program *program, str
 
 	stream->ifce->output_ctrl = gf_m2ts_output_ctrl;
 	stream->ifce->output_udta = stream;
-	stream->mx = gf_mx_new("M2TS PID");
 	if (ifce->timescale != 90000) stream->ts_scale = 90000.0 / ifce->timescale;
 	return stream;
 }
@@ -2411,14 +2632,13 @@ void gf_m2ts_mux_stream_del(GF_M2TS_Mux_Stream *st)
 		gf_free(st->tables);
 		st->tables = tab;
 	}
-	while (st->pck_first) {
-		GF_M2TS_Packet *curr_pck = st->pck_first;
-		st->pck_first = curr_pck->next;
-		gf_free(curr_pck->data);
-		gf_free(curr_pck);
+	if (st->pck_reassembler) {
+		if (st->pck_reassembler->data) gf_free(st->pck_reassembler->data);
+		if (st->pck_reassembler->mpeg2_af_descriptors) gf_free(st->pck_reassembler->mpeg2_af_descriptors);
+		gf_free(st->pck_reassembler);
 	}
 	if (st->curr_pck.data) gf_free(st->curr_pck.data);
-	if (st->mx) gf_mx_del(st->mx);
+	if (st->pck_queue) gf_m2ts_pck_queue_del(st->pck_queue);
 	if (st->loop_descriptors) {
 		while (gf_list_count(st->loop_descriptors) ) {
 			GF_M2TSDescriptor *desc = (GF_M2TSDescriptor*)gf_list_last(st->loop_descriptors);
@@ -2554,24 +2774,81 @@ GF_Err gf_m2ts_mux_enable_pcr_only_packets(GF_M2TS_Mux *muxer, Bool enable_force
 	return GF_OK;
 }
 
-
 GF_EXPORT
-const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status, u32 *usec_till_next)
+GF_Err gf_m2ts_mux_enable_statmux(GF_M2TS_Mux *muxer, u32 lookahead_ms)
+{
+	if (!muxer) return GF_BAD_PARAM;
+	if (lookahead_ms && !muxer->fixed_rate) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG2-TS Muxer] Statistical multiplexing requires a fixed mux rate\n"));
+		return GF_BAD_PARAM;
+	}
+	muxer->statmux_lookahead_ms = lookahead_ms;
+	return GF_OK;
+}
+
+/*time left in us before the deadline of the current AU of the stream (scheduling time + PCR offset) once its remaining packets are sent*/
+static s32 gf_m2ts_stream_get_laxity(GF_M2TS_Mux *muxer, GF_M2TS_Mux_Stream *stream)
+{
+	s32 laxity = gf_m2ts_time_diff_us(&muxer->time, &stream->time);
+	if (!stream->tables) {
+		u32 remain = (stream->curr_pck.data_len > stream->pck_offset) ? stream->curr_pck.data_len - stream->pck_offset : 0;
+		laxity += (s32) ((u64) stream->program->pcr_offset * 100 / 9);
+		laxity -= (s32) ((u64) ((remain + 183) / 184) * 1504 * 1000000 / muxer->bit_rate);
+	}
+	return laxity;
+}
+
+static u32 gf_m2ts_program_get_backlog(GF_M2TS_Mux_Program *program)
+{
+	u32 backlog = 0;
+	GF_M2TS_Mux_Stream *stream = program->streams;
+	while (stream) {
+		if (stream->curr_pck.data_len > stream->pck_offset)
+			backlog += stream->curr_pck.data_len - stream->pck_offset;
+		if (stream->pck_queue)
+			backlog += gf_m2ts_pck_queue_get_size(stream->pck_queue);
+		stream = stream->next;
+	}
+	return backlog;
+}
+
+static void gf_m2ts_mux_update_program_stats(GF_M2TS_Mux *muxer)
+{
+	GF_M2TS_Mux_Program *program = muxer->programs;
+	u32 window = muxer->pck_sent_over_stats_window;
+
+	while (program) {
+		u64 bits;
+		program->occupancy = program->pck_sent_over_window * 100 / window;
+		program->rate_kbps = (u32) ((u64) program->pck_sent_over_window * muxer->bit_rate / window / 1000);
+		program->backlog_bytes = gf_m2ts_program_get_backlog(program);
+		bits = (u64) program->backlog_bytes * 8;
+		program->demand_kbps = (u32) ((program->pcr_offset ? bits * 90000 / program->pcr_offset : bits) / 1000);
+		program->pck_sent_over_window = 0;
+		program = program->next;
+	}
+	muxer->pck_sent_over_stats_window = 0;
+}
+
+/*produces the next packet of the multiplex, now_us being the system clock sampled by the caller*/
+static const char *gf_m2ts_mux_process_packet(GF_M2TS_Mux *muxer, u32 *status, u32 *usec_till_next, u64 now_us)
 {
 	GF_M2TS_Mux_Program *program;
 	GF_M2TS_Mux_Stream *stream, *stream_to_process;
 	GF_M2TS_Time time, max_time;
 	u32 nb_streams, nb_streams_done;
-	u64 now_us;
 	char *ret;
 	u32 res, highest_priority;
 	Bool flush_all_pes = GF_FALSE;
 	Bool check_max_time = GF_FALSE;
+	/*statmux state: a due stream was found, the selected stream is sent ahead of its scheduling time*/
+	Bool statmux_due = GF_FALSE, statmux_early = GF_FALSE;
+	s32 statmux_laxity = 0;
+	GF_M2TS_Time statmux_end;
 
 	nb_streams = nb_streams_done = 0;
 	*status = GF_M2TS_STATE_IDLE;
 
-	now_us = gf_sys_clock_high_res();
 	if (muxer->real_time) {
 		if (!muxer->init_sys_time) {
 			//init TS time
@@ -2700,6 +2977,10 @@ const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status, u32 *usec_till_
 	}
 #endif
 
+	/*statmux: streams scheduled up to statmux_end may be sent in place of padding*/
+	statmux_end = muxer->time;
+	if (muxer->statmux_lookahead_ms) gf_m2ts_time_inc(&statmux_end, muxer->statmux_lookahead_ms, 1000);
+
 	/*all streams for each program*/
 	highest_priority = 0;
 	program = muxer->programs;
@@ -2719,9 +3000,23 @@ const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status, u32 *usec_till_
 				res = stream->process(muxer, stream);
 				/*next is rap on this stream, check flushing of other pes (we could use a goto)*/
 				if (!flush_all_pes && muxer->force_pat)
-					return gf_m2ts_mux_process(muxer, status, usec_till_next);
-
-				if (res) {
+					return gf_m2ts_mux_process_packet(muxer, status, usec_till_next, now_us);
+
+				if (res && muxer->statmux_lookahead_ms && !flush_all_pes) {
+					/*schedule the most urgent stream among due ones, or among the ones scheduled within the lookahead if none is due*/
+					Bool is_due = gf_m2ts_time_less(&stream->time, &muxer->time);
+					if (is_due || (!statmux_due && !stream->pcr_only_mode && gf_m2ts_time_less(&stream->time, &statmux_end))) {
+						s32 laxity = gf_m2ts_stream_get_laxity(muxer, stream);
+						if (!stream_to_process || (is_due && !statmux_due) || (laxity < statmux_laxity)) {
+							statmux_laxity = laxity;
+							statmux_due = is_due;
+							statmux_early = !is_due;
+							time = stream->time;
+							stream_to_process = stream;
+						}
+					}
+				}
+				else if (res) {
 					/*always schedule the earliest data*/
 					if (gf_m2ts_time_less(&stream->time, &time)) {
 						highest_priority = res;
@@ -2777,6 +3072,11 @@ send_pck:
 		} else {
 			gf_m2ts_mux_pes_get_next_packet(stream_to_process, muxer->dst_pck);
 		}
+		if (stream_to_process->program) {
+			stream_to_process->program->nb_pck_sent++;
+			stream_to_process->program->pck_sent_over_window++;
+			if (statmux_early) stream_to_process->program->nb_early_pck++;
+		}
 
 		ret = muxer->dst_pck;
 		*status = GF_M2TS_STATE_DATA;
@@ -2791,9 +3091,13 @@ send_pck:
 		/*increment time*/
 		if (muxer->fixed_rate ) {
 			gf_m2ts_time_inc(&muxer->time, 1504/*188*8*/, muxer->bit_rate);
+			/*program metrics over one second of multiplex*/
+			muxer->pck_sent_over_stats_window++;
+			if (muxer->pck_sent_over_stats_window >= muxer->bit_rate/1504)
+				gf_m2ts_mux_update_program_stats(muxer);
 		}
 		else if (muxer->real_time) {
-			u64 us_diff = gf_sys_clock_high_res() - muxer->init_sys_time;
+			u64 us_diff = now_us - muxer->init_sys_time;
 			muxer->time = muxer->init_ts_time;
 			gf_m2ts_time_inc(&muxer->time, us_diff, 1000000);
 		}
@@ -2818,5 +3122,244 @@ send_pck:
 	return ret;
 }
 
+GF_EXPORT
+const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status, u32 *usec_till_next)
+{
+	return gf_m2ts_mux_process_packet(muxer, status, usec_till_next, gf_sys_clock_high_res());
+}
+
+GF_EXPORT
+u32 gf_m2ts_mux_process_batch(GF_M2TS_Mux *muxer, char *buffer, u32 max_packets, u32 *status, u32 *usec_till_next)
+{
+	u32 nb_pck = 0;
+	/*the system clock is sampled once for the whole batch, except in real-time VBR mode where the mux time follows
+	the clock: stream input may block while processing the batch, and packets due meanwhile must be sent*/
+	u64 now_us = gf_sys_clock_high_res();
+
+	*status = GF_M2TS_STATE_IDLE;
+	if (!muxer || !buffer) return 0;
+
+	while (nb_pck < max_packets) {
+		const char *pck;
+		if (nb_pck && muxer->real_time && !muxer->fixed_rate) now_us = gf_sys_clock_high_res();
+		pck = gf_m2ts_mux_process_packet(muxer, status, usec_till_next, now_us);
+		if (!pck) break;
+		memcpy(buffer + 188 * nb_pck, pck, 188);
+		nb_pck++;
+	}
+	return nb_pck;
+}
+
+
+/*a datagram is sent when its last packet is due: OS sleeps are only accurate to the scheduler granularity,
+we sleep until M2TS_SENDER_SPIN_US before the due time then busy-wait*/
+#define M2TS_SENDER_SPIN_US	500
+#define M2TS_SENDER_MAX_PCR_PIDS	16
+/*PCR range in 27 MHz units, the 33-bit PCR base wraps about every 26.5 hours*/
+#define M2TS_SENDER_PCR_WRAP	(0x200000000ULL * 300)
+
+struct __m2ts_sender
+{
+	GF_M2TS_Mux *muxer;
+	GF_Socket *sk;
+	char *buffer;
+	u32 nb_pck, nb_pck_per_datagram;
+
+	GF_M2TS_SenderStats stats;
+	u64 first_send_time, bits_sent, send_delay_sum, pcr_jitter_sum;
+	/*difference between send time and PCR of the first PCR of each PCR PID, last PCR received and PCR wraps seen since the first PCR*/
+	struct {
+		u32 pid;
+		s64 offset;
+		u64 last_pcr, pcr_wrap;
+	} pcr_refs[M2TS_SENDER_MAX_PCR_PIDS];
+	u32 nb_pcr_refs;
+};
+
+static void gf_m2ts_sender_wait_until(u64 target_us)
+{
+	u64 now = gf_sys_clock_high_res();
+	if (now >= target_us) return;
+
+	if (target_us - now > M2TS_SENDER_SPIN_US) {
+		u64 sleep_us = target_us - now - M2TS_SENDER_SPIN_US;
+#if defined(WIN32) || defined(_WIN32_WCE)
+		gf_sleep((u32) (sleep_us / 1000));
+#else
+		struct timespec ts;
+		ts.tv_sec = (time_t) (sleep_us / 1000000);
+		ts.tv_nsec = (long) (sleep_us % 1000000) * 1000;
+#if defined(GPAC_CONFIG_LINUX)
+		clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, NULL);
+#else
+		nanosleep(&ts, NULL);
+#endif
+#endif
+	}
+	while (gf_sys_clock_high_res() < target_us) {
+	}
+}
+
+/*system time in us at which the muxer reaches the given TS time*/
+static u64 gf_m2ts_mux_get_sys_time(GF_M2TS_Mux *muxer, GF_M2TS_Time *time)
+{
+	s64 us = (s64) time->sec - (s64) muxer->init_ts_time.sec;
+	us *= 1000000;
+	us += ((s64) time->nanosec - (s64) muxer->init_ts_time.nanosec) / 1000;
+	return (u64) ((s64) muxer->init_sys_time + us);
+}
+
+static void gf_m2ts_sender_check_pcr(GF_M2TS_Sender *sender, const u8 *pck, u64 send_time)
+{
+	u32 i, pid;
+	u64 pcr;
+	s64 offset, jitter;
+
+	/*adaptation field with PCR*/
+	if (!(pck[3] & 0x20) || !pck[4] || !(pck[5] & 0x10)) return;
+
+	pid = ((pck[1] & 0x1f) << 8) | pck[2];
+	pcr = ((u64) pck[6] << 25) | ((u64) pck[7] << 17) | ((u64) pck[8] << 9) | ((u64) pck[9] << 1) | (pck[10] >> 7);
+	pcr = pcr*300 + (((pck[10] & 0x1) << 8) | pck[11]);
+
+	for (i=0; i<sender->nb_pcr_refs; i++) {
+		if (sender->pcr_refs[i].pid == pid) break;
+	}
+	if (i==sender->nb_pcr_refs) {
+		if (i==M2TS_SENDER_MAX_PCR_PIDS) return;
+		sender->pcr_refs[i].pid = pid;
+		sender->pcr_refs[i].offset = (s64) send_time - (s64) (pcr / 27);
+		sender->pcr_refs[i].last_pcr = pcr;
+		sender->pcr_refs[i].pcr_wrap = 0;
+		sender->nb_pcr_refs++;
+	}
+	/*PCR going back by more than half its range: the 33-bit base wrapped*/
+	if ((pcr < sender->pcr_refs[i].last_pcr) && (sender->pcr_refs[i].last_pcr - pcr > M2TS_SENDER_PCR_WRAP/2))
+		sender->pcr_refs[i].pcr_wrap += M2TS_SENDER_PCR_WRAP;
+	sender->pcr_refs[i].last_pcr = pcr;
+	offset = (s64) send_time - (s64) ((pcr + sender->pcr_refs[i].pcr_wrap) / 27);
+	jitter = offset - sender->pcr_refs[i].offset;
+
+	if (!sender->stats.nb_pcrs || (jitter < sender->stats.pcr_jitter_min)) sender->stats.pcr_jitter_min = (s32) jitter;
+	if (!sender->stats.nb_pcrs || (jitter > sender->stats.pcr_jitter_max)) sender->stats.pcr_jitter_max = (s32) jitter;
+	sender->pcr_jitter_sum += (jitter<0) ? -jitter : jitter;
+	sender->stats.nb_pcrs++;
+	sender->stats.pcr_jitter_avg = (u32) (sender->pcr_jitter_sum / sender->stats.nb_pcrs);
+}
+
+GF_EXPORT
+GF_M2TS_Sender *gf_m2ts_sender_new(GF_M2TS_Mux *muxer, const char *ip, u16 port, u32 ttl, const char *ifce_ip, u32 nb_pck_per_datagram)
+{
+	GF_Err e;
+	GF_M2TS_Sender *sender;
+	if (!muxer || !ip) return NULL;
+	if (!muxer->real_time) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG2-TS Sender] Muxer is not in real-time mode, cannot pace output\n"));
+		return NULL;
+	}
+
+	GF_SAFEALLOC(sender, GF_M2TS_Sender);
+	if (!sender) return NULL;
+	sender->muxer = muxer;
+	sender->nb_pck_per_datagram = nb_pck_per_datagram ? nb_pck_per_datagram : 7;
+	sender->buffer = (char *) gf_malloc(sizeof(char) * 188 * sender->nb_pck_per_datagram);
+	sender->sk = gf_sk_new(GF_SOCK_TYPE_UDP);
+	if (!sender->buffer || !sender->sk) {
+		gf_m2ts_sender_del(sender);
+		return NULL;
+	}
+	if (gf_sk_is_multicast_address(ip)) {
+		e = gf_sk_setup_multicast(sender->sk, ip, port, ttl, GF_FALSE, (char *) ifce_ip);
+	} else {
+		e = gf_sk_bind(sender->sk, ifce_ip, port, ip, port, GF_SOCK_REUSE_PORT);
+	}
+	if (e) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG2-TS Sender] Cannot setup UDP socket for %s:%d: %s\n", ip, port, gf_error_to_string(e)));
+		gf_m2ts_sender_del(sender);
+		return NULL;
+	}
+	return sender;
+}
+
+GF_EXPORT
+void gf_m2ts_sender_del(GF_M2TS_Sender *sender)
+{
+	if (!sender) return;
+	if (sender->sk) gf_sk_del(sender->sk);
+	if (sender->buffer) gf_free(sender->buffer);
+	gf_free(sender);
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_sender_process(GF_M2TS_Sender *sender, u32 max_wait_us, u32 *status)
+{
+	GF_Err e;
+	u32 i, nb_pck, usec_till_next;
+	u64 now;
+	GF_M2TS_Mux *muxer;
+	if (!sender || !status) return GF_BAD_PARAM;
+	muxer = sender->muxer;
+
+	*status = GF_M2TS_STATE_IDLE;
+	while (sender->nb_pck < sender->nb_pck_per_datagram) {
+		usec_till_next = 0;
+		nb_pck = gf_m2ts_mux_process_batch(muxer, sender->buffer + 188*sender->nb_pck, sender->nb_pck_per_datagram - sender->nb_pck, status, &usec_till_next);
+		sender->nb_pck += nb_pck;
+		if (sender->nb_pck == sender->nb_pck_per_datagram) break;
+		if (*status == GF_M2TS_STATE_EOS) break;
+		/*next packet is not due yet*/
+		if (*status == GF_M2TS_STATE_IDLE) {
+			/*not worth spinning, the caller polls again*/
+			if (usec_till_next > max_wait_us) {
+				gf_sleep(max_wait_us / 1000);
+				return GF_OK;
+			}
+			gf_m2ts_sender_wait_until(gf_sys_clock_high_res() + usec_till_next);
+			continue;
+		}
+		/*no more data on a variable rate muxer, send what we have*/
+		break;
+	}
+	if (!sender->nb_pck) return GF_OK;
+
+	now = gf_sys_clock_high_res();
+	e = gf_sk_send(sender->sk, sender->buffer, 188 * sender->nb_pck);
+	if (e) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[MPEG2-TS Sender] Error sending datagram: %s\n", gf_error_to_string(e)));
+		sender->stats.nb_send_errors++;
+	}
+
+	if (!sender->stats.nb_datagrams) {
+		sender->first_send_time = now;
+	} else {
+		sender->bits_sent += 1504 * sender->nb_pck;
+		if (now > sender->first_send_time)
+			sender->stats.bit_rate = (u32) (sender->bits_sent * 1000000 / (now - sender->first_send_time));
+	}
+	sender->stats.nb_datagrams++;
+	sender->stats.nb_packets += sender->nb_pck;
+
+	/*muxer time is the time of the next packet*/
+	if (muxer->fixed_rate && muxer->bit_rate) {
+		u64 due = gf_m2ts_mux_get_sys_time(muxer, &muxer->time) - (u64) 1504 * 1000000 / muxer->bit_rate;
+		u32 delay = (now > due) ? (u32) (now - due) : 0;
+		sender->send_delay_sum += delay;
+		if (delay > sender->stats.send_delay_max) sender->stats.send_delay_max = delay;
+		sender->stats.send_delay_avg = (u32) (sender->send_delay_sum / sender->stats.nb_datagrams);
+	}
+	for (i=0; i<sender->nb_pck; i++) {
+		gf_m2ts_sender_check_pcr(sender, (u8 *) sender->buffer + 188*i, now);
+	}
+	sender->nb_pck = 0;
+	return e;
+}
+
+GF_EXPORT
+void gf_m2ts_sender_get_stats(GF_M2TS_Sender *sender, GF_M2TS_SenderStats *stats)
+{
+	if (!sender || !stats) return;
+	*stats = sender->stats;
+}
+
 #endif /*GPAC_DISABLE_MPEG2TS_MUX*/
 
@@ -54,6 +54,16 @@
 
 #define DEBUG_TS_PACKET 0
 
+#if defined(WIN32) && !defined(__GNUC__)
+# include <intrin.h>
+# define GPAC_HAS_SSE2
+#else
+# ifdef __SSE2__
+#  include <emmintrin.h>
+#  define GPAC_HAS_SSE2
+# endif
+#endif
+
 GF_EXPORT
 const char *gf_m2ts_get_stream_name(u32 streamType)
 {
@@ -1321,18 +1331,43 @@ static u32 gf_m2ts_reframe_id3_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, Bool s
 	return 0;
 }
 
-static u32 gf_m2ts_sync(GF_M2TS_Demuxer *ts, Bool simple_check)
+/*returns the position of the first 0x47 byte in data at or after pos, or size if none*/
+static u32 gf_m2ts_find_sync_byte(const char *data, u32 pos, u32 size)
+{
+#ifdef GPAC_HAS_SSE2
+	const __m128i sync = _mm_set1_epi8(0x47);
+	while (pos + 16 <= size) {
+		u32 mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (data+pos)), sync));
+		if (mask) {
+			while (!(mask & 1)) {
+				mask >>= 1;
+				pos++;
+			}
+			return pos;
+		}
+		pos += 16;
+	}
+#endif
+	while (pos<size) {
+		if (data[pos]==0x47) return pos;
+		pos++;
+	}
+	return size;
+}
+
+static u32 gf_m2ts_sync(char *data, u32 size, Bool simple_check, Bool *prefix_present)
 {
 	u32 i=0;
 	/*if first byte is sync assume we're sync*/
-	if (simple_check && (ts->buffer[i]==0x47)) return 0;
+	if (simple_check && (data[i]==0x47)) return 0;
 
-	while (i<ts->buffer_size) {
-		if (i+188>ts->buffer_size) return ts->buffer_size;
-		if ((ts->buffer[i]==0x47) && (ts->buffer[i+188]==0x47))
+	while (1) {
+		i = gf_m2ts_find_sync_byte(data, i, size);
+		if (i+188>=size) return size;
+		if (data[i+188]==0x47)
 			break;
-		if ((ts->buffer[i]==0x47) && (ts->buffer[i+192]==0x47)) {
-			ts->prefix_present = 1;
+		if ((i+192<size) && (data[i+192]==0x47)) {
+			*prefix_present = 1;
 			break;
 		}
 		i++;
@@ -1343,6 +1378,35 @@ static u32 gf_m2ts_sync(GF_M2TS_Demuxer *ts, Bool simple_check)
 	return i;
 }
 
+GF_EXPORT
+u32 gf_m2ts_get_packet_pids(const char *data, u32 size, u32 pck_size, u16 *pids)
+{
+	u32 nb_pck = 0;
+	const u8 *pck = (const u8 *) data;
+	const u8 *end = pck + size;
+
+	/*validate 4 packets at once*/
+	while (pck + 4*pck_size <= end) {
+		if ((pck[0] ^ 0x47) | (pck[pck_size] ^ 0x47) | (pck[2*pck_size] ^ 0x47) | (pck[3*pck_size] ^ 0x47)) break;
+		pids[nb_pck] = ((pck[1] & 0x1f) << 8) | pck[2];
+		pck += pck_size;
+		pids[nb_pck+1] = ((pck[1] & 0x1f) << 8) | pck[2];
+		pck += pck_size;
+		pids[nb_pck+2] = ((pck[1] & 0x1f) << 8) | pck[2];
+		pck += pck_size;
+		pids[nb_pck+3] = ((pck[1] & 0x1f) << 8) | pck[2];
+		pck += pck_size;
+		nb_pck += 4;
+	}
+	while (pck + pck_size <= end) {
+		if (pck[0] != 0x47) break;
+		pids[nb_pck] = ((pck[1] & 0x1f) << 8) | pck[2];
+		pck += pck_size;
+		nb_pck++;
+	}
+	return nb_pck;
+}
+
 Bool gf_m2ts_crc32_check(char *data, u32 len)
 {
 	u32 crc = gf_crc_32(data, len);
@@ -1405,9 +1469,18 @@ static void gf_m2ts_section_filter_del(GF_M2TS_SectionFilter *sf)
 	gf_free(sf);
 }
 
+static s32 gf_m2ts_pes_worker_current(GF_M2TS_Demuxer *ts);
+static Bool gf_m2ts_pes_worker_other_pid(GF_M2TS_Demuxer *ts, u32 pid);
+
 GF_EXPORT
 void gf_m2ts_es_del(GF_M2TS_ES *es, GF_M2TS_Demuxer *ts)
 {
+	/*other workers may be using the stream list*/
+	if (gf_m2ts_pes_worker_current(ts) >= 0) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS] Cannot delete PID %d from a PES worker thread\n", es->pid));
+		return;
+	}
+	gf_m2ts_demux_sync_workers(ts);
 	gf_list_del_item(es->program->streams, es);
 
 	if (es->flags & GF_M2TS_ES_IS_SECTION) {
@@ -2217,6 +2290,8 @@ static void gf_m2ts_process_pmt(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *pmt, GF
 		pmt->sec->demux_restarted = 0;
 		return;
 	}
+	/*streams may be added or removed, process all pending PES packets first*/
+	gf_m2ts_demux_sync_workers(ts);
 	GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] PMT Found or updated\n"));
 
 	nb_sections = gf_list_count(sections);
@@ -2618,6 +2693,7 @@ static void gf_m2ts_process_pat(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *ses, GF
 		if (ts->on_event) ts->on_event(ts, GF_M2TS_EVT_PAT_REPEAT, NULL);
 		return;
 	}
+	gf_m2ts_demux_sync_workers(ts);
 
 	nb_sections = gf_list_count(sections);
 	if (nb_sections > 1) {
@@ -2697,6 +2773,7 @@ static void gf_m2ts_process_cat(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *ses, GF
 		if (ts->on_event) ts->on_event(ts, GF_M2TS_EVT_CAT_REPEAT, NULL);
 		return;
 	}
+	gf_m2ts_demux_sync_workers(ts);
 	/*
 		nb_sections = gf_list_count(sections);
 		if (nb_sections > 1) {
@@ -2833,10 +2910,9 @@ static void gf_m2ts_store_temi(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes)
 	pes->temi_pending = 1;
 }
 
-void gf_m2ts_flush_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes)
+static void gf_m2ts_flush_pes_at(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, u32 pck_number)
 {
 	GF_M2TS_PESHeader pesh;
-	if (!ts) return;
 	
 	/*we need at least a full, valid start code !!*/
 	if ((pes->pck_data_len >= 4) && !pes->pck_data[0] && !pes->pck_data[1] && (pes->pck_data[2] == 0x1)) {
@@ -2868,7 +2944,7 @@ void gf_m2ts_flush_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes)
 			pck.DTS = pesh.DTS;
 			pck.stream = pes;
 			if (pes->rap) pck.flags |= GF_M2TS_PES_PCK_RAP;
-			pes->pes_end_packet_number = ts->pck_number;
+			pes->pes_end_packet_number = pck_number;
 			if (ts->on_event) ts->on_event(ts, GF_M2TS_EVT_PES_TIMING, &pck);
 		}
 		GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] PID %d Got PES header PTS %d\n", pes->pid, pesh.PTS));
@@ -2971,7 +3047,28 @@ void gf_m2ts_flush_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes)
 	pes->rap = 0;
 }
 
-static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_Header *hdr, unsigned char *data, u32 data_size, GF_M2TS_AdaptationField *paf)
+void gf_m2ts_flush_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes)
+{
+	if (!ts) return;
+	/*a worker may only flush the PIDs it processes*/
+	if (gf_m2ts_pes_worker_other_pid(ts, pes->pid)) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS] Cannot flush PID %d from the PES worker thread of another PID\n", pes->pid));
+		return;
+	}
+	gf_m2ts_demux_sync_workers(ts);
+	gf_m2ts_flush_pes_at(ts, pes, ts->pck_number);
+}
+
+/*state of the input thread when a PES packet was received, the packet may be processed later by a worker thread*/
+typedef struct
+{
+	u32 pck_number;
+	Bool rap;
+	u64 last_pcr_value, before_last_pcr_value;
+	u32 last_pcr_value_pck_number, before_last_pcr_value_pck_number;
+} GF_M2TS_PESPacketInfo;
+
+static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_Header *hdr, unsigned char *data, u32 data_size, GF_M2TS_PESPacketInfo *info)
 {
 	u8 expect_cc;
 	Bool disc=0;
@@ -3017,11 +3114,11 @@ static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_H
 
 	if (hdr->payload_start) {
 		flush_pes = 1;
-		pes->pes_start_packet_number = ts->pck_number;
-		pes->before_last_pcr_value = pes->program->before_last_pcr_value;
-		pes->before_last_pcr_value_pck_number = pes->program->before_last_pcr_value_pck_number;
-		pes->last_pcr_value = pes->program->last_pcr_value;
-		pes->last_pcr_value_pck_number = pes->program->last_pcr_value_pck_number;
+		pes->pes_start_packet_number = info->pck_number;
+		pes->before_last_pcr_value = info->before_last_pcr_value;
+		pes->before_last_pcr_value_pck_number = info->before_last_pcr_value_pck_number;
+		pes->last_pcr_value = info->last_pcr_value;
+		pes->last_pcr_value_pck_number = info->last_pcr_value_pck_number;
 	} else if (pes->pes_len && (pes->pck_data_len + data_size == pes->pes_len + 6)) {
 		/* 6 = startcode+stream_id+length*/
 		/*reassemble pes*/
@@ -3038,7 +3135,7 @@ static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_H
 
 	/*PES first fragment: flush previous packet*/
 	if (flush_pes && pes->pck_data_len) {
-		gf_m2ts_flush_pes(ts, pes);
+		gf_m2ts_flush_pes_at(ts, pes, info->pck_number);
 		if (!data_size) return;
 	}
 	/*we need to wait for first packet of PES*/
@@ -3054,17 +3151,275 @@ static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_H
 	memcpy(pes->pck_data + pes->pck_data_len, data, data_size);
 	pes->pck_data_len += data_size;
 
-	if (paf && paf->random_access_indicator) pes->rap = 1;
+	if (info->rap) pes->rap = 1;
 	if (hdr->payload_start && !pes->pes_len && (pes->pck_data_len>=6)) {
 		pes->pes_len = (pes->pck_data[4]<<8) | pes->pck_data[5];
 		GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] PID %d: Got PES packet len %d\n", pes->pid, pes->pes_len));
 
 		if (pes->pes_len + 6 == pes->pck_data_len) {
-			gf_m2ts_flush_pes(ts, pes);
+			gf_m2ts_flush_pes_at(ts, pes, info->pck_number);
+		}
+	}
+}
+
+#define M2TS_PES_WORKER_QUEUE_SIZE	256
+/*queued packets are signaled to the worker by groups*/
+#define M2TS_PES_WORKER_SIGNAL_SIZE	32
+
+typedef struct
+{
+	/*NULL for a sync marker*/
+	GF_M2TS_PES *pes;
+	GF_M2TS_Header hdr;
+	GF_M2TS_PESPacketInfo info;
+	u32 data_size;
+	/*for sync markers, stops the worker*/
+	Bool stop;
+	unsigned char data[184];
+} GF_M2TS_PESJob;
+
+typedef struct
+{
+	GF_M2TS_Demuxer *ts;
+	GF_Thread *th;
+	u32 thread_id;
+	/*single producer (input thread) single consumer (worker) circular queue*/
+	GF_Semaphore *free_slots, *filled_slots, *synced;
+	GF_M2TS_PESJob *queue;
+	u32 read_pos, write_pos;
+	/*number of queued packets not yet signaled to the worker*/
+	u32 nb_pending;
+} GF_M2TS_PESWorker;
+
+struct __m2ts_pes_workers
+{
+	GF_M2TS_PESWorker *workers;
+	u32 nb_workers;
+	/*CC of the last packet queued on each PID, used by the PCR checks of the input thread*/
+	s8 last_cc[GF_M2TS_MAX_STREAMS];
+	/*PES reset requested from a worker (gf_m2ts_abort_parsing), done by the input thread once the workers are synced*/
+	Bool reset_pes_pending;
+};
+
+/*returns the index of the PES worker running the calling thread, -1 if not called from a PES worker*/
+static s32 gf_m2ts_pes_worker_current(GF_M2TS_Demuxer *ts)
+{
+	u32 i, th_id;
+	if (!ts || !ts->pes_workers) return -1;
+	th_id = gf_th_id();
+	for (i=0; i<ts->pes_workers->nb_workers; i++) {
+		if (ts->pes_workers->workers[i].thread_id == th_id) return i;
+	}
+	return -1;
+}
+
+/*returns GF_TRUE if called from a PES worker which does not process the given PID*/
+static Bool gf_m2ts_pes_worker_other_pid(GF_M2TS_Demuxer *ts, u32 pid)
+{
+	s32 w_idx = gf_m2ts_pes_worker_current(ts);
+	if (w_idx < 0) return GF_FALSE;
+	return ((u32) w_idx != pid % ts->pes_workers->nb_workers) ? GF_TRUE : GF_FALSE;
+}
+
+static u32 gf_m2ts_pes_worker_run(void *par)
+{
+	GF_M2TS_PESWorker *w = (GF_M2TS_PESWorker *)par;
+	w->thread_id = gf_th_id();
+	while (1) {
+		Bool stop = GF_FALSE;
+		GF_M2TS_PESJob *job;
+
+		gf_sema_wait(w->filled_slots);
+		job = &w->queue[w->read_pos];
+		/*packets of a given PID always go to the same worker, so they are processed in order*/
+		if (job->pes) {
+			gf_m2ts_process_pes(w->ts, job->pes, &job->hdr, job->data, job->data_size, &job->info);
+		} else {
+			stop = job->stop;
+		}
+		w->read_pos = (w->read_pos + 1) % M2TS_PES_WORKER_QUEUE_SIZE;
+		gf_sema_notify(w->free_slots, 1);
+		if (!job->pes) gf_sema_notify(w->synced, 1);
+		if (stop) break;
+	}
+	return 0;
+}
+
+static void gf_m2ts_pes_worker_flush(GF_M2TS_PESWorker *w)
+{
+	if (!w->nb_pending) return;
+	gf_sema_notify(w->filled_slots, w->nb_pending);
+	w->nb_pending = 0;
+}
+
+static void gf_m2ts_pes_worker_push_job(GF_M2TS_PESWorker *w)
+{
+	w->write_pos = (w->write_pos + 1) % M2TS_PES_WORKER_QUEUE_SIZE;
+	w->nb_pending++;
+	if (w->nb_pending == M2TS_PES_WORKER_SIGNAL_SIZE)
+		gf_m2ts_pes_worker_flush(w);
+}
+
+static GF_M2TS_PESJob *gf_m2ts_pes_worker_get_job(GF_M2TS_PESWorker *w)
+{
+	gf_sema_wait(w->free_slots);
+	return &w->queue[w->write_pos];
+}
+
+static void gf_m2ts_pes_workers_flush(GF_M2TS_Demuxer *ts)
+{
+	u32 i;
+	if (!ts->pes_workers) return;
+	for (i=0; i<ts->pes_workers->nb_workers; i++) {
+		gf_m2ts_pes_worker_flush(&ts->pes_workers->workers[i]);
+	}
+}
+
+static void gf_m2ts_pes_workers_signal(GF_M2TS_Demuxer *ts, Bool stop)
+{
+	u32 i;
+	for (i=0; i<ts->pes_workers->nb_workers; i++) {
+		GF_M2TS_PESWorker *w = &ts->pes_workers->workers[i];
+		GF_M2TS_PESJob *job = gf_m2ts_pes_worker_get_job(w);
+		job->pes = NULL;
+		job->stop = stop;
+		gf_m2ts_pes_worker_push_job(w);
+		gf_m2ts_pes_worker_flush(w);
+	}
+	for (i=0; i<ts->pes_workers->nb_workers; i++) {
+		gf_sema_wait(ts->pes_workers->workers[i].synced);
+	}
+}
+
+GF_EXPORT
+void gf_m2ts_demux_sync_workers(GF_M2TS_Demuxer *ts)
+{
+	if (!ts || !ts->pes_workers) return;
+	/*called from an event callback in a worker, we cannot wait for ourselves, and only the input thread may queue sync markers*/
+	if (gf_m2ts_pes_worker_current(ts) >= 0) return;
+	gf_m2ts_pes_workers_signal(ts, GF_FALSE);
+}
+
+static void gf_m2ts_reset_pes_data(GF_M2TS_Demuxer *ts)
+{
+	u32 i, j, count, count2;
+	count = gf_list_count(ts->programs);
+	for (i=0; i<count; i++) {
+		GF_M2TS_Program *prog = (GF_M2TS_Program *)gf_list_get(ts->programs, i);
+		count2 = gf_list_count(prog->streams);
+		for (j=0; j<count2; j++) {
+			GF_M2TS_PES *pes = (GF_M2TS_PES *)gf_list_get(prog->streams, j);
+			if (pes)
+				pes->pck_data_len = 0;
 		}
 	}
 }
 
+/*performs the PES reset requested by a worker, called by the input thread*/
+static void gf_m2ts_pes_workers_check_reset(GF_M2TS_Demuxer *ts)
+{
+	if (!ts->pes_workers || !ts->pes_workers->reset_pes_pending) return;
+	gf_m2ts_pes_workers_signal(ts, GF_FALSE);
+	ts->pes_workers->reset_pes_pending = GF_FALSE;
+	gf_m2ts_reset_pes_data(ts);
+}
+
+static void gf_m2ts_pes_workers_del(GF_M2TS_Demuxer *ts)
+{
+	u32 i;
+	if (!ts->pes_workers) return;
+	gf_m2ts_pes_workers_signal(ts, GF_TRUE);
+	for (i=0; i<ts->pes_workers->nb_workers; i++) {
+		GF_M2TS_PESWorker *w = &ts->pes_workers->workers[i];
+		gf_th_del(w->th);
+		gf_sema_del(w->free_slots);
+		gf_sema_del(w->filled_slots);
+		gf_sema_del(w->synced);
+		gf_free(w->queue);
+	}
+	gf_free(ts->pes_workers->workers);
+	gf_free(ts->pes_workers);
+	ts->pes_workers = NULL;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_demux_set_threads(GF_M2TS_Demuxer *ts, u32 nb_threads)
+{
+	u32 i;
+	if (!ts) return GF_BAD_PARAM;
+	gf_m2ts_pes_workers_del(ts);
+	if (nb_threads <= 1) return GF_OK;
+
+	GF_SAFEALLOC(ts->pes_workers, struct __m2ts_pes_workers);
+	if (!ts->pes_workers) return GF_OUT_OF_MEM;
+	ts->pes_workers->workers = (GF_M2TS_PESWorker *)gf_malloc(sizeof(GF_M2TS_PESWorker) * nb_threads);
+	if (!ts->pes_workers->workers) {
+		gf_free(ts->pes_workers);
+		ts->pes_workers = NULL;
+		return GF_OUT_OF_MEM;
+	}
+	memset(ts->pes_workers->workers, 0, sizeof(GF_M2TS_PESWorker) * nb_threads);
+	memset(ts->pes_workers->last_cc, 0xFF, sizeof(ts->pes_workers->last_cc));
+
+	for (i=0; i<nb_threads; i++) {
+		GF_M2TS_PESWorker *w = &ts->pes_workers->workers[i];
+		w->ts = ts;
+		w->queue = (GF_M2TS_PESJob *)gf_malloc(sizeof(GF_M2TS_PESJob) * M2TS_PES_WORKER_QUEUE_SIZE);
+		w->free_slots = gf_sema_new(M2TS_PES_WORKER_QUEUE_SIZE, M2TS_PES_WORKER_QUEUE_SIZE);
+		w->filled_slots = gf_sema_new(M2TS_PES_WORKER_QUEUE_SIZE, 0);
+		w->synced = gf_sema_new(1, 0);
+		w->th = gf_th_new("M2TSPESWorker");
+		if (!w->queue) break;
+		ts->pes_workers->nb_workers++;
+		gf_th_run(w->th, gf_m2ts_pes_worker_run, w);
+	}
+	if (ts->pes_workers->nb_workers < nb_threads) {
+		GF_M2TS_PESWorker *w = &ts->pes_workers->workers[ts->pes_workers->nb_workers];
+		gf_th_del(w->th);
+		gf_sema_del(w->free_slots);
+		gf_sema_del(w->filled_slots);
+		gf_sema_del(w->synced);
+		gf_m2ts_pes_workers_del(ts);
+		return GF_OUT_OF_MEM;
+	}
+	return GF_OK;
+}
+
+/*dispatches a PES packet to the PES workers if enabled, or processes it directly*/
+static void gf_m2ts_dispatch_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_Header *hdr, unsigned char *data, u32 data_size, GF_M2TS_AdaptationField *paf)
+{
+	GF_M2TS_PESPacketInfo info, *pinfo;
+	GF_M2TS_PESJob *job = NULL;
+	GF_M2TS_PESWorker *w = NULL;
+
+	if (ts->pes_workers) {
+		w = &ts->pes_workers->workers[hdr->pid % ts->pes_workers->nb_workers];
+		job = gf_m2ts_pes_worker_get_job(w);
+		pinfo = &job->info;
+		ts->pes_workers->last_cc[hdr->pid] = hdr->continuity_counter;
+	} else {
+		pinfo = &info;
+	}
+	pinfo->pck_number = ts->pck_number;
+	pinfo->rap = (paf && paf->random_access_indicator) ? GF_TRUE : GF_FALSE;
+	if (hdr->payload_start) {
+		pinfo->before_last_pcr_value = pes->program->before_last_pcr_value;
+		pinfo->before_last_pcr_value_pck_number = pes->program->before_last_pcr_value_pck_number;
+		pinfo->last_pcr_value = pes->program->last_pcr_value;
+		pinfo->last_pcr_value_pck_number = pes->program->last_pcr_value_pck_number;
+	}
+
+	if (!job) {
+		gf_m2ts_process_pes(ts, pes, hdr, data, data_size, pinfo);
+		return;
+	}
+	job->pes = pes;
+	job->hdr = *hdr;
+	job->data_size = data_size;
+	memcpy(job->data, data, data_size);
+	gf_m2ts_pes_worker_push_job(w);
+}
+
 
 static void gf_m2ts_get_adaptation_field(GF_M2TS_Demuxer *ts, GF_M2TS_AdaptationField *paf, unsigned char *data, u32 size, u32 pid)
 {
@@ -3190,6 +3545,8 @@ static void gf_m2ts_get_adaptation_field(GF_M2TS_Demuxer *ts, GF_M2TS_Adaptation
 					if (ts->ess[pid] && (ts->ess[pid]->flags & GF_M2TS_ES_IS_PES)) {
 						GF_M2TS_PES *pes = (GF_M2TS_PES *) ts->ess[pid];
 
+						/*the TEMI state is used when flushing the PES*/
+						gf_m2ts_demux_sync_workers(ts);
 						if (pes->temi_tc_desc_len)
 							gf_m2ts_store_temi(ts, pes);
 
@@ -3216,6 +3573,55 @@ static void gf_m2ts_get_adaptation_field(GF_M2TS_Demuxer *ts, GF_M2TS_Adaptation
 	GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] PID %d: Adaptation Field found: Discontinuity %d - RAP %d - PCR: "LLD"\n", pid, paf->discontinuity_indicator, paf->random_access_indicator, paf->PCR_flag ? paf->PCR_base * 300 + paf->PCR_ext : 0));
 }
 
+/*PAT, CAT and PMT PIDs*/
+static Bool gf_m2ts_is_psi_pid(GF_M2TS_Demuxer *ts, u32 pid)
+{
+	GF_M2TS_ES *es;
+	if ((pid == GF_M2TS_PID_PAT) || (pid == GF_M2TS_PID_CAT)) return GF_TRUE;
+	es = ts->ess[pid];
+	if (es && (es->flags & GF_M2TS_ES_IS_SECTION) && es->program && (es->program->pmt_pid == pid)) return GF_TRUE;
+	return GF_FALSE;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_demux_set_pid_filter(GF_M2TS_Demuxer *ts, const u32 *pids, u32 nb_pids, Bool is_whitelist)
+{
+	u32 i;
+	if (nb_pids && !pids) return GF_BAD_PARAM;
+	/*check all PIDs first, an invalid list leaves the current filter untouched*/
+	for (i=0; i<nb_pids; i++) {
+		if (pids[i] >= GF_M2TS_MAX_STREAMS) return GF_BAD_PARAM;
+	}
+	if (!nb_pids && !is_whitelist) {
+		if (ts->pid_filter) gf_free(ts->pid_filter);
+		ts->pid_filter = NULL;
+		return GF_OK;
+	}
+	if (!ts->pid_filter) {
+		ts->pid_filter = (u32*)gf_malloc(sizeof(u32) * GF_M2TS_MAX_STREAMS/32);
+		if (!ts->pid_filter) return GF_OUT_OF_MEM;
+	}
+	memset(ts->pid_filter, is_whitelist ? 0xFF : 0, sizeof(u32) * GF_M2TS_MAX_STREAMS/32);
+	for (i=0; i<nb_pids; i++) {
+		u32 pid = pids[i];
+		if (is_whitelist) ts->pid_filter[pid>>5] &= ~(1<<(pid&0x1F));
+		else ts->pid_filter[pid>>5] |= 1<<(pid&0x1F);
+	}
+	return GF_OK;
+}
+
+GF_EXPORT
+void gf_m2ts_demux_set_pcr_only(GF_M2TS_Demuxer *ts, Bool pcr_only)
+{
+	if (gf_m2ts_pes_worker_current(ts) >= 0) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS] Cannot switch PCR-only mode from a PES worker thread\n"));
+		return;
+	}
+	/*make sure no PES packet is being processed when switching*/
+	gf_m2ts_demux_sync_workers(ts);
+	ts->pcr_only = pcr_only;
+}
+
 static GF_Err gf_m2ts_process_packet(GF_M2TS_Demuxer *ts, unsigned char *data)
 {
 	GF_M2TS_ES *es;
@@ -3232,10 +3638,18 @@ static GF_Err gf_m2ts_process_packet(GF_M2TS_Demuxer *ts, unsigned char *data)
 		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[MPEG-2 TS] TS Packet %d does not start with sync marker\n", ts->pck_number));
 		return GF_CORRUPTED_DATA;
 	}
+	hdr.pid = ( (data[1]&0x1f) << 8) | data[2];
+	if (ts->pid_filter && (ts->pid_filter[hdr.pid>>5] & (1<<(hdr.pid&0x1F))) && !gf_m2ts_is_psi_pid(ts, hdr.pid))
+		return GF_OK;
+	if (ts->pcr_only && (hdr.pid > GF_M2TS_PID_SIT)) {
+		es = ts->ess[hdr.pid];
+		/*drop PES packets without PCR*/
+		if ((!es || (es->flags & GF_M2TS_ES_IS_PES)) && (!(data[3] & 0x20) || !data[4] || !(data[5] & 0x10)))
+			return GF_OK;
+	}
 	hdr.error = (data[1] & 0x80) ? 1 : 0;
 	hdr.payload_start = (data[1] & 0x40) ? 1 : 0;
 	hdr.priority = (data[1] & 0x20) ? 1 : 0;
-	hdr.pid = ( (data[1]&0x1f) << 8) | data[2];
 	hdr.scrambling_ctrl = (data[3] >> 6) & 0x3;
 	hdr.adaptation_field = (data[3] >> 4) & 0x3;
 	hdr.continuity_counter = data[3] & 0xf;
@@ -3347,8 +3761,11 @@ static GF_Err gf_m2ts_process_packet(GF_M2TS_Demuxer *ts, unsigned char *data)
 				cc = es->program->pcr_cc;
 				es->program->pcr_cc = hdr.continuity_counter;
 			}
+			else if ((es->flags & GF_M2TS_ES_IS_PES) && ts->pes_workers) cc = ts->pes_workers->last_cc[hdr.pid];
 			else if (es->flags & GF_M2TS_ES_IS_PES) cc = ((GF_M2TS_PES*)es)->cc;
 			else if (((GF_M2TS_SECTION_ES*)es)->sec) cc = ((GF_M2TS_SECTION_ES*)es)->sec->cc;
+			/*packets without PCR are dropped, CC cannot be checked*/
+			if (ts->pcr_only && !(es->flags & GF_M2TS_ES_IS_SECTION)) cc = -1;
 
 			discontinuity = paf->discontinuity_indicator;
 			if ((cc>=0) && es->program->before_last_pcr_value) {
@@ -3441,72 +3858,114 @@ static GF_Err gf_m2ts_process_packet(GF_M2TS_Demuxer *ts, unsigned char *data)
 	} else {
 		GF_M2TS_PES *pes = (GF_M2TS_PES *)es;
 		/* regular stream using PES packets */
-		if (pes->reframe && payload_size) gf_m2ts_process_pes(ts, pes, &hdr, data, payload_size, paf);
+		if (pes->reframe && payload_size && !ts->pcr_only) gf_m2ts_dispatch_pes(ts, pes, &hdr, data, payload_size, paf);
 	}
 
 	return GF_OK;
 }
 
-GF_EXPORT
-GF_Err gf_m2ts_process_data(GF_M2TS_Demuxer *ts, char *data, u32 data_size)
+/*keeps the last bytes of data (at most one partial packet) for the next input call*/
+static void gf_m2ts_carry_data(GF_M2TS_Demuxer *ts, char *data, u32 size)
 {
-	GF_Err e;
-	u32 pos, pck_size;
-	Bool is_align = 1;
-	if (ts->buffer) {
-		if (ts->alloc_size < ts->buffer_size+data_size) {
-			ts->alloc_size = ts->buffer_size+data_size;
-			ts->buffer = (char*)gf_realloc(ts->buffer, sizeof(char)*ts->alloc_size);
-		}
-		memcpy(ts->buffer + ts->buffer_size, data, sizeof(char)*data_size);
-		ts->buffer_size += data_size;
-		is_align = 0;
-	} else {
-		ts->buffer = data;
-		ts->buffer_size = data_size;
+	if (size > GF_M2TS_MAX_CARRY_SIZE) {
+		data += size - GF_M2TS_MAX_CARRY_SIZE;
+		size = GF_M2TS_MAX_CARRY_SIZE;
 	}
+	if (size) memmove(ts->buffer, data, sizeof(char)*size);
+	ts->buffer_size = size;
+}
 
-	/*sync input data*/
-	pos = gf_m2ts_sync(ts, is_align);
-	if (pos==ts->buffer_size) {
-		if (is_align) {
-			ts->buffer = (char*)gf_malloc(sizeof(char)*data_size);
-			memcpy(ts->buffer, data, sizeof(char)*data_size);
-			ts->alloc_size = ts->buffer_size = data_size;
-		}
-		return GF_OK;
-	}
-	pck_size = ts->prefix_present ? 192 : 188;
-	e=GF_OK;
-	for (;;) {
-		/*wait for a complete packet*/
-		if (ts->buffer_size < pos  + pck_size) {
-			ts->buffer_size -= pos;
-			if (!ts->buffer_size) {
-				if (!is_align) gf_free(ts->buffer);
-				ts->buffer = NULL;
-				return e;
-			}
-			if (is_align) {
-				data = ts->buffer+pos;
-				ts->buffer = (char*)gf_malloc(sizeof(char)*ts->buffer_size);
-				memcpy(ts->buffer, data, sizeof(char)*ts->buffer_size);
-				ts->alloc_size = ts->buffer_size;
-			} else {
-				memmove(ts->buffer, ts->buffer + pos, sizeof(char)*ts->buffer_size);
-			}
-			return e;
-		}
-		/*process*/
-		e |= gf_m2ts_process_packet(ts, (unsigned char *)ts->buffer+pos);
+/*processes all complete packets in data starting at pos, and carries the trailing partial packet*/
+static GF_Err gf_m2ts_process_packets(GF_M2TS_Demuxer *ts, char *data, u32 size, u32 pos)
+{
+	GF_Err e = GF_OK;
+	u32 pck_size = ts->prefix_present ? 192 : 188;
+	while (pos + pck_size <= size) {
+		e |= gf_m2ts_process_packet(ts, (unsigned char *)data+pos);
 		pos += pck_size;
 
 		if (ts->abort_parsing) {
-			if (!is_align) gf_free(ts->buffer);
-			ts->buffer = NULL;
+			ts->buffer_size = 0;
 			return e;
 		}
 	}
+	gf_m2ts_carry_data(ts, data+pos, size-pos);
+	return e;
+}
+
+static GF_Err gf_m2ts_process_buffer(GF_M2TS_Demuxer *ts, char *data, u32 data_size)
+{
+	GF_Err e;
+	u32 pos, carry_size, copy_size;
+
+	if (!data_size) return GF_OK;
+
+	/*nothing carried from previous call, process input in place*/
+	if (!ts->buffer_size) {
+		pos = gf_m2ts_sync(data, data_size, GF_TRUE, &ts->prefix_present);
+		if (pos==data_size) {
+			gf_m2ts_carry_data(ts, data, data_size);
+			return GF_OK;
+		}
+		return gf_m2ts_process_packets(ts, data, data_size, pos);
+	}
+
+	/*carried bytes usually start with the partial packet left by the previous call, in which case no resync is needed*/
+	carry_size = ts->buffer_size;
+	copy_size = sizeof(ts->buffer) - carry_size;
+	/*small input, append it to the carried bytes*/
+	if (data_size <= copy_size) {
+		memcpy(ts->buffer + carry_size, data, sizeof(char)*data_size);
+		ts->buffer_size += data_size;
+		pos = gf_m2ts_sync(ts->buffer, ts->buffer_size, GF_TRUE, &ts->prefix_present);
+		if (pos==ts->buffer_size) {
+			gf_m2ts_carry_data(ts, ts->buffer, ts->buffer_size);
+			return GF_OK;
+		}
+		return gf_m2ts_process_packets(ts, ts->buffer, ts->buffer_size, pos);
+	}
+
+	/*complete the carried bytes with the head of the input: only the packet starting in the carried bytes
+	is processed from the carry buffer, the rest of the input is processed in place*/
+	memcpy(ts->buffer + carry_size, data, sizeof(char)*copy_size);
+	ts->buffer_size = 0;
+	pos = gf_m2ts_sync(ts->buffer, sizeof(ts->buffer), GF_TRUE, &ts->prefix_present);
+	if (pos < carry_size) {
+		e = gf_m2ts_process_packet(ts, (unsigned char *)ts->buffer+pos);
+		if (ts->abort_parsing) return e;
+		pos += ts->prefix_present ? 192 : 188;
+		return e | gf_m2ts_process_packets(ts, data, data_size, pos - carry_size);
+	}
+	/*no packet start in the carried bytes, resync on input*/
+	pos = gf_m2ts_sync(data, data_size, GF_FALSE, &ts->prefix_present);
+	if (pos==data_size) {
+		gf_m2ts_carry_data(ts, data, data_size);
+		return GF_OK;
+	}
+	return gf_m2ts_process_packets(ts, data, data_size, pos);
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_process_data(GF_M2TS_Demuxer *ts, char *data, u32 data_size)
+{
+	GF_Err e = gf_m2ts_process_buffer(ts, data, data_size);
+	/*signal packets queued to the PES workers*/
+	gf_m2ts_pes_workers_flush(ts);
+	gf_m2ts_pes_workers_check_reset(ts);
+	return e;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_process_data_list(GF_M2TS_Demuxer *ts, GF_M2TS_InputBuffer *buffers, u32 nb_buffers)
+{
+	u32 i;
+	GF_Err e = GF_OK;
+	for (i=0; i<nb_buffers; i++) {
+		e |= gf_m2ts_process_buffer(ts, buffers[i].data, buffers[i].size);
+		if (ts->abort_parsing) break;
+	}
+	gf_m2ts_pes_workers_flush(ts);
+	gf_m2ts_pes_workers_check_reset(ts);
 	return e;
 }
 
@@ -3559,6 +4018,12 @@ void gf_m2ts_reset_parsers_for_program(GF_M2TS_Demuxer *ts, GF_M2TS_Program *pro
 {
 	u32 i;
 
+	if (gf_m2ts_pes_worker_current(ts) >= 0) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS] Cannot reset parsers from a PES worker thread\n"));
+		return;
+	}
+	gf_m2ts_demux_sync_workers(ts);
+
 	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
 		GF_M2TS_ES *es = (GF_M2TS_ES *) ts->ess[i];
 		if (!es) continue;
@@ -3571,6 +4036,7 @@ void gf_m2ts_reset_parsers_for_program(GF_M2TS_Demuxer *ts, GF_M2TS_Program *pro
 			GF_M2TS_PES *pes = (GF_M2TS_PES *)es;
 			if (!pes || (pes->pid==pes->program->pmt_pid)) continue;
 			pes->cc = -1;
+			if (ts->pes_workers) ts->pes_workers->last_cc[i] = -1;
 			pes->frame_state = 0;
 			pes->pck_data_len = 0;
 			if (pes->prev_data) gf_free(pes->prev_data);
@@ -3655,6 +4121,17 @@ GF_Err gf_m2ts_set_pes_framing(GF_M2TS_PES *pes, u32 mode)
 
 	if (pes->pid==pes->program->pmt_pid) return GF_BAD_PARAM;
 
+	if (gf_m2ts_pes_worker_current(pes->program->ts) >= 0) {
+		/*from a worker, only the framing of a PID processed by this worker can be changed, and PIDs cannot be reassigned*/
+		if (gf_m2ts_pes_worker_other_pid(pes->program->ts, pes->pid)
+		        || ((mode > GF_M2TS_PES_FRAMING_SKIP) && (pes->program->ts->ess[pes->pid] != (GF_M2TS_ES *) pes))) {
+			GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[MPEG-2 TS] Cannot change framing of PID %d from this PES worker thread\n", pes->pid));
+			return GF_BAD_PARAM;
+		}
+	} else {
+		gf_m2ts_demux_sync_workers(pes->program->ts);
+	}
+
 	//if component reuse, disable previous pes
 	if ((mode > GF_M2TS_PES_FRAMING_SKIP) && (pes->program->ts->ess[pes->pid] != (GF_M2TS_ES *) pes)) {
 		GF_M2TS_PES *o_pes = (GF_M2TS_PES *) pes->program->ts->ess[pes->pid];
@@ -3763,18 +4240,14 @@ GF_M2TS_Demuxer *gf_m2ts_demux_new()
 GF_EXPORT
 void gf_m2ts_abort_parsing(GF_M2TS_Demuxer *ts, Bool force_reset_pes)
 {
-	u32 i, j, count, count2;
-
 	if (force_reset_pes) {
-		count = gf_list_count(ts->programs);
-		for (i=0; i<count; i++) {
-			GF_M2TS_Program *prog = (GF_M2TS_Program *)gf_list_get(ts->programs, i);
-			count2 = gf_list_count(prog->streams);
-			for (j=0; j<count2; j++) {
-				GF_M2TS_PES *pes = (GF_M2TS_PES *)gf_list_get(prog->streams, j);
-				if (pes)
-					pes->pck_data_len = 0;
-			}
+		/*from a worker, the reset is done by the input thread once all workers are synced*/
+		if (gf_m2ts_pes_worker_current(ts) >= 0) {
+			ts->pes_workers->reset_pes_pending = GF_TRUE;
+		} else {
+			/*make sure no PES packet is being reassembled while resetting*/
+			gf_m2ts_demux_sync_workers(ts);
+			gf_m2ts_reset_pes_data(ts);
 		}
 	}
 	ts->abort_parsing = GF_TRUE;
@@ -3809,6 +4282,8 @@ GF_EXPORT
 void gf_m2ts_demux_del(GF_M2TS_Demuxer *ts)
 {
 	u32 i;
+	gf_m2ts_pes_workers_del(ts);
+	if (ts->pid_filter) gf_free(ts->pid_filter);
 	if (ts->pat) gf_m2ts_section_filter_del(ts->pat);
 	if (ts->cat) gf_m2ts_section_filter_del(ts->cat);
 	if (ts->sdt) gf_m2ts_section_filter_del(ts->sdt);
@@ -3820,7 +4295,6 @@ void gf_m2ts_demux_del(GF_M2TS_Demuxer *ts)
 		//bacause of pure PCR streams, en ES might be reassigned on 2 PIDs, one for the ES and one for the PCR
 		if (ts->ess[i] && (ts->ess[i]->pid==i)) gf_m2ts_es_del(ts->ess[i], ts);
 	}
-	if (ts->buffer) gf_free(ts->buffer);
 	while (gf_list_count(ts->programs)) {
 		GF_M2TS_Program *p = (GF_M2TS_Program *)gf_list_last(ts->programs);
 		gf_list_rem_last(ts->programs);
@@ -4125,7 +4599,7 @@ static u32 gf_m2ts_demuxer_run(void *_p)
 				gf_sleep(1);
 			}
 		} else {
-			u32 pos = 0;
+			u64 pos = 0;
 			GF_BitStream *ts_bs = NULL;
 
 			if (ts->file)
@@ -4142,9 +4616,15 @@ static u32 gf_m2ts_demuxer_run(void *_p)
 					continue;
 				}
 
-				if (ts->start_range && ts->duration) {
+				if (ts->start_range && ts->index) {
+					u64 offset;
+					if (gf_m2ts_index_seek(ts->index, 0, ts->start_range, &offset, NULL) == GF_OK) pos = offset;
+					else pos = 0;
+					ts->start_range = 0;
+					gf_bs_seek(ts_bs, pos);
+				} else if (ts->start_range && ts->duration) {
 					Double perc = ts->start_range / (1000 * ts->duration);
-					pos = (u32) (s64) (perc * ts->file_size);
+					pos = (u64) (s64) (perc * ts->file_size);
 					/*align to TS packet size*/
 					pos/=188;
 					pos*=188;
@@ -4634,6 +5114,654 @@ Bool gf_m2ts_probe_file(const char *fileName)
 	return 1;
 }
 
+#define M2TS_FILE_BLOCK_SIZE	(1024*1024)
+
+/*reads a TS or M2TS file by blocks and returns runs of synchronized packets, resyncing on sync loss. Used by the file-based tools
+(PID probing, indexing and remultiplexing) which only need packets and their PIDs*/
+typedef struct
+{
+	FILE *f;
+	char *buf;
+	/*PIDs of the packets of the current run*/
+	u16 *pids;
+	u32 size, pos;
+	/*packets of the current run, starting at buf+pos*/
+	u32 nb_pck;
+	/*188 or 192, 0 until first sync*/
+	u32 pck_size;
+	/*file offset of buf[0]*/
+	u64 buf_offset;
+	u64 nb_skipped_bytes;
+	Bool eof;
+} GF_M2TS_FileReader;
+
+static GF_Err gf_m2ts_file_reader_init(GF_M2TS_FileReader *fr, FILE *f)
+{
+	memset(fr, 0, sizeof(GF_M2TS_FileReader));
+	fr->f = f;
+	fr->buf = (char*)gf_malloc(sizeof(char)*(M2TS_FILE_BLOCK_SIZE+4));
+	fr->pids = (u16*)gf_malloc(sizeof(u16)*(M2TS_FILE_BLOCK_SIZE/188 + 1));
+	if (!fr->buf || !fr->pids) return GF_OUT_OF_MEM;
+	return GF_OK;
+}
+
+static void gf_m2ts_file_reader_reset(GF_M2TS_FileReader *fr)
+{
+	if (fr->buf) gf_free(fr->buf);
+	if (fr->pids) gf_free(fr->pids);
+	fr->buf = NULL;
+	fr->pids = NULL;
+}
+
+/*returns the number of packets of the next run, 0 at end of file*/
+static u32 gf_m2ts_file_reader_next(GF_M2TS_FileReader *fr)
+{
+	u32 read;
+	/*skip the run returned by the previous call*/
+	fr->pos += fr->nb_pck * fr->pck_size;
+	fr->nb_pck = 0;
+
+	while (1) {
+		/*stop on partial packet*/
+		while ((fr->pos < fr->size) && (fr->pos + fr->pck_size <= fr->size)) {
+			/*initial sync or sync lost*/
+			if (!fr->pck_size || (fr->buf[fr->pos]!=0x47)) {
+				Bool prefix_present = GF_FALSE;
+				u32 skip = gf_m2ts_sync(fr->buf+fr->pos, fr->size-fr->pos, GF_FALSE, &prefix_present);
+				if (skip==fr->size-fr->pos) {
+					/*keep what may still be the start of a packet*/
+					if (!fr->eof && (skip > GF_M2TS_MAX_CARRY_SIZE)) skip -= GF_M2TS_MAX_CARRY_SIZE;
+					else if (!fr->eof) skip = 0;
+					fr->nb_skipped_bytes += skip;
+					fr->pos += skip;
+					break;
+				}
+				fr->nb_skipped_bytes += skip;
+				fr->pos += skip;
+				fr->pck_size = prefix_present ? 192 : 188;
+			}
+			fr->nb_pck = gf_m2ts_get_packet_pids(fr->buf+fr->pos, fr->size-fr->pos, fr->pck_size, fr->pids);
+			if (fr->nb_pck) return fr->nb_pck;
+			break;
+		}
+		if (fr->eof) {
+			fr->nb_skipped_bytes += fr->size - fr->pos;
+			fr->pos = fr->size;
+			return 0;
+		}
+		/*move the partial packet at the beginning of the buffer and refill*/
+		fr->size -= fr->pos;
+		if (fr->size) memmove(fr->buf, fr->buf+fr->pos, sizeof(char)*fr->size);
+		fr->buf_offset += fr->pos;
+		fr->pos = 0;
+		read = (u32) fread(fr->buf+fr->size, 1, M2TS_FILE_BLOCK_SIZE-fr->size, fr->f);
+		fr->size += read;
+		if (!read) {
+			fr->eof = GF_TRUE;
+			/*last packet with 4-byte prefix misses the prefix of the next packet*/
+			if ((fr->pck_size==192) && (fr->size>=188) && (fr->size<192) && (fr->buf[0]==0x47)) {
+				memset(fr->buf+fr->size, 0, sizeof(char)*(192-fr->size));
+				fr->size = 192;
+			}
+		}
+	}
+	return 0;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_probe_pids(GF_M2TS_Demuxer *ts, const char *fileName, GF_M2TS_PIDStats *stats)
+{
+	u8 *last_cc;
+	u32 i, nb_pck;
+	FILE *f;
+	GF_Err e;
+	GF_M2TS_FileReader fr;
+
+	memset(stats, 0, sizeof(GF_M2TS_PIDStats));
+	f = gf_fopen(fileName, "rb");
+	if (!f) return GF_URL_ERROR;
+
+	e = gf_m2ts_file_reader_init(&fr, f);
+	last_cc = (u8*)gf_malloc(sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	if (e || !last_cc) {
+		gf_m2ts_file_reader_reset(&fr);
+		if (last_cc) gf_free(last_cc);
+		gf_fclose(f);
+		return GF_OUT_OF_MEM;
+	}
+	/*0xFF: no CC seen yet*/
+	memset(last_cc, 0xFF, sizeof(u8)*GF_M2TS_MAX_STREAMS);
+
+	while ((nb_pck = gf_m2ts_file_reader_next(&fr))) {
+		for (i=0; i<nb_pck; i++) {
+			u8 *pck = (u8 *) fr.buf + fr.pos + i*fr.pck_size;
+			u32 pid = fr.pids[i];
+			stats->pid_packets[pid]++;
+			/*payload present*/
+			if (pck[3] & 0x10) {
+				u8 cc = pck[3] & 0xF;
+				/*discontinuity_indicator set in the adaptation field: the CC may jump*/
+				Bool disc = ((pck[3] & 0x20) && pck[4] && (pck[5] & 0x80)) ? GF_TRUE : GF_FALSE;
+				if (!disc && (last_cc[pid] != 0xFF) && (cc != last_cc[pid]) && (cc != ((last_cc[pid]+1) & 0xF)))
+					stats->pid_cc_errors[pid]++;
+				last_cc[pid] = cc;
+			}
+			/*only PSI/SI and PMT packets are demultiplexed*/
+			if (ts && ((pid <= GF_M2TS_PID_SIT) || (ts->ess[pid] && (ts->ess[pid]->flags & GF_M2TS_ES_IS_SECTION)))) {
+				gf_m2ts_process_packet(ts, pck);
+			}
+		}
+		stats->nb_packets += nb_pck;
+	}
+	stats->packet_size = fr.pck_size;
+	stats->nb_skipped_bytes = fr.nb_skipped_bytes;
+
+	gf_m2ts_file_reader_reset(&fr);
+	gf_free(last_cc);
+	gf_fclose(f);
+	return stats->nb_packets ? GF_OK : GF_NON_COMPLIANT_BITSTREAM;
+}
+
+#define M2TS_INDEX_PES_HISTORY	8
+
+typedef struct
+{
+	GF_M2TS_IndexStream *stream;
+	/*offsets of the previous and current PES starts*/
+	u64 prev_pes_offset, pes_offset;
+	/*set when a PES start is received while the previous PES is still pending*/
+	Bool prev_pes_pending;
+	u64 last_pts, pts_shift, last_rap_pts;
+	/*PTS and offsets of the last flushed PES, reframers may output an AU after the next PES is flushed*/
+	u64 pes_pts[M2TS_INDEX_PES_HISTORY], pes_offsets[M2TS_INDEX_PES_HISTORY];
+	u32 nb_pes;
+} GF_M2TS_IndexPID;
+
+typedef struct
+{
+	GF_M2TS_Index *index;
+	GF_M2TS_IndexPID **pids;
+	/*offset of the packet being processed, and PID if the packet starts a PES*/
+	u64 pck_offset;
+	u32 pusi_pid;
+	u64 rap_interval;
+	u64 last_pcr, pcr_shift;
+	GF_Err e;
+} GF_M2TS_IndexBuilder;
+
+static GF_M2TS_IndexProgram *gf_m2ts_index_get_program(GF_M2TS_Index *index, u32 number)
+{
+	u32 i, count = gf_list_count(index->programs);
+	for (i=0; i<count; i++) {
+		GF_M2TS_IndexProgram *prog = (GF_M2TS_IndexProgram *)gf_list_get(index->programs, i);
+		if (!number || (prog->number == number)) return prog;
+	}
+	return NULL;
+}
+
+/*unwraps a timestamp looping at max_val*/
+static u64 gf_m2ts_index_unwrap(u64 val, u64 *last_val, u64 *shift, u64 max_val)
+{
+	if (*last_val && (val < *last_val) && (*last_val - val > max_val/2)) *shift += max_val;
+	*last_val = val;
+	return val + *shift;
+}
+
+static GF_M2TS_IndexPID *gf_m2ts_index_get_pid(GF_M2TS_IndexBuilder *builder, u32 pid)
+{
+	if (!builder->pids[pid]) {
+		GF_SAFEALLOC(builder->pids[pid], GF_M2TS_IndexPID);
+		if (!builder->pids[pid]) builder->e = GF_OUT_OF_MEM;
+	}
+	return builder->pids[pid];
+}
+
+static void gf_m2ts_index_on_event(GF_M2TS_Demuxer *ts, u32 evt_type, void *par)
+{
+	u32 i, count;
+	GF_M2TS_Program *prog;
+	GF_M2TS_PES_PCK *pck;
+	GF_M2TS_IndexProgram *iprog;
+	GF_M2TS_IndexPID *ipid;
+	GF_M2TS_IndexBuilder *builder = (GF_M2TS_IndexBuilder *)ts->user;
+	GF_M2TS_Index *index = builder->index;
+
+	switch (evt_type) {
+	case GF_M2TS_EVT_PMT_FOUND:
+	case GF_M2TS_EVT_PMT_UPDATE:
+		prog = (GF_M2TS_Program *)par;
+		iprog = gf_m2ts_index_get_program(index, prog->number);
+		if (!iprog) {
+			GF_SAFEALLOC(iprog, GF_M2TS_IndexProgram);
+			if (!iprog) {
+				builder->e = GF_OUT_OF_MEM;
+				return;
+			}
+			iprog->number = prog->number;
+			gf_list_add(index->programs, iprog);
+		}
+		iprog->pcr_pid = prog->pcr_pid;
+		count = gf_list_count(prog->streams);
+		for (i=0; i<count; i++) {
+			GF_M2TS_ES *es = (GF_M2TS_ES *)gf_list_get(prog->streams, i);
+			if (!(es->flags & GF_M2TS_ES_IS_PES)) continue;
+			/*default framing is needed to detect RAPs*/
+			gf_m2ts_set_pes_framing((GF_M2TS_PES *)es, GF_M2TS_PES_FRAMING_DEFAULT);
+			ipid = gf_m2ts_index_get_pid(builder, es->pid);
+			if (!ipid) return;
+			if (!ipid->stream) {
+				GF_SAFEALLOC(ipid->stream, GF_M2TS_IndexStream);
+				if (!ipid->stream) {
+					builder->e = GF_OUT_OF_MEM;
+					return;
+				}
+				ipid->stream->pid = es->pid;
+				gf_list_add(index->streams, ipid->stream);
+			}
+			ipid->stream->stream_type = es->stream_type;
+			ipid->stream->program_number = prog->number;
+		}
+		break;
+	case GF_M2TS_EVT_PES_TIMING:
+		pck = (GF_M2TS_PES_PCK *)par;
+		ipid = builder->pids[pck->stream->pid];
+		if (!ipid || !ipid->stream) return;
+		i = ipid->nb_pes % M2TS_INDEX_PES_HISTORY;
+		ipid->pes_pts[i] = pck->PTS;
+		/*PES flushed by the start of the next PES*/
+		if ((builder->pusi_pid == pck->stream->pid) && ipid->prev_pes_pending) {
+			ipid->pes_offsets[i] = ipid->prev_pes_offset;
+			ipid->prev_pes_pending = GF_FALSE;
+		} else {
+			ipid->pes_offsets[i] = ipid->pes_offset;
+		}
+		ipid->nb_pes++;
+		break;
+	case GF_M2TS_EVT_PES_PCK:
+		pck = (GF_M2TS_PES_PCK *)par;
+		if (!(pck->flags & GF_M2TS_PES_PCK_RAP)) return;
+		ipid = builder->pids[pck->stream->pid];
+		if (!ipid || !ipid->stream || !ipid->nb_pes) return;
+		{
+			u64 dts, pts;
+			GF_M2TS_IndexStream *st = ipid->stream;
+			/*locate the PES starting with this AU, default to the last flushed PES*/
+			u32 pes_idx = (ipid->nb_pes-1) % M2TS_INDEX_PES_HISTORY;
+			count = MIN(ipid->nb_pes, M2TS_INDEX_PES_HISTORY);
+			for (i=0; i<count; i++) {
+				if (ipid->pes_pts[i] == pck->PTS) {
+					pes_idx = i;
+					break;
+				}
+			}
+			pts = gf_m2ts_index_unwrap(pck->PTS, &ipid->last_pts, &ipid->pts_shift, GF_M2TS_MAX_PCR/300);
+			if (st->nb_raps && builder->rap_interval && (pts < ipid->last_rap_pts + builder->rap_interval)) return;
+			dts = pck->DTS + ipid->pts_shift;
+			/*PTS and DTS wrap at different times*/
+			if (dts > pts + GF_M2TS_MAX_PCR/600) dts -= GF_M2TS_MAX_PCR/300;
+			else if (pts > dts + GF_M2TS_MAX_PCR/600) dts += GF_M2TS_MAX_PCR/300;
+
+			if (st->nb_raps == st->alloc_raps) {
+				st->alloc_raps = st->alloc_raps ? 2*st->alloc_raps : 64;
+				st->raps = (GF_M2TS_IndexRAP *)gf_realloc(st->raps, sizeof(GF_M2TS_IndexRAP)*st->alloc_raps);
+				if (!st->raps) {
+					st->nb_raps = st->alloc_raps = 0;
+					builder->e = GF_OUT_OF_MEM;
+					return;
+				}
+			}
+			st->raps[st->nb_raps].offset = ipid->pes_offsets[pes_idx];
+			st->raps[st->nb_raps].pts = pts;
+			st->raps[st->nb_raps].dts = dts;
+			st->nb_raps++;
+			ipid->last_rap_pts = pts;
+		}
+		break;
+	case GF_M2TS_EVT_PES_PCR:
+		pck = (GF_M2TS_PES_PCK *)par;
+		iprog = gf_m2ts_index_get_program(index, pck->stream->program->number);
+		if (!iprog || (pck->stream->program->pcr_pid != iprog->pcr_pid)) return;
+		if (iprog->nb_pcrs == iprog->alloc_pcrs) {
+			iprog->alloc_pcrs = iprog->alloc_pcrs ? 2*iprog->alloc_pcrs : 64;
+			iprog->pcrs = (GF_M2TS_IndexPCR *)gf_realloc(iprog->pcrs, sizeof(GF_M2TS_IndexPCR)*iprog->alloc_pcrs);
+			if (!iprog->pcrs) {
+				iprog->nb_pcrs = iprog->alloc_pcrs = 0;
+				builder->e = GF_OUT_OF_MEM;
+				return;
+			}
+		}
+		iprog->pcrs[iprog->nb_pcrs].offset = builder->pck_offset;
+		if (iprog->nb_pcrs) {
+			GF_M2TS_IndexPCR *prev = &iprog->pcrs[iprog->nb_pcrs-1];
+			u64 pcr = pck->PTS + (prev->pcr / GF_M2TS_MAX_PCR) * GF_M2TS_MAX_PCR;
+			/*PCR loop*/
+			if ((pcr < prev->pcr) && (prev->pcr - pcr > GF_M2TS_MAX_PCR/2)) pcr += GF_M2TS_MAX_PCR;
+			iprog->pcrs[iprog->nb_pcrs].pcr = pcr;
+		} else {
+			iprog->pcrs[iprog->nb_pcrs].pcr = pck->PTS;
+		}
+		iprog->nb_pcrs++;
+		break;
+	}
+}
+
+GF_EXPORT
+void gf_m2ts_index_del(GF_M2TS_Index *index)
+{
+	if (!index) return;
+	while (gf_list_count(index->programs)) {
+		GF_M2TS_IndexProgram *prog = (GF_M2TS_IndexProgram *)gf_list_last(index->programs);
+		gf_list_rem_last(index->programs);
+		if (prog->pcrs) gf_free(prog->pcrs);
+		gf_free(prog);
+	}
+	gf_list_del(index->programs);
+	while (gf_list_count(index->streams)) {
+		GF_M2TS_IndexStream *st = (GF_M2TS_IndexStream *)gf_list_last(index->streams);
+		gf_list_rem_last(index->streams);
+		if (st->raps) gf_free(st->raps);
+		gf_free(st);
+	}
+	gf_list_del(index->streams);
+	gf_free(index);
+}
+
+static GF_M2TS_Index *gf_m2ts_index_new()
+{
+	GF_M2TS_Index *index;
+	GF_SAFEALLOC(index, GF_M2TS_Index);
+	if (!index) return NULL;
+	index->programs = gf_list_new();
+	index->streams = gf_list_new();
+	return index;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_index_build(const char *fileName, u32 rap_interval_ms, GF_M2TS_Index **out_index)
+{
+	u32 i, nb_pck;
+	FILE *f;
+	GF_M2TS_Demuxer *ts;
+	GF_M2TS_IndexBuilder builder;
+	GF_M2TS_FileReader fr;
+
+	*out_index = NULL;
+	f = gf_fopen(fileName, "rb");
+	if (!f) return GF_URL_ERROR;
+
+	memset(&builder, 0, sizeof(GF_M2TS_IndexBuilder));
+	builder.rap_interval = rap_interval_ms * 90;
+	builder.pusi_pid = GF_M2TS_MAX_STREAMS;
+	builder.index = gf_m2ts_index_new();
+	builder.pids = (GF_M2TS_IndexPID **)gf_malloc(sizeof(GF_M2TS_IndexPID *)*GF_M2TS_MAX_STREAMS);
+	builder.e = gf_m2ts_file_reader_init(&fr, f);
+	ts = gf_m2ts_demux_new();
+	if (!builder.index || !builder.pids || builder.e || !ts) {
+		builder.e = GF_OUT_OF_MEM;
+		goto exit;
+	}
+	memset(builder.pids, 0, sizeof(GF_M2TS_IndexPID *)*GF_M2TS_MAX_STREAMS);
+	ts->on_event = gf_m2ts_index_on_event;
+	ts->notify_pes_timing = GF_TRUE;
+	ts->user = &builder;
+
+	while (!builder.e && (nb_pck = gf_m2ts_file_reader_next(&fr))) {
+		for (i=0; i<nb_pck; i++) {
+			u8 *pck = (u8 *) fr.buf + fr.pos + i*fr.pck_size;
+			u32 pid = fr.pids[i];
+			GF_M2TS_IndexPID *ipid = NULL;
+			builder.pck_offset = fr.buf_offset + fr.pos + i*fr.pck_size;
+			/*offsets of M2TS packets include their prefix*/
+			if (fr.pck_size==192) builder.pck_offset -= 4;
+			builder.pusi_pid = GF_M2TS_MAX_STREAMS;
+			/*PES data may be gathered before the PMT is reported, track PES starts as soon as the ES exists*/
+			if ((pck[1] & 0x40) && ts->ess[pid] && (ts->ess[pid]->flags & GF_M2TS_ES_IS_PES))
+				ipid = gf_m2ts_index_get_pid(&builder, pid);
+			if (ipid) {
+				ipid->prev_pes_offset = ipid->pes_offset;
+				ipid->pes_offset = builder.pck_offset;
+				ipid->prev_pes_pending = ((GF_M2TS_PES *)ts->ess[pid])->pck_data_len ? GF_TRUE : GF_FALSE;
+				builder.pusi_pid = pid;
+			}
+			gf_m2ts_process_packet(ts, pck);
+		}
+	}
+	/*flush pending PES*/
+	builder.pusi_pid = GF_M2TS_MAX_STREAMS;
+	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+		if (builder.pids[i] && builder.pids[i]->stream && ts->ess[i] && (ts->ess[i]->flags & GF_M2TS_ES_IS_PES))
+			gf_m2ts_flush_pes(ts, (GF_M2TS_PES *) ts->ess[i]);
+	}
+	builder.index->packet_size = fr.pck_size;
+	builder.index->file_size = gf_ftell(f);
+
+exit:
+	if (ts) gf_m2ts_demux_del(ts);
+	gf_m2ts_file_reader_reset(&fr);
+	if (builder.pids) {
+		for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+			if (builder.pids[i]) gf_free(builder.pids[i]);
+		}
+		gf_free(builder.pids);
+	}
+	gf_fclose(f);
+	if (!builder.e && !fr.pck_size) builder.e = GF_NON_COMPLIANT_BITSTREAM;
+	if (builder.e) {
+		gf_m2ts_index_del(builder.index);
+		return builder.e;
+	}
+	*out_index = builder.index;
+	return GF_OK;
+}
+
+#define M2TS_INDEX_VERSION	1
+
+GF_EXPORT
+GF_Err gf_m2ts_index_save(GF_M2TS_Index *index, const char *fileName)
+{
+	u32 i, j;
+	GF_Err e;
+	GF_BitStream *bs;
+	FILE *f = gf_fopen(fileName, "wb");
+	if (!f) return GF_IO_ERR;
+	bs = gf_bs_from_file(f, GF_BITSTREAM_WRITE);
+	if (!bs) {
+		gf_fclose(f);
+		return GF_OUT_OF_MEM;
+	}
+	gf_bs_write_u32(bs, GF_4CC('T','S','I','X'));
+	gf_bs_write_u32(bs, M2TS_INDEX_VERSION);
+	gf_bs_write_u32(bs, index->packet_size);
+	gf_bs_write_u64(bs, index->file_size);
+
+	gf_bs_write_u32(bs, gf_list_count(index->programs));
+	for (i=0; i<gf_list_count(index->programs); i++) {
+		GF_M2TS_IndexProgram *prog = (GF_M2TS_IndexProgram *)gf_list_get(index->programs, i);
+		gf_bs_write_u32(bs, prog->number);
+		gf_bs_write_u32(bs, prog->pcr_pid);
+		gf_bs_write_u32(bs, prog->nb_pcrs);
+		for (j=0; j<prog->nb_pcrs; j++) {
+			gf_bs_write_u64(bs, prog->pcrs[j].offset);
+			gf_bs_write_u64(bs, prog->pcrs[j].pcr);
+		}
+	}
+	gf_bs_write_u32(bs, gf_list_count(index->streams));
+	for (i=0; i<gf_list_count(index->streams); i++) {
+		GF_M2TS_IndexStream *st = (GF_M2TS_IndexStream *)gf_list_get(index->streams, i);
+		gf_bs_write_u32(bs, st->pid);
+		gf_bs_write_u32(bs, st->stream_type);
+		gf_bs_write_u32(bs, st->program_number);
+		gf_bs_write_u32(bs, st->nb_raps);
+		for (j=0; j<st->nb_raps; j++) {
+			gf_bs_write_u64(bs, st->raps[j].offset);
+			gf_bs_write_u64(bs, st->raps[j].pts);
+			gf_bs_write_u64(bs, st->raps[j].dts);
+		}
+	}
+	e = gf_bs_get_position(bs) ? GF_OK : GF_IO_ERR;
+	gf_bs_del(bs);
+	gf_fclose(f);
+	return e;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_index_load(const char *fileName, GF_M2TS_Index **out_index)
+{
+	u32 i, j, count;
+	GF_Err e = GF_OK;
+	GF_BitStream *bs;
+	GF_M2TS_Index *index;
+	FILE *f;
+
+	*out_index = NULL;
+	f = gf_fopen(fileName, "rb");
+	if (!f) return GF_URL_ERROR;
+	bs = gf_bs_from_file(f, GF_BITSTREAM_READ);
+	index = gf_m2ts_index_new();
+	if (!bs || !index) {
+		e = GF_OUT_OF_MEM;
+		goto exit;
+	}
+	if ((gf_bs_read_u32(bs) != GF_4CC('T','S','I','X')) || (gf_bs_read_u32(bs) != M2TS_INDEX_VERSION)) {
+		e = GF_NON_COMPLIANT_BITSTREAM;
+		goto exit;
+	}
+	index->packet_size = gf_bs_read_u32(bs);
+	index->file_size = gf_bs_read_u64(bs);
+
+	count = gf_bs_read_u32(bs);
+	for (i=0; i<count; i++) {
+		GF_M2TS_IndexProgram *prog;
+		GF_SAFEALLOC(prog, GF_M2TS_IndexProgram);
+		if (!prog) {
+			e = GF_OUT_OF_MEM;
+			goto exit;
+		}
+		gf_list_add(index->programs, prog);
+		prog->number = gf_bs_read_u32(bs);
+		prog->pcr_pid = gf_bs_read_u32(bs);
+		prog->nb_pcrs = gf_bs_read_u32(bs);
+		if ((u64) prog->nb_pcrs*16 > gf_bs_available(bs)) {
+			prog->nb_pcrs = 0;
+			e = GF_NON_COMPLIANT_BITSTREAM;
+			goto exit;
+		}
+		prog->alloc_pcrs = prog->nb_pcrs;
+		if (prog->nb_pcrs) prog->pcrs = (GF_M2TS_IndexPCR *)gf_malloc(sizeof(GF_M2TS_IndexPCR)*prog->nb_pcrs);
+		for (j=0; j<prog->nb_pcrs; j++) {
+			prog->pcrs[j].offset = gf_bs_read_u64(bs);
+			prog->pcrs[j].pcr = gf_bs_read_u64(bs);
+		}
+	}
+	count = gf_bs_read_u32(bs);
+	for (i=0; i<count; i++) {
+		GF_M2TS_IndexStream *st;
+		GF_SAFEALLOC(st, GF_M2TS_IndexStream);
+		if (!st) {
+			e = GF_OUT_OF_MEM;
+			goto exit;
+		}
+		gf_list_add(index->streams, st);
+		st->pid = gf_bs_read_u32(bs);
+		st->stream_type = gf_bs_read_u32(bs);
+		st->program_number = gf_bs_read_u32(bs);
+		st->nb_raps = gf_bs_read_u32(bs);
+		if ((u64) st->nb_raps*24 > gf_bs_available(bs)) {
+			st->nb_raps = 0;
+			e = GF_NON_COMPLIANT_BITSTREAM;
+			goto exit;
+		}
+		st->alloc_raps = st->nb_raps;
+		if (st->nb_raps) st->raps = (GF_M2TS_IndexRAP *)gf_malloc(sizeof(GF_M2TS_IndexRAP)*st->nb_raps);
+		for (j=0; j<st->nb_raps; j++) {
+			st->raps[j].offset = gf_bs_read_u64(bs);
+			st->raps[j].pts = gf_bs_read_u64(bs);
+			st->raps[j].dts = gf_bs_read_u64(bs);
+		}
+	}
+
+exit:
+	if (bs) gf_bs_del(bs);
+	gf_fclose(f);
+	if (e) {
+		if (index) gf_m2ts_index_del(index);
+		return e;
+	}
+	*out_index = index;
+	return GF_OK;
+}
+
+GF_EXPORT
+Bool gf_m2ts_index_matches(GF_M2TS_Index *index, u64 file_size)
+{
+	u32 i, j;
+	if (!index || (index->file_size != file_size)) return GF_FALSE;
+	if ((index->packet_size != 188) && (index->packet_size != 192)) return GF_FALSE;
+	for (i=0; i<gf_list_count(index->programs); i++) {
+		GF_M2TS_IndexProgram *prog = (GF_M2TS_IndexProgram *)gf_list_get(index->programs, i);
+		for (j=0; j<prog->nb_pcrs; j++) {
+			if (prog->pcrs[j].offset >= file_size) return GF_FALSE;
+		}
+	}
+	for (i=0; i<gf_list_count(index->streams); i++) {
+		GF_M2TS_IndexStream *st = (GF_M2TS_IndexStream *)gf_list_get(index->streams, i);
+		for (j=0; j<st->nb_raps; j++) {
+			if (st->raps[j].offset >= file_size) return GF_FALSE;
+		}
+	}
+	return GF_TRUE;
+}
+
+GF_EXPORT
+Double gf_m2ts_index_get_duration(GF_M2TS_Index *index, u32 program_number)
+{
+	GF_M2TS_IndexProgram *prog = gf_m2ts_index_get_program(index, program_number);
+	if (!prog || (prog->nb_pcrs<2)) return 0;
+	return (Double) (s64) (prog->pcrs[prog->nb_pcrs-1].pcr - prog->pcrs[0].pcr) / 27000000;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_index_seek(GF_M2TS_Index *index, u32 program_number, u32 time_ms, u64 *offset, u64 *rap_pts)
+{
+	u32 i, count, low, high;
+	u64 pts;
+	GF_M2TS_IndexStream *ref = NULL;
+	GF_M2TS_IndexProgram *prog = gf_m2ts_index_get_program(index, program_number);
+	if (!prog) return GF_BAD_PARAM;
+
+	count = gf_list_count(index->streams);
+	for (i=0; i<count; i++) {
+		GF_M2TS_IndexStream *st = (GF_M2TS_IndexStream *)gf_list_get(index->streams, i);
+		if ((st->program_number != prog->number) || !st->nb_raps) continue;
+		if (st->pid == prog->pcr_pid) {
+			ref = st;
+			break;
+		}
+		if (!ref) ref = st;
+	}
+	if (!ref) return GF_NOT_FOUND;
+
+	/*last RAP with PTS at or before the target time*/
+	pts = ref->raps[0].pts + (u64) time_ms * 90;
+	low = 0;
+	high = ref->nb_raps;
+	while (high - low > 1) {
+		u32 mid = (low + high) / 2;
+		if (ref->raps[mid].pts <= pts) low = mid;
+		else high = mid;
+	}
+	if (offset) *offset = ref->raps[low].offset;
+	if (rap_pts) *rap_pts = ref->raps[low].pts;
+	return GF_OK;
+}
+
+GF_EXPORT
+void gf_m2ts_demux_set_index(GF_M2TS_Demuxer *ts, GF_M2TS_Index *index)
+{
+	ts->index = index;
+	if (index) ts->duration = gf_m2ts_index_get_duration(index, 0);
+}
+
 static void rewrite_pts_dts(unsigned char *ptr, u64 TS)
 {
 	ptr[0] &= 0xf1;
@@ -4742,4 +5870,438 @@ GF_Err gf_m2ts_restamp(char *buffer, u32 size, s64 ts_shift, u8 *is_pes)
 	return GF_OK;
 }
 
+
+/*max size of a PAT or PMT section, section_length being at most 1021*/
+#define M2TS_REMUX_MAX_SECTION	1024
+#define M2TS_REMUX_BLOCK_SIZE	(1024*1024)
+
+enum
+{
+	M2TS_REMUX_PID_DROP = 0,
+	M2TS_REMUX_PID_COPY,
+	M2TS_REMUX_PID_PAT,
+	M2TS_REMUX_PID_PMT,
+};
+
+typedef struct
+{
+	u8 data[M2TS_REMUX_MAX_SECTION];
+	u32 len;
+	/*a section is being received*/
+	Bool active;
+} GF_M2TS_RemuxSection;
+
+struct __tag_m2ts_remux
+{
+	/*output PID of each input PID*/
+	u16 *pid_map;
+	/*M2TS_REMUX_PID_* of each input PID*/
+	u8 *pid_type;
+	/*PES PIDs to restamp, indexed by output PID*/
+	u8 *is_pes;
+	/*continuity counters of the regenerated tables, indexed by output PID*/
+	u8 *table_cc;
+	/*sections being received on PAT and PMT PIDs*/
+	GF_M2TS_RemuxSection **sections;
+
+	u32 *programs;
+	u32 nb_programs;
+	s64 ts_shift;
+
+	char *out;
+	u32 out_size;
+	/*destination of the output buffer*/
+	FILE *dst;
+	u64 nb_packets_in, nb_packets_out;
+};
+
+GF_EXPORT
+GF_M2TS_Remux *gf_m2ts_remux_new()
+{
+	u32 i;
+	GF_M2TS_Remux *remux;
+	GF_SAFEALLOC(remux, GF_M2TS_Remux);
+	if (!remux) return NULL;
+	remux->pid_map = (u16 *)gf_malloc(sizeof(u16)*GF_M2TS_MAX_STREAMS);
+	remux->pid_type = (u8 *)gf_malloc(sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	remux->is_pes = (u8 *)gf_malloc(sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	remux->table_cc = (u8 *)gf_malloc(sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	remux->sections = (GF_M2TS_RemuxSection **)gf_malloc(sizeof(GF_M2TS_RemuxSection *)*GF_M2TS_MAX_STREAMS);
+	if (!remux->pid_map || !remux->pid_type || !remux->is_pes || !remux->table_cc || !remux->sections) {
+		gf_m2ts_remux_del(remux);
+		return NULL;
+	}
+	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) remux->pid_map[i] = i;
+	memset(remux->sections, 0, sizeof(GF_M2TS_RemuxSection *)*GF_M2TS_MAX_STREAMS);
+	return remux;
+}
+
+GF_EXPORT
+void gf_m2ts_remux_del(GF_M2TS_Remux *remux)
+{
+	u32 i;
+	if (!remux) return;
+	if (remux->sections) {
+		for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+			if (remux->sections[i]) gf_free(remux->sections[i]);
+		}
+		gf_free(remux->sections);
+	}
+	if (remux->pid_map) gf_free(remux->pid_map);
+	if (remux->pid_type) gf_free(remux->pid_type);
+	if (remux->is_pes) gf_free(remux->is_pes);
+	if (remux->table_cc) gf_free(remux->table_cc);
+	if (remux->programs) gf_free(remux->programs);
+	if (remux->out) gf_free(remux->out);
+	gf_free(remux);
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_remux_map_pid(GF_M2TS_Remux *remux, u32 in_pid, u32 out_pid)
+{
+	u32 i;
+	if (!remux || !in_pid || (in_pid >= 0x1FFF) || !out_pid || (out_pid >= 0x1FFF)) return GF_BAD_PARAM;
+	/*SI PIDs are always passed through as is*/
+	if ((out_pid != in_pid) && (out_pid <= GF_M2TS_PID_SIT)) return GF_BAD_PARAM;
+	/*two input PIDs cannot share an output PID. Collisions with unmapped input PIDs are checked when remuxing, once the PIDs
+	of the file are known*/
+	for (i=1; i<0x1FFF; i++) {
+		if ((i != in_pid) && (remux->pid_map[i] != i) && (remux->pid_map[i] == out_pid)) return GF_BAD_PARAM;
+	}
+	remux->pid_map[in_pid] = out_pid;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_remux_keep_program(GF_M2TS_Remux *remux, u32 program_number)
+{
+	if (!remux || !program_number) return GF_BAD_PARAM;
+	remux->programs = (u32 *)gf_realloc(remux->programs, sizeof(u32)*(remux->nb_programs+1));
+	if (!remux->programs) {
+		remux->nb_programs = 0;
+		return GF_OUT_OF_MEM;
+	}
+	remux->programs[remux->nb_programs] = program_number;
+	remux->nb_programs++;
+	return GF_OK;
+}
+
+GF_EXPORT
+void gf_m2ts_remux_set_ts_shift(GF_M2TS_Remux *remux, s64 ts_shift)
+{
+	if (remux) remux->ts_shift = ts_shift;
+}
+
+GF_EXPORT
+void gf_m2ts_remux_get_stats(GF_M2TS_Remux *remux, u64 *nb_packets_in, u64 *nb_packets_out)
+{
+	if (!remux) return;
+	if (nb_packets_in) *nb_packets_in = remux->nb_packets_in;
+	if (nb_packets_out) *nb_packets_out = remux->nb_packets_out;
+}
+
+static Bool gf_m2ts_remux_is_kept(GF_M2TS_Remux *remux, u32 program_number)
+{
+	u32 i;
+	if (!remux->nb_programs) return GF_TRUE;
+	for (i=0; i<remux->nb_programs; i++) {
+		if (remux->programs[i] == program_number) return GF_TRUE;
+	}
+	return GF_FALSE;
+}
+
+static Bool gf_m2ts_remux_is_section_type(u32 stream_type)
+{
+	switch (stream_type) {
+	case GF_M2TS_PRIVATE_SECTION:
+	case 0x0B:
+	case 0x0C:
+	case 0x0D:
+	case GF_M2TS_SYSTEMS_MPEG4_SECTIONS:
+	case GF_M2TS_MPE_SECTIONS:
+	case 0x86:
+		return GF_TRUE;
+	}
+	return GF_FALSE;
+}
+
+static void gf_m2ts_remux_flush(GF_M2TS_Remux *remux)
+{
+	if (!remux->out_size) return;
+	if (remux->ts_shift) gf_m2ts_restamp(remux->out, remux->out_size, remux->ts_shift, remux->is_pes);
+	gf_fwrite(remux->out, 1, remux->out_size, remux->dst);
+	remux->out_size = 0;
+}
+
+/*returns the next output packet, flushing the output buffer when full*/
+static u8 *gf_m2ts_remux_new_packet(GF_M2TS_Remux *remux)
+{
+	u8 *pck;
+	if (remux->out_size + 188 > M2TS_REMUX_BLOCK_SIZE) gf_m2ts_remux_flush(remux);
+	pck = (u8 *) remux->out + remux->out_size;
+	remux->out_size += 188;
+	remux->nb_packets_out++;
+	return pck;
+}
+
+/*packetizes a regenerated section in the output*/
+static void gf_m2ts_remux_write_section(GF_M2TS_Remux *remux, u32 out_pid, u8 *section, u32 len)
+{
+	u32 pos = 0;
+	while (pos < len) {
+		u8 *pck = gf_m2ts_remux_new_packet(remux);
+		u32 hdr = 4, size;
+		pck[0] = 0x47;
+		pck[1] = (out_pid >> 8) & 0x1F;
+		pck[2] = out_pid & 0xFF;
+		pck[3] = 0x10 | remux->table_cc[out_pid];
+		remux->table_cc[out_pid] = (remux->table_cc[out_pid] + 1) & 0xF;
+		if (!pos) {
+			pck[1] |= 0x40;
+			/*pointer field*/
+			pck[4] = 0;
+			hdr = 5;
+		}
+		size = MIN(len - pos, 188 - hdr);
+		memcpy(pck + hdr, section + pos, size);
+		if (hdr + size < 188) memset(pck + hdr + size, 0xFF, 188 - hdr - size);
+		pos += size;
+	}
+}
+
+static void gf_m2ts_remux_set_crc(u8 *section, u32 len)
+{
+	u32 crc = gf_crc_32((char *) section, len - 4);
+	section[len-4] = (crc >> 24) & 0xFF;
+	section[len-3] = (crc >> 16) & 0xFF;
+	section[len-2] = (crc >> 8) & 0xFF;
+	section[len-1] = crc & 0xFF;
+}
+
+static void gf_m2ts_remux_on_pat(GF_M2TS_Remux *remux, u8 *section, u32 len)
+{
+	u8 pat[M2TS_REMUX_MAX_SECTION];
+	u32 pos, out_len = 8;
+
+	memcpy(pat, section, 8);
+	for (pos=8; pos+4+4 <= len; pos+=4) {
+		u32 number = (section[pos] << 8) | section[pos+1];
+		u32 pid = ((section[pos+2] & 0x1F) << 8) | section[pos+3];
+		/*network PID*/
+		if (!number) {
+			remux->pid_type[pid] = M2TS_REMUX_PID_COPY;
+		} else if (gf_m2ts_remux_is_kept(remux, number)) {
+			remux->pid_type[pid] = M2TS_REMUX_PID_PMT;
+		} else {
+			continue;
+		}
+		pat[out_len] = section[pos];
+		pat[out_len+1] = section[pos+1];
+		pat[out_len+2] = (section[pos+2] & 0xE0) | ((remux->pid_map[pid] >> 8) & 0x1F);
+		pat[out_len+3] = remux->pid_map[pid] & 0xFF;
+		out_len += 4;
+	}
+	out_len += 4;
+	pat[1] = (pat[1] & 0xF0) | (((out_len-3) >> 8) & 0x0F);
+	pat[2] = (out_len-3) & 0xFF;
+	gf_m2ts_remux_set_crc(pat, out_len);
+	gf_m2ts_remux_write_section(remux, GF_M2TS_PID_PAT, pat, out_len);
+}
+
+static void gf_m2ts_remux_on_pmt(GF_M2TS_Remux *remux, u32 pmt_pid, u8 *section, u32 len)
+{
+	u32 pos, pid, info_len;
+	u32 number = (section[3] << 8) | section[4];
+
+	/*a PMT PID may carry the PMTs of several programs*/
+	if (!gf_m2ts_remux_is_kept(remux, number)) return;
+
+	pid = ((section[8] & 0x1F) << 8) | section[9];
+	if (pid != 0x1FFF) {
+		remux->pid_type[pid] = M2TS_REMUX_PID_COPY;
+		section[8] = (section[8] & 0xE0) | ((remux->pid_map[pid] >> 8) & 0x1F);
+		section[9] = remux->pid_map[pid] & 0xFF;
+	}
+	info_len = ((section[10] & 0xF) << 8) | section[11];
+	pos = 12 + info_len;
+	while (pos + 5 + 4 <= len) {
+		u32 stream_type = section[pos];
+		pid = ((section[pos+1] & 0x1F) << 8) | section[pos+2];
+		info_len = ((section[pos+3] & 0xF) << 8) | section[pos+4];
+		remux->pid_type[pid] = M2TS_REMUX_PID_COPY;
+		remux->is_pes[remux->pid_map[pid]] = gf_m2ts_remux_is_section_type(stream_type) ? 0 : 1;
+		section[pos+1] = (section[pos+1] & 0xE0) | ((remux->pid_map[pid] >> 8) & 0x1F);
+		section[pos+2] = remux->pid_map[pid] & 0xFF;
+		pos += 5 + info_len;
+	}
+	gf_m2ts_remux_set_crc(section, len);
+	gf_m2ts_remux_write_section(remux, remux->pid_map[pmt_pid], section, len);
+}
+
+/*appends section data, returns the number of bytes used*/
+static u32 gf_m2ts_remux_section_data(GF_M2TS_Remux *remux, u32 pid, GF_M2TS_RemuxSection *sec, u8 *data, u32 size)
+{
+	u32 total, copy, used = 0;
+
+	/*section header up to section_length*/
+	if (sec->len < 3) {
+		used = MIN(3 - sec->len, size);
+		memcpy(sec->data + sec->len, data, used);
+		sec->len += used;
+		if (sec->len < 3) return used;
+	}
+	total = 3 + (((sec->data[1] & 0xF) << 8) | sec->data[2]);
+	/*a PAT with no program is 12 bytes*/
+	if ((total > M2TS_REMUX_MAX_SECTION) || (total < 12)) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[M2TS Remux] PID %d: invalid section length %d, skipping\n", pid, total));
+		sec->active = GF_FALSE;
+		return size;
+	}
+	copy = MIN(total - sec->len, size - used);
+	memcpy(sec->data + sec->len, data + used, copy);
+	sec->len += copy;
+	used += copy;
+	if (sec->len < total) return used;
+
+	sec->active = GF_FALSE;
+	if (gf_crc_32((char *) sec->data, sec->len - 4) != GF_4CC(sec->data[sec->len-4], sec->data[sec->len-3], sec->data[sec->len-2], sec->data[sec->len-1])) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[M2TS Remux] PID %d: section CRC error, skipping\n", pid));
+	}
+	/*only current tables*/
+	else if (sec->data[5] & 0x1) {
+		if ((remux->pid_type[pid] == M2TS_REMUX_PID_PAT) && (sec->data[0] == GF_M2TS_TABLE_ID_PAT))
+			gf_m2ts_remux_on_pat(remux, sec->data, sec->len);
+		else if ((remux->pid_type[pid] == M2TS_REMUX_PID_PMT) && (sec->data[0] == GF_M2TS_TABLE_ID_PMT))
+			gf_m2ts_remux_on_pmt(remux, pid, sec->data, sec->len);
+	}
+	return used;
+}
+
+static void gf_m2ts_remux_section_packet(GF_M2TS_Remux *remux, u32 pid, u8 *pck)
+{
+	u32 pos = 4;
+	GF_M2TS_RemuxSection *sec;
+
+	/*transport error or no payload*/
+	if ((pck[1] & 0x80) || !(pck[3] & 0x10)) return;
+	if (pck[3] & 0x20) pos += 1 + pck[4];
+	if (pos >= 188) return;
+
+	sec = remux->sections[pid];
+	if (!sec) {
+		GF_SAFEALLOC(remux->sections[pid], GF_M2TS_RemuxSection);
+		sec = remux->sections[pid];
+		if (!sec) return;
+	}
+	if (pck[1] & 0x40) {
+		u32 ptr = pck[pos];
+		pos++;
+		/*end of the previous section*/
+		if (sec->active && ptr) gf_m2ts_remux_section_data(remux, pid, sec, pck + pos, MIN(ptr, 188 - pos));
+		pos += ptr;
+		sec->active = GF_FALSE;
+		if (pos >= 188) return;
+	}
+	else if (!sec->active) {
+		return;
+	}
+	while (pos < 188) {
+		if (!sec->active) {
+			/*stuffing*/
+			if ((pck[pos] == 0xFF) || !(pck[1] & 0x40)) break;
+			sec->active = GF_TRUE;
+			sec->len = 0;
+		}
+		pos += gf_m2ts_remux_section_data(remux, pid, sec, pck + pos, 188 - pos);
+	}
+}
+
+GF_EXPORT
+GF_Err gf_m2ts_remux_file(GF_M2TS_Remux *remux, const char *src, const char *dst)
+{
+	u32 i, nb_pck;
+	FILE *in, *out;
+	GF_Err e;
+	u8 *mapped_out;
+	GF_M2TS_FileReader fr;
+
+	if (!remux || !src || !dst) return GF_BAD_PARAM;
+	in = gf_fopen(src, "rb");
+	if (!in) return GF_URL_ERROR;
+	out = gf_fopen(dst, "wb");
+	if (!out) {
+		gf_fclose(in);
+		return GF_IO_ERR;
+	}
+	e = gf_m2ts_file_reader_init(&fr, in);
+	if (!remux->out) remux->out = (char*)gf_malloc(sizeof(char)*M2TS_REMUX_BLOCK_SIZE);
+	mapped_out = (u8*)gf_malloc(sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	if (e || !remux->out || !mapped_out) {
+		gf_m2ts_file_reader_reset(&fr);
+		if (mapped_out) gf_free(mapped_out);
+		gf_fclose(in);
+		gf_fclose(out);
+		return GF_OUT_OF_MEM;
+	}
+	/*output PIDs of the mapped input PIDs*/
+	memset(mapped_out, 0, sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+		if (remux->pid_map[i] != i) mapped_out[remux->pid_map[i]] = 1;
+	}
+
+	/*PIDs are dropped until signaled in the PAT or a PMT, except for SI PIDs and null packets*/
+	memset(remux->pid_type, M2TS_REMUX_PID_DROP, sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	for (i=GF_M2TS_PID_CAT; i<=GF_M2TS_PID_SIT; i++) remux->pid_type[i] = M2TS_REMUX_PID_COPY;
+	remux->pid_type[GF_M2TS_PID_PAT] = M2TS_REMUX_PID_PAT;
+	remux->pid_type[0x1FFF] = M2TS_REMUX_PID_COPY;
+	memset(remux->is_pes, 0, sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	memset(remux->table_cc, 0, sizeof(u8)*GF_M2TS_MAX_STREAMS);
+	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
+		if (remux->sections[i]) remux->sections[i]->active = GF_FALSE;
+	}
+	remux->out_size = 0;
+	remux->dst = out;
+	remux->nb_packets_in = remux->nb_packets_out = 0;
+
+	while ((nb_pck = gf_m2ts_file_reader_next(&fr))) {
+		for (i=0; i<nb_pck; i++) {
+			u8 *pck = (u8 *) fr.buf + fr.pos + i*fr.pck_size;
+			u32 pid = fr.pids[i];
+			/*kept input PID passed through on the output PID of a mapped input PID*/
+			if ((remux->pid_type[pid] != M2TS_REMUX_PID_DROP) && (remux->pid_map[pid] == pid) && mapped_out[pid]) {
+				GF_LOG(GF_LOG_ERROR, GF_LOG_CONTAINER, ("[TS Remux] PID %d is kept as is but is also the output PID of a remapped PID\n", pid));
+				e = GF_BAD_PARAM;
+				break;
+			}
+			switch (remux->pid_type[pid]) {
+			case M2TS_REMUX_PID_COPY:
+			{
+				u8 *dst_pck = gf_m2ts_remux_new_packet(remux);
+				memcpy(dst_pck, pck, 188);
+				dst_pck[1] = (dst_pck[1] & 0xE0) | ((remux->pid_map[pid] >> 8) & 0x1F);
+				dst_pck[2] = remux->pid_map[pid] & 0xFF;
+			}
+			break;
+			case M2TS_REMUX_PID_PAT:
+			case M2TS_REMUX_PID_PMT:
+				gf_m2ts_remux_section_packet(remux, pid, pck);
+				break;
+			default:
+				break;
+			}
+		}
+		remux->nb_packets_in += i;
+		if (e) break;
+	}
+	gf_m2ts_remux_flush(remux);
+	remux->dst = NULL;
+
+	gf_m2ts_file_reader_reset(&fr);
+	gf_free(mapped_out);
+	gf_fclose(in);
+	gf_fclose(out);
+	if (e) return e;
+	return remux->nb_packets_in ? GF_OK : GF_NON_COMPLIANT_BITSTREAM;
+}
+
 #endif /*GPAC_DISABLE_MPEG2TS*/
@@ -27,6 +27,7 @@
 
 /*the default size for new streams allocation...*/
 #define BS_MEM_BLOCK_ALLOC_SIZE		4096
+#define BS_CHUNK_DEFAULT_SIZE		65536
 
 /*private types*/
 enum
@@ -34,7 +35,9 @@ enum
 	GF_BITSTREAM_FILE_READ = GF_BITSTREAM_WRITE + 1,
 	GF_BITSTREAM_FILE_WRITE,
 	/*private mode if we own the buffer*/
-	GF_BITSTREAM_WRITE_DYN
+	GF_BITSTREAM_WRITE_DYN,
+	/*private mode for memory written in a list of fixed-size blocks*/
+	GF_BITSTREAM_WRITE_CHUNKED
 };
 
 struct __tag_bitstream
@@ -58,9 +61,15 @@ struct __tag_bitstream
 	void (*EndOfStream)(void *par);
 	void *par;
 
+	/*user flags attached to the bitstream*/
+	u64 cookie;
 
 	char *buffer_io;
 	u32 buffer_io_size, buffer_written;
+
+	/*blocks of a chunked bitstream, size is the number of bytes written*/
+	char **blocks;
+	u32 nb_blocks, nb_alloc_blocks, block_size;
 };
 
 
@@ -116,6 +125,68 @@ GF_BitStream *gf_bs_new(const char *buffer, u64 BufferSize, u32 mode)
 	return tmp;
 }
 
+GF_EXPORT
+GF_BitStream *gf_bs_new_chunked(u32 block_size)
+{
+	GF_BitStream *tmp;
+	GF_SAFEALLOC(tmp, GF_BitStream);
+	if (!tmp) return NULL;
+	tmp->bsmode = GF_BITSTREAM_WRITE_CHUNKED;
+	tmp->block_size = block_size ? block_size : BS_CHUNK_DEFAULT_SIZE;
+	return tmp;
+}
+
+/*gets the block containing the given byte, allocating blocks as needed*/
+static char *BS_GetBlock(GF_BitStream *bs, u64 position)
+{
+	u32 idx = (u32) (position / bs->block_size);
+	while (idx >= bs->nb_blocks) {
+		char *block;
+		if (bs->nb_blocks == bs->nb_alloc_blocks) {
+			bs->nb_alloc_blocks = bs->nb_alloc_blocks ? 2*bs->nb_alloc_blocks : 16;
+			bs->blocks = (char **)gf_realloc(bs->blocks, sizeof(char *) * bs->nb_alloc_blocks);
+			if (!bs->blocks) {
+				bs->nb_blocks = bs->nb_alloc_blocks = 0;
+				return NULL;
+			}
+		}
+		block = (char *)gf_malloc(sizeof(char) * bs->block_size);
+		if (!block) return NULL;
+		bs->blocks[bs->nb_blocks] = block;
+		bs->nb_blocks++;
+	}
+	return bs->blocks[idx];
+}
+
+static void BS_ResetBlocks(GF_BitStream *bs)
+{
+	u32 i;
+	for (i=0; i<bs->nb_blocks; i++) gf_free(bs->blocks[i]);
+	if (bs->blocks) gf_free(bs->blocks);
+	bs->blocks = NULL;
+	bs->nb_blocks = bs->nb_alloc_blocks = 0;
+	bs->size = bs->position = 0;
+	bs->current = bs->nbBits = 0;
+}
+
+GF_EXPORT
+u32 gf_bs_get_chunk_count(GF_BitStream *bs)
+{
+	if (!bs || (bs->bsmode != GF_BITSTREAM_WRITE_CHUNKED)) return 0;
+	return (u32) ((bs->size + bs->block_size - 1) / bs->block_size);
+}
+
+GF_EXPORT
+const char *gf_bs_get_chunk(GF_BitStream *bs, u32 idx, u32 *size)
+{
+	u64 start;
+	if (size) *size = 0;
+	if (idx >= gf_bs_get_chunk_count(bs)) return NULL;
+	start = (u64) idx * bs->block_size;
+	if (size) *size = (u32) ((bs->size - start > bs->block_size) ? bs->block_size : (bs->size - start));
+	return bs->blocks[idx];
+}
+
 GF_EXPORT
 GF_BitStream *gf_bs_from_file(FILE *f, u32 mode)
 {
@@ -181,6 +252,7 @@ void gf_bs_del(GF_BitStream *bs)
 	if (!bs) return;
 	/*if we are in dynamic mode (alloc done by the bitstream), free the buffer if still present*/
 	if ((bs->bsmode == GF_BITSTREAM_WRITE_DYN) && bs->original) gf_free(bs->original);
+	if (bs->bsmode == GF_BITSTREAM_WRITE_CHUNKED) BS_ResetBlocks(bs);
 	if (bs->buffer_io)
 		bs_flush_cache(bs);
 	gf_free(bs);
@@ -210,6 +282,16 @@ static u8 BS_ReadByte(GF_BitStream *bs)
 		}
 		return (u32) bs->original[bs->position++];
 	}
+	if (bs->bsmode == GF_BITSTREAM_WRITE_CHUNKED) {
+		u8 val;
+		if (bs->position >= bs->size) {
+			if (bs->EndOfStream) bs->EndOfStream(bs->par);
+			return 0;
+		}
+		val = (u8) bs->blocks[bs->position / bs->block_size][bs->position % bs->block_size];
+		bs->position++;
+		return val;
+	}
 	if (bs->buffer_io)
 		bs_flush_cache(bs);
 
@@ -222,6 +304,52 @@ static u8 BS_ReadByte(GF_BitStream *bs)
 	return 0;
 }
 
+/*loads the next 8 bytes of a memory read bitstream in a big-endian word, bytes after the end of the buffer are read as 0
+the position is not modified*/
+static GFINLINE u64 BS_PeekWord(GF_BitStream *bs)
+{
+	const u8 *ptr = (const u8 *) bs->original + bs->position;
+	if (bs->position + 8 > bs->size) {
+		u32 i, nb_bytes = (u32) (bs->size - bs->position);
+		u64 word = 0;
+		for (i=0; i<nb_bytes; i++) word |= ((u64) ptr[i]) << (56 - 8*i);
+		return word;
+	}
+	return ((u64) ptr[0] << 56) | ((u64) ptr[1] << 48) | ((u64) ptr[2] << 40) | ((u64) ptr[3] << 32)
+	       | ((u64) ptr[4] << 24) | ((u64) ptr[5] << 16) | ((u64) ptr[6] << 8) | (u64) ptr[7];
+}
+
+/*reads up to 32 bits from a memory read bitstream: the bits left in the current byte are used first, the remaining ones are
+taken from a 64-bit word loaded at the current position. The current byte / bit count are left in the same state as with bit
+by bit reading. Returns GF_FALSE if the data is not available, in which case nothing is read*/
+static GFINLINE Bool BS_ReadBitsFast(GF_BitStream *bs, u32 nBits, u32 *value)
+{
+	u64 word;
+	u32 avail = 8 - bs->nbBits;
+	u32 cur = (bs->current & 0xFF) >> bs->nbBits;
+
+	if (nBits <= avail) {
+		bs->current <<= nBits;
+		bs->nbBits += nBits;
+		*value = (cur >> (avail - nBits)) & ((1<<nBits) - 1);
+		return GF_TRUE;
+	}
+	nBits -= avail;
+	if (bs->position + (nBits+7)/8 > bs->size) return GF_FALSE;
+
+	word = BS_PeekWord(bs);
+	*value = (u32) (((u64) cur << nBits) | (word >> (64 - nBits)));
+	bs->position += nBits/8;
+	bs->nbBits = nBits % 8;
+	if (bs->nbBits) {
+		bs->current = ((u8) bs->original[bs->position]) << bs->nbBits;
+		bs->position++;
+	} else {
+		bs->nbBits = 8;
+	}
+	return GF_TRUE;
+}
+
 #define NO_OPTS
 
 #ifndef NO_OPTS
@@ -255,6 +383,10 @@ u32 gf_bs_read_int(GF_BitStream *bs, u32 nBits)
 {
 	u32 ret;
 
+	if ((bs->bsmode == GF_BITSTREAM_READ) && nBits && (nBits<=32)) {
+		if (BS_ReadBitsFast(bs, nBits, &ret)) return ret;
+	}
+
 #ifndef NO_OPTS
 	if (nBits + bs->nbBits <= 8) {
 		bs->nbBits += nBits;
@@ -274,6 +406,9 @@ GF_EXPORT
 u32 gf_bs_read_u8(GF_BitStream *bs)
 {
 	assert(bs->nbBits==8);
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->position < bs->size)) {
+		return (u8) bs->original[bs->position++];
+	}
 	return (u32) BS_ReadByte(bs);
 }
 
@@ -305,6 +440,11 @@ u32 gf_bs_read_u16(GF_BitStream *bs)
 {
 	u32 ret;
 	assert(bs->nbBits==8);
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->position + 2 <= bs->size)) {
+		const u8 *ptr = (const u8 *) bs->original + bs->position;
+		bs->position += 2;
+		return ((u32) ptr[0] << 8) | (u32) ptr[1];
+	}
 	ret = BS_ReadByte(bs);
 	ret<<=8;
 	ret |= BS_ReadByte(bs);
@@ -317,6 +457,11 @@ u32 gf_bs_read_u24(GF_BitStream *bs)
 {
 	u32 ret;
 	assert(bs->nbBits==8);
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->position + 3 <= bs->size)) {
+		const u8 *ptr = (const u8 *) bs->original + bs->position;
+		bs->position += 3;
+		return ((u32) ptr[0] << 16) | ((u32) ptr[1] << 8) | (u32) ptr[2];
+	}
 	ret = BS_ReadByte(bs);
 	ret<<=8;
 	ret |= BS_ReadByte(bs);
@@ -330,6 +475,11 @@ u32 gf_bs_read_u32(GF_BitStream *bs)
 {
 	u32 ret;
 	assert(bs->nbBits==8);
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->position + 4 <= bs->size)) {
+		const u8 *ptr = (const u8 *) bs->original + bs->position;
+		bs->position += 4;
+		return ((u32) ptr[0] << 24) | ((u32) ptr[1] << 16) | ((u32) ptr[2] << 8) | (u32) ptr[3];
+	}
 	ret = BS_ReadByte(bs);
 	ret<<=8;
 	ret |= BS_ReadByte(bs);
@@ -344,6 +494,11 @@ GF_EXPORT
 u64 gf_bs_read_u64(GF_BitStream *bs)
 {
 	u64 ret;
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->nbBits==8) && (bs->position + 8 <= bs->size)) {
+		ret = BS_PeekWord(bs);
+		bs->position += 8;
+		return ret;
+	}
 	ret = gf_bs_read_u32(bs);
 	ret<<=32;
 	ret |= gf_bs_read_u32(bs);
@@ -357,6 +512,12 @@ u64 gf_bs_read_long_int(GF_BitStream *bs, u32 nBits)
 	if (nBits>64) {
 		gf_bs_read_long_int(bs, nBits-64);
 		ret = gf_bs_read_long_int(bs, 64);
+	} else if ((bs->bsmode == GF_BITSTREAM_READ) && (nBits>32)) {
+		ret = gf_bs_read_int(bs, nBits-32);
+		ret <<= 32;
+		ret |= gf_bs_read_int(bs, 32);
+	} else if (bs->bsmode == GF_BITSTREAM_READ) {
+		ret = gf_bs_read_int(bs, nBits);
 	} else {
 		while (nBits-- > 0) {
 			ret <<= 1;
@@ -410,6 +571,17 @@ u32 gf_bs_read_data(GF_BitStream *bs, char *data, u32 nbBytes)
 			memcpy(data, bs->original + bs->position, nbBytes);
 			bs->position += nbBytes;
 			return nbBytes;
+		case GF_BITSTREAM_WRITE_CHUNKED:
+			while (nbBytes) {
+				u32 offset = (u32) (bs->position % bs->block_size);
+				u32 copy = bs->block_size - offset;
+				if (copy > nbBytes) copy = nbBytes;
+				memcpy(data, bs->blocks[bs->position / bs->block_size] + offset, copy);
+				data += copy;
+				nbBytes -= copy;
+				bs->position += copy;
+			}
+			return (u32) (bs->position - orig);
 		case GF_BITSTREAM_FILE_READ:
 		case GF_BITSTREAM_FILE_WRITE:
 			if (bs->buffer_io)
@@ -423,6 +595,22 @@ u32 gf_bs_read_data(GF_BitStream *bs, char *data, u32 nbBytes)
 		}
 	}
 
+	/*memory read, not aligned: each output byte is made of the unread bits of the current byte and the first bits of the next one*/
+	if (bs->bsmode == GF_BITSTREAM_READ) {
+		u32 i, shift = bs->nbBits;
+		const u8 *ptr = (const u8 *) bs->original + bs->position;
+		u32 cur = (bs->current & 0xFF) >> shift;
+		for (i=0; i<nbBytes; i++) {
+			data[i] = (char) ((cur << shift) | (ptr[i] >> (8 - shift)));
+			cur = ptr[i] & ((1<<(8-shift)) - 1);
+		}
+		if (nbBytes) {
+			bs->current = ((u32) ptr[nbBytes-1]) << shift;
+			bs->position += nbBytes;
+		}
+		return nbBytes;
+	}
+
 	while (nbBytes-- > 0) {
 		*data++ = gf_bs_read_int(bs, 8);
 	}
@@ -436,6 +624,14 @@ static void BS_WriteByte(GF_BitStream *bs, u8 val)
 {
 	/*we don't allow write on READ buffers*/
 	if ( (bs->bsmode == GF_BITSTREAM_READ) || (bs->bsmode == GF_BITSTREAM_FILE_READ) ) return;
+	if (bs->bsmode == GF_BITSTREAM_WRITE_CHUNKED) {
+		char *block = BS_GetBlock(bs, bs->position);
+		if (!block) return;
+		block[bs->position % bs->block_size] = val;
+		bs->position++;
+		if (bs->position > bs->size) bs->size = bs->position;
+		return;
+	}
 	if (!bs->original && !bs->stream) return;
 
 	/*we are in MEM mode*/
@@ -587,6 +783,22 @@ u32 gf_bs_write_byte(GF_BitStream *bs, u8 byte, u32 repeat_count)
 		memset(bs->original + bs->position, byte, repeat_count);
 		bs->position += repeat_count;
 		return repeat_count;
+	case GF_BITSTREAM_WRITE_CHUNKED:
+	{
+		u32 count = 0;
+		while (count < repeat_count) {
+			u32 offset = (u32) (bs->position % bs->block_size);
+			u32 fill = bs->block_size - offset;
+			char *block = BS_GetBlock(bs, bs->position);
+			if (!block) break;
+			if (fill > repeat_count - count) fill = repeat_count - count;
+			memset(block + offset, byte, fill);
+			count += fill;
+			bs->position += fill;
+		}
+		if (bs->position > bs->size) bs->size = bs->position;
+		return count;
+	}
 	case GF_BITSTREAM_FILE_READ:
 	case GF_BITSTREAM_FILE_WRITE:
 
@@ -665,6 +877,21 @@ u32 gf_bs_write_data(GF_BitStream *bs, const char *data, u32 nbBytes)
 			memcpy(bs->original + bs->position, data, nbBytes);
 			bs->position += nbBytes;
 			return nbBytes;
+		case GF_BITSTREAM_WRITE_CHUNKED:
+			/*fill the current block and allocate new ones, previous data is never moved*/
+			while (nbBytes) {
+				u32 offset = (u32) (bs->position % bs->block_size);
+				u32 copy = bs->block_size - offset;
+				char *block = BS_GetBlock(bs, bs->position);
+				if (!block) break;
+				if (copy > nbBytes) copy = nbBytes;
+				memcpy(block + offset, data, copy);
+				data += copy;
+				nbBytes -= copy;
+				bs->position += copy;
+			}
+			if (bs->position > bs->size) bs->size = bs->position;
+			return (u32) (bs->position - begin);
 		case GF_BITSTREAM_FILE_READ:
 		case GF_BITSTREAM_FILE_WRITE:
 			if (bs->buffer_io) {
@@ -724,6 +951,7 @@ u64 gf_bs_available(GF_BitStream *bs)
 	/*in WRITE mode only, this should not be called, but return something big in case ...*/
 	if ( (bs->bsmode == GF_BITSTREAM_WRITE)
 	        || (bs->bsmode == GF_BITSTREAM_WRITE_DYN)
+	        || (bs->bsmode == GF_BITSTREAM_WRITE_CHUNKED)
 	   )
 		return (u64) -1;
 
@@ -773,6 +1001,23 @@ static s32 BS_CutBuffer(GF_BitStream *bs)
 GF_EXPORT
 void gf_bs_get_content(GF_BitStream *bs, char **output, u32 *outSize)
 {
+	/*chunked mode: blocks are gathered in a single buffer*/
+	if (bs->bsmode == GF_BITSTREAM_WRITE_CHUNKED) {
+		u64 size;
+		gf_bs_align(bs);
+		size = bs->position;
+		*output = NULL;
+		*outSize = 0;
+		if (size && (size <= 0xFFFFFFFF)) {
+			*output = (char *)gf_malloc(sizeof(char) * (u32) size);
+			if (*output) {
+				gf_bs_seek(bs, 0);
+				*outSize = gf_bs_read_data(bs, *output, (u32) size);
+			}
+		}
+		BS_ResetBlocks(bs);
+		return;
+	}
 	/*only in WRITE MEM mode*/
 	if (bs->bsmode != GF_BITSTREAM_WRITE_DYN) return;
 	if (!bs->position && !bs->nbBits) {
@@ -868,6 +1113,22 @@ static GF_Err BS_SeekIntern(GF_BitStream *bs, u64 offset)
 		return GF_OK;
 	}
 
+	if (bs->bsmode == GF_BITSTREAM_WRITE_CHUNKED) {
+		/*extend with zeros as done in DYN mode, blocks are not initialized at allocation*/
+		while (bs->size < offset) {
+			u32 fill = bs->block_size - (u32) (bs->size % bs->block_size);
+			char *block = BS_GetBlock(bs, bs->size);
+			if (!block) return GF_OUT_OF_MEM;
+			if (fill > offset - bs->size) fill = (u32) (offset - bs->size);
+			memset(block + bs->size % bs->block_size, 0, fill);
+			bs->size += fill;
+		}
+		bs->position = offset;
+		bs->current = 0;
+		bs->nbBits = 0;
+		return GF_OK;
+	}
+
 	if (bs->buffer_io)
 		bs_flush_cache(bs);
 
@@ -884,8 +1145,8 @@ static GF_Err BS_SeekIntern(GF_BitStream *bs, u64 offset)
 GF_EXPORT
 GF_Err gf_bs_seek(GF_BitStream *bs, u64 offset)
 {
-	/*warning: we allow offset = bs->size for WRITE buffers*/
-	if (offset > bs->size) return GF_BAD_PARAM;
+	/*warning: we allow offset = bs->size for WRITE buffers, and offset > bs->size for CHUNKED buffers (zero-filled)*/
+	if ((offset > bs->size) && (bs->bsmode != GF_BITSTREAM_WRITE_CHUNKED)) return GF_BAD_PARAM;
 
 	gf_bs_align(bs);
 	return BS_SeekIntern(bs, offset);
@@ -969,6 +1230,24 @@ void gf_bs_set_eos_callback(GF_BitStream *bs, void (*EndOfStream)(void *par), vo
 	bs->par = par;
 }
 
+GF_EXPORT
+u64 gf_bs_set_cookie(GF_BitStream *bs, u64 cookie)
+{
+	u64 res = 0;
+	if (bs) {
+		res = bs->cookie;
+		bs->cookie = cookie;
+	}
+	return res;
+}
+
+GF_EXPORT
+u64 gf_bs_get_cookie(GF_BitStream *bs)
+{
+	if (!bs) return 0;
+	return bs->cookie;
+}
+
 
 GF_EXPORT
 u32 gf_bs_read_u32_le(GF_BitStream *bs)
@@ -1051,6 +1330,24 @@ GF_Err gf_bs_transfer(GF_BitStream *dst, GF_BitStream *src)
 	char *data;
 	u32 data_len, written;
 
+	/*chunked source, write each block to the destination*/
+	if (src->bsmode == GF_BITSTREAM_WRITE_CHUNKED) {
+		u32 i, count;
+		GF_Err e = GF_OK;
+		gf_bs_align(src);
+		src->size = src->position;
+		count = gf_bs_get_chunk_count(src);
+		for (i=0; i<count; i++) {
+			const char *chunk = gf_bs_get_chunk(src, i, &data_len);
+			if (gf_bs_write_data(dst, chunk, data_len) != data_len) {
+				e = GF_IO_ERR;
+				break;
+			}
+		}
+		BS_ResetBlocks(src);
+		return e;
+	}
+
 	data = NULL;
 	data_len = 0;
 	gf_bs_get_content(src, &data, &data_len);
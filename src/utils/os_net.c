@@ -1225,6 +1225,7 @@ GF_Err gf_sk_receive(GF_Socket *sock, char *buffer, u32 length, u32 startFrom, u
 }
 
 
+GF_EXPORT
 GF_Err gf_sk_listen(GF_Socket *sock, u32 MaxConnection)
 {
 	s32 i;
@@ -1236,6 +1237,7 @@ GF_Err gf_sk_listen(GF_Socket *sock, u32 MaxConnection)
 	return GF_OK;
 }
 
+GF_EXPORT
 GF_Err gf_sk_accept(GF_Socket *sock, GF_Socket **newConnection)
 {
 	u32 client_address_size;
@@ -1340,6 +1342,7 @@ GF_Err gf_sk_get_local_info(GF_Socket *sock, u16 *Port, u32 *Familly)
 }
 
 //we have to do this for the server sockets as we use only one thread
+GF_EXPORT
 GF_Err gf_sk_server_mode(GF_Socket *sock, Bool serverOn)
 {
 	u32 one;
@@ -8,4 +8,88 @@ do_test "$MP4BOX -dash 1000 $TEMP_DIR/file.mp4 -out $TEMP_DIR/file.mpd" "basic-d
 
 do_playback_test "$TEMP_DIR/file.mpd" "play"
 
-test_end
\ No newline at end of file
+test_end
+
+#@dash_ctx_test: runs two -dash-ctx cycles with the options $2, with and without the extra options $3, and checks the resulting MPDs are the same
+dash_ctx_test ()
+{
+
+test_begin "dash-ctx-$1"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+for mode in ref test ; do
+ opts="$2"
+ if [ $mode = "test" ] ; then
+  opts="$2 $3"
+ fi
+ dir="$TEMP_DIR/ctx-$1-$mode"
+ mkdir -p $dir
+ for cycle in 1 2 ; do
+  do_test "$MP4BOX -dash 1000 -rap -dynamic -segment-timeline -url-template -subdur 2000 -mpd-refresh 2 -dash-ctx $dir/ctx $opts $ctxfile#video $ctxfile#audio -out $dir/live.mpd" "$mode-cycle$cycle"
+ done
+ sed -e '/Generated with GPAC/d' -e '/<Title>/d' -e 's/availabilityStartTime="[^"]*"//' -e 's/publishTime="[^"]*"//' $dir/live.mpd > $dir.mpd
+done
+
+$DIFF $TEMP_DIR/ctx-$1-ref.mpd $TEMP_DIR/ctx-$1-test.mpd > /dev/null
+if [ $? != 0 ] ; then
+ result="MPD differs with $3"
+fi
+
+rm -rf $TEMP_DIR/ctx-$1-*
+test_end
+}
+
+ctxfile="$TEMP_DIR/ctx.mp4"
+
+$MP4BOX -add $MEDIA_DIR/auxiliary_files/enst_video.h264 -add $MEDIA_DIR/auxiliary_files/enst_audio.aac -new $ctxfile 2> /dev/null
+
+dash_ctx_test "checkpoint" "" "-ctx-checkpoint 0"
+dash_ctx_test "chunked" "-chunked" "-ctx-checkpoint 0"
+dash_ctx_test "threads" "" "-dash-threads 2"
+dash_ctx_test "threads-checkpoint" "-ctx-checkpoint 0" "-dash-threads 2"
+
+#a truncated or corrupted context snapshot must be refused rather than restored
+dash_ctx_corrupt_test ()
+{
+
+test_begin "dash-ctx-corrupt"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+dir="$TEMP_DIR/ctx-corrupt"
+mkdir -p $dir
+do_test "$MP4BOX -dash 1000 -rap -dynamic -segment-timeline -url-template -subdur 2000 -mpd-refresh 2 -dash-ctx $dir/ctx -ctx-checkpoint 0 $ctxfile#video $ctxfile#audio -out $dir/live.mpd" "snapshot"
+cp $dir/ctx $dir/ctx.ref
+
+#truncated in the middle of the segment timelines
+size=`wc -c < $dir/ctx.ref`
+head -c $((size - 10)) $dir/ctx.ref > $dir/ctx
+$MP4BOX -dash 1000 -rap -dynamic -segment-timeline -url-template -subdur 2000 -mpd-refresh 2 -dash-ctx $dir/ctx -ctx-checkpoint 0 $ctxfile#video $ctxfile#audio -out $dir/live.mpd > /dev/null 2>&1
+if [ $? = 0 ] ; then
+result="truncated snapshot accepted"
+fi
+
+#last timeline entry (start, duration and name of the last segment) missing
+last_seg=`ls $dir/*.m4s | sort | tail -1`
+head -c $((size - 20 - ${#last_seg})) $dir/ctx.ref > $dir/ctx
+$MP4BOX -dash 1000 -rap -dynamic -segment-timeline -url-template -subdur 2000 -mpd-refresh 2 -dash-ctx $dir/ctx -ctx-checkpoint 0 $ctxfile#video $ctxfile#audio -out $dir/live.mpd > /dev/null 2>&1
+if [ $? = 0 ] ; then
+result="snapshot with missing timeline entry accepted"
+fi
+
+#section count larger than the snapshot
+cp $dir/ctx.ref $dir/ctx
+printf '\377\377\377\377' | dd of=$dir/ctx bs=1 seek=8 conv=notrunc 2> /dev/null
+$MP4BOX -dash 1000 -rap -dynamic -segment-timeline -url-template -subdur 2000 -mpd-refresh 2 -dash-ctx $dir/ctx -ctx-checkpoint 0 $ctxfile#video $ctxfile#audio -out $dir/live.mpd > /dev/null 2>&1
+if [ $? = 0 ] ; then
+result="corrupted snapshot accepted"
+fi
+
+rm -rf $dir
+test_end
+}
+
+dash_ctx_corrupt_test
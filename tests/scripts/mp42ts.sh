@@ -42,4 +42,31 @@ ts_test "temi" "-src $mp4file -dst-file=$tsfile -temi -insert-ntp"
 
 ts_test "pcr" "-src $mp4file -dst-file=$tsfile -pcr-ms 40 -force-pcr-only -pcr-init 0 -pcr-offset 30000 -rap"
 
+#PES data demuxed with PES worker threads must match the single-threaded demux
+ts_threads_test ()
+{
+
+test_begin "mp42ts-demux-threads"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+do_test "$MP42TS -src $mp4file -dst-file=$tsfile" "file"
+
+for pid in 101 102 ; do
+do_test "$MP4BOX $tsfile -dm2ts $TEMP_DIR/st#$pid" "dump-$pid"
+do_test "$MP4BOX $tsfile -ts-threads 4 -dm2ts $TEMP_DIR/mt#$pid" "dump-threads-$pid"
+$DIFF $TEMP_DIR/st_$pid.raw $TEMP_DIR/mt_$pid.raw > /dev/null
+if [ $? != 0 ] ; then
+result="PID $pid PES data differs with PES worker threads"
+fi
+rm -f $TEMP_DIR/st_$pid.raw $TEMP_DIR/mt_$pid.raw
+done
+
+rm -f $tsfile
+test_end
+}
+
+ts_threads_test
+
 rm $mp4file
\ No newline at end of file
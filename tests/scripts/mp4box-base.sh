@@ -55,6 +55,23 @@ do_hash_test $mp4file "frag-1s"
 
 test_end
 
+
+test_begin "mp4box-base-info-iod"
+if [ $test_skip = 1 ] ; then
+ return
+fi
+
+#the root OD of a scene is rebuilt from the ESDs of its tracks, which needs their sample tables
+mp4file="$TEMP_DIR/iod.mp4"
+do_test "$MP4BOX -mp4 $MEDIA_DIR/bifs/bifs-2D-interactivity-keysensor.bt -out $mp4file" "create-iod"
+do_test "$MP4BOX -info $mp4file" "info-iod"
+res=`$MP4BOX -info $mp4file 2>&1 | grep "File has root IOD"`
+if [ -z "$res" ] ; then
+result="root IOD not found by -info"
+fi
+
+test_end
+
 #commented out since not very usefull, always changing and not impacting coverage
 return
 
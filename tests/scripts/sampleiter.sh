@@ -0,0 +1,28 @@
+#test the ISOBMFF sample iterator against gf_isom_get_sample (sampleiter testapp, skipped when not installed)
+
+sampleiter 2> /dev/null
+if [ $? = 127 ] ; then
+log $L_WAR "sampleiter not found - skipping sample iterator tests"
+return
+fi
+
+sampleiter_test ()
+{
+
+test_begin "sampleiter-$1"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+mp4file="$TEMP_DIR/sampleiter.mp4"
+do_test "$MP4BOX $2 -new $mp4file" "create"
+do_test "sampleiter $mp4file 1" "single-thread"
+do_test "sampleiter $mp4file 4" "workers"
+
+rm -f $mp4file
+test_end
+}
+
+sampleiter_test "interleaved" "-add $MEDIA_DIR/auxiliary_files/enst_video.h264 -add $MEDIA_DIR/auxiliary_files/enst_audio.aac"
+
+sampleiter_test "flat" "-flat -add $MEDIA_DIR/auxiliary_files/enst_video.h264 -add $MEDIA_DIR/auxiliary_files/enst_audio.aac"
@@ -0,0 +1,28 @@
+#test the MPEG-2 TS muxer on synthetic streams (tsmux testapp, skipped when not installed)
+
+tsmux 2> /dev/null
+if [ $? = 127 ] ; then
+log $L_WAR "tsmux not found - skipping TS muxer tests"
+return
+fi
+
+tsmux_test ()
+{
+
+test_begin "tsmux-$1"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+do_test "tsmux $1" "$1"
+
+test_end
+}
+
+tsmux_test "batch"
+
+tsmux_test "sender"
+
+tsmux_test "statmux"
+
+tsmux_test "queue"
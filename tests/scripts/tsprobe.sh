@@ -0,0 +1,67 @@
+#test the TS probe and random access index (tsprobe testapp, skipped when not installed)
+
+tsprobe 2> /dev/null
+if [ $? = 127 ] ; then
+log $L_WAR "tsprobe not found - skipping TS probe tests"
+return
+fi
+
+TSPROBE="tsprobe"
+
+#an index built before the TS file is rewritten must be detected as stale
+stale_index_test ()
+{
+
+test_begin "tsprobe-stale-index"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+mp4file="$TEMP_DIR/test.mp4"
+tsfile="$TEMP_DIR/test.ts"
+
+$MP4BOX -add $MEDIA_DIR/auxiliary_files/enst_video.h264 -add $MEDIA_DIR/auxiliary_files/enst_audio.aac -new $mp4file 2> /dev/null
+do_test "$MP42TS -src $mp4file -dst-file=$tsfile" "mux"
+do_test "$TSPROBE -idx $tsfile" "index"
+
+$TSPROBE $tsfile 2> /dev/null | grep "up to date" > /dev/null
+if [ $? != 0 ] ; then
+result="index not used on unmodified file"
+fi
+
+#append 1000 packets: offsets stay valid but the index no longer covers the file
+head -c 188000 $tsfile > $tsfile.tmp
+cat $tsfile.tmp >> $tsfile
+rm $tsfile.tmp
+
+$TSPROBE $tsfile 2> /dev/null | grep "is stale" > /dev/null
+if [ $? != 0 ] ; then
+result="stale index not detected"
+fi
+
+rm -f $mp4file $tsfile $tsfile.tsidx
+test_end
+}
+
+#PID filtered and PCR-only demux passes must match a full demux on the PIDs they keep
+pid_filter_test ()
+{
+
+test_begin "tsprobe-pid-filter"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+mp4file="$TEMP_DIR/test.mp4"
+tsfile="$TEMP_DIR/test.ts"
+
+$MP4BOX -add $MEDIA_DIR/auxiliary_files/enst_video.h264 -add $MEDIA_DIR/auxiliary_files/enst_audio.aac -new $mp4file 2> /dev/null
+do_test "$MP42TS -src $mp4file -dst-file=$tsfile" "mux"
+do_test "$TSPROBE -filter $tsfile" "filter"
+
+rm -f $mp4file $tsfile
+test_end
+}
+
+stale_index_test
+pid_filter_test
@@ -0,0 +1,176 @@
+#test the packet-level TS remultiplexer (tsremux testapp, skipped when not installed)
+
+tsremux 2> /dev/null
+if [ $? = 127 ] ; then
+log $L_WAR "tsremux not found - skipping TS remux tests"
+return
+fi
+
+TSREMUX="tsremux"
+
+#12000 packets, each carrying 15 empty PAT sections: every input packet regenerates 15 output packets
+pat_burst_test ()
+{
+
+test_begin "tsremux-pat-burst"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+srcfile="$TEMP_DIR/pat-burst.ts"
+dstfile="$TEMP_DIR/pat-burst-out.ts"
+
+printf '\107\100\000\020\000' > $srcfile
+i=0
+while [ $i -lt 15 ] ; do
+printf '\000\260\011\000\001\301\000\000\357\042\142\027' >> $srcfile
+i=$((i+1))
+done
+printf '\377\377\377' >> $srcfile
+
+i=0
+while [ $i -lt 14 ] ; do
+cat $srcfile $srcfile > $srcfile.tmp
+mv $srcfile.tmp $srcfile
+i=$((i+1))
+done
+head -c 2256000 $srcfile > $srcfile.tmp
+mv $srcfile.tmp $srcfile
+
+do_test "$TSREMUX $srcfile $dstfile" "remux"
+
+size=`wc -c < $dstfile`
+if [ "$size" != "33840000" ] ; then
+result="wrong output size $size"
+fi
+
+do_hash_test $dstfile "remux"
+
+rm -f $srcfile $dstfile
+test_end
+}
+
+pat_burst_test
+
+mp4file="$TEMP_DIR/remux.mp4"
+tsfile="$TEMP_DIR/remux.ts"
+dstfile="$TEMP_DIR/remux-out.ts"
+
+$MP4BOX -add $MEDIA_DIR/auxiliary_files/enst_video.h264 -add $MEDIA_DIR/auxiliary_files/enst_audio.aac -new $mp4file 2> /dev/null
+#video PID 101, audio PID 102
+$MP42TS -src $mp4file -dst-file=$tsfile 2> /dev/null
+
+#dumps the PES data of PID $2 of TS $1 to $TEMP_DIR/$3_$2.raw (single program TS only)
+dump_pes ()
+{
+$MP4BOX $1 -dm2ts $TEMP_DIR/$3#$2 2> /dev/null
+}
+
+#program filtering, with program 2 using PIDs 110 to 112
+remux_prog_test ()
+{
+
+test_begin "tsremux-prog"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+srcfile="$TEMP_DIR/remux-2progs.ts"
+$MP42TS -src $mp4file:ID=1 -src $mp4file:ID=2 -dst-file=$srcfile 2> /dev/null
+
+do_test "$TSREMUX -prog 2 $srcfile $dstfile" "remux"
+
+dump_pes $tsfile 101 ref
+dump_pes $dstfile 111 prog
+dump_pes $dstfile 101 drop
+$DIFF $TEMP_DIR/ref_101.raw $TEMP_DIR/prog_111.raw > /dev/null
+if [ $? != 0 ] ; then
+result="program 2 video differs"
+fi
+if [ -s $TEMP_DIR/drop_101.raw ] ; then
+result="program 1 not removed"
+fi
+
+rm -f $srcfile $dstfile $TEMP_DIR/*.raw
+test_end
+}
+
+#PID remapping, including output PIDs already used by another input PID
+remux_map_test ()
+{
+
+test_begin "tsremux-map"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+do_test "$TSREMUX -map 101:201 -map 102:202 $tsfile $dstfile" "remux"
+
+dump_pes $tsfile 101 ref
+dump_pes $tsfile 102 ref
+dump_pes $dstfile 201 map
+dump_pes $dstfile 202 map
+$DIFF $TEMP_DIR/ref_101.raw $TEMP_DIR/map_201.raw > /dev/null
+if [ $? != 0 ] ; then
+result="PID 101 remapped to 201 differs"
+fi
+$DIFF $TEMP_DIR/ref_102.raw $TEMP_DIR/map_202.raw > /dev/null
+if [ $? != 0 ] ; then
+result="PID 102 remapped to 202 differs"
+fi
+
+#PID 102 is passed through and already uses output PID 102
+$TSREMUX -map 101:102 $tsfile $dstfile > /dev/null 2>&1
+if [ $? = 0 ] ; then
+result="mapping to an unmapped input PID accepted"
+fi
+#two input PIDs mapped to the same output PID
+$TSREMUX -map 101:201 -map 102:201 $tsfile $dstfile > /dev/null 2>&1
+if [ $? = 0 ] ; then
+result="duplicate output PID accepted"
+fi
+
+#shifting PIDs is fine once the input PID using the output PID is mapped
+do_test "$TSREMUX -map 102:103 -map 101:102 $tsfile $dstfile" "remux-shift-pids"
+dump_pes $dstfile 102 shift
+$DIFF $TEMP_DIR/ref_101.raw $TEMP_DIR/shift_102.raw > /dev/null
+if [ $? != 0 ] ; then
+result="PID 101 remapped to 102 differs"
+fi
+
+rm -f $dstfile $TEMP_DIR/*.raw
+test_end
+}
+
+#PCR/PTS/DTS shifting: two shifts of 1 s must give the same result as one shift of 2 s
+remux_shift_test ()
+{
+
+test_begin "tsremux-shift"
+if [ $test_skip  = 1 ] ; then
+return
+fi
+
+do_test "$TSREMUX -shift 90000 $tsfile $dstfile" "shift"
+do_test "$TSREMUX -shift 90000 $dstfile $dstfile.2" "shift-twice"
+do_test "$TSREMUX -shift 180000 $tsfile $dstfile.3" "shift-2s"
+
+$DIFF $tsfile $dstfile > /dev/null
+if [ $? = 0 ] ; then
+result="timestamps not shifted"
+fi
+$DIFF $dstfile.2 $dstfile.3 > /dev/null
+if [ $? != 0 ] ; then
+result="shifts are not cumulative"
+fi
+do_hash_test $dstfile "shift"
+
+rm -f $dstfile $dstfile.2 $dstfile.3
+test_end
+}
+
+remux_prog_test
+remux_map_test
+remux_shift_test
+
+rm -f $mp4file $tsfile